@@ -5,6 +5,7 @@
 #include "Interface.hpp"
 
 namespace Archive {
+    // zlib and gzip formats detected automatically
     class ReadGzip : public IFilter
     {
         z_stream m_State;
@@ -13,7 +14,7 @@ namespace Archive {
         ReadGzip()
         {
             memset(&m_State, 0, sizeof(m_State));
-            auto sRC = inflateInit(&m_State);
+            auto sRC = inflateInit2(&m_State, MAX_WBITS + 32);
             if (sRC != Z_OK)
                 throw std::runtime_error("ReadGzip: fail to init inflate");
         }
@@ -34,38 +35,32 @@ namespace Archive {
         virtual ~ReadGzip() { inflateEnd(&m_State); }
     };
 
+    // zlib format by default, gzip (as for HTTP Content-Encoding) if aHeader set
     class WriteGzip : public IFilter
     {
-        const int m_Level;
-        bool      m_Reset = false;
-        z_stream  m_State;
-
-        void init()
-        {
-            memset(&m_State, 0, sizeof(m_State));
-            auto sRC = deflateInit(&m_State, m_Level);
-            if (sRC != Z_OK)
-                throw std::runtime_error("WriteGzip: fail to init deflate");
-        }
+        bool     m_Reset = false;
+        z_stream m_State;
 
-        void cleanup()
+        void reset()
         {
-            deflateEnd(&m_State);
+            if (m_Reset) {
+                deflateReset(&m_State); // keep allocated state
+                m_Reset = false;
+            }
         }
 
     public:
-        WriteGzip(int aLevel = 3)
-        : m_Level(aLevel)
+        WriteGzip(int aLevel = 3, bool aHeader = false)
         {
-            init();
+            memset(&m_State, 0, sizeof(m_State));
+            auto sRC = deflateInit2(&m_State, aLevel, Z_DEFLATED, aHeader ? MAX_WBITS + 16 : MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+            if (sRC != Z_OK)
+                throw std::runtime_error("WriteGzip: fail to init deflate");
         }
-        Pair filter(const char* aSrc, size_t aSrcLen, char* aDst, size_t aDstLen) override
+        size_t estimate(size_t aSize) override { return deflateBound(&m_State, aSize); }
+        Pair   filter(const char* aSrc, size_t aSrcLen, char* aDst, size_t aDstLen) override
         {
-            if (m_Reset) {
-                cleanup();
-                init();
-                m_Reset = false;
-            }
+            reset();
             m_State.next_in   = (uint8_t*)aSrc;
             m_State.avail_in  = aSrcLen;
             m_State.next_out  = (uint8_t*)aDst;
@@ -77,6 +72,7 @@ namespace Archive {
         }
         Finish finish(char* aDst, size_t aDstLen) override
         {
+            reset(); // no data since last finish
             m_State.next_in   = nullptr;
             m_State.avail_in  = 0;
             m_State.next_out  = (uint8_t*)aDst;
@@ -90,6 +86,6 @@ namespace Archive {
             }
             throw std::runtime_error("WriteGzip: fail to deflate/finish");
         }
-        virtual ~WriteGzip() { cleanup(); }
+        virtual ~WriteGzip() { deflateEnd(&m_State); }
     };
 } // namespace Archive
\ No newline at end of file
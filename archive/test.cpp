@@ -93,6 +93,25 @@ BOOST_AUTO_TEST_CASE(Lz4BufferSize)
     BOOST_CHECK_EQUAL(sLZ.limitSrcLen(100 * 1024, 100 * 1024), 65536);             // process upto 64Kb if dst buffer is 100Kb
     BOOST_CHECK_EQUAL(sLZ.limitSrcLen(100 * 1024, 200 * 1024), 102400);            // process all input if output buffer is large enough
 }
+BOOST_AUTO_TEST_CASE(GzipHeader)
+{
+    Archive::WriteGzip sCompressor(3, true);
+    Archive::ReadGzip  sDecompressor;
+
+    // buffers reused between messages
+    std::string sCompressed;
+    std::string sClear;
+    for (const std::string sData : {"hello world", "", "another message"}) {
+        sCompressed.clear();
+        Archive::filter(sData, &sCompressor, sCompressed);
+        BOOST_REQUIRE_GE(sCompressed.size(), 2);
+        BOOST_CHECK_EQUAL(sCompressed.substr(0, 2), "\x1f\x8b"); // gzip magic
+
+        sClear.clear();
+        Archive::filter(sCompressed, &sDecompressor, sClear);
+        BOOST_CHECK_EQUAL(sClear, sData);
+    }
+}
 BOOST_AUTO_TEST_CASE(ZstdThreads)
 {
     const std::string sData = File::to_string("/usr/bin/docker");
@@ -1,7 +1,12 @@
 #include <benchmark/benchmark.h>
 
 #define BOOST_TEST_MODULE Suites
+#include "v2/Client.hpp"
 #include "v2/Parser.hpp"
+#include "v2/Server.hpp"
+
+#include <threads/Asio.hpp>
+#include <time/Meter.hpp>
 
 // http2 session with small response
 // via nghttp
@@ -73,4 +78,100 @@ static void BM_FromServer(benchmark::State& state)
 }
 BENCHMARK(BM_FromServer);
 
+static void BM_Inflate(benchmark::State& state)
+{
+    struct Sink
+    {
+        size_t count = 0;
+        void   set_header(std::string_view, std::string_view) { count++; }
+    };
+    auto sSink = std::make_shared<Sink>();
+
+    asio_http::v2::Deflate sDeflate;
+    asio_http::Response    sResponse;
+    sResponse.result(200);
+    sResponse.set(asio_http::Headers::ContentType, "application/grpc");
+    sResponse.set("grpc-encoding", "identity");
+    sResponse.set("x-request-id", "0123456789abcdef0123456789abcdef");
+    sResponse.set(asio_http::http::field::server, "Beast/cxx");
+
+    // first block fills dynamic table, next ones use indexed fields
+    asio_http::v2::Inflate sInflate;
+    std::string            sBlock;
+    sDeflate(sResponse, sBlock);
+    sInflate(std::string_view(sBlock), sSink);
+    sBlock.clear();
+    sDeflate(sResponse, sBlock);
+
+    for (auto _ : state) {
+        sInflate(std::string_view(sBlock), sSink);
+    }
+    state.counters["headers"] = benchmark::Counter(sSink->count, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Inflate);
+
+static void BM_Huffman(benchmark::State& state)
+{
+    const std::string sValue = "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)";
+    std::string       sEncoded;
+    asio_http::v2::hpack::huffman_encode(sValue, sEncoded);
+
+    const auto& sDecoder = asio_http::v2::hpack::HuffmanDecoder::instance();
+    std::string sDecoded;
+    for (auto _ : state) {
+        sDecoded.clear();
+        sDecoder(sEncoded, sDecoded);
+        benchmark::DoNotOptimize(sDecoded.data());
+    }
+    state.SetBytesProcessed(state.iterations() * sValue.size());
+}
+BENCHMARK(BM_Huffman);
+
+// streams/sec over one h2 connection, `range(0)` requests in flight
+static void BM_Streams(benchmark::State& state)
+{
+    using namespace std::chrono_literals;
+
+    const size_t      sConcurrency = state.range(0);
+    const std::string sBody(1420, 'x');
+
+    auto sRouter = std::make_shared<asio_http::Router>();
+    sRouter->insert("/hello", [&](asio_http::asio::io_service&, const asio_http::Request& aRequest, asio_http::Response& aResponse, asio_http::asio::yield_context yield) {
+        aResponse.result(asio_http::http::status::ok);
+        aResponse.set(asio_http::Headers::ContentType, "text/plain");
+        aResponse.body().assign(sBody);
+    });
+
+    Threads::Asio  sAsioClient;
+    Threads::Asio  sAsioServer;
+    Threads::Group sGroup;
+    asio_http::v2::startServer(sAsioServer.service(), 2082, sRouter);
+    sAsioServer.start(sGroup, 2);
+    std::this_thread::sleep_for(100ms);
+    auto sClient = asio_http::v2::makeClient(sAsioClient.service());
+    sAsioClient.start(sGroup);
+
+    std::vector<std::future<asio_http::Response>> sFuture;
+    sFuture.reserve(sConcurrency);
+
+    size_t      sStreams = 0;
+    size_t      sErrors  = 0;
+    Time::Meter sMeter;
+    for (auto _ : state) {
+        for (size_t i = 0; i < sConcurrency; i++)
+            sFuture.push_back(sClient->async({.method = asio_http::http::verb::get,
+                                              .url    = "http://127.0.0.1:2082/hello"}));
+        for (auto& x : sFuture) {
+            if (x.get().body().size() != sBody.size())
+                sErrors++;
+        }
+        sFuture.clear();
+        sStreams += sConcurrency;
+    }
+    const double sELA         = sMeter.get().to_double();
+    state.counters["streams"] = sStreams / sELA;
+    state.counters["err"]     = sErrors;
+}
+BENCHMARK(BM_Streams)->UseRealTime()->Arg(100)->Arg(1000)->Arg(5000)->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
@@ -141,6 +141,84 @@ BOOST_AUTO_TEST_CASE(alive)
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(asio_http_v2)
+BOOST_AUTO_TEST_CASE(hpack_evict)
+{
+    using namespace asio_http::v2;
+    struct Headers
+    {
+        std::vector<std::pair<std::string, std::string>> list;
+        void set_header(std::string_view aName, std::string_view aValue) { list.emplace_back(aName, aValue); }
+    };
+
+    const std::string sNameA(2000, 'a');
+    const std::string sNameB(2000, 'b');
+    const std::string sValue(100, 'v');
+
+    // two entries fill default table. third one takes name of oldest entry,
+    // evicts both and wraps over ring end, overwriting own name source.
+    std::string sBlock;
+    hpack::encode_int(sBlock, 0x40, 6, 0);
+    hpack::encode_string(sBlock, sNameA);
+    hpack::encode_string(sBlock, "");
+    hpack::encode_int(sBlock, 0x40, 6, 0);
+    hpack::encode_string(sBlock, sNameB);
+    hpack::encode_string(sBlock, "");
+    hpack::encode_int(sBlock, 0x40, 6, hpack::STATIC_TABLE.size() + 2);
+    hpack::encode_string(sBlock, sValue);
+    hpack::encode_int(sBlock, 0x80, 7, hpack::STATIC_TABLE.size() + 1);
+
+    Inflate  sInflate;
+    Headers  sHeaders;
+    Headers* sPtr = &sHeaders;
+    sInflate(sBlock, sPtr);
+
+    BOOST_REQUIRE_EQUAL(sHeaders.list.size(), 4);
+    BOOST_CHECK(sHeaders.list[2].first == sNameA);
+    BOOST_CHECK(sHeaders.list[2].second == sValue);
+    BOOST_CHECK(sHeaders.list[3].first == sNameA);
+    BOOST_CHECK(sHeaders.list[3].second == sValue);
+}
+BOOST_AUTO_TEST_CASE(hpack_table_size)
+{
+    using namespace asio_http::v2;
+    struct Headers
+    {
+        std::vector<std::pair<std::string, std::string>> list;
+        void set_header(std::string_view aName, std::string_view aValue) { list.emplace_back(aName, aValue); }
+    };
+
+    asio_http::Response sResponse;
+    sResponse.result(200);
+    sResponse.set("x-request-id", "0123456789abcdef");
+
+    Deflate     sDeflate;
+    Inflate     sInflate;
+    std::string sBlock;
+    sDeflate(sResponse, sBlock); // response header indexed
+
+    // peer settings: table shrinks to 0, then grows to 100. both sizes signaled in next block
+    sDeflate.resize(0);
+    sDeflate.resize(100);
+    std::string sUpdated;
+    sDeflate(sResponse, sUpdated);
+    BOOST_REQUIRE_GE(sUpdated.size(), 3);
+    BOOST_CHECK_EQUAL(uint8_t(sUpdated[0]), 0x20);
+    BOOST_CHECK_EQUAL(uint8_t(sUpdated[1]), 0x3F); // 31 + 69
+    BOOST_CHECK_EQUAL(uint8_t(sUpdated[2]), 69);
+
+    std::string sIndexed;
+    sDeflate(sResponse, sIndexed);
+    BOOST_CHECK_LT(sIndexed.size(), sUpdated.size() - 3);
+
+    for (auto& x : {sBlock, sUpdated, sIndexed}) {
+        Headers  sHeaders;
+        Headers* sPtr = &sHeaders;
+        sInflate(x, sPtr);
+        BOOST_REQUIRE_EQUAL(sHeaders.list.size(), 2);
+        BOOST_CHECK(sHeaders.list[1].first == "x-request-id");
+        BOOST_CHECK(sHeaders.list[1].second == "0123456789abcdef");
+    }
+}
 BOOST_AUTO_TEST_CASE(simple)
 {
     std::this_thread::sleep_for(100ms); // sleep to avoid possible adress already in use
@@ -153,6 +153,10 @@ namespace asio_http::v2 {
         {
             m_Output.process_window_update(aID, aInc);
         }
+        void setting(uint16_t aKey, uint32_t aValue) override
+        {
+            m_Output.process_setting(aKey, aValue);
+        }
         void send(std::string&& aBuffer) override
         {
             m_Output.send(std::move(aBuffer));
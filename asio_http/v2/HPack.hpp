@@ -1,65 +1,341 @@
 #pragma once
 
-#include <list>
-#include <memory>
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "Huffman.hpp"
 #include "Types.hpp"
 
 #include <container/Stream.hpp>
-#include <nghttp2/nghttp2.h>
-#include <parser/Atoi.hpp>
 #include <parser/Url.hpp>
-#include <string/String.hpp>
 
 namespace asio_http::v2 {
 
+    namespace hpack {
+
+        using Pair = std::pair<std::string_view, std::string_view>;
+
+        // RFC 7541, Appendix A. index 1 at position 0
+        inline constexpr std::array<Pair, 61> STATIC_TABLE = {{
+            {":authority", ""},
+            {":method", "GET"},
+            {":method", "POST"},
+            {":path", "/"},
+            {":path", "/index.html"},
+            {":scheme", "http"},
+            {":scheme", "https"},
+            {":status", "200"},
+            {":status", "204"},
+            {":status", "206"},
+            {":status", "304"},
+            {":status", "400"},
+            {":status", "404"},
+            {":status", "500"},
+            {"accept-charset", ""},
+            {"accept-encoding", "gzip, deflate"},
+            {"accept-language", ""},
+            {"accept-ranges", ""},
+            {"accept", ""},
+            {"access-control-allow-origin", ""},
+            {"age", ""},
+            {"allow", ""},
+            {"authorization", ""},
+            {"cache-control", ""},
+            {"content-disposition", ""},
+            {"content-encoding", ""},
+            {"content-language", ""},
+            {"content-length", ""},
+            {"content-location", ""},
+            {"content-range", ""},
+            {"content-type", ""},
+            {"cookie", ""},
+            {"date", ""},
+            {"etag", ""},
+            {"expect", ""},
+            {"expires", ""},
+            {"from", ""},
+            {"host", ""},
+            {"if-match", ""},
+            {"if-modified-since", ""},
+            {"if-none-match", ""},
+            {"if-range", ""},
+            {"if-unmodified-since", ""},
+            {"last-modified", ""},
+            {"link", ""},
+            {"location", ""},
+            {"max-forwards", ""},
+            {"proxy-authenticate", ""},
+            {"proxy-authorization", ""},
+            {"range", ""},
+            {"referer", ""},
+            {"refresh", ""},
+            {"retry-after", ""},
+            {"server", ""},
+            {"set-cookie", ""},
+            {"strict-transport-security", ""},
+            {"transfer-encoding", ""},
+            {"user-agent", ""},
+            {"vary", ""},
+            {"via", ""},
+            {"www-authenticate", ""},
+        }};
+
+        // first static index for every name
+        inline const std::unordered_map<std::string_view, uint8_t> STATIC_NAMES = []() {
+            std::unordered_map<std::string_view, uint8_t> sMap;
+            for (size_t i = 0; i < STATIC_TABLE.size(); i++)
+                sMap.emplace(STATIC_TABLE[i].first, i + 1);
+            return sMap;
+        }();
+
+        // dynamic table, name and value bytes stored in ring buffer.
+        // entry can wrap around ring end, so get() can use scratch buffer
+        class DynamicTable
+        {
+            struct Entry
+            {
+                uint32_t offset = 0;
+                uint32_t name   = 0; // name size
+                uint32_t value  = 0; // value size
+
+                size_t size() const { return name + value + 32; } // RFC 7541, 4.1
+            };
+
+            std::vector<char>  m_Data;
+            std::vector<Entry> m_Entries; // ring of entries
+            size_t             m_First = 0; // oldest entry in m_Entries
+            size_t             m_Count = 0;
+            size_t             m_Write = 0; // next write offset in m_Data
+            size_t             m_Size  = 0; // table size as defined by RFC
+            size_t             m_Limit = 0;
+            uint64_t           m_Added = 0; // total number of inserted entries
+            std::string        m_Scratch;   // copy of entry referencing own data
+
+            const Entry& at(size_t aIndex) const { return m_Entries[(m_First + m_Count - 1 - aIndex) % m_Entries.size()]; }
+
+            std::string_view read(size_t aOffset, size_t aSize, std::string& aScratch) const
+            {
+                aOffset %= m_Data.size();
+                if (aOffset + aSize <= m_Data.size())
+                    return std::string_view(m_Data.data() + aOffset, aSize);
+                const size_t sFirst = m_Data.size() - aOffset;
+                aScratch.assign(m_Data.data() + aOffset, sFirst);
+                aScratch.append(m_Data.data(), aSize - sFirst);
+                return aScratch;
+            }
+
+            bool inside(std::string_view aStr) const
+            {
+                const std::less<const char*> sLess;
+                return !sLess(aStr.data(), m_Data.data()) and sLess(aStr.data(), m_Data.data() + m_Data.size());
+            }
+
+            void write(std::string_view aStr)
+            {
+                while (!aStr.empty()) {
+                    const size_t sLen = std::min(aStr.size(), m_Data.size() - m_Write);
+                    memcpy(m_Data.data() + m_Write, aStr.data(), sLen);
+                    m_Write = (m_Write + sLen) % m_Data.size();
+                    aStr.remove_prefix(sLen);
+                }
+            }
+
+            void evict_until(size_t aSize)
+            {
+                while (m_Count > 0 and m_Size > aSize) {
+                    m_Size -= m_Entries[m_First].size();
+                    m_First = (m_First + 1) % m_Entries.size();
+                    m_Count--;
+                }
+            }
+
+        public:
+            DynamicTable(size_t aLimit = DEFAULT_HEADER_TABLE_SIZE)
+            : m_Data(aLimit)
+            , m_Entries(aLimit / 32)
+            , m_Limit(aLimit)
+            {}
+
+            size_t   count() const { return m_Count; }
+            uint64_t added() const { return m_Added; }
+
+            // dynamic table size update from peer, can not grow over initial size
+            void resize(size_t aLimit)
+            {
+                if (aLimit > m_Data.size())
+                    throw std::invalid_argument("hpack: table size update too large");
+                m_Limit = aLimit;
+                evict_until(m_Limit);
+            }
+
+            void insert(std::string_view aName, std::string_view aValue)
+            {
+                const size_t sSize = aName.size() + aValue.size() + 32;
+
+                // RFC 7541, 4.4: name can refer to entry evicted or overwritten by this insert
+                if (inside(aName) or inside(aValue)) {
+                    m_Scratch.assign(aName).append(aValue);
+                    aName  = std::string_view(m_Scratch).substr(0, aName.size());
+                    aValue = std::string_view(m_Scratch).substr(aName.size());
+                }
+
+                evict_until(m_Limit >= sSize ? m_Limit - sSize : 0);
+                m_Added++;
+                if (sSize > m_Limit) // RFC 7541, 4.4: table emptied, entry not added
+                    return;
+
+                Entry sEntry{(uint32_t)m_Write, (uint32_t)aName.size(), (uint32_t)aValue.size()};
+                write(aName);
+                write(aValue);
+                m_Entries[(m_First + m_Count) % m_Entries.size()] = sEntry;
+                m_Count++;
+                m_Size += sSize;
+            }
+
+            // 0 is newest entry
+            Pair get(size_t aIndex, std::string& aNameScratch, std::string& aValueScratch) const
+            {
+                if (aIndex >= m_Count)
+                    throw std::invalid_argument("hpack: invalid dynamic table index");
+                const Entry& sEntry = at(aIndex);
+                return {read(sEntry.offset, sEntry.name, aNameScratch),
+                        read(sEntry.offset + sEntry.name, sEntry.value, aValueScratch)};
+            }
+        };
+
+        inline void encode_int(std::string& aOut, uint8_t aPrefix, uint8_t aBits, uint64_t aValue)
+        {
+            const uint8_t sMax = (1 << aBits) - 1;
+            if (aValue < sMax) {
+                aOut.push_back(aPrefix | aValue);
+                return;
+            }
+            aOut.push_back(aPrefix | sMax);
+            aValue -= sMax;
+            while (aValue >= 128) {
+                aOut.push_back((aValue & 0x7F) | 0x80);
+                aValue >>= 7;
+            }
+            aOut.push_back(aValue);
+        }
+
+        inline uint64_t decode_int(std::string_view& aStr, uint8_t aBits)
+        {
+            if (aStr.empty())
+                throw std::invalid_argument("hpack: truncated integer");
+            const uint8_t sMax   = (1 << aBits) - 1;
+            uint64_t      sValue = (uint8_t)aStr.front() & sMax;
+            aStr.remove_prefix(1);
+            if (sValue < sMax)
+                return sValue;
+            for (unsigned sShift = 0; sShift < 63; sShift += 7) {
+                if (aStr.empty())
+                    throw std::invalid_argument("hpack: truncated integer");
+                const uint8_t c = aStr.front();
+                aStr.remove_prefix(1);
+                sValue += uint64_t(c & 0x7F) << sShift;
+                if (!(c & 0x80))
+                    return sValue;
+            }
+            throw std::invalid_argument("hpack: integer overflow");
+        }
+
+        // raw or huffman string, lowercased if requested
+        template <bool LOWER = false>
+        inline void encode_string(std::string& aOut, std::string_view aStr)
+        {
+            const size_t sHuffman = huffman_size<LOWER>(aStr);
+            if (sHuffman < aStr.size()) {
+                encode_int(aOut, 0x80, 7, sHuffman);
+                huffman_encode<LOWER>(aStr, aOut);
+            } else {
+                encode_int(aOut, 0, 7, aStr.size());
+                for (char c : aStr)
+                    aOut.push_back(huffman_char<LOWER>(c));
+            }
+        }
+    } // namespace hpack
+
+    // header block decoder. names and values passed to set_header as string_view:
+    // into frame data for raw literals, into table or scratch buffers otherwise.
     class Inflate
     {
-        using InflaterT = std::unique_ptr<nghttp2_hd_inflater, void (*)(nghttp2_hd_inflater*)>;
-        InflaterT m_Ptr;
+        hpack::DynamicTable m_Table;
+        std::string         m_Block;    // header block collected from HEADERS + CONTINUATION
+        std::string         m_Name;     // huffman decoded name or wrapped table entry
+        std::string         m_Value;    // same for value
+        std::string         m_Indexed;  // scratch for wrapped name of indexed literal
 
-        template <class T>
-        void collect(nghttp2_nv sHeader, T& aObject)
+        hpack::Pair indexed(size_t aIndex, std::string& aName, std::string& aValue) const
         {
-            std::string sName((const char*)sHeader.name, sHeader.namelen);
-            std::string sValue((const char*)sHeader.value, sHeader.valuelen);
-            aObject->set_header(sName, sValue);
+            if (aIndex == 0)
+                throw std::invalid_argument("hpack: zero index");
+            if (aIndex <= hpack::STATIC_TABLE.size())
+                return hpack::STATIC_TABLE[aIndex - 1];
+            return m_Table.get(aIndex - hpack::STATIC_TABLE.size() - 1, aName, aValue);
+        }
+
+        std::string_view string(std::string_view& aStr, std::string& aScratch)
+        {
+            if (aStr.empty())
+                throw std::invalid_argument("hpack: truncated string");
+            const bool     sHuffman = aStr.front() & 0x80;
+            const uint64_t sLen     = hpack::decode_int(aStr, 7);
+            if (sLen > aStr.size())
+                throw std::invalid_argument("hpack: truncated string");
+            std::string_view sResult = aStr.substr(0, sLen);
+            aStr.remove_prefix(sLen);
+            if (!sHuffman)
+                return sResult;
+            aScratch.clear();
+            if (!hpack::HuffmanDecoder::instance()(sResult, aScratch))
+                throw std::invalid_argument("hpack: invalid huffman string");
+            return aScratch;
+        }
+
+        // literal header field, prefix bits: 6 for incremental indexing, 4 otherwise
+        hpack::Pair literal(std::string_view& aStr, uint8_t aBits)
+        {
+            const uint64_t   sIndex = hpack::decode_int(aStr, aBits);
+            std::string_view sName;
+            if (sIndex == 0)
+                sName = string(aStr, m_Name);
+            else
+                sName = indexed(sIndex, m_Name, m_Indexed).first;
+            return {sName, string(aStr, m_Value)};
         }
 
     public:
         Inflate()
-        : m_Ptr([]() {
-            nghttp2_hd_inflater* sTmp = nullptr;
-            if (nghttp2_hd_inflate_new(&sTmp))
-                throw std::runtime_error("fail to initialize nghttp/inflater");
-            return InflaterT(sTmp, nghttp2_hd_inflate_del);
-        }())
         {
+            m_Name.reserve(256);
+            m_Value.reserve(1024);
         }
 
         template <class T>
         void operator()(std::string_view aStr, T& aObject)
         {
             while (!aStr.empty()) {
-                nghttp2_nv sHeader;
-                int        sFlags = 0;
-
-                int sUsed = nghttp2_hd_inflate_hd2(m_Ptr.get(),
-                                                   &sHeader,
-                                                   &sFlags,
-                                                   (const uint8_t*)aStr.data(),
-                                                   aStr.size(),
-                                                   sHeader.flags & Flags::END_HEADERS);
-
-                if (sUsed < 0)
-                    throw std::invalid_argument("fail to inflate headers");
-                aStr.remove_prefix(sUsed);
-                if (sFlags & NGHTTP2_HD_INFLATE_EMIT)
-                    collect(sHeader, aObject);
-                if (sFlags & NGHTTP2_HD_INFLATE_FINAL)
-                    nghttp2_hd_inflate_end_headers(m_Ptr.get());
+                const uint8_t c = aStr.front();
+                if (c & 0x80) { // indexed
+                    auto [sName, sValue] = indexed(hpack::decode_int(aStr, 7), m_Name, m_Value);
+                    aObject->set_header(sName, sValue);
+                } else if (c & 0x40) { // incremental indexing
+                    auto [sName, sValue] = literal(aStr, 6);
+                    aObject->set_header(sName, sValue);
+                    m_Table.insert(sName, sValue);
+                } else if (c & 0x20) { // table size update
+                    m_Table.resize(hpack::decode_int(aStr, 5));
+                } else { // without indexing or never indexed
+                    auto [sName, sValue] = literal(aStr, 4);
+                    aObject->set_header(sName, sValue);
+                }
             }
         }
 
@@ -69,100 +345,166 @@ namespace asio_http::v2 {
             Container::imemstream sData(aData);
 
             uint8_t sPadLength = 0;
-            if (aHeader.flags & Flags::PADDED)
-                sData.read(sPadLength);
-            if (aHeader.flags & Flags::PRIORITY) {
-                sData.skip(4 + 1); // stream id + prio
+            if (aHeader.type == Type::HEADERS) {
+                if (aHeader.flags & Flags::PADDED)
+                    sData.read(sPadLength);
+                if (aHeader.flags & Flags::PRIORITY)
+                    sData.skip(4 + 1); // stream id + prio
             }
             std::string_view sRest = sData.rest();
+            if (sPadLength > sRest.size())
+                throw std::invalid_argument("hpack: invalid padding");
             sRest.remove_suffix(sPadLength);
+
+            // header block fragment can split field representation, collect it all
+            if (!(aHeader.flags & Flags::END_HEADERS) or !m_Block.empty()) {
+                m_Block.append(sRest);
+                if (!(aHeader.flags & Flags::END_HEADERS))
+                    return;
+                operator()(std::string_view(m_Block), aObject);
+                m_Block.clear();
+                return;
+            }
             operator()(sRest, aObject);
         }
     };
 
+    // header block encoder, appends directly to frame buffer.
+    // static table used for exact and name matches, dynamic table for repeated pairs.
     class Deflate
     {
-        using DeflaterT = std::unique_ptr<nghttp2_hd_deflater, void (*)(nghttp2_hd_deflater*)>;
-        DeflaterT m_Deflate;
+        hpack::DynamicTable                       m_Table;
+        std::unordered_map<std::string, uint64_t> m_Index; // name + '\0' + value -> insertion number
+        std::string                               m_Key;
+        std::string                               m_Lower;
+        size_t                                    m_Limit = DEFAULT_HEADER_TABLE_SIZE;
+        std::optional<size_t>                     m_Smallest; // pending table size update
 
-        std::string deflate(const std::vector<nghttp2_nv>& aPairs)
+        // values changing on every message are not worth indexing
+        static bool indexable(std::string_view aName, std::string_view aValue)
         {
-            std::string sTmp;
-            size_t      sLength = nghttp2_hd_deflate_bound(m_Deflate.get(), aPairs.data(), aPairs.size());
-            sTmp.resize(sLength);
-            ssize_t sUsed = nghttp2_hd_deflate_hd(m_Deflate.get(),
-                                                  (uint8_t*)sTmp.data(),
-                                                  sLength,
-                                                  aPairs.data(),
-                                                  aPairs.size());
-            if (sUsed < 0)
-                throw std::runtime_error("fail to deflate headers");
-            sTmp.resize(sUsed);
-            return sTmp;
+            if (aName.size() + aValue.size() > 256)
+                return false;
+            return aName != ":path" and aName != "content-length" and aName != "date" and aName != "etag" and aName != "authorization" and aName != "cookie" and aName != "set-cookie" and aName != "last-modified";
         }
 
-        struct Pairs
+        // aName is lower case
+        void encode(std::string& aOut, std::string_view aName, std::string_view aValue)
         {
-            std::list<std::string>  m_Shadow;
-            std::vector<nghttp2_nv> m_Pairs;
+            // static table exact match
+            uint8_t sNameIndex = 0;
+            if (auto sIt = hpack::STATIC_NAMES.find(aName); sIt != hpack::STATIC_NAMES.end()) {
+                sNameIndex = sIt->second;
+                for (size_t i = sNameIndex - 1; i < hpack::STATIC_TABLE.size() and hpack::STATIC_TABLE[i].first == aName; i++) {
+                    if (hpack::STATIC_TABLE[i].second == aValue) {
+                        hpack::encode_int(aOut, 0x80, 7, i + 1);
+                        return;
+                    }
+                }
+            }
 
-            void assign_ref(boost::beast::string_view sName, boost::beast::string_view sValue)
-            {
-                nghttp2_nv sNV;
-                sNV.name     = (uint8_t*)sName.data();
-                sNV.namelen  = sName.size();
-                sNV.value    = (uint8_t*)sValue.data();
-                sNV.valuelen = sValue.size();
-                sNV.flags    = NGHTTP2_NV_FLAG_NONE;
-                m_Pairs.push_back(sNV);
+            if (!indexable(aName, aValue)) {
+                if (sNameIndex) {
+                    hpack::encode_int(aOut, 0x00, 4, sNameIndex);
+                } else {
+                    aOut.push_back(0x00);
+                    hpack::encode_string(aOut, aName);
+                }
+                hpack::encode_string(aOut, aValue);
+                return;
             }
 
-            void assign_lower(boost::beast::string_view sName, boost::beast::string_view sValue)
-            {
-                m_Shadow.push_back(std::string(sName));
-                String::tolower(m_Shadow.back());
-                assign_ref(m_Shadow.back(), sValue);
+            m_Key.assign(aName);
+            m_Key.push_back('\0');
+            m_Key.append(aValue);
+            if (auto sIt = m_Index.find(m_Key); sIt != m_Index.end()) {
+                const uint64_t sAge = m_Table.added() - 1 - sIt->second;
+                if (sAge < m_Table.count()) {
+                    hpack::encode_int(aOut, 0x80, 7, hpack::STATIC_TABLE.size() + 1 + sAge);
+                    return;
+                }
+                m_Index.erase(sIt); // evicted
             }
-        };
 
-    public:
-        Deflate()
-        : m_Deflate([]() {
-            nghttp2_hd_deflater* sTmp = nullptr;
-            if (nghttp2_hd_deflate_new(&sTmp, DEFAULT_HEADER_TABLE_SIZE))
-                throw std::runtime_error("fail to initialize nghttp/deflater");
-            return DeflaterT(sTmp, nghttp2_hd_deflate_del);
-        }())
+            if (sNameIndex) {
+                hpack::encode_int(aOut, 0x40, 6, sNameIndex);
+            } else {
+                aOut.push_back(0x40);
+                hpack::encode_string(aOut, aName);
+            }
+            hpack::encode_string(aOut, aValue);
+            m_Table.insert(aName, aValue);
+            m_Index[m_Key] = m_Table.added() - 1;
+            if (m_Index.size() > m_Table.count() * 2)
+                vacuum();
+        }
+
+        void vacuum()
         {
+            for (auto sIt = m_Index.begin(); sIt != m_Index.end();) {
+                if (m_Table.added() - 1 - sIt->second >= m_Table.count())
+                    sIt = m_Index.erase(sIt);
+                else
+                    sIt++;
+            }
         }
 
-        std::string operator()(const ClientRequest& aRequest)
+        // RFC 7541, 4.2: smallest size since last header block, then final one
+        void update(std::string& aOut)
         {
-            Pairs sPairs;
+            if (!m_Smallest)
+                return;
+            if (*m_Smallest < m_Limit)
+                hpack::encode_int(aOut, 0x20, 5, *m_Smallest);
+            hpack::encode_int(aOut, 0x20, 5, m_Limit);
+            m_Smallest.reset();
+        }
 
-            sPairs.assign_ref(":method", http::to_string(aRequest.method));
-            const auto sParsed = Parser::url(aRequest.url);
-            sPairs.assign_ref(":path", sParsed.path);
-            sPairs.assign_ref(":scheme", "http");
-            sPairs.assign_ref(":authority", sParsed.host); // FIXME: add port
+        void encode_lower(std::string& aOut, std::string_view aName, std::string_view aValue)
+        {
+            m_Lower.assign(aName);
+            for (auto& c : m_Lower)
+                c = hpack::huffman_char<true>(c);
+            encode(aOut, m_Lower, aValue);
+        }
 
-            for (auto& x : aRequest.headers)
-                sPairs.assign_lower(x.first, x.second);
+        template <class T>
+        static std::string_view view(const T& aStr) { return std::string_view(aStr.data(), aStr.size()); }
 
-            return deflate(sPairs.m_Pairs);
+    public:
+        // SETTINGS_HEADER_TABLE_SIZE from peer. table never grows over default size
+        void resize(size_t aPeerLimit)
+        {
+            const size_t sLimit = std::min(aPeerLimit, DEFAULT_HEADER_TABLE_SIZE);
+            if (sLimit == m_Limit and !m_Smallest)
+                return;
+            m_Smallest = std::min(m_Smallest.value_or(sLimit), sLimit);
+            m_Limit    = sLimit;
+            m_Table.resize(sLimit);
         }
 
-        std::string operator()(const Response& aResponse)
+        void operator()(const ClientRequest& aRequest, std::string& aOut)
         {
-            Pairs sPairs;
+            update(aOut);
+            const auto sParsed = Parser::url(aRequest.url);
+            encode(aOut, ":method", view(http::to_string(aRequest.method)));
+            encode(aOut, ":path", sParsed.path);
+            encode(aOut, ":scheme", "http");
+            encode(aOut, ":authority", sParsed.host); // FIXME: add port
 
-            const std::string sStatus = std::to_string(aResponse.result_int());
-            sPairs.assign_ref(":status", sStatus);
+            for (auto& x : aRequest.headers)
+                encode_lower(aOut, x.first, x.second);
+        }
 
-            for (auto& x : aResponse)
-                sPairs.assign_lower(x.name_string(), x.value());
+        void operator()(const Response& aResponse, std::string& aOut)
+        {
+            update(aOut);
+            std::array<char, 8> sStatus;
+            const auto          sEnd = std::to_chars(sStatus.data(), sStatus.data() + sStatus.size(), aResponse.result_int()).ptr;
+            encode(aOut, ":status", std::string_view(sStatus.data(), sEnd - sStatus.data()));
 
-            return deflate(sPairs.m_Pairs);
+            for (auto& x : aResponse)
+                encode_lower(aOut, view(x.name_string()), view(x.value()));
         }
     };
-} // namespace asio_http::v2
\ No newline at end of file
+} // namespace asio_http::v2
@@ -3,6 +3,8 @@
 #include "HPack.hpp"
 #include "Types.hpp"
 
+#include <deque>
+
 #include <container/Stream.hpp>
 
 namespace asio_http::v2 {
@@ -14,15 +16,31 @@ namespace asio_http::v2 {
         asio::steady_timer m_Timer;
         Deflate            m_Deflate;
 
+        // DATA frames refer to response body kept in m_Info,
+        // other frames owns whole serialized frame in `data`
+        struct Frame
+        {
+            Header           header;
+            std::string      data;
+            std::string_view view;
+            uint32_t         stream = 0; // DATA frame
+        };
+        using Queue = std::deque<Frame>; // references are stable on push_back/pop_front
+
         // send queue for not accountable frames (or we have budget)
-        std::list<std::string> m_PriorityQueue;
-        std::list<std::string> m_WriteQueue;
+        Queue m_PriorityQueue;
+        Queue m_WriteQueue;
 
         // responses body to send
         struct Info
         {
             std::string body;
-            uint32_t    budget = DEFAULT_WINDOW_SIZE;
+            size_t      offset   = 0; // bytes enqueued as DATA frames
+            uint32_t    budget   = DEFAULT_WINDOW_SIZE;
+            uint32_t    inflight = 0; // frames in write queue, referencing body
+            bool        done     = false;
+
+            size_t pending() const { return body.size() - offset; }
         };
         std::map<uint32_t, Info> m_Info;
 
@@ -37,28 +55,39 @@ namespace asio_http::v2 {
 #ifdef CATAPULT_PROFILE
         std::optional<Profile::Catapult::Holder> m_LowBudget;
 #endif
-        void enqueue(uint32_t aStreamId, std::string_view aData, bool aLast)
+        void enqueue(uint32_t aStreamId, Info& aInfo, size_t aLen, bool aLast)
         {
-            while (!aData.empty()) {
-                const size_t sLen = std::min(aData.size(), DEFAULT_MAX_FRAME_SIZE);
-
-                Header sHeader;
-                sHeader.type = Type::DATA;
-                if (sLen == aData.size() and aLast)
-                    sHeader.flags = Flags::END_STREAM;
-                sHeader.stream = aStreamId;
-                sHeader.size   = sLen;
-                sHeader.to_net();
-
-                std::string sTmp;
-                sTmp.append((const char*)&sHeader, sizeof(sHeader));
-                sTmp.append(aData.substr(0, sLen));
-                m_WriteQueue.push_back(std::move(sTmp));
-
-                aData.remove_prefix(sLen);
+            std::string_view sData(aInfo.body.data() + aInfo.offset, aLen);
+            aInfo.offset += aLen;
+            while (!sData.empty()) {
+                const size_t sLen = std::min(sData.size(), DEFAULT_MAX_FRAME_SIZE);
+
+                Frame& sFrame      = m_WriteQueue.emplace_back();
+                sFrame.header.type = Type::DATA;
+                if (sLen == sData.size() and aLast)
+                    sFrame.header.flags = Flags::END_STREAM;
+                sFrame.header.stream = aStreamId;
+                sFrame.header.size   = sLen;
+                sFrame.header.to_net();
+                sFrame.view   = sData.substr(0, sLen);
+                sFrame.stream = aStreamId;
+                aInfo.inflight++;
+
+                sData.remove_prefix(sLen);
             }
         }
 
+        // DATA frame written, release body once all frames sent
+        void release(uint32_t aStreamId)
+        {
+            auto sIt = m_Info.find(aStreamId);
+            assert(sIt != m_Info.end());
+            auto& sInfo = sIt->second;
+            sInfo.inflight--;
+            if (sInfo.done and sInfo.inflight == 0)
+                m_Info.erase(sIt);
+        }
+
         void flush()
         {
             CATAPULT_COUNTER("output", "streams (before flush)", m_Info.size());
@@ -70,41 +99,42 @@ namespace asio_http::v2 {
             for (auto x = m_Info.begin(); x != m_Info.end();) {
                 auto& sStreamId = x->first;
                 auto& sData     = x->second;
-                auto& sBody     = sData.body;
 
-                if (sBody.size() == 0) { // no more data to send
-                    x = m_Info.erase(x);
+                if (sData.done or sData.pending() == 0) { // no more data to send
+                    if (sData.inflight == 0)
+                        x = m_Info.erase(x);
+                    else
+                        x++;
                     continue;
                 }
 
                 const size_t sLen = std::min({(size_t)m_Budget,
                                               (size_t)sData.budget,
-                                              sBody.size(),
+                                              sData.pending(),
                                               MAX_STREAM_EXCLUSIVE});
 
-                const bool sNoBudget = sLen < MIN_FRAME_SIZE and sBody.size() > sLen;
+                const bool sNoBudget = sLen < MIN_FRAME_SIZE and sData.pending() > sLen;
 
                 if (sNoBudget) {
-                    TRACE("low budget for stream " << sStreamId << " (" << sBody.size() << " bytes pending)"
+                    TRACE("low budget for stream " << sStreamId << " (" << sData.pending() << " bytes pending)"
                                                    << "(connection: " << m_Budget << ", stream: " << sData.budget << ")");
                     x++;
                     continue;
                 }
 
-                const bool sLast = sLen == sBody.size();
-                enqueue(sStreamId, std::string_view(sBody.data(), sLen), sLast);
+                const bool sLast = sLen == sData.pending();
+                enqueue(sStreamId, sData, sLen, sLast);
                 m_Budget -= sLen;
+                sData.budget -= sLen;
                 TRACE("enqueue " << sLen << " bytes for stream " << sStreamId << ", connection budget: " << m_Budget);
 
                 if (sLast) {
                     TRACE("stream " << sStreamId << " done");
-                    x = m_Info.erase(x);
+                    sData.done = true;
                 } else {
-                    sData.budget -= sLen;
-                    sBody.erase(0, sLen);
-                    TRACE("stream " << sStreamId << " have " << sBody.size() << " bytes pending");
-                    x++;
+                    TRACE("stream " << sStreamId << " have " << sData.pending() << " bytes pending");
                 }
+                x++;
                 if (m_Budget < MIN_FRAME_SIZE) {
 #ifdef CATAPULT_PROFILE
                     // CATAPULT_EVENT("output", "low connection budget");
@@ -119,7 +149,7 @@ namespace asio_http::v2 {
             const size_t sWaitBytes = [this]() {
                 size_t sBytes = 0;
                 for (auto x = m_Info.begin(); x != m_Info.end(); x++) {
-                    sBytes += x->second.body.size();
+                    sBytes += x->second.pending();
                 }
                 return sBytes;
             }();
@@ -127,13 +157,38 @@ namespace asio_http::v2 {
 #endif
         }
 
+        // HEADERS frame, header block encoded in place after frame header
+        template <class T>
+        void enqueue_headers(uint32_t aStreamId, const T& aMessage, bool aEmpty)
+        {
+            Header sHeader;
+            sHeader.type   = Type::HEADERS;
+            sHeader.flags  = Flags::END_HEADERS;
+            sHeader.stream = aStreamId;
+            if (aEmpty)
+                sHeader.flags |= Flags::END_STREAM;
+
+            Frame& sFrame = m_WriteQueue.emplace_back();
+            sFrame.data.resize(sizeof(sHeader));
+            m_Deflate(aMessage, sFrame.data);
+            sHeader.size = sFrame.data.size() - sizeof(sHeader);
+            sHeader.to_net();
+            memcpy(sFrame.data.data(), &sHeader, sizeof(sHeader));
+        }
+
+        void start_body(uint32_t aStreamId, std::string&& aBody)
+        {
+            auto& sInfo = m_Info[aStreamId];
+            sInfo.body  = std::move(aBody);
+        }
+
     public:
         Output(beast::tcp_stream& aStream, asio::strand<asio::io_context::executor_type>& aStrand)
         : m_Stream(aStream)
         , m_Strand(aStrand)
         , m_Timer(m_Strand)
         {
-            m_Buffer.reserve(MAX_MERGE);
+            m_Buffer.reserve(MAX_MERGE * 2);
         }
 
         bool idle() const
@@ -156,33 +211,23 @@ namespace asio_http::v2 {
             m_Timer.cancel();
         }
 
+        void process_setting(uint16_t aKey, uint32_t aValue)
+        {
+            if (aKey == Setting::HEADER_TABLE_SIZE)
+                m_Deflate.resize(aValue);
+        }
+
         void send(std::string&& aBuffer)
         {
-            m_PriorityQueue.push_back(std::move(aBuffer));
+            m_PriorityQueue.emplace_back().data = std::move(aBuffer);
             m_Timer.cancel();
         }
 
         void enqueue(uint32_t aStreamId, Response& aResponse)
         {
-            Header sHeader;
-            sHeader.type   = Type::HEADERS;
-            sHeader.flags  = Flags::END_HEADERS;
-            sHeader.stream = aStreamId;
-            if (aResponse.body().empty())
-                sHeader.flags |= Flags::END_STREAM;
-            auto sDeflated = m_Deflate(aResponse);
-            sHeader.size   = sDeflated.size();
-            sHeader.to_net();
-
-            std::string sTmp;
-            sTmp.append((const char*)&sHeader, sizeof(sHeader));
-            sTmp.append(sDeflated);
-            m_WriteQueue.push_back(std::move(sTmp));
-
-            if (!aResponse.body().empty()) {
-                auto& sInfo = m_Info[aStreamId];
-                sInfo.body  = std::move(aResponse.body());
-            }
+            enqueue_headers(aStreamId, aResponse, aResponse.body().empty());
+            if (!aResponse.body().empty())
+                start_body(aStreamId, std::move(aResponse.body()));
 
             TRACE("queued response for stream " << aStreamId);
             CATAPULT_COUNTER("output", "streams (enqueue)", m_Info.size())
@@ -191,25 +236,9 @@ namespace asio_http::v2 {
 
         void enqueue(uint32_t aStreamId, ClientRequest& aRequest)
         {
-            Header sHeader;
-            sHeader.type   = Type::HEADERS;
-            sHeader.flags  = Flags::END_HEADERS;
-            sHeader.stream = aStreamId;
-            if (aRequest.body.empty())
-                sHeader.flags |= Flags::END_STREAM;
-            auto sDeflated = m_Deflate(aRequest);
-            sHeader.size   = sDeflated.size();
-            sHeader.to_net();
-
-            std::string sTmp;
-            sTmp.append((const char*)&sHeader, sizeof(sHeader));
-            sTmp.append(sDeflated);
-            m_WriteQueue.push_back(std::move(sTmp));
-
-            if (!aRequest.body.empty()) {
-                auto& sInfo = m_Info[aStreamId];
-                sInfo.body  = std::move(aRequest.body);
-            }
+            enqueue_headers(aStreamId, aRequest, aRequest.body.empty());
+            if (!aRequest.body.empty())
+                start_body(aStreamId, std::move(aRequest.body));
 
             TRACE("queued request for stream " << aStreamId);
             CATAPULT_COUNTER("output", "streams (enqueue)", m_Info.size())
@@ -220,22 +249,32 @@ namespace asio_http::v2 {
         {
             beast::error_code ec;
 
-            auto sWriteOut = [&](std::list<std::string>& aQueue) {
+            // scatter/gather write: frame header and payload from response body
+            auto sWriteOut = [&](Queue& aQueue) {
                 size_t sLength = 0;
                 size_t sCount  = 0;
                 for (auto sIt = aQueue.begin();
                      sIt != aQueue.end() and sCount < MAX_MERGE and sLength < MAX_STREAM_EXCLUSIVE;
                      sIt++, sCount++) {
-                    auto& sStr = *sIt;
-                    m_Buffer.push_back(asio::const_buffer(sStr.data(), sStr.size()));
-                    sLength += sStr.size();
+                    auto& sFrame = *sIt;
+                    if (sFrame.stream != 0) {
+                        m_Buffer.push_back(asio::const_buffer(&sFrame.header, sizeof(sFrame.header)));
+                        m_Buffer.push_back(asio::const_buffer(sFrame.view.data(), sFrame.view.size()));
+                        sLength += sizeof(sFrame.header) + sFrame.view.size();
+                    } else {
+                        m_Buffer.push_back(asio::const_buffer(sFrame.data.data(), sFrame.data.size()));
+                        sLength += sFrame.data.size();
+                    }
                 }
                 CATAPULT_EVENT("output", "write")
                 asio::async_write(m_Stream, m_Buffer, yield[ec]);
                 if (ec)
                     throw ec;
-                for (size_t i = 0; i < sCount; i++)
+                for (size_t i = 0; i < sCount; i++) {
+                    if (aQueue.front().stream != 0)
+                        release(aQueue.front().stream);
                     aQueue.pop_front();
+                }
                 m_Buffer.clear();
             };
 
@@ -261,4 +300,4 @@ namespace asio_http::v2 {
             }
         }
     };
-} // namespace asio_http::v2
\ No newline at end of file
+} // namespace asio_http::v2
@@ -6,12 +6,15 @@
 #include "InputBuf.hpp"
 #include "Types.hpp"
 
+#include <parser/Atoi.hpp>
+
 namespace asio_http::v2::parser {
 
     struct IMessage
     {
-        virtual void set_header(std::string& aName, std::string& aValue) = 0;
-        virtual void append_body(std::string& aBody)                     = 0;
+        // views are valid only during call
+        virtual void set_header(std::string_view aName, std::string_view aValue) = 0;
+        virtual void append_body(std::string_view aBody)                         = 0;
         virtual ~IMessage() {}
     };
     using MessagePtr = std::shared_ptr<IMessage>;
@@ -19,6 +22,7 @@ namespace asio_http::v2::parser {
     struct API
     {
         virtual void       established(){};
+        virtual void       setting(uint16_t aKey, uint32_t aValue){};
         virtual MessagePtr new_message(uint32_t aID)                            = 0;
         virtual void       process_message(uint32_t aID, MessagePtr&& aMessage) = 0;
         virtual void       window_update(uint32_t aID, uint32_t aInc)           = 0;
@@ -200,6 +204,7 @@ namespace asio_http::v2::parser {
                 sData.read(sVal);
                 sVal.to_host();
                 // TRACE(sVal.key << ": " << sVal.value);
+                m_API->setting(sVal.key, sVal.value);
             }
             send_settings(true);
         }
@@ -279,24 +284,29 @@ namespace asio_http::v2::parser {
 
     // link to asio
 
+    inline beast::string_view to_beast(std::string_view aStr)
+    {
+        return beast::string_view(aStr.data(), aStr.size());
+    }
+
     struct AsioRequest : IMessage
     {
         Request request;
 
-        virtual void set_header(std::string& aName, std::string& aValue) override
+        virtual void set_header(std::string_view aName, std::string_view aValue) override
         {
             if (aName == ":method")
-                request.method(http::string_to_verb(aValue));
+                request.method(http::string_to_verb(to_beast(aValue)));
             else if (aName == ":path")
-                request.target(aValue);
+                request.target(to_beast(aValue));
             else if (aName == ":authority")
-                request.set(http::field::host, aValue);
+                request.set(http::field::host, to_beast(aValue));
             else if (aName.size() > 1 and aName[0] == ':')
                 ;
             else
-                request.set(aName, aValue);
+                request.set(to_beast(aName), to_beast(aValue));
         }
-        virtual void append_body(std::string& aBody) override
+        virtual void append_body(std::string_view aBody) override
         {
             request.body().append(aBody);
         }
@@ -306,16 +316,16 @@ namespace asio_http::v2::parser {
     {
         Response response;
 
-        virtual void set_header(std::string& aName, std::string& aValue) override
+        virtual void set_header(std::string_view aName, std::string_view aValue) override
         {
             if (aName == ":status")
                 response.result(Parser::Atoi<unsigned>(aValue));
             else if (aName.size() > 1 and aName[0] == ':')
                 ;
             else
-                response.set(aName, aValue);
+                response.set(to_beast(aName), to_beast(aValue));
         }
-        virtual void append_body(std::string& aBody) override
+        virtual void append_body(std::string_view aBody) override
         {
             response.body().append(aBody);
         }
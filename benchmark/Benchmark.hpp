@@ -2,7 +2,13 @@
 
 #include <benchmark/benchmark.h>
 
+#include <atomic>
 #include <chrono>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <boost/asio/awaitable.hpp>
 #include <boost/asio/co_spawn.hpp>
@@ -10,10 +16,23 @@
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/steady_timer.hpp>
 
-#include <prometheus/Histogramm.hpp>
+#include "Hdr.hpp"
+
 #include <time/Meter.hpp>
 
 namespace Benchmark {
+
+    // counters for latency in ms (aLatency in ns), throughput and errors
+    inline void Report(benchmark::State& state, const std::string& aPrefix, const Hdr& aLatency, double aELA, uint64_t aCount, uint64_t aError, std::span<const double> aQuantiles)
+    {
+        char sName[32];
+        for (double x : aQuantiles) {
+            snprintf(sName, sizeof(sName), x > 0.99 and x < 1 ? "lat(%g)" : "lat(%.2f)", x);
+            state.counters[aPrefix + sName] = aLatency.quantile(x) / 1e6;
+        }
+        state.counters[aPrefix + "rps"] = aCount / aELA;
+        state.counters[aPrefix + "err"] = aError / aELA;
+    }
     template <class I, class H, class F>
     inline void Coro(benchmark::State& state, unsigned aCount, I aInit, H aHandler, F aFini)
     {
@@ -22,7 +41,7 @@ namespace Benchmark {
         uint32_t                sCount   = 0;
         uint32_t                sRunning = 0;
         uint32_t                sError   = 0;
-        Prometheus::Histogramm  sLatency;
+        Hdr                     sLatency;
 
         boost::asio::co_spawn(
             sAsio,
@@ -49,7 +68,7 @@ namespace Benchmark {
                         Time::Meter sMeter;
                         try {
                             co_await aHandler(aSerial);
-                            sLatency.tick(sMeter.get().to_ms());
+                            sLatency.record(sMeter.get().to_ns());
                             sCount++;
                         } catch (...) {
                             sError++;
@@ -65,14 +84,8 @@ namespace Benchmark {
 
         Time::Meter sMeter;
         sAsio.run();
-        const double                    sELA = sMeter.get().to_double();
-        constexpr std::array<double, 4> sProb{0.5, 0.99, 1.0};
-        const auto                      sResult = sLatency.quantile(sProb);
-        state.counters["rps"]                   = sCount / sELA;
-        state.counters["err"]                   = sError / sELA;
-        state.counters["lat(0.50)"]             = sResult[0];
-        state.counters["lat(0.99)"]             = sResult[1];
-        state.counters["lat(1.00)"]             = sResult[2];
+        const double sELA = sMeter.get().to_double();
+        Report(state, "", sLatency, sELA, sCount, sError, std::array{0.5, 0.99, 1.0});
     }
 
     class RateLimit
@@ -82,6 +95,7 @@ namespace Benchmark {
         const unsigned         m_Tick; // time to one request in us
         unsigned               m_Count = 0;
         Time::Meter            m_Meter;
+        Time::time_spec        m_Start = Time::time_spec::steady();
         std::unique_ptr<Timer> m_Timer;
 
     public:
@@ -93,6 +107,13 @@ namespace Benchmark {
             }
         }
 
+        // steady time current request should start, if load is on schedule.
+        // latency measured from here includes time request was delayed by slow ones (coordinated omission)
+        Time::time_spec due() const
+        {
+            return m_Start + Time::time_spec(0, long(m_Count - 1) * m_Tick * 1000);
+        }
+
         template <class T>
         boost::asio::awaitable<void> operator()(T&& aHandler)
         {
@@ -108,12 +129,13 @@ namespace Benchmark {
                 if (!m_Timer) {
                     m_Timer = std::make_unique<Timer>(co_await boost::asio::this_coro::executor);
                 }
-                m_Timer->expires_from_now(std::chrono::microseconds(m_Tick));
+                m_Timer->expires_from_now(std::chrono::microseconds(m_Count * m_Tick - sELA)); // until next one due
                 co_await m_Timer->async_wait(boost::asio::use_awaitable);
             }
             if (sELA >= 1'000'000) {
                 m_Count = 0;
                 m_Meter.reset();
+                m_Start = Time::time_spec::steady();
             }
             if (sPtr) {
                 std::rethrow_exception(sPtr);
@@ -137,7 +159,7 @@ namespace Benchmark {
         std::atomic_bool        sExit{false};
         unsigned                sReadCount = 0;
         unsigned                sReadError = 0;
-        Prometheus::Histogramm  sReadLatency;
+        Hdr                     sReadLatency;
 
         for (unsigned i = 0; i < aConfig.COUNT; i++) {
             boost::asio::co_spawn(
@@ -147,9 +169,8 @@ namespace Benchmark {
                     while (!sExit) {
                         try {
                             co_await sLimit([&]() -> boost::asio::awaitable<void> {
-                                Time::Meter sMeter;
                                 co_await aReadOp();
-                                sReadLatency.tick(sMeter.get().to_ms());
+                                sReadLatency.record(std::max<int64_t>(0, Time::time_spec::steady().to_ns() - sLimit.due().to_ns()));
                                 sReadCount++;
                             });
                         } catch (...) {
@@ -162,7 +183,7 @@ namespace Benchmark {
 
         unsigned               sWriteCount = 0;
         unsigned               sWriteError = 0;
-        Prometheus::Histogramm sWriteLatency;
+        Hdr                    sWriteLatency;
         for (unsigned i = 0; i < aConfig.COUNT; i++) {
             boost::asio::co_spawn(
                 sAsio,
@@ -171,9 +192,8 @@ namespace Benchmark {
                     while (!sExit) {
                         try {
                             co_await sLimit([&]() -> boost::asio::awaitable<void> {
-                                Time::Meter sMeter;
                                 co_await aWriteOp();
-                                sWriteLatency.tick(sMeter.get().to_ms());
+                                sWriteLatency.record(std::max<int64_t>(0, Time::time_spec::steady().to_ns() - sLimit.due().to_ns()));
                                 sWriteCount++;
                             });
                         } catch (...) {
@@ -202,20 +222,120 @@ namespace Benchmark {
         const double sELA = sMeter.get().to_double();
 
         constexpr std::array<double, 3> sProb{0.5, 0.99, 1.0};
+        Report(state, "r:", sReadLatency, sELA, sReadCount, sReadError, sProb);
+        Report(state, "w:", sWriteLatency, sELA, sWriteCount, sWriteError, sProb);
+    }
+
+    struct OpenConfig
+    {
+        double                    rps          = 1000;  // target rate, all threads together
+        unsigned                  threads      = 1;     // io_service threads
+        bool                      poisson      = false; // exponential intervals between requests, constant rate otherwise
+        unsigned                  max_inflight = 10000; // per thread, requests over limit not started and counted as errors
+        std::chrono::milliseconds window{10};           // run time per benchmark iteration
+    };
+
+    // open loop load: requests started by schedule, not when previous one finished.
+    // latency measured from scheduled start, so stall of server or of generator itself
+    // counted for all requests which should be sent during stall (no coordinated omission).
+    // aHandler(serial) called from aConfig.threads threads at same time.
+    // counters: lat(q) from schedule, svc(q) - service time from actual start, ms
+    template <class H>
+    inline void Open(benchmark::State& state, const OpenConfig& aConfig, H aHandler)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct Worker
         {
-            auto sResult                  = sReadLatency.quantile(sProb);
-            state.counters["r:lat(0.50)"] = sResult[0];
-            state.counters["r:lat(0.99)"] = sResult[1];
-            state.counters["r:lat(1.00)"] = sResult[2];
-            state.counters["r:rps"]       = sReadCount / sELA;
-            state.counters["r:err"]       = sReadError / sELA;
-            sResult                       = sWriteLatency.quantile(sProb);
-            state.counters["w:lat(0.50)"] = sResult[0];
-            state.counters["w:lat(0.99)"] = sResult[1];
-            state.counters["w:lat(1.00)"] = sResult[2];
-            state.counters["w:rps"]       = sWriteCount / sELA;
-            state.counters["w:err"]       = sWriteError / sELA;
+            boost::asio::io_service asio;
+            Hdr                     latency;
+            Hdr                     service;
+            uint64_t                count    = 0;
+            uint64_t                error    = 0;
+            unsigned                inflight = 0;
+        };
+
+        const unsigned                       sThreads = std::max(1u, aConfig.threads);
+        const double                         sRate    = aConfig.rps / sThreads; // per thread
+        const auto                           sStart   = Clock::now();
+        std::atomic_bool                     sExit{false};
+        std::vector<std::unique_ptr<Worker>> sWorkers;
+
+        for (unsigned t = 0; t < sThreads; t++) {
+            auto& sWorker = *sWorkers.emplace_back(std::make_unique<Worker>());
+            boost::asio::co_spawn(
+                sWorker.asio,
+                [&, t]() -> boost::asio::awaitable<void> {
+                    std::mt19937_64                     sRandom(t);
+                    std::exponential_distribution<>     sPoisson(sRate);
+                    boost::asio::steady_timer           sTimer(sWorker.asio);
+                    const std::chrono::duration<double> sTick(1.0 / sRate);
+
+                    // threads shifted, to spread constant rate evenly
+                    auto sNext = sStart + std::chrono::duration_cast<Clock::duration>(sTick * t / sThreads);
+                    for (uint64_t i = 0; !sExit; i++) {
+                        sNext += std::chrono::duration_cast<Clock::duration>(aConfig.poisson ? std::chrono::duration<double>(sPoisson(sRandom)) : sTick);
+                        if (sNext > Clock::now()) {
+                            sTimer.expires_at(sNext);
+                            co_await sTimer.async_wait(boost::asio::use_awaitable);
+                        }
+                        if (sWorker.inflight >= aConfig.max_inflight) {
+                            sWorker.error++;
+                            continue;
+                        }
+                        sWorker.inflight++;
+                        boost::asio::co_spawn(
+                            sWorker.asio,
+                            [&, sDue = sNext, aSerial = i * sThreads + t]() -> boost::asio::awaitable<void> {
+                                const auto sBegin = Clock::now();
+                                try {
+                                    co_await aHandler(aSerial);
+                                    const auto sNow = Clock::now();
+                                    sWorker.latency.record(std::chrono::nanoseconds(sNow - sDue).count());
+                                    sWorker.service.record(std::chrono::nanoseconds(sNow - sBegin).count());
+                                    sWorker.count++;
+                                } catch (...) {
+                                    sWorker.error++;
+                                }
+                                sWorker.inflight--;
+                            },
+                            boost::asio::detached);
+                    }
+                },
+                boost::asio::detached);
+        }
+
+        std::vector<std::thread> sPool;
+        for (auto& x : sWorkers)
+            sPool.emplace_back([&sAsio = x->asio]() { sAsio.run(); });
+
+        for (auto _ : state)
+            std::this_thread::sleep_for(aConfig.window);
+        sExit = true;
+        for (auto& x : sPool)
+            x.join(); // wait requests in flight
+        const double sELA = std::chrono::duration<double>(Clock::now() - sStart).count();
+
+        Hdr      sLatency;
+        Hdr      sService;
+        uint64_t sCount = 0;
+        uint64_t sError = 0;
+        for (auto& x : sWorkers) {
+            sLatency.merge(x->latency);
+            sService.merge(x->service);
+            sCount += x->count;
+            sError += x->error;
+        }
+
+        constexpr std::array<double, 6> sProb{0.5, 0.9, 0.99, 0.999, 0.9999, 1.0};
+        Report(state, "", sLatency, sELA, sCount, sError, sProb);
+        for (double x : {0.5, 0.99, 1.0}) {
+            char sName[32];
+            snprintf(sName, sizeof(sName), "svc(%.2f)", x);
+            state.counters[sName] = sService.quantile(x) / 1e6;
         }
+        state.counters["target"] = aConfig.rps;
+        state.SetItemsProcessed(sCount);
     }
 
 } // namespace Benchmark
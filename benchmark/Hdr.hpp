@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Benchmark {
+
+    // HDR histogram: values grouped by power of 2, every group split to SUB linear buckets.
+    // relative error below 1/SUB for any value, all values counted (no sampling),
+    // memory fixed, record is O(1). histograms from different threads can be merged.
+    class Hdr
+    {
+        static constexpr unsigned BITS = 8;
+        static constexpr uint64_t SUB  = 1 << BITS;
+
+        std::vector<uint64_t> m_Counts;
+        uint64_t              m_Total = 0;
+        uint64_t              m_Min   = std::numeric_limits<uint64_t>::max();
+        uint64_t              m_Max   = 0;
+        double                m_Sum   = 0;
+
+        static unsigned index(uint64_t aValue)
+        {
+            if (aValue < SUB)
+                return aValue;
+            const unsigned sShift = 63 - __builtin_clzll(aValue) - BITS;
+            return sShift * SUB + (aValue >> sShift);
+        }
+
+        // highest value with same index
+        static uint64_t highest(unsigned aIndex)
+        {
+            if (aIndex < SUB)
+                return aIndex;
+            const unsigned sShift = aIndex / SUB - 1;
+            const uint64_t sBase  = aIndex - sShift * SUB;
+            return ((sBase + 1) << sShift) - 1;
+        }
+
+    public:
+        Hdr()
+        : m_Counts((65 - BITS) * SUB)
+        {}
+
+        void record(uint64_t aValue, uint64_t aCount = 1)
+        {
+            m_Counts[index(aValue)] += aCount;
+            m_Total += aCount;
+            m_Min = std::min(m_Min, aValue);
+            m_Max = std::max(m_Max, aValue);
+            m_Sum += double(aValue) * aCount;
+        }
+
+        void merge(const Hdr& aOther)
+        {
+            for (size_t i = 0; i < m_Counts.size(); i++)
+                m_Counts[i] += aOther.m_Counts[i];
+            m_Total += aOther.m_Total;
+            m_Min = std::min(m_Min, aOther.m_Min);
+            m_Max = std::max(m_Max, aOther.m_Max);
+            m_Sum += aOther.m_Sum;
+        }
+
+        uint64_t count() const { return m_Total; }
+        uint64_t min() const { return m_Total ? m_Min : 0; }
+        uint64_t max() const { return m_Max; }
+        double   mean() const { return m_Total ? m_Sum / m_Total : 0; }
+
+        // value at quantile aPhi (0..1)
+        uint64_t quantile(double aPhi) const
+        {
+            if (m_Total == 0)
+                return 0;
+            if (aPhi >= 1)
+                return m_Max;
+            const uint64_t sRank = std::max<uint64_t>(1, aPhi * m_Total + 0.5);
+            uint64_t       sSum  = 0;
+            for (size_t i = 0; i < m_Counts.size(); i++) {
+                sSum += m_Counts[i];
+                if (sSum >= sRank)
+                    return std::clamp(highest(i), min(), m_Max);
+            }
+            return m_Max;
+        }
+
+        template <class P>
+        auto quantile(const P& aParam) const -> P
+        {
+            P sResult{};
+            for (unsigned i = 0; i < aParam.size(); i++)
+                sResult[i] = quantile(aParam[i]);
+            return sResult;
+        }
+
+        void clear()
+        {
+            std::fill(m_Counts.begin(), m_Counts.end(), 0);
+            m_Total = 0;
+            m_Min   = std::numeric_limits<uint64_t>::max();
+            m_Max   = 0;
+            m_Sum   = 0;
+        }
+    };
+
+} // namespace Benchmark
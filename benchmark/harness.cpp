@@ -0,0 +1,59 @@
+#include <mutex>
+
+#include <benchmark/Benchmark.hpp>
+
+// model of server: one worker, fixed service time, and 20ms stall every second (like gc pause).
+// closed loop sends nothing while server stalled, so only one request sees stall.
+// open loop keeps sending, and latency of all requests queued during stall counted.
+class Server
+{
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr auto SERVICE = std::chrono::microseconds(100);
+    static constexpr auto PERIOD  = std::chrono::seconds(1);
+    static constexpr auto STALL   = std::chrono::milliseconds(20);
+
+    std::mutex              m_Mutex;
+    const Clock::time_point m_Start = Clock::now();
+    Clock::time_point       m_Free  = m_Start;
+
+    // time request accepted now will be completed
+    Clock::time_point schedule()
+    {
+        std::unique_lock sLock(m_Mutex);
+        auto             sBegin = std::max(Clock::now(), m_Free);
+        const auto       sPhase = (sBegin - m_Start) % PERIOD;
+        if (sPhase < STALL)
+            sBegin += STALL - sPhase;
+        m_Free = sBegin + SERVICE;
+        return m_Free;
+    }
+
+public:
+    boost::asio::awaitable<void> call()
+    {
+        boost::asio::steady_timer sTimer(co_await boost::asio::this_coro::executor);
+        sTimer.expires_at(schedule());
+        co_await sTimer.async_wait(boost::asio::use_awaitable);
+    }
+};
+
+static void BM_Closed(benchmark::State& state)
+{
+    Server sServer;
+    auto   sNothing = []() -> boost::asio::awaitable<void> { co_return; };
+    Benchmark::Coro(
+        state, 1, sNothing, [&](auto) { return sServer.call(); }, sNothing);
+}
+BENCHMARK(BM_Closed)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_Open(benchmark::State& state)
+{
+    Server sServer;
+    Benchmark::Open(state, {.rps = double(state.range(0)), .threads = 2, .poisson = bool(state.range(1))}, [&](auto) {
+        return sServer.call();
+    });
+}
+BENCHMARK(BM_Open)->UseRealTime()->Args({1000, 0})->Args({1000, 1})->Args({5000, 0})->Args({5000, 1})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
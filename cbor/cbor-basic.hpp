@@ -5,24 +5,24 @@
 namespace cbor {
 
     // unsigned int
-    template <class T>
+    template <Input S, class T>
     typename std::enable_if<std::is_unsigned<T>::value, void>::type
-    read(istream& s, T& val)
+    read(S& s, T& val)
     {
         val = get_uint<T>(s, ensure_type(s, CBOR_UINT));
     }
 
-    template <class T>
+    template <Output S, class T>
     typename std::enable_if<std::is_unsigned<T>::value, void>::type
-    write(ostream& out, T value)
+    write(S& out, T value)
     {
         write_type_value(out, CBOR_UINT, value);
     }
 
     // signed int
-    template <class T>
+    template <Input S, class T>
     typename std::enable_if<std::is_signed<T>::value, void>::type
-    read(istream& s, T& val)
+    read(S& s, T& val)
     {
         const auto t = get_type(s);
         switch (t.major) {
@@ -32,9 +32,9 @@ namespace cbor {
         }
     }
 
-    template <class T>
+    template <Output S, class T>
     typename std::enable_if<std::is_signed<T>::value, void>::type
-    write(ostream& out, T value)
+    write(S& out, T value)
     {
         if (value < 0) {
             write_type_value(out, CBOR_NINT, (uint64_t) - (value + 1));
@@ -44,7 +44,8 @@ namespace cbor {
     }
 
     // float
-    inline void read(istream& s, float& v)
+    template <Input S>
+    void read(S& s, float& v)
     {
         auto minorType = ensure_type(s, CBOR_X);
         if (minorType == CBOR_FLOAT) {
@@ -61,7 +62,8 @@ namespace cbor {
         throw std::invalid_argument("unexpected special: " + std::to_string(minorType));
     }
 
-    inline void write(ostream& out, float v)
+    template <Output S>
+    void write(S& out, float v)
     {
         write_special(out, CBOR_FLOAT);
         union
@@ -75,7 +77,8 @@ namespace cbor {
     }
 
     // double
-    inline void read(istream& s, double& v)
+    template <Input S>
+    void read(S& s, double& v)
     {
         auto minorType = ensure_type(s, CBOR_X);
         if (minorType == CBOR_DOUBLE) {
@@ -92,7 +95,8 @@ namespace cbor {
         throw std::invalid_argument("unexpected special:" + std::to_string(minorType));
     }
 
-    inline void write(ostream& out, double v)
+    template <Output S>
+    void write(S& out, double v)
     {
         write_special(out, CBOR_DOUBLE);
         union
@@ -106,7 +110,8 @@ namespace cbor {
     }
 
     // bool
-    inline void read(istream& s, bool& v)
+    template <Input S>
+    void read(S& s, bool& v)
     {
         auto minorType = ensure_type(s, CBOR_X);
         switch (minorType) {
@@ -116,13 +121,15 @@ namespace cbor {
         }
     }
 
-    inline void write(ostream& out, bool v)
+    template <Output S>
+    void write(S& out, bool v)
     {
         write_special(out, v ? CBOR_TRUE : CBOR_FALSE);
     }
 
     // tag
-    inline bool read_tag(istream& s, uint64_t& tag)
+    template <Input S>
+    bool read_tag(S& s, uint64_t& tag)
     {
         TypeInfo info = {};
         s.read(&info, sizeof(info));
@@ -134,7 +141,8 @@ namespace cbor {
         return false;
     }
 
-    inline void write_tag(ostream& out, uint64_t tag)
+    template <Output S>
+    void write_tag(S& out, uint64_t tag)
     {
         write_type_value(out, CBOR_TAG, tag);
     }
@@ -6,11 +6,12 @@
 #include "cbor-internals.hpp"
 
 namespace cbor {
-    template <class T>
-    requires std::is_member_function_pointer_v<decltype(&T::cbor_read)>
-    void read(istream& in, T& t) { t.cbor_read(in); }
+    // cbor_read/cbor_write can be templates too, to use concrete stream type
+    template <Input S, class T>
+    requires requires(S& in, T& t) { t.cbor_read(in); }
+    void read(S& in, T& t) { t.cbor_read(in); }
 
-    template <class T>
-    requires std::is_member_function_pointer_v<decltype(&T::cbor_write)>
-    void write(ostream& out, const T& t) { t.cbor_write(out); }
+    template <Output S, class T>
+    requires requires(S& out, const T& t) { t.cbor_write(out); }
+    void write(S& out, const T& t) { t.cbor_write(out); }
 } // namespace cbor
\ No newline at end of file
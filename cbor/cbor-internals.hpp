@@ -3,9 +3,11 @@
 #include <string.h>
 
 #include <cassert>
+#include <concepts>
 #include <cstdint>
 #include <list>
 #include <map>
+#include <span>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -47,6 +49,87 @@ namespace cbor {
     using imemstream = Container::imemstream;
     using omemstream = Container::omemstream;
 
+    // read/write functions are templates over stream type. with final
+    // ispan/obuffer all stream calls are resolved statically and inlined.
+    template <class S>
+    concept Input = std::derived_from<S, istream>;
+    template <class S>
+    concept Output = std::derived_from<S, ostream>;
+
+    // input over contiguous buffer. strings can be read as string_view into buffer
+    class ispan final : public File::IMemReader
+    {
+        const char* m_Begin;
+        const char* m_Ptr;
+        const char* m_End;
+
+        [[noreturn, gnu::noinline, gnu::cold]] static void underflow() { throw EndOfBuffer(); }
+
+    public:
+        using EndOfBuffer = Container::imemstream::EndOfBuffer;
+
+        explicit ispan(std::span<const std::byte> aData)
+        : m_Begin((const char*)aData.data())
+        , m_Ptr(m_Begin)
+        , m_End(m_Begin + aData.size())
+        {
+        }
+        explicit ispan(std::string_view aData)
+        : ispan(std::as_bytes(std::span(aData.data(), aData.size())))
+        {
+        }
+
+        size_t available() const { return m_End - m_Ptr; }
+        size_t offset() const { return m_Ptr - m_Begin; }
+
+        // one bounds check for whole block
+        const char* take(size_t aSize)
+        {
+            if (aSize > available()) [[unlikely]]
+                underflow();
+            const char* sPtr = m_Ptr;
+            m_Ptr += aSize;
+            return sPtr;
+        }
+
+        std::string_view rest() { return substring(available()); }
+
+        size_t read(void* aBuffer, size_t aSize) override
+        {
+            memcpy(aBuffer, take(aSize), aSize);
+            return aSize;
+        }
+        void unget() override
+        {
+            if (m_Ptr == m_Begin)
+                underflow();
+            m_Ptr--;
+        }
+        std::string_view substring(size_t aSize) override { return std::string_view(take(aSize), aSize); }
+        bool             eof() override { return m_Ptr >= m_End; }
+        void             close() override {}
+    };
+
+    // output appended to external string, can be reused between messages
+    class obuffer final : public File::IWriter
+    {
+        std::string& m_Out;
+
+    public:
+        explicit obuffer(std::string& aOut)
+        : m_Out(aOut)
+        {
+        }
+
+        std::string& str() { return m_Out; }
+        void         put(uint8_t aByte) { m_Out.push_back(aByte); }
+
+        void write(const void* aData, size_t aSize) override { m_Out.append((const char*)aData, aSize); }
+        void flush() override {}
+        void sync() override {}
+        void close() override {}
+    };
+
     // IMPL DETAILS
 
     template <class T>
@@ -58,8 +141,8 @@ namespace cbor {
     template <class T>
     typename std::enable_if<sizeof(T) == 8, T>::type be2h(T val) { return be64toh(val); }
 
-    template <class T>
-    auto read_integer(istream& s)
+    template <class T, Input S>
+    auto read_integer(S& s)
     {
         T t;
         s.read(&t, sizeof(t));
@@ -67,8 +150,8 @@ namespace cbor {
         return t;
     }
 
-    template <class T = uint64_t>
-    T get_uint(istream& s, uint8_t minorType)
+    template <class T = uint64_t, Input S>
+    T get_uint(S& s, uint8_t minorType)
     {
         if (minorType < CBOR_8)
             return minorType;
@@ -83,13 +166,24 @@ namespace cbor {
         throw std::invalid_argument("unexpected minor type: " + std::to_string(minorType));
     }
 
+    // every item takes at least one byte: reject impossible counts before allocation
+    template <Input S>
+    void check_count(S& s, size_t aCount)
+    {
+        if constexpr (std::is_same_v<S, ispan>) {
+            if (aCount > s.available())
+                throw ispan::EndOfBuffer();
+        }
+    }
+
     struct TypeInfo
     {
         uint8_t minor : 5; // size. (type & 31)
         uint8_t major : 3; // type. (type >> 5)
     };
 
-    inline TypeInfo get_type(istream& s)
+    template <Input S>
+    TypeInfo get_type(S& s)
     {
         TypeInfo info = {};
         while (1) {
@@ -103,7 +197,8 @@ namespace cbor {
         return info;
     }
 
-    inline uint8_t ensure_type(istream& s, uint8_t needType)
+    template <Input S>
+    uint8_t ensure_type(S& s, uint8_t needType)
     {
         TypeInfo t = get_type(s);
         if (t.major != needType)
@@ -111,36 +206,36 @@ namespace cbor {
         return t.minor;
     }
 
-    inline void write_type_value(ostream& out, uint8_t major_type, uint64_t value)
+    template <Output S>
+    void write_type_value(S& out, uint8_t major_type, uint64_t value)
     {
         major_type <<= 5;
         if (value < CBOR_8) {
             uint8_t sByte = major_type | value;
             out.write(&sByte, 1);
         } else if (value <= __UINT8_MAX__) {
-            uint8_t sByte = major_type | CBOR_8;
-            out.write(&sByte, 1);
-            sByte = value;
-            out.write(&sByte, 1);
+            const uint8_t sTmp[2] = {uint8_t(major_type | CBOR_8), uint8_t(value)};
+            out.write(sTmp, sizeof(sTmp));
         } else if (value <= __UINT16_MAX__) {
-            uint8_t sByte = major_type | CBOR_16;
-            out.write(&sByte, 1);
-            uint16_t tmp = htobe16((uint16_t)value);
-            out.write(&tmp, sizeof(tmp));
+            uint8_t        sTmp[3] = {uint8_t(major_type | CBOR_16)};
+            const uint16_t sValue  = htobe16((uint16_t)value);
+            memcpy(sTmp + 1, &sValue, sizeof(sValue));
+            out.write(sTmp, sizeof(sTmp));
         } else if (value <= __UINT32_MAX__) {
-            uint8_t sByte = major_type | CBOR_32;
-            out.write(&sByte, 1);
-            uint32_t tmp = htobe32((uint32_t)value);
-            out.write(&tmp, sizeof(tmp));
+            uint8_t        sTmp[5] = {uint8_t(major_type | CBOR_32)};
+            const uint32_t sValue  = htobe32((uint32_t)value);
+            memcpy(sTmp + 1, &sValue, sizeof(sValue));
+            out.write(sTmp, sizeof(sTmp));
         } else {
-            uint8_t sByte = major_type | CBOR_64;
-            out.write(&sByte, 1);
-            uint64_t tmp = htobe64(value);
-            out.write(&tmp, sizeof(tmp));
+            uint8_t        sTmp[9] = {uint8_t(major_type | CBOR_64)};
+            const uint64_t sValue  = htobe64(value);
+            memcpy(sTmp + 1, &sValue, sizeof(sValue));
+            out.write(sTmp, sizeof(sTmp));
         }
     }
 
-    inline void write_special(ostream& out, uint8_t special)
+    template <Output S>
+    void write_special(S& out, uint8_t special)
     {
         uint8_t sByte = (uint8_t)(CBOR_X << 5 | special);
         out.write(&sByte, 1);
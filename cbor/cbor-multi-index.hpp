@@ -6,8 +6,8 @@
 
 namespace cbor {
 
-    template <class T, class I, class A>
-    void read(istream& s, boost::multi_index_container<T, I, A>& t)
+    template <Input S, class T, class I, class A>
+    void read(S& s, boost::multi_index_container<T, I, A>& t)
     {
         size_t mt = get_uint(s, ensure_type(s, CBOR_LIST));
         t.clear();
@@ -18,8 +18,8 @@ namespace cbor {
         }
     }
 
-    template <class T, class I, class A>
-    void write(ostream& out, const boost::multi_index_container<T, I, A>& t)
+    template <Output S, class T, class I, class A>
+    void write(S& out, const boost::multi_index_container<T, I, A>& t)
     {
         write_type_value(out, CBOR_LIST, t.size());
         for (auto& x : t)
@@ -5,8 +5,8 @@
 
 namespace cbor {
 
-    template <class T>
-    void read(istream& s, std::optional<T>& t)
+    template <Input S, class T>
+    void read(S& s, std::optional<T>& t)
     {
         TypeInfo info = get_type(s);
         if (info.major == CBOR_X and info.minor == CBOR_NULL) {
@@ -18,8 +18,8 @@ namespace cbor {
         read(s, t.value());
     }
 
-    template <class T>
-    void write(ostream& out, const std::optional<T>& t)
+    template <Output S, class T>
+    void write(S& out, const std::optional<T>& t)
     {
         if (t.has_value())
             write(out, t.value());
@@ -1,10 +1,13 @@
 #pragma once
+#include <bit>
+
 #include "cbor-basic.hpp"
 
 namespace cbor {
 
     // string
-    inline void read(istream& s, std::string& str)
+    template <Input S>
+    void read(S& s, std::string& str)
     {
         size_t len = get_uint(s, ensure_type(s, CBOR_STR));
 #ifdef FUZZING_BUILD_MODE
@@ -15,7 +18,9 @@ namespace cbor {
         s.read(&str[0], len);
     }
 
-    inline void read(imemstream& s, std::string_view& str)
+    template <Input S>
+    requires std::derived_from<S, File::IMemReader>
+    void read(S& s, std::string_view& str)
     {
         size_t len = get_uint(s, ensure_type(s, CBOR_STR));
 #ifdef FUZZING_BUILD_MODE
@@ -25,13 +30,15 @@ namespace cbor {
         str = s.substring(len);
     }
 
-    inline void write(ostream& out, const std::string_view& str)
+    template <Output S>
+    void write(S& out, const std::string_view& str)
     {
         write_type_value(out, CBOR_STR, str.size());
         out.write(str.data(), str.size());
     }
 
-    inline void write(ostream& out, const char* str)
+    template <Output S>
+    void write(S& out, const char* str)
     {
         auto len = strlen(str);
         write_type_value(out, CBOR_STR, len);
@@ -39,8 +46,8 @@ namespace cbor {
     }
 
     // list
-    template <class T>
-    void read(istream& s, std::list<T>& l)
+    template <Input S, class T>
+    void read(S& s, std::list<T>& l)
     {
         size_t mt = get_uint(s, ensure_type(s, CBOR_LIST));
         l.clear();
@@ -50,8 +57,8 @@ namespace cbor {
         }
     }
 
-    template <class T>
-    void write(ostream& out, const std::list<T>& l)
+    template <Output S, class T>
+    void write(S& out, const std::list<T>& l)
     {
         write_type_value(out, CBOR_LIST, l.size());
         for (const auto& x : l) {
@@ -59,39 +66,116 @@ namespace cbor {
         }
     }
 
-    // vector
+    // vector of trivial types written as byte string, with RFC 8746 typed array tag
+    // for numbers. numbers can be also read from list.
+    template <class T>
+    constexpr bool is_typed_array = std::is_arithmetic_v<T> and !std::is_same_v<T, bool> and sizeof(T) <= 8;
+
+    template <class T>
+    constexpr uint64_t typed_array_tag()
+    {
+        // 0b010_f_s_e_ll: float, signed, little endian, log2 of size (float: of size / 2)
+        constexpr bool     sFloat  = std::is_floating_point_v<T>;
+        constexpr bool     sSigned = !sFloat and std::is_signed_v<T>;
+        constexpr bool     sLittle = sizeof(T) > 1 and std::endian::native == std::endian::little;
+        constexpr uint64_t sSize   = std::bit_width(sizeof(T)) - (sFloat ? 2 : 1);
+        return 0b01000000 | sFloat << 4 | sSigned << 3 | sLittle << 2 | sSize;
+    }
+
     template <class T>
+    T byteswap(T aValue)
+    {
+        using U = std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+        U sTmp;
+        memcpy(&sTmp, &aValue, sizeof(T));
+        if constexpr (sizeof(T) == 2)
+            sTmp = __builtin_bswap16(sTmp);
+        else if constexpr (sizeof(T) == 4)
+            sTmp = __builtin_bswap32(sTmp);
+        else
+            sTmp = __builtin_bswap64(sTmp);
+        memcpy(&aValue, &sTmp, sizeof(T));
+        return aValue;
+    }
+
+    template <Input S, class T>
     typename std::enable_if<std::is_trivial<T>::value, void>::type
-    read(istream& s, std::vector<T>& data)
+    read(S& s, std::vector<T>& data)
     {
-        size_t len = get_uint(s, ensure_type(s, CBOR_BINARY));
+        uint64_t sTag = 0;
+        TypeInfo info = {};
+        while (1) {
+            s.read(&info, sizeof(info));
+            if (info.major != CBOR_TAG)
+                break;
+            sTag = get_uint(s, info.minor);
+        }
         data.clear();
+
+        if constexpr (is_typed_array<T>) {
+            if (info.major == CBOR_LIST) {
+                size_t mt = get_uint(s, info.minor);
+                check_count(s, mt);
+#ifdef FUZZING_BUILD_MODE
+                if (mt > 1024 * 1024)
+                    throw std::bad_alloc();
+#endif
+                data.resize(mt);
+                for (auto& x : data)
+                    read(s, x);
+                return;
+            }
+        }
+        if (info.major != CBOR_BINARY)
+            throw std::invalid_argument("unexpected major type: " + std::to_string(info.major));
+
+        size_t len = get_uint(s, info.minor);
 #ifdef FUZZING_BUILD_MODE
         if (len / sizeof(T) > 1024 * 1024)
             throw std::bad_alloc();
 #endif
         if (len % sizeof(T) > 0)
             throw std::invalid_argument("read " + std::to_string(len) + " bytes to vector of " + std::to_string(sizeof(T)));
+        check_count(s, len);
+
+        bool sSwap = false;
+        if constexpr (is_typed_array<T>) {
+            constexpr uint64_t EXPECTED = typed_array_tag<T>();
+            constexpr uint64_t SWAPPED  = sizeof(T) > 1 ? EXPECTED ^ 0b100 : (std::is_signed_v<T> ? EXPECTED : 68); // other endian, or clamped uint8
+            if (sTag >= 64 and sTag <= 87) {
+                if (sTag != EXPECTED and sTag != SWAPPED)
+                    throw std::invalid_argument("unexpected typed array tag: " + std::to_string(sTag));
+                sSwap = sizeof(T) > 1 and sTag == SWAPPED;
+            }
+        }
         data.resize(len / sizeof(T));
         if (len > 0) {
             s.read(&data[0], len);
         }
+        if constexpr (is_typed_array<T> and sizeof(T) > 1) {
+            if (sSwap)
+                for (auto& x : data)
+                    x = byteswap(x);
+        }
     }
 
-    template <class T>
+    template <Output S, class T>
     typename std::enable_if<std::is_trivial<T>::value, void>::type
-    write(ostream& out, const std::vector<T>& data)
+    write(S& out, const std::vector<T>& data)
     {
+        if constexpr (is_typed_array<T>)
+            write_tag(out, typed_array_tag<T>());
         write_type_value(out, CBOR_BINARY, data.size() * sizeof(T));
         out.write(data.data(), data.size() * sizeof(T));
     }
 
-    template <class T>
+    template <Input S, class T>
     typename std::enable_if<!std::is_trivial<T>::value, void>::type
-    read(istream& s, std::vector<T>& l)
+    read(S& s, std::vector<T>& l)
     {
         size_t mt = get_uint(s, ensure_type(s, CBOR_LIST));
         l.clear();
+        check_count(s, mt);
 #ifdef FUZZING_BUILD_MODE
         if (mt > 1024 * 1024)
             throw std::bad_alloc();
@@ -103,9 +187,9 @@ namespace cbor {
         }
     }
 
-    template <class T>
+    template <Output S, class T>
     typename std::enable_if<!std::is_trivial<T>::value, void>::type
-    write(ostream& out, const std::vector<T>& l)
+    write(S& out, const std::vector<T>& l)
     {
         write_type_value(out, CBOR_LIST, l.size());
         for (const auto& x : l) {
@@ -114,8 +198,8 @@ namespace cbor {
     }
 
     // map
-    template <class K, class V>
-    void read(istream& s, std::map<K, V>& map)
+    template <Input S, class K, class V>
+    void read(S& s, std::map<K, V>& map)
     {
         size_t mt = get_uint(s, ensure_type(s, CBOR_MAP));
         map.clear();
@@ -128,8 +212,8 @@ namespace cbor {
         }
     }
 
-    template <class K, class V>
-    void write(ostream& out, const std::map<K, V>& map)
+    template <Output S, class K, class V>
+    void write(S& out, const std::map<K, V>& map)
     {
         write_type_value(out, CBOR_MAP, map.size());
         for (const auto& x : map) {
@@ -139,8 +223,8 @@ namespace cbor {
     }
 
     // unordered map
-    template <class K, class V>
-    void read(istream& s, std::unordered_map<K, V>& map)
+    template <Input S, class K, class V>
+    void read(S& s, std::unordered_map<K, V>& map)
     {
         size_t mt = get_uint(s, ensure_type(s, CBOR_MAP));
         map.clear();
@@ -153,8 +237,8 @@ namespace cbor {
         }
     }
 
-    template <class K, class V>
-    void write(ostream& out, const std::unordered_map<K, V>& map)
+    template <Output S, class K, class V>
+    void write(S& out, const std::unordered_map<K, V>& map)
     {
         write_type_value(out, CBOR_MAP, map.size());
         for (const auto& x : map) {
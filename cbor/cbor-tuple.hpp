@@ -14,7 +14,7 @@ namespace cbor {
     struct is_tuple<std::tuple<T...>> : std::true_type
     {};
 
-    template <class S, class T>
+    template <Input S, class T>
     typename std::enable_if<is_tuple<T>::value, void>::type
     read(S& in, T& t)
     {
@@ -29,9 +29,9 @@ namespace cbor {
             t);
     }
 
-    template <class T>
+    template <Output S, class T>
     typename std::enable_if<is_tuple<T>::value, void>::type
-    write(ostream& out, const T& t)
+    write(S& out, const T& t)
     {
         write_type_value(out, CBOR_LIST, std::tuple_size<T>::value);
         Mpl::for_each_element(
@@ -41,7 +41,7 @@ namespace cbor {
             t);
     }
 
-    template <class S, class... T>
+    template <Input S, class... T>
     typename std::enable_if<(sizeof...(T) > 1), void>::type
     read(S& in, T&... t)
     {
@@ -56,9 +56,9 @@ namespace cbor {
             t...);
     }
 
-    template <class... T>
+    template <Output S, class... T>
     typename std::enable_if<(sizeof...(T) > 1), void>::type
-    write(ostream& out, const T&... t)
+    write(S& out, const T&... t)
     {
         write_type_value(out, CBOR_LIST, sizeof...(t));
         Mpl::for_each_argument(
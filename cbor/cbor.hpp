@@ -14,15 +14,16 @@ namespace cbor {
     template <class... T>
     inline std::string to_string(const T&... t)
     {
-        cbor::omemstream sStream;
+        std::string   sResult;
+        cbor::obuffer sStream(sResult);
         cbor::write(sStream, t...);
-        return sStream.str();
+        return sResult;
     }
 
     template <class... T>
     inline void from_string(std::string_view aStr, T&... t)
     {
-        cbor::imemstream sStream(aStr);
+        cbor::ispan sStream(aStr);
         cbor::read(sStream, t...);
     }
 } // namespace cbor
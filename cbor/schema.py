@@ -21,7 +21,7 @@ def write_hpp(j, f):
         print (x["name"]+" = std::nullopt;", file=f)
     print ("}", file=f)
 
-    print ("void cbor_write(cbor::ostream& out) const {", file=f)
+    print ("template <class S> void cbor_write(S& out) const {", file=f)
     print ("size_t sCount = 0;", file=f)
     for x in j["fields"]:
         print ("if ("+x["name"]+") {sCount++;}", file=f)
@@ -34,7 +34,7 @@ def write_hpp(j, f):
         print ("}", file=f)
     print ("}", file=f)
 
-    print ("void cbor_read(cbor::istream& in) {", file=f)
+    print ("template <class S> void cbor_read(S& in) {", file=f)
     print ("size_t sCount = cbor::get_uint(in, cbor::ensure_type(in, cbor::CBOR_MAP));", file=f)
     print ("for (size_t i = 0; i < sCount; i++) {", file=f)
     print ("uint32_t sId = 0; cbor::read(in, sId);", file=f)
@@ -149,4 +149,61 @@ BOOST_AUTO_TEST_CASE(optional)
     cbor::read(in, sVal);
     BOOST_CHECK_EQUAL(false, sVal.has_value());
 }
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_CASE(span)
+{
+    std::string   buffer;
+    cbor::obuffer out(buffer);
+    cbor::write(out, 1, std::string("string"), std::optional<double>(), std::map<int, std::string>{{1, "one"}});
+
+    cbor::ispan                in(buffer);
+    int                        a;
+    std::string_view           b;
+    std::optional<double>      c = 1.0;
+    std::map<int, std::string> d;
+    cbor::read(in, a, b, c, d);
+    BOOST_CHECK_EQUAL(a, 1);
+    BOOST_CHECK_EQUAL(b, "string");
+    BOOST_CHECK(b.data() > buffer.data() and b.data() < buffer.data() + buffer.size()); // no copy
+    BOOST_CHECK(!c);
+    BOOST_CHECK_EQUAL(d[1], "one");
+    BOOST_CHECK(in.eof());
+
+    // truncated input
+    cbor::ispan truncated(std::string_view(buffer).substr(0, buffer.size() - 1));
+    BOOST_CHECK_THROW(cbor::read(truncated, a, b, c, d), cbor::ispan::EndOfBuffer);
+
+    // huge list size in small buffer
+    cbor::ispan            huge(std::string_view("\x9b\x00\x00\x00\x01\x00\x00\x00\x00", 9));
+    std::list<std::string> e;
+    BOOST_CHECK_THROW(cbor::read(huge, e), cbor::ispan::EndOfBuffer);
+}
+BOOST_AUTO_TEST_CASE(typed_array)
+{
+    const std::vector<int32_t> data = {1, -2, 300000, -400000};
+
+    // tag 78: int32, little endian
+    const std::string sBinary = cbor::to_string(data);
+    BOOST_CHECK_EQUAL(Format::to_hex(sBinary.substr(0, 4)), "d84e5001");
+
+    std::vector<int32_t> actual;
+    cbor::from_string(sBinary, actual);
+    BOOST_CHECK(data == actual);
+
+    // list of integers
+    cbor::from_string(cbor::to_string(std::list<int32_t>(data.begin(), data.end())), actual);
+    BOOST_CHECK(data == actual);
+
+    // big endian typed array (tag 74)
+    std::string sBig = "\xd8\x4a\x50";
+    for (auto x : data) {
+        const uint32_t sTmp = htobe32(x);
+        sBig.append((const char*)&sTmp, sizeof(sTmp));
+    }
+    cbor::from_string(sBig, actual);
+    BOOST_CHECK(data == actual);
+
+    // float32 array can not be read as double
+    std::vector<double> doubles;
+    BOOST_CHECK_THROW(cbor::from_string(cbor::to_string(std::vector<float>{1.0, 2.0}), doubles), std::invalid_argument);
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 #include <boost/lockfree/spsc_queue.hpp>
@@ -46,4 +49,65 @@ namespace Container
             m_Back = (m_Back + 1) % m_Max;
         }
     };
+
+    // bounded multiple producers, single consumer queue (Dmitry Vyukov design).
+    // data stays in cell after pop, so producer can swap own buffer with old one and reuse capacity.
+    template<class T>
+    class MPSC_Ring {
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T data;
+        };
+        const size_t m_Mask;
+        std::unique_ptr<Cell[]> m_Cells;
+        alignas(64) std::atomic<size_t> m_Head{0}; // producers
+        alignas(64) size_t m_Tail = 0;             // consumer
+
+    public:
+
+        MPSC_Ring(size_t aSize)
+        : m_Mask(aSize - 1)
+        , m_Cells(new Cell[aSize])
+        {
+            if (aSize < 2 or (aSize & m_Mask) != 0)
+                throw std::invalid_argument("MPSC_Ring: size must be power of 2");
+            for (size_t i = 0; i < aSize; i++)
+                m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        // aWriter(T&) called for free cell. false if queue is full
+        template<class F>
+        bool push(F&& aWriter)
+        {
+            size_t sPos = m_Head.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& sCell = m_Cells[sPos & m_Mask];
+                const intptr_t sDiff = intptr_t(sCell.sequence.load(std::memory_order_acquire)) - intptr_t(sPos);
+                if (sDiff == 0) {
+                    if (m_Head.compare_exchange_weak(sPos, sPos + 1, std::memory_order_relaxed)) {
+                        aWriter(sCell.data);
+                        sCell.sequence.store(sPos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (sDiff < 0) {
+                    return false;
+                } else {
+                    sPos = m_Head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // aReader(T&) called for oldest element. false if queue is empty
+        template<class F>
+        bool pop(F&& aReader)
+        {
+            Cell& sCell = m_Cells[m_Tail & m_Mask];
+            if (sCell.sequence.load(std::memory_order_acquire) != m_Tail + 1)
+                return false;
+            aReader(sCell.data);
+            sCell.sequence.store(m_Tail + m_Mask + 1, std::memory_order_release);
+            m_Tail++;
+            return true;
+        }
+    };
 }
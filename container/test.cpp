@@ -11,6 +11,7 @@
 #include "RequestQueue.hpp"
 #include "Session.hpp"
 #include "Collect.hpp"
+#include "Lockfree.hpp"
 
 using namespace std::chrono_literals;
 
@@ -149,4 +150,44 @@ BOOST_AUTO_TEST_CASE(collect)
     BOOST_CHECK_EQUAL(c.size(), 0);
     BOOST_CHECK_EQUAL(c.idle(), true);
 }
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_CASE(mpsc_ring)
+{
+    Container::MPSC_Ring<std::vector<unsigned>> sRing(8);
+    BOOST_CHECK_THROW(Container::MPSC_Ring<int>(6), std::invalid_argument);
+    BOOST_CHECK_EQUAL(sRing.pop([](auto&) {}), false);
+
+    const unsigned        THREADS = 4;
+    const unsigned        COUNT   = 10000;
+    std::vector<unsigned> sLast(THREADS, 0);
+    std::atomic<unsigned> sDone{0};
+
+    std::vector<std::thread> sThreads;
+    for (unsigned t = 0; t < THREADS; t++)
+        sThreads.emplace_back([&, t]() {
+            std::vector<unsigned> sBuffer;
+            for (unsigned i = 1; i <= COUNT; i++) {
+                sBuffer.assign({t, i});
+                while (!sRing.push([&](auto& aCell) { std::swap(aCell, sBuffer); }))
+                    std::this_thread::yield();
+            }
+            sDone++;
+        });
+
+    unsigned sCount = 0;
+    while (sCount < THREADS * COUNT) {
+        if (!sRing.pop([&](auto& aCell) {
+                // per producer order kept
+                BOOST_REQUIRE_EQUAL(aCell.size(), 2);
+                BOOST_REQUIRE_EQUAL(aCell[1], sLast[aCell[0]] + 1);
+                sLast[aCell[0]] = aCell[1];
+            }))
+            std::this_thread::yield();
+        else
+            sCount++;
+    }
+    for (auto& x : sThreads)
+        x.join();
+    BOOST_CHECK_EQUAL(sDone, THREADS);
+    BOOST_CHECK_EQUAL(sRing.pop([](auto&) {}), false);
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -108,13 +108,11 @@ namespace Curl {
             operator()(Client::Request{.url = aURL}, std::move(aCallback));
         }
 
+        // multi handle is not thread safe: request started from loop thread
         void operator()(const Client::Request& aReq, CB&& aCallback)
         {
-            if (activeCount() < m_Params.max_connections and m_Waiting.empty()) {
-                startRequest(Request(aReq, std::move(aCallback)));
-            } else {
-                m_Waiting.insert(Request(aReq, std::move(aCallback)), m_Params.queue_timeout_ms);
-            }
+            m_Waiting.insert(Request(aReq, std::move(aCallback)), m_Params.queue_timeout_ms);
+            curl_multi_wakeup(m_Handle);
         }
 
         void start(Threads::Group& tg)
@@ -125,7 +123,8 @@ namespace Curl {
                 while (!m_Stopping) {
                     const uint64_t sTimeout = m_Waiting.eta(100);
                     // naive: no epoll, no errors
-                    curl_multi_wait(m_Handle, 0, 0, sTimeout, 0);
+                    curl_multi_poll(m_Handle, 0, 0, sTimeout, 0);
+                    startWaiting();
                     curl_multi_perform(m_Handle, &transfers);
                     while (auto x = curl_multi_info_read(m_Handle, &queue)) {
                         if (x->msg == CURLMSG_DONE)
@@ -137,6 +136,7 @@ namespace Curl {
             });
             tg.at_stop([this]() {
                 m_Stopping = true;
+                curl_multi_wakeup(m_Handle);
             });
             m_Next.start(tg);
         }
@@ -1,51 +1,181 @@
 #pragma once
 
-#include <map>
-#include <optional>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
 
 namespace ECS {
 
-    // not thread safe
-    template <class V>
-    struct ComponentStore
+    inline constexpr uint32_t CHUNK = 1024;         // rows per chunk, same for all columns
+    inline constexpr uint32_t NONE  = uint32_t(-1); // no archetype
+
+    // chunked column of components.
+    // chunks never move, so component stays on place until row removed or replaced by last one
+    template <class T>
+    class Column : public boost::noncopyable
     {
-        std::map<uint64_t, V> m_Store; // entity_id to component
+        struct Chunk
+        {
+            alignas(T) std::byte data[sizeof(T) * CHUNK];
+        };
+        std::vector<std::unique_ptr<Chunk>> m_Chunks;
+        uint32_t                            m_Size = 0;
+
+    public:
+        T* chunk(uint32_t aIndex) { return std::launder(reinterpret_cast<T*>(m_Chunks[aIndex]->data)); }
+        T& operator[](uint32_t aRow) { return chunk(aRow / CHUNK)[aRow % CHUNK]; }
+
+        template <class... A>
+        void emplace_back(A&&... aArgs)
+        {
+            if (m_Size == m_Chunks.size() * CHUNK)
+                m_Chunks.push_back(std::make_unique<Chunk>());
+            new (&chunk(m_Size / CHUNK)[m_Size % CHUNK]) T(std::forward<A>(aArgs)...);
+            m_Size++;
+        }
+
+        // last row moved to aRow
+        void swap_remove(uint32_t aRow)
+        {
+            T& sLast = (*this)[m_Size - 1];
+            if (aRow != m_Size - 1) {
+                T& sRow = (*this)[aRow];
+                sRow.~T();
+                new (&sRow) T(std::move(sLast));
+            }
+            sLast.~T();
+            m_Size--;
+            // keep one spare chunk, to avoid allocation on add/remove at chunk border
+            if (m_Chunks.size() > m_Size / CHUNK + 2)
+                m_Chunks.pop_back();
+        }
 
-        void create(uint64_t aEntity, V&& aData)
+        ~Column()
         {
-            m_Store.emplace(aEntity, std::move(aData));
+            for (uint32_t i = 0; i < m_Size; i++)
+                (*this)[i].~T();
         }
+    };
+
+    template <class T, class... V>
+    inline constexpr unsigned index_of = [] {
+        constexpr bool sMatch[] = {std::is_same_v<T, V>...};
+        for (unsigned i = 0; i < sizeof...(V); i++)
+            if (sMatch[i])
+                return i;
+        return unsigned(sizeof...(V));
+    }();
+
+    // entities with same set of components. structure of arrays: column per component type,
+    // rows of all columns (and m_Entities) are in same order.
+    template <class... V>
+    class Archetype : public boost::noncopyable
+    {
+        static_assert(sizeof...(V) <= 64, "ECS: too many component types");
 
-        void erase(uint64_t aEntity)
+    public:
+        template <class T>
+        static constexpr uint64_t bit()
         {
-            m_Store.erase(aEntity);
+            static_assert(index_of<T, V...> < sizeof...(V), "ECS: unknown component type");
+            return uint64_t(1) << index_of<T, V...>;
         }
 
-        std::optional<V*> get(uint64_t aEntity)
+        const uint64_t                     m_Mask;
+        std::vector<uint64_t>              m_Entities; // row to entity id
+        std::tuple<Column<V>...>           m_Columns;  // only columns from mask used
+        std::array<uint32_t, sizeof...(V)> m_Add;      // archetype with one more component, cached
+        std::array<uint32_t, sizeof...(V)> m_Remove;   // and without one
+
+        explicit Archetype(uint64_t aMask)
+        : m_Mask(aMask)
         {
-            auto sIt = m_Store.find(aEntity);
-            if (sIt == m_Store.end())
-                return std::nullopt;
-            return &sIt->second;
+            m_Add.fill(NONE);
+            m_Remove.fill(NONE);
         }
 
+        template <class T>
+        bool has() const { return m_Mask & bit<T>(); }
+
+        template <class T>
+        Column<T>& column() { return std::get<Column<T>>(m_Columns); }
+
+        uint32_t size() const { return m_Entities.size(); }
+        uint32_t chunks() const { return (size() + CHUNK - 1) / CHUNK; }
+
+        // call aFunc(column) for every column in mask
         template <class F>
-        void inspect(uint64_t aEntity, F&& aFunc)
+        void for_each_column(F&& aFunc)
+        {
+            std::apply([this, &aFunc](auto&... x) { (call_if_used(x, aFunc), ...); }, m_Columns);
+        }
+
+        // last row moved to aRow, return id of moved entity
+        uint64_t swap_remove(uint32_t aRow)
+        {
+            for_each_column([aRow](auto& x) { x.swap_remove(aRow); });
+            const uint64_t sMoved = m_Entities.back();
+            m_Entities[aRow]      = sMoved;
+            m_Entities.pop_back();
+            return sMoved;
+        }
+
+        ~Archetype()
+        {
+            // columns know nothing about mask, so shrink them here
+            while (!m_Entities.empty())
+                swap_remove(m_Entities.size() - 1);
+        }
+
+    private:
+        template <class T, class F>
+        void call_if_used(Column<T>& aColumn, F& aFunc)
         {
-            auto sIt = m_Store.find(aEntity);
-            if (sIt == m_Store.end())
-                return;
-            aFunc(sIt->second);
+            if (has<T>())
+                aFunc(aColumn);
         }
     };
 
-    template <class... V>
-    struct Store
+    // sparse set index: entity id to archetype and row. pages allocated on demand
+    class Index : public boost::noncopyable
     {
-        template <class T>
-        ComponentStore<T>& get() { return std::get<ComponentStore<T>>(m_Store); }
+    public:
+        struct Location
+        {
+            uint32_t archetype = NONE;
+            uint32_t row       = 0;
+        };
+
+    private:
+        static constexpr size_t PAGE = 4096;
+        using Page                   = std::array<Location, PAGE>;
+        std::vector<std::unique_ptr<Page>> m_Pages;
 
-        std::tuple<ComponentStore<V>...> m_Store;
+    public:
+        Location get(uint64_t aEntity) const
+        {
+            const size_t sPage = aEntity / PAGE;
+            if (sPage >= m_Pages.size() or !m_Pages[sPage])
+                return {};
+            return (*m_Pages[sPage])[aEntity % PAGE];
+        }
+
+        Location& at(uint64_t aEntity)
+        {
+            const size_t sPage = aEntity / PAGE;
+            if (sPage >= m_Pages.size())
+                m_Pages.resize(sPage + 1);
+            if (!m_Pages[sPage])
+                m_Pages[sPage] = std::make_unique<Page>();
+            return (*m_Pages[sPage])[aEntity % PAGE];
+        }
     };
 
 } // namespace ECS
@@ -30,7 +30,7 @@ namespace ECS {
         ~Entity()
         {
             if (m_ID > 0)
-                Mpl::for_each_element([this](auto& x) { x.erase(m_ID); }, system().m_Store);
+                system().destroy(m_ID);
         }
 
         uint64_t getID() const { return m_ID; }
@@ -43,25 +43,26 @@ namespace ECS {
         template <class C>
         void assign(C&& aComponent)
         {
-            system().template get<C>().create(m_ID, std::move(aComponent));
+            system().template create<std::remove_cvref_t<C>>(m_ID, std::forward<C>(aComponent));
         }
 
         template <class C>
         void erase()
         {
-            system().template get<C>().erase(m_ID);
+            system().template erase<C>(m_ID);
         }
 
+        // pointer valid until next assign/erase in system
         template <class C>
         std::optional<C*> get()
         {
-            return system().template get<C>().get(m_ID);
+            return system().template get<C>(m_ID);
         }
 
         template <class F>
         void inspect(F&& aFunc)
         {
-            Mpl::for_each_element([this, aFunc = std::forward<F>(aFunc)](auto& x) mutable { x.inspect(m_ID, aFunc); }, system().m_Store);
+            system().inspect(m_ID, aFunc);
         }
 
         static S& system()
@@ -1,7 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <optional>
+
 #include "Component.hpp"
 
+#include <threads/Group.hpp>
+
 namespace ECS {
 
     template <class... V>
@@ -10,20 +17,212 @@ namespace ECS {
     template <class... V>
     struct TmpEntity;
 
+    // archetype storage: entities with same component set live in one table,
+    // component moved to other table when added or removed.
+    // not thread safe. references to components valid until next add/remove of component or entity.
     template <class... V>
-    class System : protected Store<V...>
+    class System : public boost::noncopyable
     {
         friend class Entity<V...>;
+        using A        = Archetype<V...>;
+        using Location = Index::Location;
+
         uint64_t m_Serial{1}; // id 0 reserved. Entity d-tor uses it.
 
+        std::vector<std::unique_ptr<A>> m_Archetypes;
+        std::map<uint64_t, uint32_t>    m_ByMask;
+        Index                           m_Index;
+
         uint64_t nextEntityID() { return m_Serial++; }
 
+        uint32_t archetype(uint64_t aMask)
+        {
+            auto sIt = m_ByMask.find(aMask);
+            if (sIt != m_ByMask.end())
+                return sIt->second;
+            m_Archetypes.push_back(std::make_unique<A>(aMask));
+            m_ByMask.emplace(aMask, m_Archetypes.size() - 1);
+            return m_Archetypes.size() - 1;
+        }
+
+        template <class T>
+        uint32_t with(uint32_t aFrom)
+        {
+            if (aFrom == NONE)
+                return archetype(A::template bit<T>());
+            auto& sCache = m_Archetypes[aFrom]->m_Add[index_of<T, V...>];
+            if (sCache == NONE)
+                sCache = archetype(m_Archetypes[aFrom]->m_Mask | A::template bit<T>());
+            return sCache;
+        }
+
+        template <class T>
+        uint32_t without(uint32_t aFrom)
+        {
+            const uint64_t sMask = m_Archetypes[aFrom]->m_Mask & ~A::template bit<T>();
+            if (sMask == 0)
+                return NONE;
+            auto& sCache = m_Archetypes[aFrom]->m_Remove[index_of<T, V...>];
+            if (sCache == NONE)
+                sCache = archetype(sMask);
+            return sCache;
+        }
+
+        // remove row, fix index for entity moved to its place
+        void remove(Location aLocation)
+        {
+            A&             sFrom  = *m_Archetypes[aLocation.archetype];
+            const uint64_t sMoved = sFrom.swap_remove(aLocation.row);
+            if (aLocation.row < sFrom.size())
+                m_Index.at(sMoved).row = aLocation.row;
+        }
+
+        // move components of entity to archetype aTo, which has all or all but one of them.
+        // aTo columns not present in source must be filled by caller
+        void move(uint64_t aEntity, Location aFrom, uint32_t aTo)
+        {
+            A& sTo = *m_Archetypes[aTo];
+            if (aFrom.archetype != NONE) {
+                A& sFrom = *m_Archetypes[aFrom.archetype];
+                sTo.for_each_column([&](auto& x) {
+                    using T = std::remove_reference_t<decltype(x[0])>;
+                    if (sFrom.template has<T>())
+                        x.emplace_back(std::move(sFrom.template column<T>()[aFrom.row]));
+                });
+                sTo.m_Entities.push_back(aEntity);
+                remove(aFrom);
+            } else {
+                sTo.m_Entities.push_back(aEntity);
+            }
+            m_Index.at(aEntity) = {aTo, sTo.size() - 1};
+        }
+
+        // like map::emplace: existing component not replaced
+        template <class T, class... Args>
+        void create(uint64_t aEntity, Args&&... aArgs)
+        {
+            const Location sLocation = m_Index.get(aEntity);
+            if (sLocation.archetype != NONE and m_Archetypes[sLocation.archetype]->template has<T>())
+                return;
+            const uint32_t sTo = with<T>(sLocation.archetype);
+            m_Archetypes[sTo]->template column<T>().emplace_back(std::forward<Args>(aArgs)...);
+            move(aEntity, sLocation, sTo);
+        }
+
+        template <class T>
+        void erase(uint64_t aEntity)
+        {
+            const Location sLocation = m_Index.get(aEntity);
+            if (sLocation.archetype == NONE or !m_Archetypes[sLocation.archetype]->template has<T>())
+                return;
+            const uint32_t sTo = without<T>(sLocation.archetype);
+            if (sTo == NONE) {
+                destroy(aEntity);
+                return;
+            }
+            move(aEntity, sLocation, sTo);
+        }
+
+        void destroy(uint64_t aEntity)
+        {
+            Location& sLocation = m_Index.at(aEntity);
+            if (sLocation.archetype == NONE)
+                return;
+            const Location sOld = sLocation;
+            sLocation           = {};
+            remove(sOld);
+        }
+
+        template <class T>
+        std::optional<T*> get(uint64_t aEntity)
+        {
+            const Location sLocation = m_Index.get(aEntity);
+            if (sLocation.archetype == NONE or !m_Archetypes[sLocation.archetype]->template has<T>())
+                return std::nullopt;
+            return &m_Archetypes[sLocation.archetype]->template column<T>()[sLocation.row];
+        }
+
+        template <class F>
+        void inspect(uint64_t aEntity, F&& aFunc)
+        {
+            const Location sLocation = m_Index.get(aEntity);
+            if (sLocation.archetype == NONE)
+                return;
+            m_Archetypes[sLocation.archetype]->for_each_column([&](auto& x) { aFunc(x[sLocation.row]); });
+        }
+
+        // rows of one chunk, columns are plain arrays here
+        template <class... C, class F>
+        static void visit(A& aArchetype, uint32_t aChunk, F& aFunc)
+        {
+            const uint32_t  sFrom    = aChunk * CHUNK;
+            const uint32_t  sSize    = std::min(CHUNK, aArchetype.size() - sFrom);
+            const uint64_t* sEntity  = aArchetype.m_Entities.data() + sFrom;
+            const auto      sColumns = std::make_tuple(aArchetype.template column<C>().chunk(aChunk)...);
+            for (uint32_t i = 0; i < sSize; i++) {
+                if constexpr (std::is_invocable_v<F&, C&...>)
+                    aFunc(std::get<C*>(sColumns)[i]...);
+                else
+                    aFunc(TmpEntity<V...>(sEntity[i]), std::get<C*>(sColumns)[i]...);
+            }
+        }
+
     public:
-        template <class C, class F>
+        // aFunc(entity, C&...) or aFunc(C&...) for every entity with all components C.
+        // order is not defined. components must not be added or removed from aFunc
+        template <class... C, class F>
         void forEach(F&& aFunc)
         {
-            for (auto& x : this->template get<C>().m_Store)
-                aFunc(TmpEntity<V...>(x.first), x.second);
+            constexpr uint64_t sMask = (A::template bit<C>() | ...);
+            for (auto& x : m_Archetypes) {
+                if ((x->m_Mask & sMask) != sMask)
+                    continue;
+                for (uint32_t i = 0; i < x->chunks(); i++)
+                    visit<C...>(*x, i, aFunc);
+            }
+        }
+
+        // like forEach, but chunks processed by aThreads threads.
+        // aFunc called concurrently, for different entities
+        template <class... C, class F>
+        void forEachParallel(F&& aFunc, unsigned aThreads = 4)
+        {
+            constexpr uint64_t                   sMask = (A::template bit<C>() | ...);
+            std::vector<std::pair<A*, uint32_t>> sJobs;
+            for (auto& x : m_Archetypes) {
+                if ((x->m_Mask & sMask) != sMask)
+                    continue;
+                for (uint32_t i = 0; i < x->chunks(); i++)
+                    sJobs.emplace_back(x.get(), i);
+            }
+            aThreads = std::min<size_t>(aThreads, sJobs.size());
+            if (aThreads <= 1) {
+                for (auto& [sArchetype, sChunk] : sJobs)
+                    visit<C...>(*sArchetype, sChunk, aFunc);
+                return;
+            }
+
+            std::atomic<size_t> sNext{0};
+            Threads::Group      sGroup;
+            sGroup.start(
+                [&]() {
+                    for (size_t i = sNext++; i < sJobs.size(); i = sNext++)
+                        visit<C...>(*sJobs[i].first, sJobs[i].second, aFunc);
+                },
+                aThreads);
+            sGroup.wait();
+        }
+
+        // number of entities with all components C
+        template <class... C>
+        size_t count() const
+        {
+            constexpr uint64_t sMask  = (A::template bit<C>() | ...);
+            size_t             sCount = 0;
+            for (auto& x : m_Archetypes)
+                if ((x->m_Mask & sMask) == sMask)
+                    sCount += x->size();
+            return sCount;
         }
     };
 
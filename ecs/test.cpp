@@ -2,10 +2,13 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <map>
 #include <set>
 
 #include "Entity.hpp"
 
+#include <time/Meter.hpp>
+
 BOOST_AUTO_TEST_SUITE(ecs)
 BOOST_AUTO_TEST_CASE(entity)
 {
@@ -174,4 +177,165 @@ BOOST_AUTO_TEST_CASE(xtest)
     });
     BOOST_CHECK_EQUAL(sMap.stale(30), false);
 }
+
+namespace Sim {
+    struct Position
+    {
+        float x = 0, y = 0;
+    };
+    struct Velocity
+    {
+        float dx = 0, dy = 0;
+    };
+    struct Health
+    {
+        int value = 100;
+    };
+    struct Name
+    {
+        std::string name;
+    };
+    using E = ECS::Entity<Position, Velocity, Health, Name>;
+} // namespace Sim
+
+BOOST_AUTO_TEST_CASE(archetype)
+{
+    using namespace Sim;
+    auto& sSystem = E::system();
+
+    std::vector<E> sList;
+    for (int i = 0; i < 3000; i++) {
+        sList.push_back(E::create());
+        auto& e = sList.back();
+        e.assign(Position{float(i), 0});
+        if (i % 2 == 0)
+            e.assign(Velocity{1, 2});
+        if (i % 3 == 0)
+            e.assign(Name{"e" + std::to_string(i)});
+    }
+    BOOST_CHECK_EQUAL(sSystem.count<Position>(), 3000);
+    BOOST_CHECK_EQUAL((sSystem.count<Position, Velocity>()), 1500);
+    BOOST_CHECK_EQUAL((sSystem.count<Velocity, Name>()), 500);
+
+    // components kept while entity moved between archetypes
+    for (int i = 0; i < 3000; i += 2)
+        sList[i].erase<Velocity>();
+    while (sList.size() > 2000) // destroy some
+        sList.pop_back();
+    for (int i = 0; i < 2000; i++) {
+        BOOST_REQUIRE(sList[i].get<Position>());
+        BOOST_CHECK_EQUAL(sList[i].get<Position>().value()->x, i);
+        BOOST_CHECK_EQUAL(sList[i].get<Name>().has_value(), i % 3 == 0);
+        if (i % 3 == 0)
+            BOOST_CHECK_EQUAL(sList[i].get<Name>().value()->name, "e" + std::to_string(i));
+    }
+    BOOST_CHECK_EQUAL(sSystem.count<Position>(), 2000);
+    BOOST_CHECK_EQUAL(sSystem.count<Velocity>(), 0);
+
+    // entity without components
+    sList[0].erase<Position>();
+    sList[0].erase<Name>();
+    BOOST_CHECK(!sList[0].get<Position>());
+    BOOST_CHECK_EQUAL(sSystem.count<Position>(), 1999);
+
+    // join with entity
+    size_t sCount = 0;
+    sSystem.forEach<Position, Name>([&sCount](auto&& aEntity, Position& aPos, Name& aName) {
+        BOOST_CHECK_EQUAL("e" + std::to_string(int(aPos.x)), aName.name);
+        BOOST_CHECK_EQUAL(aEntity.template get<Name>().value(), &aName);
+        sCount++;
+    });
+    BOOST_CHECK_EQUAL(sCount, 666);
+}
+
+BOOST_AUTO_TEST_CASE(parallel)
+{
+    using namespace Sim;
+    std::vector<E> sList;
+    for (int i = 0; i < 100000; i++) {
+        sList.push_back(E::create());
+        sList.back().assign(Position{});
+        sList.back().assign(Velocity{1, float(i % 2)});
+        if (i % 10 == 0)
+            sList.back().assign(Health{});
+    }
+    E::system().forEachParallel<Position, Velocity>([](Position& aPos, const Velocity& aVel) {
+        aPos.x += aVel.dx;
+        aPos.y += aVel.dy;
+    });
+    double sSumX = 0;
+    double sSumY = 0;
+    E::system().forEach<Position>([&](Position& aPos) {
+        sSumX += aPos.x;
+        sSumY += aPos.y;
+    });
+    BOOST_CHECK_EQUAL(sSumX, 100000);
+    BOOST_CHECK_EQUAL(sSumY, 50000);
+}
+
+// iteration over one component and join of two, compared with map per component
+BOOST_AUTO_TEST_CASE(iteration)
+{
+    using namespace Sim;
+    constexpr size_t COUNT = 1000000;
+
+    std::map<uint64_t, Position> sMapPos;
+    std::map<uint64_t, Velocity> sMapVel;
+    std::vector<E>               sList;
+    sList.reserve(COUNT);
+    for (size_t i = 0; i < COUNT; i++) {
+        sList.push_back(E::create());
+        auto& e = sList.back();
+        e.assign(Position{});
+        sMapPos[e.getID()] = Position{};
+        if (i % 4 != 0) {
+            e.assign(Velocity{1, 1});
+            sMapVel[e.getID()] = Velocity{1, 1};
+        }
+        if (i % 8 == 0)
+            e.assign(Health{});
+    }
+
+    auto sReport = [](const char* aName, size_t aCount, auto&& aFunc) {
+        Time::Meter sMeter;
+        aFunc();
+        const double sELA = sMeter.get().to_double();
+        BOOST_TEST_MESSAGE(aName << ": " << sELA * 1e9 / aCount << " ns/entity");
+    };
+
+    double sSum = 0;
+    sReport("map, one component", COUNT, [&]() {
+        for (auto& [sID, sPos] : sMapPos)
+            sSum += sPos.x;
+    });
+    sReport("map, join", COUNT, [&]() {
+        for (auto& [sID, sVel] : sMapVel) {
+            auto sIt = sMapPos.find(sID);
+            if (sIt != sMapPos.end()) {
+                sIt->second.x += sVel.dx;
+                sIt->second.y += sVel.dy;
+            }
+        }
+    });
+    sReport("archetype, one component", COUNT, [&]() {
+        E::system().forEach<Position>([&](Position& aPos) { sSum += aPos.x; });
+    });
+    sReport("archetype, join", COUNT, [&]() {
+        E::system().forEach<Position, Velocity>([](Position& aPos, const Velocity& aVel) {
+            aPos.x += aVel.dx;
+            aPos.y += aVel.dy;
+        });
+    });
+    sReport("archetype, parallel join", COUNT, [&]() {
+        E::system().forEachParallel<Position, Velocity>([](Position& aPos, const Velocity& aVel) {
+            aPos.x += aVel.dx;
+            aPos.y += aVel.dy;
+        });
+    });
+    BOOST_TEST_MESSAGE("checksum: " << sSum);
+
+    double sX = 0;
+    E::system().forEach<Position>([&](Position& aPos) { sX += aPos.x; });
+    BOOST_CHECK_EQUAL(sX, 2 * COUNT * 3 / 4);
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,23 +1,57 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 namespace Format {
     namespace aux {
         static const char sDict[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+
+#ifdef __AVX2__
+        // 16 bytes to 32 hex digits, nibble translated with compare instead of lookup
+        inline void to_hex_block(const char* aPtr, char* aOut)
+        {
+            const __m256i sByte    = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(aPtr)));
+            const __m256i sNibbles = _mm256_or_si256(_mm256_srli_epi16(sByte, 4), _mm256_slli_epi16(_mm256_and_si256(sByte, _mm256_set1_epi16(0x0F)), 8));
+            const __m256i sLetters = _mm256_and_si256(_mm256_cmpgt_epi8(sNibbles, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(aOut), _mm256_add_epi8(_mm256_add_epi8(sNibbles, _mm256_set1_epi8('0')), sLetters));
+        }
+#endif
+    } // namespace aux
+
+    // aOut must have space for 2 * x.size() bytes. return end of output
+    inline char* to_hex(std::string_view x, char* aOut)
+    {
+        size_t i = 0;
+#ifdef __AVX2__
+        for (; i + 16 <= x.size(); i += 16, aOut += 32)
+            aux::to_hex_block(x.data() + i, aOut);
+#endif
+        for (; i < x.size(); i++) {
+            const uint8_t sByte = x[i];
+            *aOut++             = aux::sDict[sByte >> 4];
+            *aOut++             = aux::sDict[sByte & 0x0F];
+        }
+        return aOut;
+    }
+
+    // append to aOut
+    inline void to_hex(std::string_view x, std::string& aOut)
+    {
+        const size_t sSize = aOut.size();
+        aOut.resize(sSize + x.size() * 2);
+        to_hex(x, aOut.data() + sSize);
     }
 
     inline std::string to_hex(std::string_view x)
     {
         std::string sResult;
-        sResult.reserve(x.size() * 2);
-        for (const uint8_t i : x) {
-            auto a1 = i >> 4;
-            auto a2 = i & 0x0F;
-            sResult.push_back(aux::sDict[a1]);
-            sResult.push_back(aux::sDict[a2]);
-        }
+        to_hex(x, sResult);
         return sResult;
     }
 
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstring>
 #include <string>
+#include <string_view>
 
 #include "Hex.hpp"
 
@@ -11,23 +13,65 @@ namespace Format {
         {
             return (c >= 'A' and c <= 'Z') || (c >= 'a' and c <= 'z') || (c >= '0' and c <= '9') || c == '-' || c == '_' || c == '.' || c == '~';
         }
+
+#ifdef __AVX2__
+        // length of unreserved prefix of 32 byte block
+        inline unsigned unreserved_block(const char* aPtr)
+        {
+            auto sIn = [](__m256i x, char a, char b) {
+                const __m256i sOffset = _mm256_sub_epi8(x, _mm256_set1_epi8(a));
+                return _mm256_cmpeq_epi8(_mm256_min_epu8(sOffset, _mm256_set1_epi8(b - a)), sOffset);
+            };
+            const __m256i sInput = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPtr));
+            __m256i       sOk    = _mm256_or_si256(sIn(_mm256_or_si256(sInput, _mm256_set1_epi8(0x20)), 'a', 'z'), sIn(sInput, '0', '9'));
+            for (char c : {'-', '_', '.', '~'})
+                sOk = _mm256_or_si256(sOk, _mm256_cmpeq_epi8(sInput, _mm256_set1_epi8(c)));
+            const uint32_t sMask = ~uint32_t(_mm256_movemask_epi8(sOk));
+            return sMask ? __builtin_ctz(sMask) : 32;
+        }
+#endif
     } // namespace aux
 
-    inline std::string url_encode(const std::string& aData)
+    // aOut must have space for 3 * aData.size() bytes. return end of output
+    inline char* url_encode(std::string_view aData, char* aOut)
     {
-        std::string sResult;
-        sResult.reserve(aData.size() * 3);
-        for (const uint8_t i : aData) {
-            if (aux::unreserved(i))
-                sResult.push_back(i);
+        size_t i = 0;
+        while (i < aData.size()) {
+#ifdef __AVX2__
+            // copy unreserved characters by blocks
+            if (i + 32 <= aData.size()) {
+                const unsigned sCount = aux::unreserved_block(aData.data() + i);
+                memcpy(aOut, aData.data() + i, sCount);
+                aOut += sCount;
+                i += sCount;
+                if (sCount == 32)
+                    continue;
+            }
+#endif
+            const uint8_t c = aData[i++];
+            if (aux::unreserved(c))
+                *aOut++ = c;
             else {
-                auto a1 = i >> 4;
-                auto a2 = i & 0x0F;
-                sResult.push_back('%');
-                sResult.push_back(aux::sDict[a1]);
-                sResult.push_back(aux::sDict[a2]);
+                *aOut++ = '%';
+                *aOut++ = aux::sDict[c >> 4];
+                *aOut++ = aux::sDict[c & 0x0F];
             }
         }
+        return aOut;
+    }
+
+    // append to aOut
+    inline void url_encode(std::string_view aData, std::string& aOut)
+    {
+        const size_t sSize = aOut.size();
+        aOut.resize(sSize + aData.size() * 3);
+        aOut.resize(url_encode(aData, aOut.data() + sSize) - aOut.data());
+    }
+
+    inline std::string url_encode(std::string_view aData)
+    {
+        std::string sResult;
+        url_encode(aData, sResult);
         return sResult;
     }
-} // namespace Format
\ No newline at end of file
+} // namespace Format
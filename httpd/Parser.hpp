@@ -1,59 +1,162 @@
 #pragma once
 
 #include <llhttp.h>
+#include <strings.h>
 
-#include <map>
+#include <functional>
 #include <string>
+#include <string_view>
+
+#include <boost/container/small_vector.hpp>
 
 #include <exception/Error.hpp>
 
 namespace httpd {
 
-    struct iless
+    // case insensitive FNV-1a, so header lookup compares hashes first
+    inline constexpr uint32_t header_hash(std::string_view aName)
     {
-        bool operator()(const std::string& a, const std::string& b) const
+        uint32_t sHash = 2166136261u;
+        for (char c : aName) {
+            if (c >= 'A' and c <= 'Z')
+                c += 'a' - 'A';
+            sHash ^= (uint8_t)c;
+            sHash *= 16777619u;
+        }
+        return sHash;
+    }
+
+    // all message data (url, header names and values, body) stored in one arena buffer.
+    // parts are kept as offsets, so message can be copied or moved, and
+    // arena capacity reused by next message after clear().
+    class Message
+    {
+    protected:
+        struct Slice
+        {
+            uint32_t offset = 0;
+            uint32_t size   = 0;
+        };
+
+        struct Header
+        {
+            Slice    name;
+            Slice    value;
+            uint32_t hash = 0;
+        };
+
+        using HeaderList = boost::container::small_vector<Header, 16>;
+
+        std::string m_Arena;
+        HeaderList  m_Headers;
+        Slice       m_Body;
+
+        std::string_view view(const Slice& aSlice) const { return std::string_view(m_Arena.data() + aSlice.offset, aSlice.size); }
+
+        Slice append(Slice aSlice, const char* aData, size_t aSize)
         {
-            return strcasecmp(a.data(), b.data()) < 0;
+            if (aSlice.size == 0)
+                aSlice.offset = m_Arena.size();
+            m_Arena.append(aData, aSize);
+            aSlice.size += aSize;
+            return aSlice;
+        }
+
+        template <class P>
+        friend class Parser;
+
+    public:
+        static constexpr size_t ARENA_SIZE = 4096; // reserved once, reused between messages
+
+        bool keep_alive{false};
+
+        class HeaderRange
+        {
+            const Message& m_Message;
+
+        public:
+            using value_type = std::pair<std::string_view, std::string_view>;
+
+            struct iterator
+            {
+                const Message*             m_Message;
+                HeaderList::const_iterator m_Current;
+
+                value_type operator*() const { return {m_Message->view(m_Current->name), m_Message->view(m_Current->value)}; }
+                iterator&  operator++()
+                {
+                    ++m_Current;
+                    return *this;
+                }
+                bool operator==(const iterator& aOther) const { return m_Current == aOther.m_Current; }
+            };
+
+            HeaderRange(const Message& aMessage)
+            : m_Message(aMessage)
+            {}
+
+            iterator begin() const { return {&m_Message, m_Message.m_Headers.begin()}; }
+            iterator end() const { return {&m_Message, m_Message.m_Headers.end()}; }
+            size_t   size() const { return m_Message.m_Headers.size(); }
+        };
+
+        std::string_view body() const { return view(m_Body); }
+        HeaderRange      headers() const { return HeaderRange(*this); }
+
+        // case insensitive lookup. empty string_view if header not found
+        std::string_view header(std::string_view aName) const
+        {
+            const uint32_t sHash = header_hash(aName);
+            for (auto& x : m_Headers) {
+                if (x.hash != sHash or x.name.size != aName.size())
+                    continue;
+                if (0 == strncasecmp(m_Arena.data() + x.name.offset, aName.data(), aName.size()))
+                    return view(x.value);
+            }
+            return {};
+        }
+
+        void clear()
+        {
+            m_Arena.clear();
+            m_Headers.clear();
+            m_Body     = {};
+            keep_alive = false;
         }
     };
-    // multi map ?
-    using Headers = std::map<std::string, std::string, iless>;
 
-    struct Request
+    struct Request : Message
     {
         using Handler = std::function<void(Request&)>;
 
         const char* method = nullptr;
-        std::string url;
-        Headers     headers;
-        std::string body;
-        bool        keep_alive{false};
+
+        std::string_view url() const { return view(m_Url); }
 
         void clear()
         {
+            Message::clear();
             method = nullptr;
-            url.clear();
-            headers.clear();
-            body.clear();
-            keep_alive = false;
+            m_Url  = {};
         }
+
+    private:
+        Slice m_Url;
+
+        template <class P>
+        friend class Parser;
     };
 
-    struct Response
+    struct Response : Message
     {
         using Handler = std::function<void(Response&)>;
 
-        uint16_t    status = 0;
-        Headers     headers;
-        std::string body;
-        bool        keep_alive{false};
+        uint16_t status = 0;
 
         void clear()
         {
+            Message::clear();
             status = 0;
-            headers.clear();
-            body.clear();
-            keep_alive = false;
         }
     };
 
@@ -70,37 +173,38 @@ namespace httpd {
         static int on_url(llhttp_t* aParser, const char* aData, size_t aSize) { return Get(aParser)->on_url_int(aData, aSize); }
         int        on_url_int(const char* aData, size_t aSize)
         {
-            m_Data.url.append(aData, aSize);
+            if constexpr (std::is_same_v<X, Request>)
+                m_Data.m_Url = m_Data.append(m_Data.m_Url, aData, aSize);
             return 0;
         }
 
         static int on_header_field(llhttp_t* aParser, const char* aData, size_t aSize) { return Get(aParser)->on_header_field_int(aData, aSize); }
         int        on_header_field_int(const char* aData, size_t aSize)
         {
-            m_HeaderName.append(aData, aSize);
+            m_Header.name = m_Data.append(m_Header.name, aData, aSize);
             return 0;
         }
 
         static int on_header_value(llhttp_t* aParser, const char* aData, size_t aSize) { return Get(aParser)->on_header_value_int(aData, aSize); }
         int        on_header_value_int(const char* aData, size_t aSize)
         {
-            m_HeaderValue.append(aData, aSize);
+            m_Header.value = m_Data.append(m_Header.value, aData, aSize);
             return 0;
         }
 
         static int on_header_value_complete(llhttp_t* aParser) { return Get(aParser)->on_header_value_complete_int(); }
         int        on_header_value_complete_int()
         {
-            m_Data.headers.insert(std::make_pair(std::move(m_HeaderName), std::move(m_HeaderValue)));
-            m_HeaderName.clear();
-            m_HeaderValue.clear();
+            m_Header.hash = header_hash(m_Data.view(m_Header.name));
+            m_Data.m_Headers.push_back(m_Header);
+            m_Header = {};
             return 0;
         }
 
         static int on_body(llhttp_t* aParser, const char* aData, size_t aSize) { return Get(aParser)->on_body_int(aData, aSize); }
         int        on_body_int(const char* aData, size_t aSize)
         {
-            m_Data.body.append(aData, aSize);
+            m_Data.m_Body = m_Data.append(m_Data.m_Body, aData, aSize);
             return 0;
         }
 
@@ -119,8 +223,7 @@ namespace httpd {
 
         typename X::Handler m_Handler;
         X                   m_Data;
-        std::string         m_HeaderName;
-        std::string         m_HeaderValue;
+        Message::Header     m_Header;
 
         void init2()
         {
@@ -134,6 +237,7 @@ namespace httpd {
             m_Settings.on_header_value_complete = on_header_value_complete;
             m_Settings.on_body                  = on_body;
             m_Settings.on_message_complete      = on_message_complete;
+            m_Data.m_Arena.reserve(Message::ARENA_SIZE);
         }
 
     public:
@@ -155,8 +259,9 @@ namespace httpd {
             size_t sResult = llhttp_execute(&m_Parser, aData, aSize);
             if (sResult == HPE_PAUSED_H2_UPGRADE) {
                 if constexpr (std::is_same_v<X, Request>) {
-                    m_Data.method = llhttp_method_name((llhttp_method_t)m_Parser.method);
-                    m_Data.body   = std::to_string(m_Parser.http_major) + '.' + std::to_string(m_Parser.http_minor);
+                    const char sVersion[] = {char('0' + m_Parser.http_major), '.', char('0' + m_Parser.http_minor)};
+                    m_Data.method         = llhttp_method_name((llhttp_method_t)m_Parser.method);
+                    m_Data.m_Body         = m_Data.append({}, sVersion, sizeof(sVersion));
                     m_Handler(m_Data);
                     return llhttp_get_error_pos(&m_Parser) - aData;
                 } else {
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <llhttp.h>
+#include <sys/uio.h>
+#include <time.h>
+
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <string>
+#include <string_view>
+
+#include <boost/container/small_vector.hpp>
+
+namespace httpd {
+
+    // status lines built once from llhttp status map: `HTTP/1.1 404 Not Found\r\n`
+    inline std::string_view status_line(uint16_t aStatus)
+    {
+        static const auto sTable = []() {
+            std::array<std::string, 600> sTable;
+            auto                         sAdd = [&sTable](unsigned aCode, std::string aName) {
+                bool sFirst = true;
+                for (auto& c : aName) {
+                    if (c == '_') {
+                        c      = ' ';
+                        sFirst = true;
+                    } else if (!sFirst) {
+                        c = std::tolower(c);
+                    } else {
+                        sFirst = false;
+                    }
+                }
+                if (aCode == 200)
+                    aName = "OK";
+                sTable[aCode] = "HTTP/1.1 " + std::to_string(aCode) + ' ' + aName + "\r\n";
+            };
+#define HTTP_STATUS_GEN(NUM, NAME, STRING) sAdd(NUM, #STRING);
+            HTTP_STATUS_MAP(HTTP_STATUS_GEN)
+#undef HTTP_STATUS_GEN
+            for (unsigned i = 100; i < sTable.size(); i++)
+                if (sTable[i].empty())
+                    sTable[i] = "HTTP/1.1 " + std::to_string(i) + " Unknown\r\n";
+            return sTable;
+        }();
+        if (aStatus < 100 or aStatus >= sTable.size())
+            aStatus = 500;
+        return sTable[aStatus];
+    }
+
+    // `Date: ...\r\n` header, formatted once per second in every thread
+    inline std::string_view date_header()
+    {
+        struct Cache
+        {
+            time_t               now = 0;
+            std::array<char, 64> buf;
+            size_t               size = 0;
+        };
+        thread_local Cache sCache;
+
+        const time_t sNow = time(nullptr);
+        if (sNow != sCache.now) {
+            struct tm sTm;
+            gmtime_r(&sNow, &sTm);
+            sCache.size = strftime(sCache.buf.data(), sCache.buf.size(), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &sTm);
+            sCache.now  = sNow;
+        }
+        return std::string_view(sCache.buf.data(), sCache.size);
+    }
+
+    // response serialized to iovec list without copy of header values and body.
+    // referenced data must be alive until write() returns.
+    struct Reply
+    {
+        using Header = std::pair<std::string_view, std::string_view>;
+
+        uint16_t                                  status = 200;
+        bool                                      keep_alive{true};
+        boost::container::small_vector<Header, 8> headers;
+        std::string_view                          body;
+
+        template <class C>
+        void write(C& aConnection) const
+        {
+            static constexpr std::string_view CRLF       = "\r\n";
+            static constexpr std::string_view COLON      = ": ";
+            static constexpr std::string_view KEEP_ALIVE = "Connection: keep-alive\r\n";
+            static constexpr std::string_view CLOSE      = "Connection: close\r\n";
+            static constexpr std::string_view LENGTH     = "Content-Length: ";
+
+            boost::container::small_vector<iovec, 64> sIov;
+            auto                                      sAdd = [&sIov](std::string_view aStr) {
+                sIov.push_back(iovec{const_cast<char*>(aStr.data()), aStr.size()});
+            };
+
+            std::array<char, 24> sLength;
+            const auto           sEnd = std::to_chars(sLength.data(), sLength.data() + sLength.size(), body.size()).ptr;
+
+            sAdd(status_line(status));
+            sAdd(date_header());
+            sAdd(keep_alive ? KEEP_ALIVE : CLOSE);
+            sAdd(LENGTH);
+            sAdd(std::string_view(sLength.data(), sEnd - sLength.data()));
+            sAdd(CRLF);
+            for (auto& [sName, sValue] : headers) {
+                sAdd(sName);
+                sAdd(COLON);
+                sAdd(sValue);
+                sAdd(CRLF);
+            }
+            sAdd(CRLF);
+            if (!body.empty())
+                sAdd(body);
+            aConnection.write(sIov.data(), sIov.size());
+        }
+    };
+} // namespace httpd
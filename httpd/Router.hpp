@@ -1,31 +1,117 @@
 #pragma once
 
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
 #include <threads/Group.hpp>
 #include <threads/SafeQueue.hpp>
 
 #include "Connection.hpp"
+#include "Reply.hpp"
 
 namespace httpd {
+    // radix tree over url prefixes, lookup returns value for longest matched prefix
+    template <class V>
+    class PrefixTree
+    {
+        struct Node
+        {
+            std::string           label;
+            std::vector<uint32_t> children; // sorted by first label char
+            int32_t               value = -1;
+        };
+        std::vector<Node> m_Nodes{1};
+        std::vector<V>    m_Values;
+
+        uint32_t child(const Node& aNode, char aChar) const
+        {
+            for (auto x : aNode.children)
+                if (m_Nodes[x].label.front() == aChar)
+                    return x;
+            return 0;
+        }
+
+        uint32_t add_node(std::string_view aLabel, int32_t aValue)
+        {
+            m_Nodes.push_back(Node{std::string(aLabel), {}, aValue});
+            return m_Nodes.size() - 1;
+        }
+
+        void add_child(uint32_t aParent, uint32_t aChild)
+        {
+            auto& sList = m_Nodes[aParent].children;
+            auto  sIt   = std::lower_bound(sList.begin(), sList.end(), aChild, [this](uint32_t a, uint32_t b) {
+                return m_Nodes[a].label.front() < m_Nodes[b].label.front();
+            });
+            sList.insert(sIt, aChild);
+        }
+
+    public:
+        void insert(std::string_view aKey, V&& aValue)
+        {
+            m_Values.push_back(std::move(aValue));
+            const int32_t sValue = m_Values.size() - 1;
+
+            uint32_t sCurrent = 0;
+            while (true) {
+                if (aKey.empty()) {
+                    if (m_Nodes[sCurrent].value == -1) // first inserted wins, as in plain list
+                        m_Nodes[sCurrent].value = sValue;
+                    return;
+                }
+                const uint32_t sChild = child(m_Nodes[sCurrent], aKey.front());
+                if (sChild == 0) {
+                    add_child(sCurrent, add_node(aKey, sValue));
+                    return;
+                }
+                const std::string& sLabel  = m_Nodes[sChild].label;
+                const size_t       sCommon = std::mismatch(sLabel.begin(), sLabel.end(), aKey.begin(), aKey.end()).first - sLabel.begin();
+                uint32_t           sNext   = sChild;
+                if (sCommon < sLabel.size()) {
+                    // split child: common part becomes new node
+                    sNext = add_node(aKey.substr(0, sCommon), -1);
+                    m_Nodes[sChild].label.erase(0, sCommon);
+                    m_Nodes[sNext].children.push_back(sChild);
+                    std::replace(m_Nodes[sCurrent].children.begin(), m_Nodes[sCurrent].children.end(), sChild, sNext);
+                }
+                sCurrent = sNext;
+                aKey.remove_prefix(sCommon);
+            }
+        }
+
+        const V* find(std::string_view aKey) const
+        {
+            int32_t  sFound   = m_Nodes[0].value;
+            uint32_t sCurrent = 0;
+            while (!aKey.empty()) {
+                const uint32_t sChild = child(m_Nodes[sCurrent], aKey.front());
+                if (sChild == 0 or !aKey.starts_with(m_Nodes[sChild].label))
+                    break;
+                aKey.remove_prefix(m_Nodes[sChild].label.size());
+                sCurrent = sChild;
+                if (m_Nodes[sCurrent].value != -1)
+                    sFound = m_Nodes[sCurrent].value;
+            }
+            return sFound == -1 ? nullptr : &m_Values[sFound];
+        }
+    };
+
     struct Router
     {
         using Worker     = Threads::SafeQueueThread<std::function<void()>>;
         using UserResult = Connection::UserResult;
+        using Handler    = std::function<UserResult(Connection::SharedPtr, const Request&)>;
 
         struct Location
         {
-            std::string prefix;
-            bool        async = true;
+            Handler handler;
+            bool    async = true;
         };
-        using Handler = std::function<UserResult(Connection::SharedPtr, const Request&)>;
 
     private:
-        Worker                                  m_Worker;
-        std::list<std::pair<Location, Handler>> m_Locations;
-
-        bool match(const Location& aLoc, const Request& aReq) const
-        {
-            return 0 == aReq.url.compare(0, aLoc.prefix.size(), aLoc.prefix);
-        }
+        Worker               m_Worker;
+        PrefixTree<Location> m_Locations;
 
         UserResult process(Connection::SharedPtr aConnection, const Request& aRequest, const Handler& aHandler, bool aAsync)
         {
@@ -51,19 +137,21 @@ namespace httpd {
         {}
 
         void start(Threads::Group& aGroup) { m_Worker.start(aGroup); }
-        void insert_sync(const std::string& aLoc, const Handler aHandler) { m_Locations.push_back({Location{aLoc, false}, aHandler}); }
-        void insert(const std::string& aLoc, const Handler aHandler) { m_Locations.push_back({Location{aLoc, true}, aHandler}); }
+        void insert_sync(const std::string& aLoc, const Handler aHandler) { m_Locations.insert(aLoc, Location{aHandler, false}); }
+        void insert(const std::string& aLoc, const Handler aHandler) { m_Locations.insert(aLoc, Location{aHandler, true}); }
 
+        // longest matched prefix wins
         UserResult operator()(Connection::SharedPtr aConnection, const Request& aRequest)
         {
-            for (auto& [sLoc, sHandler] : m_Locations)
-                if (match(sLoc, aRequest))
-                    return process(aConnection, aRequest, sHandler, sLoc.async);
+            if (auto sLoc = m_Locations.find(aRequest.url()); sLoc != nullptr)
+                return process(aConnection, aRequest, sLoc->handler, sLoc->async);
 
-            const std::string sNotFound = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
-            aConnection->write(sNotFound);
+            Reply sNotFound;
+            sNotFound.status     = 404;
+            sNotFound.keep_alive = aRequest.keep_alive;
+            sNotFound.write(*aConnection);
             return UserResult::DONE;
         }
     };
 
-} // namespace httpd
\ No newline at end of file
+} // namespace httpd
@@ -9,6 +9,21 @@
 
 using namespace std::chrono_literals;
 
+// count allocations made by current thread
+thread_local uint64_t gAllocations = 0;
+void*                 operator new(size_t aSize)
+{
+    gAllocations++;
+    if (void* sPtr = malloc(aSize))
+        return sPtr;
+    throw std::bad_alloc();
+}
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* aPtr) noexcept { free(aPtr); }
+void operator delete(void* aPtr, size_t) noexcept { free(aPtr); }
+#pragma GCC diagnostic pop
+
 BOOST_AUTO_TEST_SUITE(parser)
 BOOST_AUTO_TEST_CASE(request)
 {
@@ -35,14 +50,17 @@ BOOST_AUTO_TEST_CASE(request)
 
     httpd::Request::Handler sHandler = [&sCalled](httpd::Request& aRequest) {
         BOOST_CHECK_EQUAL(aRequest.method, "POST");
-        BOOST_CHECK_EQUAL(aRequest.url, "/joyent/http-parser");
-        const auto sHeaders = aRequest.headers;
+        BOOST_CHECK_EQUAL(aRequest.url(), "/joyent/http-parser");
+        const auto sHeaders = aRequest.headers();
         for (const auto& x : sHeaders) {
             BOOST_TEST_MESSAGE("found header " << x.first << "=" << x.second);
             if (x.first == "DNT")
                 BOOST_CHECK_EQUAL(x.second, "1");
         }
-        BOOST_CHECK_EQUAL(aRequest.body, "hello world");
+        BOOST_CHECK_EQUAL(aRequest.body(), "hello world");
+        BOOST_CHECK_EQUAL(aRequest.header("accept-encoding"), "gzip, deflate, sdch");
+        BOOST_CHECK_EQUAL(aRequest.header("CONNECTION"), "keep-alive");
+        BOOST_CHECK(aRequest.header("Not-Exists").empty());
         sCalled = true;
     };
 
@@ -50,6 +68,102 @@ BOOST_AUTO_TEST_CASE(request)
     BOOST_CHECK_EQUAL(sParser.consume(sData.data(), sData.size()), sData.size());
     BOOST_CHECK(sCalled);
 }
+BOOST_AUTO_TEST_CASE(allocations)
+{
+    const std::string sData =
+        "GET /api/v1/some/long/path/to/resource?with=query&and=more HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n"
+        "POST /api/v1/upload HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "Content-Length: 11\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n"
+        "hello world";
+
+    unsigned                sCount   = 0;
+    httpd::Request::Handler sHandler = [&sCount](httpd::Request& aRequest) {
+        BOOST_REQUIRE_EQUAL(aRequest.header("host"), "example.com");
+        sCount++;
+    };
+    httpd::Parser<httpd::Request> sParser(sHandler);
+    sParser.consume(sData.data(), sData.size()); // warm up
+
+    const unsigned COUNT  = 1000;
+    const uint64_t sStart = gAllocations;
+    for (unsigned i = 0; i < COUNT; i++)
+        sParser.consume(sData.data(), sData.size());
+    const uint64_t sUsed = gAllocations - sStart;
+    BOOST_TEST_MESSAGE("allocations per request: " << double(sUsed) / (COUNT * 2));
+    BOOST_CHECK_EQUAL(sCount, COUNT * 2 + 2);
+    BOOST_CHECK_EQUAL(sUsed, 0);
+}
+BOOST_AUTO_TEST_CASE(reply)
+{
+    struct Collect
+    {
+        std::string result;
+        void        write(const iovec* aIov, size_t aCount)
+        {
+            for (size_t i = 0; i < aCount; i++)
+                result.append((const char*)aIov[i].iov_base, aIov[i].iov_len);
+        }
+    } sCollect;
+    sCollect.result.reserve(1024);
+
+    httpd::Reply sReply;
+    sReply.status = 404;
+    sReply.headers.push_back({"Content-Type", "text/plain"});
+    sReply.body = "not found";
+
+    sReply.write(sCollect); // warm up status and date cache
+    sCollect.result.clear();
+
+    const uint64_t sStart = gAllocations;
+    sReply.write(sCollect);
+    BOOST_CHECK_EQUAL(gAllocations - sStart, 0);
+    BOOST_TEST_MESSAGE("reply: " << sCollect.result);
+
+    const auto sDate = httpd::date_header();
+    BOOST_CHECK_EQUAL(sCollect.result,
+                      "HTTP/1.1 404 Not Found\r\n" +
+                          std::string(sDate) +
+                          "Connection: keep-alive\r\n"
+                          "Content-Length: 9\r\n"
+                          "Content-Type: text/plain\r\n"
+                          "\r\n"
+                          "not found");
+    BOOST_CHECK_EQUAL(httpd::status_line(200), "HTTP/1.1 200 OK\r\n");
+    BOOST_CHECK_EQUAL(httpd::status_line(503), "HTTP/1.1 503 Service Unavailable\r\n");
+}
+BOOST_AUTO_TEST_CASE(prefix)
+{
+    httpd::PrefixTree<int> sTree;
+    sTree.insert("/api", 1);
+    sTree.insert("/api/v1/", 2);
+    sTree.insert("/apple", 3);
+    sTree.insert("/api/v2", 4);
+    sTree.insert("/api", 5); // duplicate, first one wins
+
+    auto sFind = [&sTree](std::string_view aKey) {
+        auto sPtr = sTree.find(aKey);
+        return sPtr ? *sPtr : 0;
+    };
+    BOOST_CHECK_EQUAL(sFind("/api"), 1);
+    BOOST_CHECK_EQUAL(sFind("/api/v1"), 1);
+    BOOST_CHECK_EQUAL(sFind("/api/v1/users"), 2);
+    BOOST_CHECK_EQUAL(sFind("/api/v2/users"), 4);
+    BOOST_CHECK_EQUAL(sFind("/apple/pie"), 3);
+    BOOST_CHECK_EQUAL(sFind("/ap"), 0);
+    BOOST_CHECK_EQUAL(sFind("/other"), 0);
+
+    sTree.insert("/", 6);
+    BOOST_CHECK_EQUAL(sFind("/other"), 6);
+    BOOST_CHECK_EQUAL(sFind("/api/v1/users"), 2);
+}
 BOOST_AUTO_TEST_CASE(http2)
 {
     const std::string sData = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
@@ -58,8 +172,8 @@ BOOST_AUTO_TEST_CASE(http2)
 
     httpd::Request::Handler sHandler = [&sCalled](httpd::Request& aRequest) {
         BOOST_CHECK_EQUAL(aRequest.method, "PRI");
-        BOOST_CHECK_EQUAL(aRequest.url, "*");
-        BOOST_CHECK_EQUAL(aRequest.body, "2.0");
+        BOOST_CHECK_EQUAL(aRequest.url(), "*");
+        BOOST_CHECK_EQUAL(aRequest.body(), "2.0");
         sCalled = true;
     };
 
@@ -86,13 +200,13 @@ BOOST_AUTO_TEST_CASE(response)
 
     httpd::Response::Handler sHandler = [&sCalled](httpd::Response& aResponse) {
         BOOST_CHECK_EQUAL(aResponse.status, 200);
-        const auto sHeaders = aResponse.headers;
+        const auto sHeaders = aResponse.headers();
         for (const auto& x : sHeaders) {
             BOOST_TEST_MESSAGE("found header " << x.first << "=" << x.second);
             if (x.first == "Server")
                 BOOST_CHECK_EQUAL(x.second, "nginx/1.14.2");
         }
-        BOOST_CHECK_EQUAL(aResponse.body, "<?php\nphpinfo();\n?>\n");
+        BOOST_CHECK_EQUAL(aResponse.body(), "<?php\nphpinfo();\n?>\n");
         sCalled = true;
     };
 
@@ -159,6 +273,15 @@ struct WithServer
         };
         m_Router.insert("/slow", sHandler3); // call handler in worker thread
 
+        auto sHandler4 = [](Connection::SharedPtr aPeer, const Request& aRequest) {
+            httpd::Reply sReply;
+            sReply.headers.push_back({"Content-Type", "text/plain"});
+            sReply.body = aRequest.url();
+            sReply.write(*aPeer);
+            return Connection::UserResult::DONE;
+        };
+        m_Router.insert_sync("/reply", sHandler4);
+
         m_Router.start(m_Group);
         auto sListener = httpd::Create(&m_EPoll, 2081, m_Router);
         sListener->start();
@@ -180,6 +303,9 @@ BOOST_AUTO_TEST_CASE(curl)
     BOOST_CHECK_EQUAL(sResult.body, "9876543210");
     sResult = sClient.GET("http://127.0.0.1:2081/not_exists");
     BOOST_CHECK_EQUAL(sResult.status, 404);
+    sResult = sClient.GET("http://127.0.0.1:2081/reply/echo");
+    BOOST_CHECK_EQUAL(sResult.status, 200);
+    BOOST_CHECK_EQUAL(sResult.body, "/reply/echo");
 }
 
 BOOST_AUTO_TEST_CASE(raw)
@@ -194,9 +320,9 @@ BOOST_AUTO_TEST_CASE(raw)
         sResponseCount++;
         BOOST_TEST_MESSAGE("response " << sResponseCount);
         BOOST_TEST_MESSAGE("status:  " << aResponse.status);
-        for (const auto& x : aResponse.headers)
+        for (const auto& x : aResponse.headers())
             BOOST_TEST_MESSAGE("found header " << x.first << "=" << x.second);
-        BOOST_TEST_MESSAGE("body:    " << aResponse.body);
+        BOOST_TEST_MESSAGE("body:    " << aResponse.body());
         return ClientConnection::UserResult::DONE;
     });
     Threads::WaitGroup sWait(1);
@@ -233,7 +359,7 @@ BOOST_AUTO_TEST_CASE(simple)
                          sResponseCount++;
                          BOOST_CHECK_EQUAL(aCode, 0);
                          BOOST_CHECK_EQUAL(aResponse.status, 200);
-                         BOOST_CHECK_EQUAL(aResponse.body, "0123456789");
+                         BOOST_CHECK_EQUAL(aResponse.body(), "0123456789");
                      }});
     std::this_thread::sleep_for(20ms);
 
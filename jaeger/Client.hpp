@@ -1,147 +1,282 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+
 #include "Jaeger.hpp"
+#include "Otlp.hpp"
 
-#include <curl/Curl.hpp>
-#include <threads/SafeQueue.hpp>
+#include <archive/Gzip.hpp>
+#include <archive/Util.hpp>
+#include <container/Lockfree.hpp>
+#include <curl/Multi.hpp>
 #include <unsorted/Env.hpp>
 #include <unsorted/Log4cxx.hpp>
 
 namespace Jaeger {
     inline log4cxx::LoggerPtr sLogger = Logger::Get("jaeger");
 
-    struct Client : boost::noncopyable
+    // head based sampling. decision of remote parent (traceparent flags) followed as is,
+    // so all services of trace agree. new traces sampled by trace id,
+    // rate limit counts traces started in current second
+    class Sampler
     {
-        struct Params
-        {
-            std::string url = Util::getEnv("JAEGER_URL");
-        };
-
-    private:
-        const Params          m_Params;
-        Curl::Client::Default m_Hint;
-        Curl::Client          m_Client;
+        const uint64_t        m_Threshold;
+        const unsigned        m_Limit;
+        std::atomic<uint64_t> m_Second{0};
+        std::atomic<unsigned> m_Count{0};
 
     public:
-        Client()
+        Sampler(double aRatio, unsigned aLimit)
+        : m_Threshold(std::clamp(aRatio, 0.0, 1.0) * (1ULL << 53))
+        , m_Limit(aLimit)
         {
-            INFO("using " << m_Params.url);
-            auto& sHeaders           = m_Hint.headers;
-            sHeaders["Content-Type"] = "application/x-protobuf";
         }
-        Curl::Client::Result send(std::string_view aMsg)
+
+        bool operator()(const Params& aParams) noexcept
         {
-            Curl::Client::Request sRequest{
-                .method = Curl::Client::Method::POST,
-                .url    = m_Params.url,
-                .body   = aMsg};
-            return m_Client(m_Hint.wrap(std::move(sRequest)));
+            if (aParams.sampled)
+                return *aParams.sampled;
+            if ((aParams.traceIdLow >> 11) >= m_Threshold)
+                return false;
+            if (m_Limit == 0)
+                return true;
+
+            const uint64_t sNow    = ::time(nullptr);
+            uint64_t       sSecond = m_Second.load(std::memory_order_relaxed);
+            if (sSecond != sNow and m_Second.compare_exchange_strong(sSecond, sNow))
+                m_Count.store(0, std::memory_order_relaxed);
+            return m_Count.fetch_add(1, std::memory_order_relaxed) < m_Limit;
         }
     };
 
+    /*
+        traces encoded to OTLP protobuf in caller thread (into thread local buffer),
+        and passed to exporter via lock free ring by swapping buffers.
+        exporter threads concatenate traces into requests (up to batch_size spans),
+        compress them and post via Curl::Multi with up to concurrency requests in flight.
+        if ring is full - trace dropped and counted.
+    */
     class Queue : public QueueFace
     {
-        const std::string         m_Service;
-        const std::string         m_Version;
-        static constexpr unsigned QUEUE_LIMIT = 20;   // max notifications in queue
-        static constexpr int      SPAN_LIMIT  = 1000; // max traces in single batch
+    public:
+        struct Params
+        {
+            std::string url         = Util::getEnv("JAEGER_URL");
+            unsigned    concurrency = 4;    // requests in flight
+            unsigned    threads     = 2;    // exporter threads, to compress in parallel
+            unsigned    ring_size   = 4096; // traces waiting for export, power of 2
+            size_t      batch_size  = 1000; // max spans in single request
+            double      linger      = 1.0;  // max delay before export, seconds
+            bool        gzip        = true;
+            double      ratio       = 1.0; // part of traces to export
+            unsigned    rate_limit  = 0;   // max traces per second, 0 - unlimited
+        };
+
+    private:
+        const Params m_Params;
+        std::string  m_Resource; // encoded Resource, common for all requests
+        Sampler      m_Sampler;
+
+        struct Encoded
+        {
+            std::string data;
+            size_t      count = 0;
+        };
+        Container::MPSC_Ring<Encoded> m_Ring;
+        std::atomic<size_t>           m_Pending{0}; // spans in ring, to wake exporter
 
-        std::mutex                                      m_Mutex;
-        trace::TracesData     m_Traces;
-        trace::ResourceSpans* m_Spans     = nullptr;
-        int                                             m_SpanCount = 0;
+        std::atomic<uint64_t> m_Exported{0};
+        std::atomic<uint64_t> m_Dropped{0};
+        std::atomic<uint64_t> m_Failed{0};
 
-        struct Info
+        struct Request
         {
-            std::string serialized = {};
-            int         count      = {};
+            std::string body;
+            std::string compressed;
+            size_t      count = 0;
         };
+        std::vector<Request>  m_Requests;
+        std::vector<Request*> m_Free; // requests not in flight
 
-        Client                         m_Client;
-        Threads::SafeQueueThread<Info> m_Queue;
-        Threads::Group                 m_Group; // must be last, to be destroyed first
+        std::mutex              m_RingMutex; // ring consumer is single, only exporter threads wait for it
+        std::mutex              m_Mutex;
+        std::condition_variable m_Cond;
+        bool                    m_Stop = false;
 
-        void push_i()
+        Curl::Multi    m_Multi;
+        Threads::Group m_Network; // stopped after exporter
+        Threads::Group m_Group;   // must be last, to be destroyed first
+
+        Request* acquire()
         {
-            assert(m_Spans);
-            m_Queue.insert(Info{m_Traces.SerializeAsString(), m_SpanCount});
-            m_Spans     = nullptr;
-            m_SpanCount = 0;
-            m_Traces.Clear();
+            std::unique_lock sLock(m_Mutex);
+            m_Cond.wait(sLock, [this]() { return !m_Free.empty(); });
+            auto sRequest = m_Free.back();
+            m_Free.pop_back();
+            return sRequest;
         }
 
-        void idle()
+        void release(Request* aRequest)
         {
             std::unique_lock sLock(m_Mutex);
-            if (m_Queue.size() == 0 and m_Spans != nullptr)
-                push_i();
+            m_Free.push_back(aRequest);
+            m_Cond.notify_all();
         }
 
-        void process(const Info& aInfo)
+        void post(Archive::WriteGzip& aGzip, Request* aRequest)
         {
-            try {
-                DEBUG("flush " << aInfo.count << " spans");
-                auto sResult = m_Client.send(aInfo.serialized);
-                if (sResult.status != 200)
-                    ERROR(Exception::HttpError::format(sResult.body, sResult.status));
-            } catch (const std::exception& aErr) {
-                ERROR(aErr.what());
+            Curl::Client::Request sRequest{
+                .method = Curl::Client::Method::POST,
+                .url    = m_Params.url,
+                .body   = aRequest->body};
+            sRequest.headers["Content-Type"] = "application/x-protobuf";
+            sRequest.headers["Expect"]       = ""; // no 100-continue round trip for large batches
+            if (m_Params.gzip) {
+                aRequest->compressed.clear();
+                Archive::filter(aRequest->body, &aGzip, aRequest->compressed);
+                sRequest.body                        = aRequest->compressed;
+                sRequest.headers["Content-Encoding"] = "gzip";
             }
+
+            m_Multi(sRequest, [this, aRequest](Curl::Multi::Result&& aResult) {
+                try {
+                    auto sResult = aResult.get();
+                    if (sResult.status != 200)
+                        throw Exception::HttpError(sResult.body, sResult.status);
+                    DEBUG("exported " << aRequest->count << " spans");
+                    m_Exported += aRequest->count;
+                } catch (const std::exception& aErr) {
+                    ERROR("fail to export " << aRequest->count << " spans: " << aErr.what());
+                    m_Failed += aRequest->count;
+                }
+                release(aRequest);
+            });
         }
 
-        void set_tag(common::KeyValue* aTag, const std::string& aKey, const std::string& aValue)
+        // send everything from ring
+        void flush(Archive::WriteGzip& aGzip)
         {
-            aTag->set_key(aKey);
-            aTag->mutable_value()->set_string_value(aValue);
+            while (true) {
+                auto sRequest = acquire();
+                sRequest->body.clear();
+                sRequest->count = 0;
+
+                Protobuf::Writer sWriter(sRequest->body);
+                sWriter.message(Otlp::TRACES_RESOURCE_SPANS, [&]() {
+                    sWriter.append(m_Resource);
+                    std::unique_lock sLock(m_RingMutex);
+                    while (sRequest->count < m_Params.batch_size and m_Ring.pop([&](Encoded& aTrace) {
+                               sWriter.append(aTrace.data);
+                               sRequest->count += aTrace.count;
+                           }))
+                        ;
+                });
+
+                if (sRequest->count == 0) {
+                    release(sRequest);
+                    return;
+                }
+                m_Pending -= sRequest->count;
+                try {
+                    post(aGzip, sRequest);
+                } catch (const std::exception& aErr) {
+                    ERROR("fail to export " << sRequest->count << " spans: " << aErr.what());
+                    m_Failed += sRequest->count;
+                    release(sRequest);
+                }
+            }
+        }
+
+        void thread_loop()
+        {
+            Threads::threadName("jaeger");
+            Archive::WriteGzip sGzip(1, true); // fast mode, ratio is close to default for protobuf
+            bool               sStop = false;
+            while (!sStop) {
+                {
+                    std::unique_lock sLock(m_Mutex);
+                    m_Cond.wait_for(sLock, std::chrono::duration<double>(m_Params.linger), [this]() {
+                        return m_Stop or m_Pending >= m_Params.batch_size;
+                    });
+                    sStop = m_Stop;
+                }
+                flush(sGzip);
+            }
+
+            // wait requests in flight
+            std::unique_lock sLock(m_Mutex);
+            m_Cond.wait(sLock, [this]() { return m_Free.size() == m_Requests.size(); });
         }
 
     public:
-        Queue(const std::string& aService, const std::string aVersion)
-        : m_Service(aService)
-        , m_Version(aVersion)
-        , m_Queue([this](const Info& aInfo) { process(aInfo); },
-                  {.retry  = true,
-                   .linger = 2,
-                   .idle   = [this]() { idle(); }})
+        Queue(const std::string& aService, const std::string& aVersion)
+        : Queue(aService, aVersion, Params{})
         {
         }
 
+        Queue(const std::string& aService, const std::string& aVersion, const Params& aParams)
+        : m_Params(aParams)
+        , m_Sampler(aParams.ratio, aParams.rate_limit)
+        , m_Ring(aParams.ring_size)
+        , m_Requests(aParams.concurrency)
+        , m_Multi({.max_connections = aParams.concurrency})
+        {
+            INFO("using " << m_Params.url);
+            if (m_Params.concurrency == 0 or m_Params.threads == 0)
+                throw std::invalid_argument("Jaeger::Queue: zero concurrency");
+            Otlp::resource(m_Resource, {Tag{"service.name", aService}, Tag{"service.version", aVersion}});
+            for (auto& x : m_Requests)
+                m_Free.push_back(&x);
+        }
+
         void start()
         {
+            m_Multi.start(m_Network);
+            m_Group.start([this]() { thread_loop(); }, m_Params.threads);
             m_Group.at_stop([this]() {
                 std::unique_lock sLock(m_Mutex);
-                if (m_Spans != nullptr)
-                    push_i();
+                m_Stop = true;
+                m_Cond.notify_all();
             });
-            m_Queue.start(m_Group);
         }
 
-        void send(trace::ScopeSpans& aMsg) noexcept override
+        void send(const Jaeger::Params& aParams, const SpanList& aSpans) noexcept override
         {
-            const int sCount = aMsg.spans_size();
+            if (aSpans.empty())
+                return;
             try {
-                std::unique_lock sLock(m_Mutex);
+                static thread_local std::string sBuffer;
+                sBuffer.clear();
+                Otlp::encode(sBuffer, aParams, aSpans);
 
-                if (m_Queue.size() >= QUEUE_LIMIT) {
-                    ERROR("fail to enqueue " << sCount << " spans: queue limit");
+                const size_t sPending = m_Pending.fetch_add(aSpans.size()) + aSpans.size();
+                const bool   sPushed  = m_Ring.push([&](Encoded& aCell) {
+                    std::swap(aCell.data, sBuffer); // old buffer reused for next trace
+                    aCell.count = aSpans.size();
+                });
+                if (!sPushed) {
+                    m_Pending -= aSpans.size();
+                    m_Dropped += aSpans.size();
                     return;
                 }
-
-                if (m_Spans == nullptr) {
-                    m_Spans = m_Traces.add_resource_spans();
-                    set_tag(m_Spans->mutable_resource()->add_attributes(), "service.name", m_Service);
-                    set_tag(m_Spans->mutable_resource()->add_attributes(), "service.version", m_Version);
+                if (sPending >= m_Params.batch_size) {
+                    // exporter checks m_Pending under m_Mutex: notify under it too, or wakeup is lost
+                    std::unique_lock sLock(m_Mutex);
+                    m_Cond.notify_all();
                 }
-
-                auto sScope = m_Spans->add_scope_spans();
-                *sScope     = std::move(aMsg);
-                m_SpanCount += sCount;
-
-                if (m_SpanCount >= SPAN_LIMIT)
-                    push_i();
-            } catch (const std::exception& e) {
-                ERROR("fail to enqueue " << sCount << " spans: " << e.what());
+            } catch (...) {
+                m_Dropped += aSpans.size();
             }
         }
+
+        bool sample(const Jaeger::Params& aParams) noexcept override
+        {
+            return m_Sampler(aParams);
+        }
+
+        uint64_t exported() const { return m_Exported; }
+        uint64_t dropped() const { return m_Dropped; }
+        uint64_t failed() const { return m_Failed; }
     };
 } // namespace Jaeger
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/asio.hpp>
+
+#include <atomic>
+
+#include "Otlp.hpp"
+
+#include <archive/Gzip.hpp>
+#include <archive/Util.hpp>
+#include <threads/Group.hpp>
+
+namespace Jaeger {
+
+    // OTLP/HTTP endpoint stub for tests and benchmarks: decode requests and count spans
+    class Collector
+    {
+        using tcp = boost::asio::ip::tcp;
+
+        boost::asio::io_context m_Context;
+        tcp::acceptor           m_Acceptor;
+        std::atomic<uint64_t>   m_Spans{0};
+        std::atomic<uint64_t>   m_Requests{0};
+        std::atomic<uint64_t>   m_Bytes{0};
+        Threads::Group          m_Group; // must be last
+
+        struct Connection : std::enable_shared_from_this<Connection>
+        {
+            Collector&             m_Parent;
+            tcp::socket            m_Socket;
+            boost::asio::streambuf m_Buffer;
+            size_t                 m_Length = 0;
+            bool                   m_Gzip   = false;
+
+            Connection(Collector& aParent, tcp::socket&& aSocket)
+            : m_Parent(aParent)
+            , m_Socket(std::move(aSocket))
+            {
+            }
+
+            void read_header()
+            {
+                boost::asio::async_read_until(m_Socket, m_Buffer, "\r\n\r\n", [p = shared_from_this()](boost::system::error_code ec, size_t aSize) {
+                    if (ec)
+                        return;
+                    std::string sHeader(boost::asio::buffers_begin(p->m_Buffer.data()), boost::asio::buffers_begin(p->m_Buffer.data()) + aSize);
+                    p->m_Buffer.consume(aSize);
+                    boost::algorithm::to_lower(sHeader);
+
+                    p->m_Length = 0;
+                    if (auto sPos = sHeader.find("content-length:"); sPos != std::string::npos)
+                        p->m_Length = std::stoul(sHeader.substr(sPos + 15));
+                    p->m_Gzip = sHeader.find("content-encoding: gzip") != std::string::npos;
+                    if (sHeader.find("expect: 100-continue") != std::string::npos)
+                        boost::asio::write(p->m_Socket, boost::asio::buffer(std::string_view("HTTP/1.1 100 Continue\r\n\r\n")), ec);
+                    p->read_body();
+                });
+            }
+
+            void read_body()
+            {
+                const size_t sNeed = m_Length > m_Buffer.size() ? m_Length - m_Buffer.size() : 0;
+                boost::asio::async_read(m_Socket, m_Buffer, boost::asio::transfer_exactly(sNeed), [p = shared_from_this()](boost::system::error_code ec, size_t) {
+                    if (ec)
+                        return;
+                    std::string sBody(boost::asio::buffers_begin(p->m_Buffer.data()), boost::asio::buffers_begin(p->m_Buffer.data()) + p->m_Length);
+                    p->m_Buffer.consume(p->m_Length);
+
+                    std::string_view sReply = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+                    try {
+                        p->m_Parent.process(sBody, p->m_Gzip);
+                    } catch (const std::exception&) {
+                        sReply = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n";
+                    }
+                    boost::asio::write(p->m_Socket, boost::asio::buffer(sReply), ec);
+                    if (!ec)
+                        p->read_header();
+                });
+            }
+        };
+
+        void accept()
+        {
+            m_Acceptor.async_accept([this](boost::system::error_code ec, tcp::socket aSocket) {
+                if (ec)
+                    return;
+                std::make_shared<Connection>(*this, std::move(aSocket))->read_header();
+                accept();
+            });
+        }
+
+        void process(const std::string& aBody, bool aGzip)
+        {
+            std::string sClear;
+            if (aGzip) {
+                Archive::ReadGzip sGzip;
+                Archive::filter(aBody, &sGzip, sClear);
+            }
+            const std::string& sData = aGzip ? sClear : aBody;
+
+            // TracesData.ResourceSpans.ScopeSpans.Span
+            size_t           sCount = 0;
+            Protobuf::Reader sReader(sData);
+            sReader.parse([&](const Protobuf::FieldInfo& aField, Protobuf::Reader* aReader) {
+                if (aField.id != Otlp::TRACES_RESOURCE_SPANS)
+                    return Protobuf::ACT_SKIP;
+                aReader->sub().parse([&](const Protobuf::FieldInfo& aField, Protobuf::Reader* aReader) {
+                    if (aField.id != Otlp::RESOURCE_SPANS_SCOPE_SPANS)
+                        return Protobuf::ACT_SKIP;
+                    aReader->sub().parse([&](const Protobuf::FieldInfo& aField, Protobuf::Reader*) {
+                        if (aField.id == Otlp::SCOPE_SPANS_SPANS)
+                            sCount++;
+                        return Protobuf::ACT_SKIP;
+                    });
+                    return Protobuf::ACT_USED;
+                });
+                return Protobuf::ACT_USED;
+            });
+
+            m_Spans += sCount;
+            m_Bytes += aBody.size();
+            m_Requests++;
+        }
+
+    public:
+        // any free port if aPort is 0
+        Collector(uint16_t aPort = 0)
+        : m_Acceptor(m_Context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), aPort))
+        {
+        }
+
+        void start(unsigned aThreads = 1)
+        {
+            accept();
+            m_Group.start([this]() { m_Context.run(); }, aThreads);
+            m_Group.at_stop([this]() { m_Context.stop(); });
+        }
+
+        std::string url() const { return "http://127.0.0.1:" + std::to_string(m_Acceptor.local_endpoint().port()) + "/v1/traces"; }
+
+        uint64_t spans() const { return m_Spans; }
+        uint64_t requests() const { return m_Requests; }
+        uint64_t bytes() const { return m_Bytes; } // as received, compressed
+    };
+} // namespace Jaeger
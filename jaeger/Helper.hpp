@@ -8,8 +8,11 @@
 
 namespace Jaeger {
 
+    // empty span if trace not sampled
     inline SpanPtr start(const Params& aParams, QueuePtr aQueue, const std::string& aName)
     {
+        if (!aQueue->sample(aParams))
+            return {};
         return std::make_shared<Span>(aParams, aQueue, aName);
     }
 
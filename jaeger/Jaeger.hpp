@@ -1,6 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
 #include <variant>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
 
@@ -10,7 +17,6 @@
 #include <parser/Hex.hpp>
 #include <parser/Parser.hpp>
 #include <time/Meter.hpp>
-#include <trace.pb.h>
 #include <unsorted/Random.hpp>
 #include <unsorted/Uuid.hpp>
 
@@ -22,13 +28,15 @@ namespace Jaeger {
         uint64_t traceIdLow  = 0;
         uint64_t parentId    = 0;
 
+        std::optional<bool> sampled; // decision of remote parent, not set for new trace
+
         std::string traceparent() const // for HTTP headers
         {
             return "00-" + // version
                    Format::to_hex(htobe64(traceIdHigh)) +
                    Format::to_hex(htobe64(traceIdLow)) + '-' +
                    Format::to_hex(htobe64(parentId)) + '-' +
-                   "00"; // flags
+                   (sampled.value_or(false) ? "01" : "00"); // flags
         };
 
         std::string binary_trace_id() const
@@ -61,7 +69,8 @@ namespace Jaeger {
                     case 3: // parent id
                         sNew.parentId = be64toh(Parser::from_hex<uint64_t>(aParam));
                         break;
-                    case 4: // flags not used
+                    case 4: // flags
+                        sNew.sampled = Parser::from_hex<uint8_t>(aParam) & 0x01;
                         break;
                     }
                 },
@@ -77,44 +86,55 @@ namespace Jaeger {
         }
     };
 
-    namespace common = opentelemetry::proto::common::v1;
-    namespace trace  = opentelemetry::proto::trace::v1;
-
     struct Tag
     {
         std::string name;
 
         std::variant<std::string, const char*, double, bool, int64_t> value;
+    };
+    using TagList = std::vector<Tag>;
 
-        void convert(common::KeyValue* aTag) const
-        {
-            aTag->set_key(name);
-            auto sValue = aTag->mutable_value();
-            std::visit(Mpl::overloaded{
-                           [&](const std::string& arg) { sValue->set_string_value(arg); },
-                           [&](const char* arg) { sValue->set_string_value(arg); },
-                           [&](double arg) { sValue->set_double_value(arg); },
-                           [&](bool arg) { sValue->set_bool_value(arg); },
-                           [&](int64_t arg) { sValue->set_int_value(arg); },
-                       },
-                       value);
-        }
+    struct Event
+    {
+        uint64_t    time = 0; // unix ns
+        std::string name;
+        TagList     attributes;
+    };
+
+    // span kept as plain data until trace is complete, and encoded to OTLP protobuf by queue
+    struct SpanData
+    {
+        std::string        name;
+        uint64_t           span_id   = 0;
+        uint64_t           parent_id = 0;
+        uint64_t           start     = 0; // unix ns
+        uint64_t           end       = 0;
+        TagList            attributes;
+        std::vector<Event> events;
+        bool               failed = false;
+        std::string        message; // status message if failed
     };
+    using SpanList = std::deque<SpanData>; // stable addresses on append
 
     class QueueFace : boost::noncopyable
     {
     public:
-        virtual void send(trace::ScopeSpans& aMsg) noexcept = 0;
+        // called once for complete trace
+        virtual void send(const Params& aParams, const SpanList& aSpans) noexcept = 0;
+
+        // head based sampling: trace not started if false
+        virtual bool sample(const Params& aParams) noexcept { return true; }
+
         virtual ~QueueFace() {};
     };
     using QueuePtr = std::shared_ptr<QueueFace>;
 
     class Store : boost::noncopyable
     {
-        const Params      m_Params;
-        QueuePtr          m_Queue;
-        std::mutex        m_Mutex;
-        trace::ScopeSpans m_Spans;
+        const Params m_Params;
+        QueuePtr     m_Queue;
+        std::mutex   m_Mutex;
+        SpanList     m_Spans;
 
     public:
         Store(const Params& aParams, QueuePtr aQueue)
@@ -128,32 +148,32 @@ namespace Jaeger {
             return m_Params;
         }
 
-        trace::Span* create_span()
+        SpanData* create_span()
         {
             std::unique_lock sLock(m_Mutex);
-            return m_Spans.add_spans();
+            return &m_Spans.emplace_back();
         }
 
         template <class T>
         void iterate(T t)
         {
             std::unique_lock sLock(m_Mutex);
-            for (auto& x : m_Spans.spans()) {
+            for (auto& x : m_Spans) {
                 t(x);
             }
         }
 
         ~Store()
         {
-            m_Queue->send(m_Spans);
+            m_Queue->send(m_Params, m_Spans);
         }
     };
     using StorePtr = std::shared_ptr<Store>;
 
     struct LogEntry
     {
-        const trace::Span*       m_Span  = nullptr;
-        const trace::Span_Event* m_Event = nullptr;
+        const SpanData* m_Span  = nullptr;
+        const Event*    m_Event = nullptr;
     };
     using LogList  = std::vector<LogEntry>;
     using TextList = std::vector<std::string>;
@@ -163,7 +183,7 @@ namespace Jaeger {
         const int m_XCount;
         StorePtr  m_Store;
 
-        trace::Span* m_Span = nullptr;
+        SpanData* m_Span = nullptr;
 
         const uint64_t m_SpanId = Util::random8();
         bool           m_Alive  = true;
@@ -173,24 +193,13 @@ namespace Jaeger {
             return std::make_shared<Store>(aParams, aQueue);
         }
 
-        static std::string to_binary(uint64_t aVal)
-        {
-            uint64_t sVal = htobe64(aVal);
-            return std::string(reinterpret_cast<const char*>(&sVal), sizeof(sVal));
-        }
-
         void init(const std::string& aName, uint64_t aParentSpanId)
         {
-            m_Span = m_Store->create_span();
-            m_Span->set_name(aName);
-            m_Span->set_trace_id(m_Store->params().binary_trace_id());
-            m_Span->set_span_id(to_binary(m_SpanId));
-            if (aParentSpanId or m_Store->params().parentId) {
-                m_Span->set_parent_span_id(to_binary(
-                    aParentSpanId == 0 ? m_Store->params().parentId
-                                       : aParentSpanId));
-            }
-            m_Span->set_start_time_unix_nano(Time::get_time().to_ns());
+            m_Span            = m_Store->create_span();
+            m_Span->name      = aName;
+            m_Span->span_id   = m_SpanId;
+            m_Span->parent_id = aParentSpanId == 0 ? m_Store->params().parentId : aParentSpanId;
+            m_Span->start     = Time::get_time().to_ns();
         }
 
     public:
@@ -229,8 +238,8 @@ namespace Jaeger {
                 if (m_Alive) {
                     if (m_XCount != std::uncaught_exceptions())
                         set_error();
-                    m_Span->set_end_time_unix_nano(Time::get_time().to_ns());
-                    m_Alive = false;
+                    m_Span->end = Time::get_time().to_ns();
+                    m_Alive     = false;
                 }
             } catch (...) {
                 m_Alive = false;
@@ -244,42 +253,43 @@ namespace Jaeger {
 
         void set_tag(const Tag& aTag)
         {
-            aTag.convert(m_Span->add_attributes());
+            m_Span->attributes.push_back(aTag);
         }
 
         void set_error(const char* aMessage = nullptr)
         {
-            auto sStatus = m_Span->mutable_status();
-            sStatus->set_message(aMessage != nullptr ? aMessage : "error");
-            sStatus->set_code(trace::Status::STATUS_CODE_ERROR);
+            m_Span->failed  = true;
+            m_Span->message = aMessage != nullptr ? aMessage : "error";
         }
 
         template <class... T>
         void set_log(const char* aName, const T&... aTag)
         {
-            auto sLog = m_Span->add_events();
-            sLog->set_time_unix_nano(Time::get_time().to_ns());
-            sLog->set_name(aName);
-            (static_cast<void>(aTag.convert(sLog->add_attributes())), ...);
+            auto& sLog = m_Span->events.emplace_back();
+            sLog.time  = Time::get_time().to_ns();
+            sLog.name  = aName;
+            sLog.attributes.reserve(sizeof...(aTag));
+            (sLog.attributes.push_back(aTag), ...);
         }
 
         std::string trace_id() const // for UI, logging.
         {
-            return Format::to_hex(m_Span->trace_id());
+            return Format::to_hex(m_Store->params().binary_trace_id());
         }
 
         std::string traceparent() const
         {
-            return Params{m_Store->params().traceIdHigh, m_Store->params().traceIdLow, m_SpanId}.traceparent();
+            // span exists only for sampled trace
+            return Params{m_Store->params().traceIdHigh, m_Store->params().traceIdLow, m_SpanId, true}.traceparent();
         }
 
         TextList export_log() const
         {
             TextList text;
             LogList  log;
-            m_Store->iterate([&](const trace::Span& aSpan) {
-                if (aSpan.events_size() > 0) {
-                    for (auto& event : aSpan.events()) {
+            m_Store->iterate([&](const SpanData& aSpan) {
+                if (!aSpan.events.empty()) {
+                    for (auto& event : aSpan.events) {
                         log.push_back(LogEntry{&aSpan, &event});
                     }
                 } else {
@@ -288,16 +298,16 @@ namespace Jaeger {
             });
             auto timestamp = [](auto& a) {
                 if (a.m_Event == nullptr) {
-                    return a.m_Span->start_time_unix_nano();
+                    return a.m_Span->start;
                 } else {
-                    return a.m_Event->time_unix_nano();
+                    return a.m_Event->time;
                 }
             };
             auto span_name = [](auto& a) -> std::string {
-                if (a->has_status()) {
-                    return a->name() + " (status: " + a->status().message() + ")";
+                if (a->failed) {
+                    return a->name + " (status: " + a->message + ")";
                 } else {
-                    return a->name();
+                    return a->name;
                 }
             };
             std::sort(log.begin(), log.end(), [&](auto a, auto b) {
@@ -310,21 +320,20 @@ namespace Jaeger {
                     text.push_back(name);
                 } else {
                     std::stringstream sTmp;
-                    Format::List(sTmp, x.m_Event->attributes(), [](auto a) {
+                    Format::List(sTmp, x.m_Event->attributes, [](auto a) {
                         std::stringstream sTmp;
-                        sTmp << a.key() << ": ";
-                        if (a.value().has_string_value()) {
-                            sTmp << a.value().string_value();
-                        } else if (a.value().has_int_value()) {
-                            sTmp << a.value().int_value();
-                        } else if (a.value().has_double_value()) {
-                            sTmp << a.value().double_value();
-                        } else {
-                            sTmp << "not-supported-value-type";
-                        }
+                        sTmp << a.name << ": ";
+                        std::visit(Mpl::overloaded{
+                                       [&](const std::string& arg) { sTmp << arg; },
+                                       [&](const char* arg) { sTmp << arg; },
+                                       [&](double arg) { sTmp << arg; },
+                                       [&](bool) { sTmp << "not-supported-value-type"; },
+                                       [&](int64_t arg) { sTmp << arg; },
+                                   },
+                                   a.value);
                         return sTmp.str();
                     });
-                    std::string sStr = name + ": " + x.m_Event->name() + (x.m_Event->attributes_size() > 0 ? (" " + sTmp.str()) : "");
+                    std::string sStr = name + ": " + x.m_Event->name + (!x.m_Event->attributes.empty() ? (" " + sTmp.str()) : "");
                     text.push_back(std::move(sStr));
                 }
             }
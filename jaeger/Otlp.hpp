@@ -0,0 +1,146 @@
+#pragma once
+
+#include <endian.h>
+
+#include <protobuf/Protobuf.hpp>
+
+#include "Jaeger.hpp"
+
+/*
+    OTLP protobuf written directly with Protobuf::Writer, field numbers from otlp_proto
+
+    ScopeSpans of trace encoded as field of ResourceSpans, so encoded traces
+    can be concatenated after Resource to form request:
+
+    TracesData { ResourceSpans { Resource, ScopeSpans, ScopeSpans, ... } }
+*/
+
+namespace Jaeger::Otlp {
+
+    enum : uint64_t
+    {
+        // TracesData
+        TRACES_RESOURCE_SPANS = 1,
+
+        // ResourceSpans
+        RESOURCE_SPANS_RESOURCE    = 1,
+        RESOURCE_SPANS_SCOPE_SPANS = 2,
+
+        // Resource
+        RESOURCE_ATTRIBUTES = 1,
+
+        // ScopeSpans
+        SCOPE_SPANS_SPANS = 2,
+
+        // Span
+        SPAN_TRACE_ID       = 1,
+        SPAN_SPAN_ID        = 2,
+        SPAN_PARENT_SPAN_ID = 4,
+        SPAN_NAME           = 5,
+        SPAN_START_TIME     = 7,
+        SPAN_END_TIME       = 8,
+        SPAN_ATTRIBUTES     = 9,
+        SPAN_EVENTS         = 11,
+        SPAN_STATUS         = 15,
+
+        // Span.Event
+        EVENT_TIME       = 1,
+        EVENT_NAME       = 2,
+        EVENT_ATTRIBUTES = 3,
+
+        // Status
+        STATUS_MESSAGE = 2,
+        STATUS_CODE    = 3,
+
+        // KeyValue
+        KEY_VALUE_KEY   = 1,
+        KEY_VALUE_VALUE = 2,
+
+        // AnyValue
+        ANY_VALUE_STRING = 1,
+        ANY_VALUE_BOOL   = 2,
+        ANY_VALUE_INT    = 3,
+        ANY_VALUE_DOUBLE = 4,
+    };
+
+    constexpr unsigned STATUS_CODE_ERROR = 2;
+
+    inline void encode(Protobuf::Writer& aWriter, uint64_t aId, const Tag& aTag)
+    {
+        aWriter.message(aId, [&]() {
+            aWriter.write(KEY_VALUE_KEY, aTag.name);
+            aWriter.message(KEY_VALUE_VALUE, [&]() {
+                std::visit(Mpl::overloaded{
+                               [&](const std::string& arg) { aWriter.write(ANY_VALUE_STRING, arg); },
+                               [&](const char* arg) { aWriter.write(ANY_VALUE_STRING, std::string_view(arg)); },
+                               [&](double arg) { aWriter.write(ANY_VALUE_DOUBLE, arg); },
+                               [&](bool arg) { aWriter.write(ANY_VALUE_BOOL, unsigned(arg)); },
+                               [&](int64_t arg) { aWriter.write(ANY_VALUE_INT, arg); },
+                           },
+                           aTag.value);
+            });
+        });
+    }
+
+    // ids are big endian bytes
+    inline void encode(Protobuf::Writer& aWriter, uint64_t aId, uint64_t aHigh, uint64_t aLow)
+    {
+        const uint64_t sId[2] = {htobe64(aHigh), htobe64(aLow)};
+        aWriter.write(aId, std::string_view(reinterpret_cast<const char*>(sId), sizeof(sId)));
+    }
+
+    inline void encode(Protobuf::Writer& aWriter, uint64_t aId, uint64_t aSpanId)
+    {
+        const uint64_t sId = htobe64(aSpanId);
+        aWriter.write(aId, std::string_view(reinterpret_cast<const char*>(&sId), sizeof(sId)));
+    }
+
+    inline void encode(Protobuf::Writer& aWriter, const Params& aParams, const SpanData& aSpan)
+    {
+        aWriter.message(SCOPE_SPANS_SPANS, [&]() {
+            encode(aWriter, SPAN_TRACE_ID, aParams.traceIdHigh, aParams.traceIdLow);
+            encode(aWriter, SPAN_SPAN_ID, aSpan.span_id);
+            if (aSpan.parent_id != 0)
+                encode(aWriter, SPAN_PARENT_SPAN_ID, aSpan.parent_id);
+            aWriter.write(SPAN_NAME, aSpan.name);
+            aWriter.write(SPAN_START_TIME, aSpan.start, Protobuf::FIXED);
+            aWriter.write(SPAN_END_TIME, aSpan.end, Protobuf::FIXED);
+            for (auto& x : aSpan.attributes)
+                encode(aWriter, SPAN_ATTRIBUTES, x);
+            for (auto& x : aSpan.events) {
+                aWriter.message(SPAN_EVENTS, [&]() {
+                    aWriter.write(EVENT_TIME, x.time, Protobuf::FIXED);
+                    aWriter.write(EVENT_NAME, x.name);
+                    for (auto& y : x.attributes)
+                        encode(aWriter, EVENT_ATTRIBUTES, y);
+                });
+            }
+            if (aSpan.failed) {
+                aWriter.message(SPAN_STATUS, [&]() {
+                    aWriter.write(STATUS_MESSAGE, aSpan.message);
+                    aWriter.write(STATUS_CODE, STATUS_CODE_ERROR);
+                });
+            }
+        });
+    }
+
+    // ScopeSpans of single trace, as ResourceSpans field
+    inline void encode(std::string& aBuffer, const Params& aParams, const SpanList& aSpans)
+    {
+        Protobuf::Writer sWriter(aBuffer);
+        sWriter.message(RESOURCE_SPANS_SCOPE_SPANS, [&]() {
+            for (auto& x : aSpans)
+                encode(sWriter, aParams, x);
+        });
+    }
+
+    // Resource, as ResourceSpans field
+    inline void resource(std::string& aBuffer, const TagList& aTags)
+    {
+        Protobuf::Writer sWriter(aBuffer);
+        sWriter.message(RESOURCE_SPANS_RESOURCE, [&]() {
+            for (auto& x : aTags)
+                encode(sWriter, RESOURCE_ATTRIBUTES, x);
+        });
+    }
+} // namespace Jaeger::Otlp
@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+
+#include <thread>
+
+#include "Client.hpp"
+#include "Collector.hpp"
+#include "Helper.hpp"
+
+constexpr unsigned SPANS = 10; // per trace
+
+static void makeTrace(Jaeger::QueuePtr aQueue)
+{
+    using namespace Jaeger;
+    auto sTrace = start(Params::uuid(), aQueue, "root");
+    set_tag(sTrace, Tag{"count", 50l});
+    for (unsigned i = 1; i < SPANS; i++) {
+        auto sSpan = start(sTrace, "child");
+        set_log(sSpan, "merge", Tag{"factor", 42.2}, Tag{"name", "value"});
+    }
+}
+
+// encode only: trace of SPANS spans to reused buffer
+static void BM_Encode(benchmark::State& state)
+{
+    struct Encode : Jaeger::QueueFace
+    {
+        std::string m_Buffer;
+        void        send(const Jaeger::Params& aParams, const Jaeger::SpanList& aSpans) noexcept override
+        {
+            m_Buffer.clear();
+            Jaeger::Otlp::encode(m_Buffer, aParams, aSpans);
+        }
+    };
+    auto sQueue = std::make_shared<Encode>();
+    for (auto _ : state)
+        makeTrace(sQueue);
+    state.counters["spans/sec"] = benchmark::Counter(state.iterations() * SPANS, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Encode);
+
+// TRACES traces from N threads exported to local collector.
+// time measured until collector got all spans (or they are dropped).
+// arg 0: threads, arg 1: gzip
+static void BM_Export(benchmark::State& state)
+{
+    constexpr unsigned TRACES   = 20000; // per thread
+    const unsigned     sThreads = state.range(0);
+    const uint64_t     sTotal   = uint64_t(TRACES) * SPANS * sThreads;
+
+    Jaeger::Collector sCollector;
+    sCollector.start(4);
+
+    auto sQueue = std::make_shared<Jaeger::Queue>("benchmark", "0.1", Jaeger::Queue::Params{.url = sCollector.url(), .linger = 0.01, .gzip = bool(state.range(1))});
+    sQueue->start();
+
+    uint64_t sDone = 0;
+    for (auto _ : state) {
+        Time::Meter sMeter;
+
+        std::vector<std::thread> sList;
+        for (unsigned t = 0; t < sThreads; t++)
+            sList.emplace_back([&]() {
+                for (unsigned i = 0; i < TRACES; i++)
+                    makeTrace(sQueue);
+            });
+        for (auto& x : sList)
+            x.join();
+
+        sDone += sTotal;
+        while (sCollector.spans() + sQueue->dropped() + sQueue->failed() < sDone)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        state.SetIterationTime(sMeter.get().to_double());
+    }
+    state.counters["spans/sec"] = benchmark::Counter(sCollector.spans(), benchmark::Counter::kIsRate);
+    state.counters["dropped"]   = sQueue->dropped();
+    state.counters["requests"]  = sCollector.requests();
+    state.counters["bytes"]     = sCollector.bytes();
+}
+BENCHMARK(BM_Export)->UseManualTime()->Unit(benchmark::kMillisecond)->Args({1, 0})->Args({1, 1})->Args({4, 0})->Args({4, 1});
+
+BENCHMARK_MAIN();
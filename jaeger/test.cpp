@@ -7,9 +7,12 @@ using namespace std::chrono_literals;
 #include <thread>
 
 #include "Client.hpp"
+#include "Collector.hpp"
 #include "Helper.hpp"
 #include "Jaeger.hpp"
 
+#include <trace.pb.h>
+
 static void waitTrace(const std::string& aTraceID)
 {
     bool sTraceFound = false;
@@ -37,6 +40,12 @@ BOOST_AUTO_TEST_CASE(params)
     BOOST_CHECK_EQUAL(sParsed.traceIdHigh, sParams.traceIdHigh);
     BOOST_CHECK_EQUAL(sParsed.traceIdLow, sParams.traceIdLow);
     BOOST_CHECK_EQUAL(sParsed.parentId, sParams.parentId);
+    BOOST_CHECK(sParsed.sampled == false);
+
+    auto sSampled    = sParams;
+    sSampled.sampled = true;
+    BOOST_CHECK(sSampled.traceparent().ends_with("-01"));
+    BOOST_CHECK(Jaeger::Params::parse(sSampled.traceparent()).sampled == true);
 }
 BOOST_AUTO_TEST_CASE(simple)
 {
@@ -138,4 +147,136 @@ BOOST_AUTO_TEST_CASE(parts)
     }
     std::this_thread::sleep_for(10ms);
 }
+// encoded traces kept as request body
+struct EncodeQueue : Jaeger::QueueFace
+{
+    std::string m_Body;
+
+    void send(const Jaeger::Params& aParams, const Jaeger::SpanList& aSpans) noexcept override
+    {
+        Protobuf::Writer sWriter(m_Body);
+        sWriter.message(Jaeger::Otlp::TRACES_RESOURCE_SPANS, [&]() {
+            Jaeger::Otlp::resource(m_Body, {Jaeger::Tag{"service.name", "test.cpp"}});
+            Jaeger::Otlp::encode(m_Body, aParams, aSpans);
+        });
+    }
+};
+BOOST_AUTO_TEST_CASE(otlp)
+{
+    using namespace Jaeger;
+    namespace trace = opentelemetry::proto::trace::v1;
+
+    auto        sQueue  = std::make_shared<EncodeQueue>();
+    auto        sParams = Params::uuid();
+    std::string sTraceParent;
+    {
+        auto sTrace = start(sParams, sQueue, "root");
+        set_tag(sTrace, Tag{"count", 50l});
+        set_tag(sTrace, Tag{"remote", true});
+        set_tag(sTrace, Tag{"string", std::string(200, 'x')}); // long length
+        {
+            auto sChild = start(sTrace, "child");
+            set_log(sChild, "merge", Tag{"factor", 42.2}, Tag{"negative", -5l}, Tag{"name", "value"});
+            set_error(sChild, "failed");
+            sTraceParent = sChild->traceparent();
+        }
+    }
+
+    trace::TracesData sData;
+    BOOST_REQUIRE(sData.ParseFromString(sQueue->m_Body));
+    BOOST_REQUIRE_EQUAL(sData.resource_spans_size(), 1);
+    auto& sResource = sData.resource_spans(0);
+    BOOST_REQUIRE_EQUAL(sResource.resource().attributes_size(), 1);
+    BOOST_CHECK_EQUAL(sResource.resource().attributes(0).value().string_value(), "test.cpp");
+    BOOST_REQUIRE_EQUAL(sResource.scope_spans_size(), 1);
+    BOOST_REQUIRE_EQUAL(sResource.scope_spans(0).spans_size(), 2);
+
+    auto& sRoot  = sResource.scope_spans(0).spans(0);
+    auto& sChild = sResource.scope_spans(0).spans(1);
+    BOOST_CHECK_EQUAL(sRoot.name(), "root");
+    BOOST_CHECK_EQUAL(sRoot.trace_id(), sParams.binary_trace_id());
+    BOOST_CHECK(sRoot.parent_span_id().empty());
+    BOOST_CHECK_LE(sRoot.start_time_unix_nano(), sRoot.end_time_unix_nano());
+    BOOST_REQUIRE_EQUAL(sRoot.attributes_size(), 3);
+    BOOST_CHECK_EQUAL(sRoot.attributes(0).key(), "count");
+    BOOST_CHECK_EQUAL(sRoot.attributes(0).value().int_value(), 50);
+    BOOST_CHECK_EQUAL(sRoot.attributes(1).value().bool_value(), true);
+    BOOST_CHECK_EQUAL(sRoot.attributes(2).value().string_value().size(), 200);
+    BOOST_CHECK(!sRoot.has_status());
+
+    BOOST_CHECK_EQUAL(sChild.name(), "child");
+    BOOST_CHECK_EQUAL(sChild.parent_span_id(), sRoot.span_id());
+    BOOST_CHECK_EQUAL(Params::parse(sTraceParent).parentId, be64toh(*reinterpret_cast<const uint64_t*>(sChild.span_id().data())));
+    BOOST_REQUIRE_EQUAL(sChild.events_size(), 1);
+    auto& sEvent = sChild.events(0);
+    BOOST_CHECK_EQUAL(sEvent.name(), "merge");
+    BOOST_REQUIRE_EQUAL(sEvent.attributes_size(), 3);
+    BOOST_CHECK_EQUAL(sEvent.attributes(0).value().double_value(), 42.2);
+    BOOST_CHECK_EQUAL(sEvent.attributes(1).value().int_value(), -5);
+    BOOST_CHECK_EQUAL(sEvent.attributes(2).value().string_value(), "value");
+    BOOST_CHECK_EQUAL(sChild.status().message(), "failed");
+    BOOST_CHECK_EQUAL(sChild.status().code(), trace::Status::STATUS_CODE_ERROR);
+}
+BOOST_AUTO_TEST_CASE(sampler)
+{
+    Jaeger::Sampler sHalf(0.5, 0);
+    unsigned        sCount = 0;
+    for (unsigned i = 0; i < 10000; i++) {
+        const auto sParams = Jaeger::Params::uuid();
+        const bool sResult = sHalf(sParams);
+        BOOST_CHECK_EQUAL(sResult, sHalf(sParams)); // same decision for trace
+        sCount += sResult;
+    }
+    BOOST_CHECK_CLOSE(sCount / 10000.0, 0.5, 10);
+
+    Jaeger::Sampler sNone(0, 0);
+    BOOST_CHECK_EQUAL(sNone(Jaeger::Params::uuid()), false);
+
+    Jaeger::Sampler sLimit(1, 10);
+    sCount = 0;
+    for (unsigned i = 0; i < 1000; i++)
+        sCount += sLimit(Jaeger::Params::uuid());
+    BOOST_CHECK_GE(sCount, 10);
+    BOOST_CHECK_LE(sCount, 20); // second can change during loop
+
+    // remote parent decision followed, limit not applied
+    auto sRemote    = Jaeger::Params::uuid();
+    sRemote.sampled = true;
+    for (unsigned i = 0; i < 100; i++)
+        BOOST_CHECK(sLimit(sRemote) and sNone(sRemote));
+    sRemote.sampled = false;
+    BOOST_CHECK(!sHalf(sRemote));
+}
+BOOST_AUTO_TEST_CASE(collector)
+{
+    using namespace Jaeger;
+
+    Collector sCollector;
+    sCollector.start();
+
+    const unsigned THREADS = 4;
+    const unsigned TRACES  = 1000;
+    const unsigned SPANS   = 5;
+    {
+        auto sQueue = std::make_shared<Queue>("test.cpp", "0.1/test", Queue::Params{.url = sCollector.url(), .batch_size = 500, .linger = 0.01});
+        sQueue->start();
+
+        std::vector<std::thread> sThreads;
+        for (unsigned t = 0; t < THREADS; t++)
+            sThreads.emplace_back([&]() {
+                for (unsigned i = 0; i < TRACES; i++) {
+                    auto sTrace = start(Params::uuid(), sQueue, "root");
+                    for (unsigned j = 1; j < SPANS; j++)
+                        start(sTrace, "child");
+                    if (i % 100 == 0)
+                        std::this_thread::sleep_for(1ms); // do not overflow ring
+                }
+            });
+        for (auto& x : sThreads)
+            x.join();
+        BOOST_CHECK_EQUAL(sQueue->dropped(), 0);
+    } // flush on destruction
+    BOOST_TEST_MESSAGE("requests: " << sCollector.requests() << ", bytes: " << sCollector.bytes());
+    BOOST_CHECK_EQUAL(sCollector.spans(), THREADS * TRACES * SPANS);
+}
 BOOST_AUTO_TEST_SUITE_END()
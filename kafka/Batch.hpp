@@ -0,0 +1,381 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Kafka.hpp"
+
+namespace Kafka::Batch {
+
+    struct Record
+    {
+        std::string_view key; // empty key: all such records of batch go to one partition
+        std::string_view value;
+    };
+
+    // aggregate for whole batch
+    struct Result
+    {
+        size_t              delivered = 0;
+        size_t              failed    = 0;
+        rd_kafka_resp_err_t error     = RD_KAFKA_RESP_ERR_NO_ERROR; // one of errors, if any
+        double              latency   = 0;                          // ms, from produce to last delivery report
+    };
+
+    using Callback = std::function<void(const Result&)>;
+
+    struct Params
+    {
+        // accumulator used by add(). batch size and linger adapt to delivery latency:
+        // halved if latency above target, slowly increased otherwise
+        size_t min_records    = 64;
+        size_t max_records    = 65536;
+        size_t max_bytes      = 4 << 20;
+        double max_linger     = 50;  // ms
+        double target_latency = 100; // ms
+        bool   adaptive       = true;
+    };
+
+    // producer for pre-serialized records. payloads are not copied:
+    // rdkafka gets pointers, memory released after last delivery report of batch.
+    // records partitioned like by default partitioner (consistent_random), so key-partition mapping
+    // is same as for Kafka::Producer. rd_kafka_produce_batch called once per partition,
+    // records from first rejected with full queue retried in order with RD_KAFKA_MSG_F_BLOCK.
+    // delivery reports and callbacks are served by own thread: callbacks must be fast.
+    class Producer : public boost::noncopyable
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct Pending
+        {
+            Producer*                   parent = nullptr;
+            std::atomic<size_t>         left{0};
+            std::atomic<size_t>         failed{0};
+            std::atomic<int>            error{RD_KAFKA_RESP_ERR_NO_ERROR};
+            size_t                      count = 0;
+            bool                        accumulated = false;
+            Clock::time_point           start;
+            Callback                    callback;
+            std::shared_ptr<const void> owner;
+        };
+
+        // storage for add()
+        struct Accumulator
+        {
+            struct Offset
+            {
+                size_t key   = 0;
+                size_t value = 0;
+                size_t size  = 0; // value size, key size is value - key
+            };
+            std::string                           data;
+            std::vector<Offset>                   offsets;
+            std::shared_ptr<std::promise<Result>> promise = std::make_shared<std::promise<Result>>();
+            std::shared_future<Result>            future  = promise->get_future().share();
+            Clock::time_point                     start   = Clock::now();
+        };
+
+        const Params                       m_Params;
+        std::unique_ptr<RdKafka::Conf>     m_Config;
+        std::unique_ptr<RdKafka::Producer> m_Producer;
+        rd_kafka_topic_t*                  m_Topic      = nullptr;
+        int32_t                            m_Partitions = 0;
+        std::atomic<uint32_t>              m_Sticky{0};
+
+        std::mutex                   m_Mutex;
+        std::unique_ptr<Accumulator> m_Accumulator;
+        std::atomic<size_t>          m_Target;
+        std::atomic<double>          m_Linger;
+
+        std::atomic<uint64_t> m_Delivered{0};
+        std::atomic<uint64_t> m_Failed{0};
+
+        std::atomic_bool m_Stop{false};
+        std::thread      m_Thread;
+
+        static void OnDelivery(rd_kafka_t*, const rd_kafka_message_t* aMessage, void*)
+        {
+            auto sPending = static_cast<Pending*>(aMessage->_private);
+            if (aMessage->err != RD_KAFKA_RESP_ERR_NO_ERROR)
+                sPending->parent->fail(sPending, aMessage->err);
+            sPending->parent->release(sPending);
+        }
+
+        void fail(Pending* aPending, rd_kafka_resp_err_t aError)
+        {
+            aPending->failed++;
+            aPending->error = aError;
+        }
+
+        void release(Pending* aPending)
+        {
+            if (--aPending->left > 0)
+                return;
+            std::unique_ptr<Pending> sPending(aPending);
+
+            Result sResult;
+            sResult.failed    = sPending->failed;
+            sResult.delivered = sPending->count - sResult.failed;
+            sResult.error     = static_cast<rd_kafka_resp_err_t>(sPending->error.load());
+            sResult.latency   = std::chrono::duration<double, std::milli>(Clock::now() - sPending->start).count();
+            m_Delivered += sResult.delivered;
+            m_Failed += sResult.failed;
+            if (sPending->accumulated)
+                adapt(sResult.latency);
+            if (sPending->callback)
+                sPending->callback(sResult);
+        }
+
+        // AIMD, like congestion control
+        void adapt(double aLatency)
+        {
+            if (!m_Params.adaptive)
+                return;
+            size_t sTarget = m_Target;
+            double sLinger = m_Linger;
+            if (aLatency > m_Params.target_latency) {
+                sTarget = std::max(m_Params.min_records, sTarget / 2);
+                sLinger = sLinger / 2;
+            } else {
+                sTarget = std::min(m_Params.max_records, sTarget + sTarget / 8 + 1);
+                sLinger = std::min(m_Params.max_linger, sLinger * 1.1 + 0.01);
+            }
+            m_Target = sTarget;
+            m_Linger = sLinger;
+        }
+
+        int32_t partition(std::string_view aKey, int32_t aSticky) const
+        {
+            if (aKey.empty())
+                return aSticky;
+            return rd_kafka_msg_partitioner_consistent_random(m_Topic, aKey.data(), aKey.size(), m_Partitions, nullptr, nullptr);
+        }
+
+        // lock must be held
+        std::unique_ptr<Accumulator> detach()
+        {
+            if (!m_Accumulator or m_Accumulator->offsets.empty())
+                return nullptr;
+            return std::exchange(m_Accumulator, nullptr);
+        }
+
+        void send(std::unique_ptr<Accumulator> aBatch)
+        {
+            if (!aBatch)
+                return;
+            std::vector<Record> sRecords;
+            sRecords.reserve(aBatch->offsets.size());
+            const std::string_view sData = aBatch->data;
+            for (auto& x : aBatch->offsets)
+                sRecords.push_back({sData.substr(x.key, x.value - x.key), sData.substr(x.value, x.size)});
+            auto                        sPromise = aBatch->promise;
+            std::shared_ptr<const void> sOwner(std::move(aBatch));
+            produce(sRecords, [sPromise](const Result& aResult) { sPromise->set_value(aResult); }, std::move(sOwner), true);
+        }
+
+        void produce(std::span<const Record> aRecords, Callback&& aCallback, std::shared_ptr<const void>&& aOwner, bool aAccumulated)
+        {
+            auto sPending         = new Pending;
+            sPending->parent      = this;
+            sPending->left        = aRecords.size() + 1; // not completed until all records queued
+            sPending->count       = aRecords.size();
+            sPending->accumulated = aAccumulated;
+            sPending->start       = Clock::now();
+            sPending->callback    = std::move(aCallback);
+            sPending->owner       = std::move(aOwner);
+
+            // counting sort by partition: one produce_batch call per partition
+            thread_local std::vector<int32_t>            sPartition;
+            thread_local std::vector<uint32_t>           sIndex;
+            thread_local std::vector<rd_kafka_message_t> sMessages;
+            const int32_t                                sSticky = m_Sticky++ % m_Partitions;
+            sPartition.resize(aRecords.size());
+            sIndex.assign(m_Partitions + 1, 0);
+            for (size_t i = 0; i < aRecords.size(); i++) {
+                sPartition[i] = partition(aRecords[i].key, sSticky);
+                sIndex[sPartition[i] + 1]++;
+            }
+            for (int32_t p = 0; p < m_Partitions; p++)
+                sIndex[p + 1] += sIndex[p];
+            sMessages.resize(aRecords.size());
+            for (size_t i = 0; i < aRecords.size(); i++) {
+                auto& sMessage    = sMessages[sIndex[sPartition[i]]++];
+                sMessage          = rd_kafka_message_t{};
+                sMessage.payload  = const_cast<char*>(aRecords[i].value.data());
+                sMessage.len      = aRecords[i].value.size();
+                sMessage.key      = const_cast<char*>(aRecords[i].key.data());
+                sMessage.key_len  = aRecords[i].key.size();
+                sMessage._private = sPending;
+            }
+
+            // blocking from own thread is deadlock: nobody serves delivery reports
+            const int sBlock = std::this_thread::get_id() == m_Thread.get_id() ? 0 : RD_KAFKA_MSG_F_BLOCK;
+            size_t    sFrom  = 0;
+            for (int32_t p = 0; p < m_Partitions; p++) {
+                const size_t sTo = sIndex[p];
+                if (sFrom == sTo)
+                    continue;
+                const size_t sQueued = rd_kafka_produce_batch(m_Topic, p, 0, &sMessages[sFrom], sTo - sFrom);
+                if (sQueued == sTo - sFrom) {
+                    sFrom = sTo;
+                    continue;
+                }
+                // keep partition order: tail from first rejected record resubmitted one by one,
+                // after first error rest of tail is failed too
+                size_t i = sFrom;
+                while (sMessages[i].err == RD_KAFKA_RESP_ERR_NO_ERROR)
+                    i++;
+                bool sStop = false;
+                for (; i < sTo; i++) {
+                    auto& sMessage = sMessages[i];
+                    if (sMessage.err == RD_KAFKA_RESP_ERR_NO_ERROR)
+                        continue;
+                    if (!sStop and sMessage.err == RD_KAFKA_RESP_ERR__QUEUE_FULL and sBlock)
+                        sMessage.err = rd_kafka_producev(m_Producer->c_ptr(),
+                                                         RD_KAFKA_V_RKT(m_Topic),
+                                                         RD_KAFKA_V_PARTITION(p),
+                                                         RD_KAFKA_V_MSGFLAGS(sBlock),
+                                                         RD_KAFKA_V_VALUE(sMessage.payload, sMessage.len),
+                                                         RD_KAFKA_V_KEY(sMessage.key, sMessage.key_len),
+                                                         RD_KAFKA_V_OPAQUE(sPending),
+                                                         RD_KAFKA_V_END);
+                    if (sMessage.err != RD_KAFKA_RESP_ERR_NO_ERROR) {
+                        sStop = true;
+                        fail(sPending, sMessage.err);
+                        release(sPending);
+                    }
+                }
+                sFrom = sTo;
+            }
+            release(sPending);
+        }
+
+        void poll()
+        {
+            while (!m_Stop) {
+                m_Producer->poll(std::clamp<int>(m_Linger / 2, 1, 10));
+
+                std::unique_ptr<Accumulator> sBatch;
+                {
+                    std::unique_lock sLock(m_Mutex);
+                    if (m_Accumulator and std::chrono::duration<double, std::milli>(Clock::now() - m_Accumulator->start).count() >= m_Linger)
+                        sBatch = detach();
+                }
+                send(std::move(sBatch));
+            }
+        }
+
+    public:
+        Producer(const Options& aOptions, const std::string& aTopic, const Params& aParams = {})
+        : m_Params(aParams)
+        , m_Config(RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL))
+        , m_Target(aParams.min_records)
+        , m_Linger(aParams.max_linger / 10)
+        {
+            std::string sErr;
+            configure(m_Config.get(), aOptions);
+            rd_kafka_conf_set_dr_msg_cb(m_Config->c_ptr_global(), OnDelivery);
+
+            m_Producer.reset(RdKafka::Producer::create(m_Config.get(), sErr));
+            if (!m_Producer)
+                throw std::invalid_argument("Kafka::Batch::Producer: can't create producer: " + sErr);
+            ensure_topic(m_Producer.get(), aTopic, "Batch::Producer");
+
+            m_Topic = rd_kafka_topic_new(m_Producer->c_ptr(), aTopic.c_str(), nullptr);
+            if (m_Topic == nullptr)
+                throw std::invalid_argument("Kafka::Batch::Producer: can't create topic handle: " + aTopic);
+
+            const rd_kafka_metadata_t* sMeta = nullptr;
+            auto                       sCode = rd_kafka_metadata(m_Producer->c_ptr(), 0, m_Topic, &sMeta, TIMEOUT);
+            if (sCode == RD_KAFKA_RESP_ERR_NO_ERROR and sMeta->topic_cnt == 1)
+                m_Partitions = sMeta->topics[0].partition_cnt;
+            if (sMeta)
+                rd_kafka_metadata_destroy(sMeta);
+            if (m_Partitions <= 0) {
+                rd_kafka_topic_destroy(m_Topic);
+                check(sCode, "Batch::Producer: metadata");
+                throw std::invalid_argument("Kafka::Batch::Producer: no partitions in topic " + aTopic);
+            }
+
+            m_Thread = std::thread([this]() { poll(); });
+        }
+
+        // records and memory they point to must be valid until callback called.
+        // aOwner released after callback: attach storage to it to pass ownership
+        void push(std::span<const Record> aRecords, Callback aCallback, std::shared_ptr<const void> aOwner = {})
+        {
+            produce(aRecords, std::move(aCallback), std::move(aOwner), false);
+        }
+
+        std::future<Result> push(std::span<const Record> aRecords, std::shared_ptr<const void> aOwner = {})
+        {
+            auto sPromise = std::make_shared<std::promise<Result>>();
+            auto sFuture  = sPromise->get_future();
+            produce(aRecords, [sPromise](const Result& aResult) { sPromise->set_value(aResult); }, std::move(aOwner), false);
+            return sFuture;
+        }
+
+        // copy record into current batch. batch sent when it reaches adaptive size or after linger.
+        // future completes with result of whole batch
+        std::shared_future<Result> add(std::string_view aKey, std::string_view aValue)
+        {
+            std::unique_ptr<Accumulator> sBatch;
+            std::shared_future<Result>   sFuture;
+            {
+                std::unique_lock sLock(m_Mutex);
+                if (!m_Accumulator)
+                    m_Accumulator = std::make_unique<Accumulator>();
+                auto& sData = m_Accumulator->data;
+                m_Accumulator->offsets.push_back({sData.size(), sData.size() + aKey.size(), aValue.size()});
+                sData.append(aKey);
+                sData.append(aValue);
+                sFuture = m_Accumulator->future;
+                if (m_Accumulator->offsets.size() >= m_Target or sData.size() >= m_Params.max_bytes)
+                    sBatch = detach();
+            }
+            send(std::move(sBatch));
+            return sFuture;
+        }
+
+        // send accumulated records and wait for all delivery reports
+        void flush(int aTimeout = TIMEOUT)
+        {
+            std::unique_ptr<Accumulator> sBatch;
+            {
+                std::unique_lock sLock(m_Mutex);
+                sBatch = detach();
+            }
+            send(std::move(sBatch));
+            check(m_Producer->flush(aTimeout), "Batch::Producer: flush");
+        }
+
+        uint64_t delivered() const { return m_Delivered; }
+        uint64_t failed() const { return m_Failed; }
+        size_t   target() const { return m_Target; } // current batch size for add()
+        double   linger() const { return m_Linger; } // current linger for add(), ms
+        int32_t  partitions() const { return m_Partitions; }
+
+        // not delivered records are purged, callbacks called with errors
+        ~Producer()
+        {
+            try {
+                flush(TIMEOUT * 10);
+            } catch (const std::exception& e) {
+                ERROR("fail to flush: " << e.what());
+            }
+            m_Stop = true;
+            m_Thread.join();
+            rd_kafka_purge(m_Producer->c_ptr(), RD_KAFKA_PURGE_F_QUEUE | RD_KAFKA_PURGE_F_INFLIGHT);
+            m_Producer->flush(TIMEOUT); // serve delivery reports of purged records
+            rd_kafka_topic_destroy(m_Topic);
+        }
+    };
+} // namespace Kafka::Batch
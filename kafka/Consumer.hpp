@@ -212,6 +212,11 @@ namespace Kafka
         {
             return Queue::CreateConsumer(m_Consumer->c_ptr());
         }
+
+        rd_kafka_t* c_ptr()
+        {
+            return m_Consumer->c_ptr();
+        }
     };
 
 }
\ No newline at end of file
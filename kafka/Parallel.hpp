@@ -0,0 +1,396 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/connect_pipe.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/asio/readable_pipe.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/writable_pipe.hpp>
+#include <boost/noncopyable.hpp>
+
+#include "Consumer.hpp"
+
+namespace Kafka::Parallel {
+
+    // messages of one partition, in offset order. pointers valid until handler completes
+    using Messages = std::span<rd_kafka_message_t* const>;
+    using Handler  = std::function<boost::asio::awaitable<void>(Messages)>;
+
+    struct Params
+    {
+        size_t batch_size      = 4096;  // max messages from one rd_kafka_consume_batch_queue
+        size_t max_inflight    = 10000; // per partition: paused above, resumed below half
+        int    commit_interval = 1000;  // ms between async commits
+    };
+
+    // consumer for stream processing.
+    // messages fetched in batches from consumer queue, without blocking executor (queue io event wakes coroutine).
+    // batch split by partition, sub-batches of partition handled one by one by coroutine spawned on worker executor,
+    // so partitions processed in parallel and order inside partition preserved.
+    // processed offset of every partition committed asynchronously each commit_interval (and synchronously on revoke and stop).
+    // partition with too many queued messages paused, until worker catch up.
+    // at least once: if handler throws, partition stopped and offsets after failed batch not committed, run() rethrows.
+    class Consumer : private RdKafka::RebalanceCb, public boost::noncopyable
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct Batch : public boost::noncopyable
+        {
+            std::vector<rd_kafka_message_t*> messages;
+
+            Batch() = default;
+            Batch(Batch&& aOther)
+            : messages(std::move(aOther.messages))
+            {
+                aOther.messages.clear();
+            }
+            ~Batch()
+            {
+                for (auto x : messages)
+                    rd_kafka_message_destroy(x);
+            }
+        };
+
+        struct Partition
+        {
+            std::string       topic;
+            int32_t           partition = 0;
+            std::deque<Batch> queue;
+            size_t            inflight  = 0;  // messages in queue and in handler
+            int64_t           done      = -1; // offset of last processed message
+            int64_t           committed = -1; // last commited offset (next to consume)
+            bool              running   = false;
+            bool              paused    = false;
+            bool              revoked   = false;
+            bool              failed    = false;
+        };
+        using PartitionPtr = std::shared_ptr<Partition>;
+        using Key          = std::pair<std::string, int32_t>;
+
+        const Params                m_Params;
+        const Handler               m_Handler;
+        std::atomic_bool            m_Stop{false};
+        std::mutex                  m_Mutex;
+        std::map<Key, PartitionPtr> m_Partitions;
+        size_t                      m_Active = 0; // running workers
+        std::exception_ptr          m_Error;
+
+        std::atomic<uint64_t> m_Processed{0};
+        std::atomic<uint64_t> m_Commits{0};
+        std::atomic<uint64_t> m_Pauses{0};
+
+        // destroyed first: close() may call rebalance_cb
+        Kafka::Consumer m_Consumer;
+        QueuePtr        m_Queue;
+
+        static Options patchOptions(Options&& aOptions)
+        {
+            aOptions["enable.auto.commit"] = "false";
+            return std::move(aOptions);
+        }
+
+        static void OnCommit(rd_kafka_t*, rd_kafka_resp_err_t aError, rd_kafka_topic_partition_list_t* aOffsets, void* aOpaque)
+        {
+            if (aError == RD_KAFKA_RESP_ERR_NO_ERROR or aError == RD_KAFKA_RESP_ERR__NO_OFFSET)
+                return;
+            WARN("async commit failed: " << rd_kafka_err2str(aError));
+            // resend with next commit
+            auto             sSelf = static_cast<Consumer*>(aOpaque);
+            std::unique_lock sLock(sSelf->m_Mutex);
+            for (int i = 0; aOffsets and i < aOffsets->cnt; i++) {
+                auto sIt = sSelf->m_Partitions.find({aOffsets->elems[i].topic, aOffsets->elems[i].partition});
+                if (sIt != sSelf->m_Partitions.end())
+                    sIt->second->committed = -1;
+            }
+        }
+
+        void pause(Partition& aPartition, bool aPause)
+        {
+            using List = std::unique_ptr<rd_kafka_topic_partition_list_t, void (*)(rd_kafka_topic_partition_list_t*)>;
+            List sList(rd_kafka_topic_partition_list_new(1), rd_kafka_topic_partition_list_destroy);
+            rd_kafka_topic_partition_list_add(sList.get(), aPartition.topic.c_str(), aPartition.partition);
+            const auto sCode = aPause ? rd_kafka_pause_partitions(m_Consumer.c_ptr(), sList.get())
+                                      : rd_kafka_resume_partitions(m_Consumer.c_ptr(), sList.get());
+            if (sCode != RD_KAFKA_RESP_ERR_NO_ERROR)
+                WARN("fail to " << (aPause ? "pause" : "resume") << " partition " << aPartition.partition << ": " << rd_kafka_err2str(sCode));
+            aPartition.paused = aPause;
+            if (aPause)
+                m_Pauses++;
+        }
+
+        // resume partition paused by backpressure, once worker catch up. called under m_Mutex
+        void resume(Partition& aPartition)
+        {
+            if (aPartition.paused and !aPartition.revoked and aPartition.inflight <= m_Params.max_inflight / 2)
+                pause(aPartition, false);
+        }
+
+        // commit processed offsets. aSync used on stop, aRevoked on rebalance
+        void commit(bool aSync, bool aRevoked = false)
+        {
+            using List = std::unique_ptr<rd_kafka_topic_partition_list_t, void (*)(rd_kafka_topic_partition_list_t*)>;
+            List sList(nullptr, rd_kafka_topic_partition_list_destroy);
+            {
+                std::unique_lock sLock(m_Mutex);
+                sList.reset(rd_kafka_topic_partition_list_new(m_Partitions.size()));
+                for (auto& [sKey, sPartition] : m_Partitions) {
+                    if (aRevoked != sPartition->revoked or sPartition->done < 0 or sPartition->done + 1 <= sPartition->committed)
+                        continue;
+                    rd_kafka_topic_partition_list_add(sList.get(), sPartition->topic.c_str(), sPartition->partition)->offset = sPartition->done + 1;
+                    sPartition->committed = sPartition->done + 1;
+                }
+            }
+            if (sList->cnt == 0)
+                return;
+            m_Commits++;
+            DEBUG("commit " << sList->cnt << " partitions" << (aSync ? " (sync)" : ""));
+            if (aSync)
+                check(rd_kafka_commit(m_Consumer.c_ptr(), sList.get(), 0), "Parallel::Consumer: commit");
+            else
+                check(rd_kafka_commit_queue(m_Consumer.c_ptr(), sList.get(), m_Queue->c_ptr(), OnCommit, this), "Parallel::Consumer: commit queue");
+        }
+
+        // stable split of fetched messages by partition, queue to workers
+        void dispatch(std::span<rd_kafka_message_t*> aMessages, const boost::asio::any_io_executor& aWorkers)
+        {
+            auto sEnd = std::remove_if(aMessages.begin(), aMessages.end(), [](rd_kafka_message_t* x) {
+                if (x->err == RD_KAFKA_RESP_ERR_NO_ERROR)
+                    return false;
+                if (x->err != RD_KAFKA_RESP_ERR__PARTITION_EOF)
+                    WARN("got error: " << rd_kafka_message_errstr(x));
+                rd_kafka_message_destroy(x);
+                return true;
+            });
+            std::stable_sort(aMessages.begin(), sEnd, [](auto a, auto b) {
+                return std::make_pair(a->rkt, a->partition) < std::make_pair(b->rkt, b->partition);
+            });
+
+            std::unique_lock sLock(m_Mutex);
+            for (auto sIt = aMessages.begin(); sIt != sEnd;) {
+                auto sNext = std::find_if(sIt, sEnd, [sFirst = *sIt](auto x) { return x->rkt != sFirst->rkt or x->partition != sFirst->partition; });
+
+                Batch sBatch;
+                sBatch.messages.assign(sIt, sNext);
+                auto& sPartition = m_Partitions[{rd_kafka_topic_name((*sIt)->rkt), (*sIt)->partition}];
+                if (!sPartition) {
+                    sPartition            = std::make_shared<Partition>();
+                    sPartition->topic     = rd_kafka_topic_name((*sIt)->rkt);
+                    sPartition->partition = (*sIt)->partition;
+                }
+                sIt = sNext;
+                if (sPartition->failed)
+                    continue;
+
+                sPartition->inflight += sBatch.messages.size();
+                sPartition->queue.push_back(std::move(sBatch));
+                if (!sPartition->paused and sPartition->inflight > m_Params.max_inflight)
+                    pause(*sPartition, true);
+                if (!sPartition->running) {
+                    sPartition->running = true;
+                    m_Active++;
+                    boost::asio::co_spawn(aWorkers, work(sPartition), boost::asio::detached);
+                }
+            }
+        }
+
+        boost::asio::awaitable<void> work(PartitionPtr aPartition)
+        {
+            std::unique_lock sLock(m_Mutex);
+            while (!aPartition->queue.empty()) {
+                Batch sBatch = std::move(aPartition->queue.front());
+                aPartition->queue.pop_front();
+
+                // redelivered after reassignment while previous batch was in handler
+                auto sFresh = std::find_if(sBatch.messages.begin(), sBatch.messages.end(), [&](auto x) { return x->offset > aPartition->done; });
+                if (sFresh != sBatch.messages.begin()) {
+                    aPartition->inflight -= sFresh - sBatch.messages.begin();
+                    std::for_each(sBatch.messages.begin(), sFresh, rd_kafka_message_destroy);
+                    sBatch.messages.erase(sBatch.messages.begin(), sFresh);
+                    resume(*aPartition);
+                }
+                if (sBatch.messages.empty())
+                    continue;
+                sLock.unlock();
+
+                std::exception_ptr sError;
+                try {
+                    co_await m_Handler(sBatch.messages);
+                } catch (...) {
+                    sError = std::current_exception();
+                }
+
+                sLock.lock();
+                aPartition->inflight -= sBatch.messages.size();
+                if (sError) {
+                    ERROR("handler failed, partition " << aPartition->partition << " stopped at offset " << sBatch.messages.front()->offset);
+                    if (!m_Error)
+                        m_Error = sError;
+                    aPartition->failed = true;
+                    aPartition->queue.clear();
+                    aPartition->inflight = 0;
+                    m_Stop = true;
+                    break;
+                }
+                m_Processed += sBatch.messages.size();
+                aPartition->done = sBatch.messages.back()->offset;
+                resume(*aPartition);
+            }
+            aPartition->running = false;
+            m_Active--;
+
+            // kept by rebalance_cb while handler in progress
+            if (aPartition->revoked) {
+                auto sIt = m_Partitions.find({aPartition->topic, aPartition->partition});
+                if (sIt != m_Partitions.end() and sIt->second == aPartition)
+                    m_Partitions.erase(sIt);
+            }
+        }
+
+        void rebalance_cb(RdKafka::KafkaConsumer*                aConsumer,
+                          RdKafka::ErrorCode                     aErrCode,
+                          std::vector<RdKafka::TopicPartition*>& aPartitions) override
+        {
+            const bool sCooperative = aConsumer->rebalance_protocol() == "COOPERATIVE";
+            if (aErrCode == RdKafka::ERR__ASSIGN_PARTITIONS) {
+                INFO("assigned " << aPartitions.size() << " partitions");
+                {
+                    // partition revoked and assigned back while worker still running:
+                    // keep it, so redelivered batches queued behind worker
+                    std::unique_lock sLock(m_Mutex);
+                    for (auto x : aPartitions) {
+                        auto sIt = m_Partitions.find({x->topic(), x->partition()});
+                        if (sIt == m_Partitions.end())
+                            continue;
+                        sIt->second->revoked   = false;
+                        sIt->second->paused    = false;
+                        sIt->second->committed = -1;
+                    }
+                }
+                if (sCooperative)
+                    check(aConsumer->incremental_assign(aPartitions), "Parallel::Consumer: incremental assign");
+                else
+                    check(aConsumer->assign(aPartitions), "Parallel::Consumer: assign");
+                return;
+            }
+
+            // drop queued messages: new owner will get them. handler in progress completes, but not commited.
+            // partition with handler in progress removed by worker, so reassigned partition never gets second worker
+            INFO("revoked " << aPartitions.size() << " partitions");
+            {
+                std::unique_lock sLock(m_Mutex);
+                for (auto x : aPartitions) {
+                    auto sIt = m_Partitions.find({x->topic(), x->partition()});
+                    if (sIt == m_Partitions.end())
+                        continue;
+                    sIt->second->revoked = true;
+                    for (auto& sBatch : sIt->second->queue)
+                        sIt->second->inflight -= sBatch.messages.size();
+                    sIt->second->queue.clear();
+                }
+            }
+            try {
+                commit(true, true);
+            } catch (const std::exception& e) {
+                WARN("fail to commit revoked partitions: " << e.what());
+            }
+            {
+                std::unique_lock sLock(m_Mutex);
+                std::erase_if(m_Partitions, [](auto& x) { return x.second->revoked and !x.second->running; });
+            }
+            if (sCooperative)
+                check(aConsumer->incremental_unassign(aPartitions), "Parallel::Consumer: incremental unassign");
+            else
+                check(aConsumer->unassign(), "Parallel::Consumer: unassign");
+        }
+
+    public:
+        Consumer(Options aOptions, const std::string& aTopic, Handler&& aHandler, const Params& aParams = {})
+        : m_Params(aParams)
+        , m_Handler(std::move(aHandler))
+        , m_Consumer(patchOptions(std::move(aOptions)), aTopic, this)
+        , m_Queue(m_Consumer.queue())
+        {
+        }
+
+        // fetch and process messages until stop() called or handler failed.
+        // workers spawned on aWorkers (for example thread_pool executor)
+        boost::asio::awaitable<void> run(boost::asio::any_io_executor aWorkers)
+        {
+            using namespace std::chrono_literals;
+            using namespace boost::asio::experimental::awaitable_operators;
+            auto sExecutor = co_await boost::asio::this_coro::executor;
+
+            boost::asio::readable_pipe sRead(sExecutor);
+            boost::asio::writable_pipe sWrite(sExecutor);
+            boost::asio::connect_pipe(sRead, sWrite);
+            m_Queue->io_event_enable(sWrite.native_handle());
+
+            std::vector<rd_kafka_message_t*> sBuffer(m_Params.batch_size);
+            boost::asio::steady_timer        sTimer(sExecutor);
+            auto                             sCommit = Clock::now();
+            while (!m_Stop) {
+                const ssize_t sCount = rd_kafka_consume_batch_queue(m_Queue->c_ptr(), 0, sBuffer.data(), sBuffer.size());
+                if (sCount < 0)
+                    check(rd_kafka_last_error(), "Parallel::Consumer: consume batch");
+                if (sCount > 0)
+                    dispatch(std::span(sBuffer.data(), sCount), aWorkers);
+
+                if (Clock::now() - sCommit >= std::chrono::milliseconds(m_Params.commit_interval)) {
+                    commit(false);
+                    sCommit = Clock::now();
+                }
+                if (sCount > 0)
+                    continue;
+
+                char sTmp[64];
+                sTimer.expires_from_now(100ms);
+                co_await (
+                    sRead.async_read_some(boost::asio::buffer(sTmp), boost::asio::use_awaitable) ||
+                    sTimer.async_wait(boost::asio::use_awaitable));
+            }
+            m_Queue->io_event_enable(-1);
+
+            // drain workers
+            while (true) {
+                {
+                    std::unique_lock sLock(m_Mutex);
+                    if (m_Active == 0)
+                        break;
+                }
+                sTimer.expires_from_now(10ms);
+                co_await sTimer.async_wait(boost::asio::use_awaitable);
+            }
+            commit(true);
+            if (m_Error)
+                std::rethrow_exception(m_Error);
+        }
+
+        boost::asio::awaitable<void> run()
+        {
+            co_await run(co_await boost::asio::this_coro::executor);
+        }
+
+        void stop() { m_Stop = true; }
+
+        uint64_t processed() const { return m_Processed; } // messages passed to handler without error
+        uint64_t commits() const { return m_Commits; }
+        uint64_t pauses() const { return m_Pauses; } // partitions paused by backpressure
+    };
+
+} // namespace Kafka::Parallel
@@ -1,4 +1,11 @@
+#include "Batch.hpp"
 #include "Coro.hpp"
+#include "Parallel.hpp"
+
+#include <deque>
+#include <optional>
+
+#include <boost/asio/thread_pool.hpp>
 
 #include <benchmark/Benchmark.hpp>
 
@@ -22,4 +29,169 @@ static void BM_Produce(benchmark::State& state)
 }
 BENCHMARK(BM_Produce)->UseRealTime()->Arg(1)->Arg(100)->Arg(500)->Arg(2500)->Arg(5000)->Arg(7500)->Unit(benchmark::kMillisecond);
 
+// librdkafka mock cluster as local broker stand-in: no network, topics created on demand
+static const Kafka::Options sMockOptions{{"test.mock.num.brokers", "1"}, {"client.id", "bench/batch"}};
+
+static void BM_ProduceBatch(benchmark::State& state)
+{
+    Kafka::Batch::Producer sProducer(sMockOptions, "t_benchmark_batch");
+
+    const size_t                      sSize = state.range(0);
+    std::vector<std::string>          sKeys;
+    std::vector<Kafka::Batch::Record> sRecords;
+    for (size_t i = 0; i < sSize; i++)
+        sKeys.push_back("key-" + std::to_string(i % 1000));
+    for (size_t i = 0; i < sSize; i++)
+        sRecords.push_back({sKeys[i], "bench-value"});
+
+    // few batches in flight, like pipelined writer
+    constexpr size_t                              WINDOW = 4;
+    std::deque<std::future<Kafka::Batch::Result>> sInflight;
+    Prometheus::Histogramm                        sLatency;
+    auto                                          sWait = [&]() {
+        sLatency.tick(sInflight.front().get().latency);
+        sInflight.pop_front();
+    };
+
+    Time::Meter sMeter;
+    for (auto _ : state) {
+        if (sInflight.size() == WINDOW)
+            sWait();
+        sInflight.push_back(sProducer.push(sRecords));
+    }
+    while (!sInflight.empty())
+        sWait();
+    const double sELA = sMeter.get().to_double();
+
+    constexpr std::array<double, 2> sProb{0.5, 0.99};
+    const auto                      sResult = sLatency.quantile(sProb);
+    state.counters["msgs/sec"]              = sProducer.delivered() / sELA;
+    state.counters["err"]                   = sProducer.failed();
+    state.counters["lat(0.50)"]             = sResult[0];
+    state.counters["lat(0.99)"]             = sResult[1];
+}
+BENCHMARK(BM_ProduceBatch)->UseRealTime()->Arg(100)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// record by record via accumulator, batch size adapts to delivery latency.
+// latency of sampled records measured from add(), so includes linger
+static void BM_ProduceAdd(benchmark::State& state)
+{
+    Kafka::Batch::Producer sProducer(sMockOptions, "t_benchmark_batch");
+
+    using Future = std::shared_future<Kafka::Batch::Result>;
+    std::deque<std::pair<Time::Meter, Future>> sSamples;
+    Prometheus::Histogramm                     sLatency;
+    size_t                                     sSerial = 0;
+    auto                                       sCheck  = [&](bool aWait) {
+        while (!sSamples.empty() and (aWait or sSamples.front().second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+            sSamples.front().second.wait();
+            sLatency.tick(sSamples.front().first.get().to_ms());
+            sSamples.pop_front();
+        }
+    };
+
+    Time::Meter sMeter;
+    for (auto _ : state) {
+        const bool sSample = sSerial % 64 == 0;
+        Time::Meter sAdded;
+        auto        sFuture = sProducer.add("key-" + std::to_string(sSerial++ % 1000), "bench-value");
+        if (sSample) {
+            sSamples.emplace_back(sAdded, std::move(sFuture));
+            sCheck(false);
+        }
+    }
+    sProducer.flush();
+    sCheck(true);
+    const double sELA = sMeter.get().to_double();
+
+    constexpr std::array<double, 2> sProb{0.5, 0.99};
+    const auto                      sResult = sLatency.quantile(sProb);
+    state.counters["msgs/sec"]              = sProducer.delivered() / sELA;
+    state.counters["err"]                   = sProducer.failed();
+    state.counters["lat(0.50)"]             = sResult[0];
+    state.counters["lat(0.99)"]             = sResult[1];
+    state.counters["batch"]                 = sProducer.target();
+}
+BENCHMARK(BM_ProduceAdd)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// per message work of stream processor: about 5us of cpu
+static void process(const rd_kafka_message_t* aMsg)
+{
+    const auto sDeadline = std::chrono::steady_clock::now() + std::chrono::microseconds(5);
+    while (std::chrono::steady_clock::now() < sDeadline)
+        benchmark::DoNotOptimize(aMsg->len);
+}
+
+// consume MSG_COUNT messages from t_benchmark (3 partitions) with new group.
+// arg 0: Kafka::Consumer, message by message. N: Parallel::Consumer with N worker threads.
+// time measured from first message, so group join not included
+static void BM_Consume(benchmark::State& state)
+{
+    constexpr size_t MSG_COUNT = 30000;
+    {
+        Kafka::Batch::Producer            sProducer({{"bootstrap.servers", "broker-1.kafka"}, {"client.id", "bench/fill"}}, "t_benchmark");
+        std::vector<std::string>          sKeys;
+        std::vector<Kafka::Batch::Record> sRecords;
+        for (size_t i = 0; i < MSG_COUNT; i++)
+            sKeys.push_back("key-" + std::to_string(i % 1000));
+        for (auto& x : sKeys)
+            sRecords.push_back({x, "bench-value"});
+        sProducer.push(sRecords).wait();
+    }
+
+    Kafka::Options sOptions{{"bootstrap.servers", "broker-1.kafka"},
+                            {"client.id", "bench/consumer"},
+                            {"auto.offset.reset", "earliest"},
+                            {"enable.auto.commit", "false"}};
+
+    const int sWorkers = state.range(0);
+    size_t    sSerial  = 0;
+    for (auto _ : state) {
+        sOptions["group.id"] = "g_benchmark_" + std::to_string(::time(nullptr)) + "_" + std::to_string(sSerial++);
+        std::optional<Time::Meter> sMeter;
+
+        if (sWorkers == 0) {
+            Kafka::Consumer sConsumer(sOptions, "t_benchmark");
+            for (size_t sCount = 0; sCount < MSG_COUNT;) {
+                auto sMsg = sConsumer.consume();
+                if (!sMsg or sMsg->err() != RdKafka::ERR_NO_ERROR)
+                    continue;
+                if (!sMeter)
+                    sMeter.emplace();
+                process(sMsg->c_ptr());
+                if (++sCount % 1000 == 0)
+                    sConsumer.sync();
+            }
+            sConsumer.sync();
+        } else {
+            std::mutex                sMutex;
+            size_t                    sCount = 0;
+            boost::asio::io_service   sAsio;
+            boost::asio::thread_pool  sPool(sWorkers);
+            Kafka::Parallel::Consumer sConsumer(sOptions, "t_benchmark", [&](Kafka::Parallel::Messages aMessages) -> boost::asio::awaitable<void> {
+                {
+                    std::unique_lock sLock(sMutex);
+                    if (!sMeter)
+                        sMeter.emplace();
+                }
+                for (auto x : aMessages)
+                    process(x);
+                std::unique_lock sLock(sMutex);
+                sCount += aMessages.size();
+                if (sCount >= MSG_COUNT)
+                    sConsumer.stop();
+                co_return;
+            });
+            boost::asio::co_spawn(sAsio, sConsumer.run(sPool.get_executor()), boost::asio::detached);
+            sAsio.run();
+            sPool.join();
+            state.counters["pauses"] = sConsumer.pauses();
+        }
+        const double sELA = sMeter->get().to_double();
+        state.SetIterationTime(sELA);
+        state.counters["msgs/sec"] = MSG_COUNT / sELA;
+    }
+}
+BENCHMARK(BM_Consume)->UseManualTime()->Iterations(3)->Arg(0)->Arg(1)->Arg(3)->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,303 @@
+#include "Consumer.hpp"
+
+#include <librdkafka/rdkafka.h>
+#include <librdkafka/rdkafkacpp.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+struct rd_kafka_topic_s
+{};
+struct rd_kafka_queue_s
+{};
+
+namespace Fake {
+
+    namespace {
+        rd_kafka_topic_t sTopic;
+        rd_kafka_queue_t sQueue;
+
+        RdKafka::RebalanceCb*   sRebalance = nullptr;
+        RdKafka::KafkaConsumer* sConsumer  = nullptr;
+
+        using Callback = void (*)(rd_kafka_t*, rd_kafka_resp_err_t, rd_kafka_topic_partition_list_t*, void*);
+        std::vector<std::pair<Callback, void*>> sCallbacks; // async commit results, served by next poll
+
+        // eager protocol: revoke and assign always cover all partitions
+        void rebalance(RdKafka::ErrorCode aCode)
+        {
+            std::vector<RdKafka::TopicPartition*> sList;
+            for (int i = 0; i < PARTITIONS; i++)
+                sList.push_back(RdKafka::TopicPartition::create(state().topic, i, RdKafka::Topic::OFFSET_INVALID));
+            sRebalance->rebalance_cb(sConsumer, aCode, sList);
+            RdKafka::TopicPartition::destroy(sList);
+        }
+
+        struct Conf : RdKafka::Conf
+        {
+            ConfResult set(const std::string&, const std::string&, std::string&) override { return CONF_OK; }
+            ConfResult set(const std::string&, RdKafka::EventCb*, std::string&) override { return CONF_OK; }
+            ConfResult set(const std::string&, RdKafka::RebalanceCb* aCallback, std::string&) override
+            {
+                sRebalance = aCallback;
+                return CONF_OK;
+            }
+            rd_kafka_conf_t* c_ptr_global() override { return nullptr; }
+        };
+
+        struct Metadata : RdKafka::Metadata
+        {
+            TopicMetadataVector        vector;
+            const TopicMetadataVector* topics() const override { return &vector; }
+        };
+
+        struct TopicPartition : RdKafka::TopicPartition
+        {
+            std::string topic_;
+            int         partition_ = 0;
+            int64_t     offset_    = 0;
+
+            const std::string& topic() const override { return topic_; }
+            int                partition() const override { return partition_; }
+            int64_t            offset() const override { return offset_; }
+            void               set_offset(int64_t aOffset) override { offset_ = aOffset; }
+        };
+
+        struct Consumer : RdKafka::KafkaConsumer
+        {
+            using ErrorCode = RdKafka::ErrorCode;
+            using List      = std::vector<RdKafka::TopicPartition*>;
+
+            ErrorCode metadata(bool, const RdKafka::Topic*, RdKafka::Metadata** aMeta, int) override
+            {
+                *aMeta = new Metadata;
+                return RdKafka::ERR_NO_ERROR;
+            }
+            rd_kafka_t* c_ptr() override { return nullptr; }
+            ErrorCode   subscribe(const std::vector<std::string>& aTopics) override
+            {
+                std::unique_lock sLock(state().mutex);
+                state().topic = aTopics.front();
+                return RdKafka::ERR_NO_ERROR;
+            }
+            ErrorCode                       unsubscribe() override { return RdKafka::ERR_NO_ERROR; }
+            RdKafka::Message*               consume(int) override { return nullptr; }
+            ErrorCode                       close() override { return RdKafka::ERR_NO_ERROR; }
+            ErrorCode                       assignment(List&) override { return RdKafka::ERR_NO_ERROR; }
+            ErrorCode                       position(List&) override { return RdKafka::ERR_NO_ERROR; }
+            ErrorCode                       committed(List&, int) override { return RdKafka::ERR_NO_ERROR; }
+            ErrorCode                       query_watermark_offsets(const std::string&, int32_t, int64_t*, int64_t*, int) override { return RdKafka::ERR_NO_ERROR; }
+            ErrorCode                       seek(const RdKafka::TopicPartition&, int) override { return RdKafka::ERR_NO_ERROR; }
+            ErrorCode                       pause(List&) override { return RdKafka::ERR_NO_ERROR; }
+            ErrorCode                       resume(List&) override { return RdKafka::ERR_NO_ERROR; }
+            ErrorCode                       commitSync() override { return RdKafka::ERR_NO_ERROR; }
+            ErrorCode                       commitSync(List&) override { return RdKafka::ERR_NO_ERROR; }
+            RdKafka::ConsumerGroupMetadata* groupMetadata() override { return nullptr; }
+            ErrorCode                       fatal_error(std::string&) const override { return RdKafka::ERR_NO_ERROR; }
+            std::string                     rebalance_protocol() override { return "EAGER"; }
+            RdKafka::Error*                 incremental_assign(const List&) override { std::abort(); }
+            RdKafka::Error*                 incremental_unassign(const List&) override { std::abort(); }
+
+            ErrorCode assign(const List&) override
+            {
+                auto&            sState = state();
+                std::unique_lock sLock(sState.mutex);
+                sState.reassigned = sState.polls > 1;
+                sState.assigned   = true;
+                for (int i = 0; i < PARTITIONS; i++) {
+                    sState.next[i]   = std::max<int64_t>(sState.committed[i], 0);
+                    sState.paused[i] = false;
+                }
+                return RdKafka::ERR_NO_ERROR;
+            }
+            ErrorCode unassign() override
+            {
+                std::unique_lock sLock(state().mutex);
+                state().assigned = false;
+                return RdKafka::ERR_NO_ERROR;
+            }
+        };
+    } // namespace
+
+    State& state()
+    {
+        static State sState;
+        return sState;
+    }
+
+    void reset(const Params& aParams)
+    {
+        auto&            sState = state();
+        std::unique_lock sLock(sState.mutex);
+        sState.params     = aParams;
+        sState.polls      = 0;
+        sState.assigned   = false;
+        sState.reassigned = false;
+        sState.pauses     = 0;
+        sState.commits    = 0;
+        for (int i = 0; i < PARTITIONS; i++) {
+            sState.next[i]      = 0;
+            sState.committed[i] = -1;
+            sState.paused[i]    = false;
+        }
+        sState.live = 0;
+        sCallbacks.clear();
+    }
+
+} // namespace Fake
+
+namespace RdKafka {
+
+    std::string err2str(ErrorCode aCode) { return "error " + std::to_string(aCode); }
+
+    Conf*  Conf::create(ConfType) { return new Fake::Conf; }
+    Topic* Topic::create(Handle*, const std::string&, const Conf*, std::string&) { return new Topic; }
+
+    TopicPartition* TopicPartition::create(const std::string& aTopic, int aPartition, int64_t aOffset)
+    {
+        auto sPartition        = new Fake::TopicPartition;
+        sPartition->topic_     = aTopic;
+        sPartition->partition_ = aPartition;
+        sPartition->offset_    = aOffset;
+        return sPartition;
+    }
+    void TopicPartition::destroy(std::vector<TopicPartition*>& aList)
+    {
+        for (auto x : aList)
+            delete x;
+    }
+
+    KafkaConsumer* KafkaConsumer::create(const Conf*, std::string&)
+    {
+        return Fake::sConsumer = new Fake::Consumer;
+    }
+
+} // namespace RdKafka
+
+extern "C" {
+
+const char* rd_kafka_err2str(rd_kafka_resp_err_t) { return "error"; }
+void        rd_kafka_conf_set_events(rd_kafka_conf_t*, int) {}
+const char* rd_kafka_topic_name(const rd_kafka_topic_t*) { return Fake::state().topic.c_str(); }
+
+rd_kafka_queue_t* rd_kafka_queue_get_main(rd_kafka_t*) { return &Fake::sQueue; }
+rd_kafka_queue_t* rd_kafka_queue_get_consumer(rd_kafka_t*) { return &Fake::sQueue; }
+void              rd_kafka_queue_destroy(rd_kafka_queue_t*) {}
+void              rd_kafka_queue_io_event_enable(rd_kafka_queue_t*, int, const void*, size_t) {}
+rd_kafka_event_t* rd_kafka_queue_poll(rd_kafka_queue_t*, int) { return nullptr; }
+
+rd_kafka_topic_partition_list_t* rd_kafka_topic_partition_list_new(int aSize)
+{
+    auto sElems = static_cast<rd_kafka_topic_partition_t*>(calloc(aSize + 1, sizeof(rd_kafka_topic_partition_t)));
+    return new rd_kafka_topic_partition_list_t{0, aSize, sElems};
+}
+void rd_kafka_topic_partition_list_destroy(rd_kafka_topic_partition_list_t* aList)
+{
+    for (int i = 0; i < aList->cnt; i++)
+        free(aList->elems[i].topic);
+    free(aList->elems);
+    delete aList;
+}
+rd_kafka_topic_partition_t* rd_kafka_topic_partition_list_add(rd_kafka_topic_partition_list_t* aList, const char* aTopic, int32_t aPartition)
+{
+    if (aList->cnt >= aList->size)
+        std::abort();
+    auto& sElem     = aList->elems[aList->cnt++];
+    sElem.topic     = strdup(aTopic);
+    sElem.partition = aPartition;
+    sElem.offset    = RdKafka::Topic::OFFSET_INVALID;
+    return &sElem;
+}
+
+rd_kafka_resp_err_t rd_kafka_pause_partitions(rd_kafka_t*, rd_kafka_topic_partition_list_t* aList)
+{
+    auto&            sState = Fake::state();
+    std::unique_lock sLock(sState.mutex);
+    for (int i = 0; i < aList->cnt; i++)
+        sState.paused[aList->elems[i].partition] = true;
+    sState.pauses++;
+    return RD_KAFKA_RESP_ERR_NO_ERROR;
+}
+rd_kafka_resp_err_t rd_kafka_resume_partitions(rd_kafka_t*, rd_kafka_topic_partition_list_t* aList)
+{
+    auto&            sState = Fake::state();
+    std::unique_lock sLock(sState.mutex);
+    for (int i = 0; i < aList->cnt; i++)
+        sState.paused[aList->elems[i].partition] = false;
+    return RD_KAFKA_RESP_ERR_NO_ERROR;
+}
+rd_kafka_resp_err_t rd_kafka_commit(rd_kafka_t*, const rd_kafka_topic_partition_list_t* aList, int)
+{
+    auto&            sState = Fake::state();
+    std::unique_lock sLock(sState.mutex);
+    sState.commits++;
+    for (int i = 0; i < aList->cnt; i++) {
+        auto& sElem = aList->elems[i];
+        if (sElem.offset < 0 or sElem.offset > sState.params.size)
+            std::abort();
+        sState.committed[sElem.partition] = sElem.offset;
+    }
+    return RD_KAFKA_RESP_ERR_NO_ERROR;
+}
+rd_kafka_resp_err_t rd_kafka_commit_queue(rd_kafka_t*                            aKafka,
+                                          const rd_kafka_topic_partition_list_t* aList,
+                                          rd_kafka_queue_t*,
+                                          Fake::Callback aCallback,
+                                          void*          aOpaque)
+{
+    rd_kafka_commit(aKafka, aList, 1);
+    if (aCallback)
+        Fake::sCallbacks.push_back({aCallback, aOpaque});
+    return RD_KAFKA_RESP_ERR_NO_ERROR;
+}
+
+ssize_t rd_kafka_consume_batch_queue(rd_kafka_queue_t*, int, rd_kafka_message_t** aOut, size_t aSize)
+{
+    auto& sState = Fake::state();
+    for (auto [sCallback, sOpaque] : Fake::sCallbacks)
+        sCallback(nullptr, RD_KAFKA_RESP_ERR_NO_ERROR, nullptr, sOpaque);
+    Fake::sCallbacks.clear();
+
+    const int  sPoll   = ++sState.polls;
+    const bool sRevoke = sState.params.revoke_at > 0;
+    if (sPoll == 1 or (sRevoke and sPoll == sState.params.revoke_at + 1))
+        Fake::rebalance(RdKafka::ERR__ASSIGN_PARTITIONS);
+    if (sRevoke and sPoll == sState.params.revoke_at) {
+        Fake::rebalance(RdKafka::ERR__REVOKE_PARTITIONS);
+        return 0;
+    }
+
+    // chunks of 7 messages from every partition in turn
+    std::unique_lock sLock(sState.mutex);
+    if (!sState.assigned)
+        return 0;
+    size_t sCount = 0;
+    for (bool sMore = true; sMore and sCount < aSize;) {
+        sMore = false;
+        for (int i = 0; i < Fake::PARTITIONS; i++) {
+            for (int j = 0; j < 7 and sCount < aSize and !sState.paused[i] and sState.next[i] < sState.params.size; j++) {
+                auto sMessage       = new rd_kafka_message_t{};
+                sMessage->rkt       = &Fake::sTopic;
+                sMessage->partition = i;
+                sMessage->offset    = sState.next[i]++;
+                if (sMessage->offset % 1000 == 500)
+                    sMessage->err = RD_KAFKA_RESP_ERR__PARTITION_EOF;
+                sState.live++;
+                aOut[sCount++] = sMessage;
+                sMore          = true;
+            }
+        }
+    }
+    return sCount;
+}
+
+rd_kafka_resp_err_t rd_kafka_last_error(void) { return RD_KAFKA_RESP_ERR_NO_ERROR; }
+const char*         rd_kafka_message_errstr(const rd_kafka_message_t*) { return "partition EOF"; }
+void                rd_kafka_message_destroy(rd_kafka_message_t* aMessage)
+{
+    Fake::state().live--;
+    delete aMessage;
+}
+}
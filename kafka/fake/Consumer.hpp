@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// in-memory consumer behind fake librdkafka headers.
+// every partition holds `size` messages, consumer queue returns interleaved chunks of all partitions,
+// message with offset 500 mod 1000 replaced by PARTITION_EOF event.
+// eager rebalance: all partitions assigned on first poll, revoked on poll `revoke_at` and assigned back on next one.
+// fetch restarts from committed offset after assignment, like a new owner would
+namespace Fake {
+
+    constexpr int PARTITIONS = 3;
+
+    struct Params
+    {
+        int64_t size      = 20000;
+        int     revoke_at = 30; // 0 to keep assignment
+    };
+
+    struct State
+    {
+        std::mutex  mutex;
+        Params      params;
+        std::string topic;
+
+        int     polls      = 0;
+        bool    assigned   = false;
+        bool    reassigned = false; // revoked and assigned back
+        int     pauses     = 0;
+        int     commits    = 0;
+        int64_t next[PARTITIONS]{};      // offset to fetch
+        int64_t committed[PARTITIONS]{}; // -1 if not committed yet
+        bool    paused[PARTITIONS]{};
+
+        std::atomic<int64_t> live{0}; // fetched and not destroyed messages
+    };
+
+    State& state();
+    void   reset(const Params& aParams = {});
+
+} // namespace Fake
@@ -0,0 +1,84 @@
+#pragma once
+
+// subset of librdkafka C API used by Kafka.hpp, Consumer.hpp and Parallel.hpp.
+// implemented in fake/Consumer.cpp, to run Parallel::Consumer without broker
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+extern "C" {
+
+typedef struct rd_kafka_s       rd_kafka_t;
+typedef struct rd_kafka_topic_s rd_kafka_topic_t;
+typedef struct rd_kafka_conf_s  rd_kafka_conf_t;
+typedef struct rd_kafka_queue_s rd_kafka_queue_t;
+typedef struct rd_kafka_op_s    rd_kafka_event_t;
+
+typedef enum
+{
+    RD_KAFKA_RESP_ERR__PARTITION_EOF = -191,
+    RD_KAFKA_RESP_ERR__NO_OFFSET     = -168,
+    RD_KAFKA_RESP_ERR_NO_ERROR       = 0,
+} rd_kafka_resp_err_t;
+
+typedef struct rd_kafka_message_s
+{
+    rd_kafka_resp_err_t err;
+    rd_kafka_topic_t*   rkt;
+    int32_t             partition;
+    void*               payload;
+    size_t              len;
+    void*               key;
+    size_t              key_len;
+    int64_t             offset;
+    void*               _private;
+} rd_kafka_message_t;
+
+typedef struct rd_kafka_topic_partition_s
+{
+    char*               topic;
+    int32_t             partition;
+    int64_t             offset;
+    void*               metadata;
+    size_t              metadata_size;
+    void*               opaque;
+    rd_kafka_resp_err_t err;
+    void*               _private;
+} rd_kafka_topic_partition_t;
+
+typedef struct rd_kafka_topic_partition_list_s
+{
+    int                         cnt;
+    int                         size;
+    rd_kafka_topic_partition_t* elems;
+} rd_kafka_topic_partition_list_t;
+
+const char* rd_kafka_err2str(rd_kafka_resp_err_t);
+void        rd_kafka_conf_set_events(rd_kafka_conf_t*, int);
+const char* rd_kafka_topic_name(const rd_kafka_topic_t*);
+
+rd_kafka_queue_t* rd_kafka_queue_get_main(rd_kafka_t*);
+rd_kafka_queue_t* rd_kafka_queue_get_consumer(rd_kafka_t*);
+void              rd_kafka_queue_destroy(rd_kafka_queue_t*);
+void              rd_kafka_queue_io_event_enable(rd_kafka_queue_t*, int, const void*, size_t);
+rd_kafka_event_t* rd_kafka_queue_poll(rd_kafka_queue_t*, int);
+
+rd_kafka_topic_partition_list_t* rd_kafka_topic_partition_list_new(int);
+void                             rd_kafka_topic_partition_list_destroy(rd_kafka_topic_partition_list_t*);
+rd_kafka_topic_partition_t*      rd_kafka_topic_partition_list_add(rd_kafka_topic_partition_list_t*, const char*, int32_t);
+
+rd_kafka_resp_err_t rd_kafka_pause_partitions(rd_kafka_t*, rd_kafka_topic_partition_list_t*);
+rd_kafka_resp_err_t rd_kafka_resume_partitions(rd_kafka_t*, rd_kafka_topic_partition_list_t*);
+rd_kafka_resp_err_t rd_kafka_commit(rd_kafka_t*, const rd_kafka_topic_partition_list_t*, int);
+rd_kafka_resp_err_t rd_kafka_commit_queue(rd_kafka_t*,
+                                          const rd_kafka_topic_partition_list_t*,
+                                          rd_kafka_queue_t*,
+                                          void (*)(rd_kafka_t*, rd_kafka_resp_err_t, rd_kafka_topic_partition_list_t*, void*),
+                                          void*);
+
+ssize_t             rd_kafka_consume_batch_queue(rd_kafka_queue_t*, int, rd_kafka_message_t**, size_t);
+rd_kafka_resp_err_t rd_kafka_last_error(void);
+void                rd_kafka_message_destroy(rd_kafka_message_t*);
+const char*         rd_kafka_message_errstr(const rd_kafka_message_t*);
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+// subset of librdkafka C++ API used by Kafka.hpp, Consumer.hpp and Parallel.hpp.
+// implemented in fake/Consumer.cpp
+
+#include <string>
+#include <vector>
+
+#include "rdkafka.h"
+
+namespace RdKafka {
+
+    enum ErrorCode
+    {
+        ERR_NO_ERROR           = 0,
+        ERR__NO_OFFSET         = -168,
+        ERR__ASSIGN_PARTITIONS = -175,
+        ERR__REVOKE_PARTITIONS = -174,
+    };
+    std::string err2str(ErrorCode);
+
+    struct Error
+    {
+        virtual ~Error() {}
+        virtual std::string str() const  = 0;
+        virtual std::string name() const = 0;
+    };
+
+    struct Headers
+    {
+        struct Header
+        {
+            std::string key() const;
+            const void* value() const;
+            size_t      value_size() const;
+        };
+        std::vector<Header> get_all() const;
+    };
+
+    struct Message
+    {
+        virtual ~Message() {}
+        virtual ErrorCode   err() const         = 0;
+        virtual std::string errstr() const      = 0;
+        virtual std::string topic_name() const  = 0;
+        virtual int32_t     partition() const   = 0;
+        virtual int64_t     offset() const      = 0;
+        virtual const void* key_pointer() const = 0;
+        virtual size_t      key_len() const     = 0;
+        virtual void*       payload() const     = 0;
+        virtual size_t      len() const         = 0;
+        virtual Headers*    headers()           = 0;
+    };
+
+    struct EventCb;
+    struct RebalanceCb;
+
+    struct Conf
+    {
+        enum ConfType
+        {
+            CONF_GLOBAL,
+            CONF_TOPIC
+        };
+        enum ConfResult
+        {
+            CONF_UNKNOWN = -2,
+            CONF_INVALID = -1,
+            CONF_OK      = 0
+        };
+        static Conf* create(ConfType);
+
+        virtual ~Conf() {}
+        virtual ConfResult       set(const std::string&, const std::string&, std::string&) = 0;
+        virtual ConfResult       set(const std::string&, EventCb*, std::string&)           = 0;
+        virtual ConfResult       set(const std::string&, RebalanceCb*, std::string&)       = 0;
+        virtual rd_kafka_conf_t* c_ptr_global()                                            = 0;
+    };
+
+    struct Topic;
+
+    struct TopicMetadata
+    {
+        virtual ~TopicMetadata() {}
+        virtual ErrorCode err() const = 0;
+    };
+
+    struct Metadata
+    {
+        typedef std::vector<const TopicMetadata*> TopicMetadataVector;
+        virtual ~Metadata() {}
+        virtual const TopicMetadataVector* topics() const = 0;
+    };
+
+    struct Handle
+    {
+        virtual ~Handle() {}
+        virtual ErrorCode   metadata(bool, const Topic*, Metadata**, int) = 0;
+        virtual rd_kafka_t* c_ptr()                                       = 0;
+    };
+
+    struct Topic
+    {
+        static const int64_t OFFSET_INVALID = -1001;
+        static Topic*        create(Handle*, const std::string&, const Conf*, std::string&);
+        virtual ~Topic() {}
+    };
+
+    struct TopicPartition
+    {
+        static TopicPartition* create(const std::string&, int, int64_t);
+        static void            destroy(std::vector<TopicPartition*>&);
+
+        virtual ~TopicPartition() {}
+        virtual const std::string& topic() const      = 0;
+        virtual int                partition() const  = 0;
+        virtual int64_t            offset() const     = 0;
+        virtual void               set_offset(int64_t) = 0;
+    };
+
+    struct ConsumerGroupMetadata
+    {
+        virtual ~ConsumerGroupMetadata() {}
+    };
+
+    struct KafkaConsumer : Handle
+    {
+        static KafkaConsumer* create(const Conf*, std::string&);
+
+        virtual ErrorCode              subscribe(const std::vector<std::string>&)                                    = 0;
+        virtual ErrorCode              unsubscribe()                                                                 = 0;
+        virtual Message*               consume(int)                                                                  = 0;
+        virtual ErrorCode              close()                                                                       = 0;
+        virtual ErrorCode              assignment(std::vector<TopicPartition*>&)                                     = 0;
+        virtual ErrorCode              position(std::vector<TopicPartition*>&)                                       = 0;
+        virtual ErrorCode              committed(std::vector<TopicPartition*>&, int)                                 = 0;
+        virtual ErrorCode              query_watermark_offsets(const std::string&, int32_t, int64_t*, int64_t*, int) = 0;
+        virtual ErrorCode              seek(const TopicPartition&, int)                                              = 0;
+        virtual ErrorCode              pause(std::vector<TopicPartition*>&)                                          = 0;
+        virtual ErrorCode              resume(std::vector<TopicPartition*>&)                                         = 0;
+        virtual ErrorCode              commitSync()                                                                  = 0;
+        virtual ErrorCode              commitSync(std::vector<TopicPartition*>&)                                     = 0;
+        virtual ConsumerGroupMetadata* groupMetadata()                                                               = 0;
+        virtual ErrorCode              fatal_error(std::string&) const                                               = 0;
+        virtual std::string            rebalance_protocol()                                                          = 0;
+        virtual ErrorCode              assign(const std::vector<TopicPartition*>&)                                   = 0;
+        virtual ErrorCode              unassign()                                                                    = 0;
+        virtual Error*                 incremental_assign(const std::vector<TopicPartition*>&)                       = 0;
+        virtual Error*                 incremental_unassign(const std::vector<TopicPartition*>&)                     = 0;
+    };
+
+    struct RebalanceCb
+    {
+        virtual ~RebalanceCb() {}
+        virtual void rebalance_cb(KafkaConsumer*, ErrorCode, std::vector<TopicPartition*>&) = 0;
+    };
+
+} // namespace RdKafka
@@ -3,8 +3,10 @@
 
 #include <boost/asio.hpp>
 
+#include "Batch.hpp"
 #include "Coro.hpp"
 #include "Factory.hpp"
+#include "Parallel.hpp"
 #include "Registry.hpp"
 #include "Transform.hpp"
 
@@ -115,6 +117,103 @@ BOOST_AUTO_TEST_CASE(basic)
     }
 }
 
+BOOST_AUTO_TEST_CASE(batch)
+{
+    const std::string sValue = "batch: " + std::to_string(::time(nullptr));
+    {
+        Kafka::Batch::Producer sKafka(producerOptions("batch/producer", false), "t_source", {.min_records = 4});
+
+        auto sData = std::make_shared<std::vector<std::string>>();
+        for (int i = 0; i < 100; i++)
+            sData->push_back("key-" + std::to_string(i % 10));
+        std::vector<Kafka::Batch::Record> sRecords;
+        for (auto& x : *sData)
+            sRecords.push_back({x, sValue});
+
+        auto sResult = sKafka.push(sRecords, sData).get();
+        BOOST_CHECK_EQUAL(sResult.delivered, 100);
+        BOOST_CHECK_EQUAL(sResult.failed, 0);
+        BOOST_TEST_MESSAGE("batch delivered in " << sResult.latency << " ms");
+
+        std::vector<std::shared_future<Kafka::Batch::Result>> sFutures;
+        for (int i = 0; i < 10; i++)
+            sFutures.push_back(sKafka.add("key-" + std::to_string(i), sValue));
+        sKafka.flush();
+        for (auto& x : sFutures)
+            BOOST_CHECK_EQUAL(x.get().failed, 0);
+        BOOST_CHECK_EQUAL(sKafka.delivered(), 110);
+    }
+
+    // same key always in same partition
+    Kafka::Consumer                sConsumer(consumerOptions("batch/consumer", "g_batch"), "t_source");
+    std::map<std::string, int32_t> sPartition;
+    int                            sCount    = 0;
+    const auto                     sDeadline = std::chrono::steady_clock::now() + 20s;
+    while (sCount < 110 and std::chrono::steady_clock::now() < sDeadline) {
+        auto sMsg = sConsumer.consume();
+        if (sMsg->err() != RdKafka::ERR_NO_ERROR or Kafka::Help::value(sMsg) != sValue)
+            continue;
+        sCount++;
+        auto [sIter, sUnused] = sPartition.emplace(Kafka::Help::key(sMsg), sMsg->partition());
+        BOOST_CHECK_EQUAL(sIter->second, sMsg->partition());
+    }
+    sConsumer.sync();
+    BOOST_CHECK_EQUAL(sCount, 110);
+    BOOST_CHECK_EQUAL(sPartition.size(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(parallel)
+{
+    constexpr int     MSG_COUNT = 300;
+    const std::string sValue    = "parallel: " + std::to_string(::time(nullptr)) + ": ";
+    {
+        Kafka::Producer sKafka(producerOptions("parallel/producer", false), "t_source");
+        for (int i = 0; i < MSG_COUNT; i++)
+            sKafka.push(RdKafka::Topic::PARTITION_UA, "key-" + std::to_string(i % 10), sValue + std::to_string(i));
+        sKafka.flush();
+    }
+
+    // order inside key (so inside partition) must be preserved
+    std::mutex                 sMutex;
+    std::map<std::string, int> sLast;
+    int                        sCount = 0;
+
+    boost::asio::io_service   sAsio;
+    boost::asio::thread_pool  sWorkers(4);
+    Kafka::Parallel::Consumer sConsumer(
+        consumerOptions("parallel/consumer", "g_parallel"), "t_source",
+        [&](Kafka::Parallel::Messages aMessages) -> boost::asio::awaitable<void> {
+            for (auto x : aMessages) {
+                const auto sPayload = Kafka::Help::value(x);
+                if (!sPayload.starts_with(sValue))
+                    continue;
+                const int        sSerial = Parser::Atoi<int>(sPayload.substr(sValue.size()));
+                std::unique_lock sLock(sMutex);
+                auto [sIt, sNew] = sLast.emplace(Kafka::Help::key(x), sSerial);
+                if (!sNew) {
+                    BOOST_CHECK_LT(sIt->second, sSerial);
+                    sIt->second = sSerial;
+                }
+                if (++sCount == MSG_COUNT)
+                    sConsumer.stop();
+            }
+            boost::asio::steady_timer sTimer(co_await boost::asio::this_coro::executor);
+            sTimer.expires_from_now(1ms);
+            co_await sTimer.async_wait(boost::asio::use_awaitable);
+        },
+        {.batch_size = 64, .max_inflight = 16, .commit_interval = 100});
+
+    boost::asio::co_spawn(sAsio, sConsumer.run(sWorkers.get_executor()), boost::asio::detached);
+    sAsio.run_for(20s);
+    sWorkers.join();
+
+    BOOST_CHECK_EQUAL(sCount, MSG_COUNT);
+    BOOST_CHECK_EQUAL(sLast.size(), 10);
+    BOOST_CHECK_GE(sConsumer.processed(), MSG_COUNT);
+    BOOST_CHECK_GT(sConsumer.commits(), 0);
+    BOOST_TEST_MESSAGE("partitions paused " << sConsumer.pauses() << " times");
+}
+
 struct SerdesTest
 {
     std::string name;
@@ -13,12 +13,14 @@ namespace KV {
         std::string                key;
         std::optional<std::string> value = {};
 
-        void cbor_read(cbor::istream& sInput)
+        template <class S>
+        void cbor_read(S& sInput)
         {
             cbor::read(sInput, key);
             cbor::read(sInput, value);
         }
-        void cbor_write(cbor::ostream& sOutput) const
+        template <class S>
+        void cbor_write(S& sOutput) const
         {
             cbor::write(sOutput, key);
             cbor::write(sOutput, value);
@@ -31,12 +33,14 @@ namespace KV {
         std::string                key;
         std::optional<std::string> value;
 
-        void cbor_read(cbor::istream& sInput)
+        template <class S>
+        void cbor_read(S& sInput)
         {
             cbor::read(sInput, key);
             cbor::read(sInput, value);
         }
-        void cbor_write(cbor::ostream& sOutput) const
+        template <class S>
+        void cbor_write(S& sOutput) const
         {
             cbor::write(sOutput, key);
             cbor::write(sOutput, value);
@@ -33,18 +33,19 @@ namespace KV {
 
         boost::asio::awaitable<Responses> Call(const Requests& aRequests)
         {
-            cbor::omemstream sOutput;
+            std::string   sBody;
+            cbor::obuffer sOutput(sBody);
             cbor::write(sOutput, aRequests);
 
-            auto sRequest = AsioHttp::Request{.method = "POST", .url = m_Params.url, .body = std::move(sOutput.str())};
+            auto sRequest = AsioHttp::Request{.method = "POST", .url = m_Params.url, .body = std::move(sBody)};
             auto sResult  = co_await m_Client->perform(std::move(sRequest));
 
             if (sResult.status != 200) {
                 throw std::runtime_error("http response code " + std::to_string(sResult.status));
             }
 
-            cbor::imemstream sInput(std::string_view(sResult.body));
-            Responses        sResponses;
+            cbor::ispan sInput(std::string_view(sResult.body));
+            Responses   sResponses;
             cbor::read(sInput, sResponses);
             co_return sResponses;
         }
@@ -1,35 +1,126 @@
 #pragma once
 
-#include <unordered_map>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
 
 #include "API.hpp"
+#include "Storage.hpp"
 #include "asio_http/API.hpp"
 #include "asio_http/Asio.hpp"
 
+#include <threads/Coro.hpp>
+
 namespace KV {
+
+    struct ServerParams
+    {
+        std::string path    = {}; // directory for shard logs, empty to keep data in memory only
+        unsigned    shards  = 8;
+        unsigned    threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+        size_t      memory  = 1024 * 1024 * 1024; // total eviction budget
+        bool        sync    = false;
+    };
+
+    // every shard owned by own strand in thread pool.
+    // batch split by key hash and processed by all shards in parallel,
+    // log flushed once per batch in every shard.
     class Server : public std::enable_shared_from_this<Server>
     {
-        std::unordered_map<std::string, std::string> m_Data;
+        using Strand = boost::asio::strand<boost::asio::thread_pool::executor_type>;
 
-        boost::asio::awaitable<Response> Get(Request& aRequest)
+        struct Part
         {
-            Response sResponse;
-            sResponse.key = aRequest.key;
-            if (auto x = m_Data.find(aRequest.key); x != m_Data.end()) {
-                sResponse.value = x->second;
+            Shard  shard;
+            Strand strand;
+
+            Part(const ShardParams& aParams, Strand&& aStrand)
+            : shard(aParams)
+            , strand(std::move(aStrand))
+            {
             }
-            co_return sResponse;
-        }
+        };
+
+        const ServerParams                 m_Params;
+        boost::asio::thread_pool           m_Pool;
+        std::vector<std::unique_ptr<Part>> m_Shards;
 
-        boost::asio::awaitable<Response> Set(Request& aRequest)
+        size_t Index(std::string_view aKey) const { return std::hash<std::string_view>{}(aKey) % m_Shards.size(); }
+
+        static void Process(Shard& aShard, Requests& aRequests, Responses& aResponses, const std::vector<uint32_t>& aList)
         {
-            Response sResponse;
-            sResponse.key        = aRequest.key;
-            m_Data[aRequest.key] = std::move(aRequest.value.value());
-            co_return sResponse;
+            for (auto i : aList) {
+                auto& sRequest = aRequests[i];
+                if (sRequest.value) {
+                    aShard.Set(sRequest.key, *sRequest.value);
+                } else if (auto sValue = aShard.Get(sRequest.key); sValue) {
+                    aResponses[i].value.emplace(*sValue);
+                }
+            }
+            aShard.Flush();
         }
 
     public:
+        Server(const ServerParams& aParams = {})
+        : m_Params(aParams)
+        , m_Pool(aParams.threads)
+        {
+            if (!m_Params.path.empty())
+                std::filesystem::create_directories(m_Params.path);
+            for (unsigned i = 0; i < std::max(1u, m_Params.shards); i++) {
+                ShardParams sParams{.memory = m_Params.memory / std::max(1u, m_Params.shards), .sync = m_Params.sync};
+                if (!m_Params.path.empty())
+                    sParams.path = m_Params.path + "/shard-" + std::to_string(i) + ".log";
+                m_Shards.push_back(std::make_unique<Part>(sParams, boost::asio::make_strand(m_Pool.get_executor())));
+            }
+        }
+
+        boost::asio::awaitable<Responses> Call(Requests& aRequests)
+        {
+            Responses                          sResponses(aRequests.size());
+            std::vector<std::vector<uint32_t>> sLists(m_Shards.size());
+            for (uint32_t i = 0; i < aRequests.size(); i++) {
+                sResponses[i].key = aRequests[i].key;
+                sLists[Index(aRequests[i].key)].push_back(i);
+            }
+
+            std::atomic<unsigned> sPending{0};
+            std::exception_ptr    sError;
+            std::mutex            sMutex;
+            Threads::Coro::Waiter sWaiter;
+            for (auto& x : sLists)
+                if (!x.empty())
+                    sPending++;
+            if (sPending == 0)
+                co_return sResponses;
+
+            for (size_t i = 0; i < m_Shards.size(); i++) {
+                if (sLists[i].empty())
+                    continue;
+                auto& sPart = *m_Shards[i];
+                boost::asio::post(sPart.strand, [&, &sList = sLists[i]]() {
+                    try {
+                        Process(sPart.shard, aRequests, sResponses, sList);
+                    } catch (...) {
+                        std::unique_lock sLock(sMutex);
+                        if (!sError)
+                            sError = std::current_exception();
+                    }
+                    if (--sPending == 0)
+                        sWaiter.notify();
+                });
+            }
+            co_await sWaiter.wait();
+            if (sError)
+                std::rethrow_exception(sError);
+            co_return sResponses;
+        }
+
         void Configure(AsioHttp::ServerPtr aServer)
         {
             using namespace AsioHttp;
@@ -37,20 +128,12 @@ namespace KV {
             aServer->addHandler("/kv", [self](BeastRequest&& aRequest) -> ba::awaitable<BeastResponse> {
                 BeastResponse sResponse;
                 if (aRequest.method() == http::verb::post) {
-                    KV::Responses    sResponses;
-                    KV::Requests     sRequests;
-                    cbor::imemstream sInput(std::string_view(aRequest.body()));
+                    KV::Requests sRequests;
+                    cbor::ispan  sInput(std::string_view(aRequest.body()));
                     cbor::read(sInput, sRequests);
-                    for (auto& x : sRequests) {
-                        if (x.value) {
-                            sResponses.push_back(co_await self->Set(x));
-                        } else {
-                            sResponses.push_back(co_await self->Get(x));
-                        }
-                    }
-                    cbor::omemstream sOutput;
+                    KV::Responses sResponses = co_await self->Call(sRequests);
+                    cbor::obuffer sOutput(sResponse.body());
                     cbor::write(sOutput, sResponses);
-                    sResponse.body() = std::move(sOutput.str());
                     sResponse.result(http::status::ok);
                 } else {
                     sResponse.result(http::status::method_not_allowed);
@@ -58,5 +141,46 @@ namespace KV {
                 co_return sResponse;
             });
         }
+
+        // rewrite all shard logs, for example before shutdown.
+        // future is ready once all shards done, holds first error if any
+        std::future<void> Compact()
+        {
+            struct State
+            {
+                std::mutex         mutex;
+                std::promise<void> promise;
+                std::exception_ptr error;
+                size_t             pending = 0;
+            };
+            auto sState     = std::make_shared<State>();
+            sState->pending = m_Shards.size();
+            auto sFuture    = sState->promise.get_future();
+
+            for (auto& x : m_Shards)
+                boost::asio::post(x->strand, [sState, &sShard = x->shard]() {
+                    std::exception_ptr sError;
+                    try {
+                        sShard.Compact();
+                    } catch (...) {
+                        sError = std::current_exception();
+                    }
+                    std::unique_lock sLock(sState->mutex);
+                    if (sError and !sState->error)
+                        sState->error = sError;
+                    if (--sState->pending > 0)
+                        return;
+                    if (sState->error)
+                        sState->promise.set_exception(sState->error);
+                    else
+                        sState->promise.set_value();
+                });
+            return sFuture;
+        }
+
+        ~Server()
+        {
+            m_Pool.join();
+        }
     };
-} // namespace KV
\ No newline at end of file
+} // namespace KV
@@ -0,0 +1,407 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+
+#include <exception/Error.hpp>
+#include <file/Util.hpp>
+#include <hash/CRC32.hpp>
+#include <unsorted/Raii.hpp>
+
+namespace KV {
+
+    // values stored in chunks of power of 2 size classes, carved from 1MB pages.
+    // released chunk reused by next value of same class, pages never returned.
+    // values larger than page allocated directly.
+    class Slab : public boost::noncopyable
+    {
+    public:
+        static constexpr size_t  PAGE_SIZE = 1 << 20;
+        static constexpr size_t  MIN_SIZE  = 32;
+        static constexpr uint8_t CLASSES   = std::bit_width(PAGE_SIZE / MIN_SIZE);
+        static constexpr uint8_t DIRECT    = CLASSES;
+
+        struct Chunk
+        {
+            char*   data = nullptr;
+            uint8_t cls  = 0;
+        };
+
+    private:
+        std::array<std::vector<char*>, CLASSES> m_Free;
+        std::vector<std::unique_ptr<char[]>>    m_Pages;
+        size_t                                  m_Used = 0;
+
+        static uint8_t Class(size_t aSize)
+        {
+            if (aSize <= MIN_SIZE)
+                return 0;
+            if (aSize > PAGE_SIZE)
+                return DIRECT;
+            return std::bit_width(aSize - 1) - std::bit_width(MIN_SIZE - 1);
+        }
+
+        void Grow(uint8_t aClass)
+        {
+            const size_t sSize = MIN_SIZE << aClass;
+            m_Pages.push_back(std::make_unique<char[]>(PAGE_SIZE));
+            char* sPage = m_Pages.back().get();
+            for (size_t i = PAGE_SIZE; i >= sSize; i -= sSize)
+                m_Free[aClass].push_back(sPage + i - sSize);
+        }
+
+    public:
+        // memory accounted for value of given size
+        static size_t Size(size_t aSize)
+        {
+            const uint8_t sClass = Class(aSize);
+            return sClass == DIRECT ? aSize : MIN_SIZE << sClass;
+        }
+
+        Chunk Allocate(size_t aSize)
+        {
+            const uint8_t sClass = Class(aSize);
+            m_Used += Size(aSize);
+            if (sClass == DIRECT)
+                return {new char[aSize], DIRECT};
+            auto& sFree = m_Free[sClass];
+            if (sFree.empty())
+                Grow(sClass);
+            char* sPtr = sFree.back();
+            sFree.pop_back();
+            return {sPtr, sClass};
+        }
+
+        void Release(const Chunk& aChunk, size_t aSize)
+        {
+            m_Used -= Size(aSize);
+            if (aChunk.cls == DIRECT)
+                delete[] aChunk.data;
+            else
+                m_Free[aChunk.cls].push_back(aChunk.data);
+        }
+
+        size_t Used() const { return m_Used; }
+        size_t Reserved() const { return m_Pages.size() * PAGE_SIZE; }
+    };
+
+    // append only log of set operations.
+    // record: crc32, key size, value size, key, value. crc covers sizes and data.
+    class Log : public boost::noncopyable
+    {
+        struct Header
+        {
+            uint32_t crc;
+            uint32_t key;
+            uint32_t value;
+        };
+        static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+        const std::string m_Path;
+        int               m_FD   = -1;
+        uint64_t          m_Size = 0; // file size + buffered data
+        std::string       m_Buffer;
+
+        static uint32_t Checksum(const Header& aHeader, std::string_view aKey, std::string_view aValue)
+        {
+            return Hash::CRC32::sum(aHeader.key, aHeader.value, aKey, aValue);
+        }
+
+        static void Append(std::string& aBuffer, std::string_view aKey, std::string_view aValue)
+        {
+            Header sHeader{0, uint32_t(aKey.size()), uint32_t(aValue.size())};
+            sHeader.crc = Checksum(sHeader, aKey, aValue);
+            aBuffer.append((const char*)&sHeader, sizeof(sHeader));
+            aBuffer.append(aKey);
+            aBuffer.append(aValue);
+        }
+
+        static void Write(int aFD, std::string_view aData)
+        {
+            while (!aData.empty()) {
+                const ssize_t sRC = ::write(aFD, aData.data(), aData.size());
+                if (sRC == -1) {
+                    if (errno == EINTR)
+                        continue;
+                    throw Exception::ErrnoError("KV::Log: fail to write");
+                }
+                aData.remove_prefix(sRC);
+            }
+        }
+
+        static void Sync(int aFD)
+        {
+            if (-1 == ::fdatasync(aFD))
+                throw Exception::ErrnoError("KV::Log: fail to sync");
+        }
+
+    public:
+        explicit Log(const std::string& aPath)
+        : m_Path(aPath)
+        {
+            m_FD = ::open(m_Path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            if (m_FD == -1)
+                throw Exception::ErrnoError("KV::Log: fail to open " + m_Path);
+        }
+
+        // call handler for every valid record. tail after first broken record
+        // (partial write on crash) is truncated.
+        template <class H>
+        void Replay(H&& aHandler)
+        {
+            struct stat sStat;
+            if (-1 == ::fstat(m_FD, &sStat))
+                throw Exception::ErrnoError("KV::Log: fail to stat " + m_Path);
+
+            uint64_t sGood = 0;
+            if (sStat.st_size > 0) {
+                void* sMap = ::mmap(nullptr, sStat.st_size, PROT_READ, MAP_PRIVATE, m_FD, 0);
+                if (sMap == MAP_FAILED)
+                    throw Exception::ErrnoError("KV::Log: fail to mmap " + m_Path);
+                Util::Raii sCleanup([sMap, sSize = sStat.st_size]() { ::munmap(sMap, sSize); });
+                ::madvise(sMap, sStat.st_size, MADV_SEQUENTIAL);
+
+                std::string_view sData((const char*)sMap, sStat.st_size);
+                while (sData.size() >= sizeof(Header)) {
+                    Header sHeader;
+                    memcpy(&sHeader, sData.data(), sizeof(sHeader));
+                    if (sData.size() - sizeof(Header) < uint64_t(sHeader.key) + sHeader.value)
+                        break;
+                    const auto sKey   = sData.substr(sizeof(Header), sHeader.key);
+                    const auto sValue = sData.substr(sizeof(Header) + sHeader.key, sHeader.value);
+                    if (sHeader.crc != Checksum(sHeader, sKey, sValue))
+                        break;
+                    aHandler(sKey, sValue);
+                    const size_t sLen = sizeof(Header) + sHeader.key + sHeader.value;
+                    sData.remove_prefix(sLen);
+                    sGood += sLen;
+                }
+            }
+            if (sGood < uint64_t(sStat.st_size) and -1 == ::ftruncate(m_FD, sGood))
+                throw Exception::ErrnoError("KV::Log: fail to truncate " + m_Path);
+            if (-1 == ::lseek(m_FD, sGood, SEEK_SET))
+                throw Exception::ErrnoError("KV::Log: fail to seek " + m_Path);
+            m_Size = sGood;
+        }
+
+        void Append(std::string_view aKey, std::string_view aValue)
+        {
+            Append(m_Buffer, aKey, aValue);
+            m_Size += sizeof(Header) + aKey.size() + aValue.size();
+            if (m_Buffer.size() >= FLUSH_SIZE)
+                Flush(false);
+        }
+
+        void Flush(bool aSync)
+        {
+            if (!m_Buffer.empty()) {
+                Write(m_FD, m_Buffer);
+                m_Buffer.clear();
+            }
+            if (aSync)
+                Sync(m_FD);
+        }
+
+        // rename is durable only after parent directory synced
+        static void SyncDir(const std::string& aPath)
+        {
+            const auto sDir = std::filesystem::path(aPath).parent_path();
+            int        sFD  = ::open(sDir.empty() ? "." : sDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (sFD == -1)
+                throw Exception::ErrnoError("KV::Log: fail to open directory of " + aPath);
+            Util::Raii sGuard([sFD]() { ::close(sFD); });
+            if (-1 == ::fsync(sFD))
+                throw Exception::ErrnoError("KV::Log: fail to sync directory of " + aPath);
+        }
+
+        // replace log with records produced by aForEach(append), atomically via rename
+        template <class F>
+        void Rewrite(F&& aForEach)
+        {
+            Flush(false);
+            const std::string sTmpName = File::tmpName(m_Path);
+            int               sFD      = ::open(sTmpName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (sFD == -1)
+                throw Exception::ErrnoError("KV::Log: fail to create " + sTmpName);
+            Util::Raii sGuard([sFD, &sTmpName]() { ::close(sFD); ::unlink(sTmpName.c_str()); });
+
+            std::string sBuffer;
+            uint64_t    sSize = 0;
+            aForEach([&](std::string_view aKey, std::string_view aValue) {
+                Append(sBuffer, aKey, aValue);
+                if (sBuffer.size() >= FLUSH_SIZE) {
+                    Write(sFD, sBuffer);
+                    sSize += sBuffer.size();
+                    sBuffer.clear();
+                }
+            });
+            Write(sFD, sBuffer);
+            sSize += sBuffer.size();
+            Sync(sFD);
+
+            if (-1 == ::rename(sTmpName.c_str(), m_Path.c_str()))
+                throw Exception::ErrnoError("KV::Log: fail to rename " + sTmpName);
+            sGuard.dismiss();
+            ::close(m_FD);
+            m_FD   = sFD;
+            m_Size = sSize;
+            SyncDir(m_Path);
+        }
+
+        uint64_t Size() const { return m_Size; }
+
+        ~Log()
+        {
+            try {
+                Flush(false);
+            } catch (...) {
+            }
+            ::close(m_FD);
+        }
+    };
+
+    struct ShardParams
+    {
+        std::string path        = {};                // log file, empty to keep data in memory only
+        size_t      memory      = 256 * 1024 * 1024; // eviction budget, keys and values
+        bool        sync        = false;             // fdatasync log after every batch
+        uint64_t    compact_min = 64 * 1024 * 1024;  // do not compact smaller logs
+    };
+
+    // single threaded storage: keys in hash map, values in slab, LRU eviction
+    // when memory budget exceeded. every Set appended to log, log rewritten
+    // with live data when it grows twice bigger than data in memory.
+    class Shard : public boost::noncopyable
+    {
+        struct Hash : std::hash<std::string_view>
+        {
+            using is_transparent = void;
+        };
+        using LRU = std::list<const std::string*>;
+
+        struct Entry
+        {
+            Slab::Chunk   chunk;
+            uint32_t      size = 0;
+            LRU::iterator lru;
+
+            std::string_view view() const { return std::string_view(chunk.data, size); }
+        };
+        using Map = std::unordered_map<std::string, Entry, Hash, std::equal_to<>>;
+
+        static constexpr size_t ENTRY_OVERHEAD = 64; // map node and lru node
+
+        const ShardParams    m_Params;
+        Slab                 m_Slab;
+        Map                  m_Map;
+        LRU                  m_Lru; // most recent at front
+        size_t               m_Keys = 0;
+        std::unique_ptr<Log> m_Log;
+        uint64_t             m_Evicted = 0;
+
+        void Remove(Map::iterator aIt)
+        {
+            m_Keys -= aIt->first.size() + ENTRY_OVERHEAD;
+            m_Slab.Release(aIt->second.chunk, aIt->second.size);
+            m_Lru.erase(aIt->second.lru);
+            m_Map.erase(aIt);
+        }
+
+        void Evict()
+        {
+            while (Used() > m_Params.memory and m_Lru.size() > 1) {
+                Remove(m_Map.find(*m_Lru.back()));
+                m_Evicted++;
+            }
+        }
+
+        void Store(std::string_view aKey, std::string_view aValue)
+        {
+            auto sIt = m_Map.find(aKey);
+            if (sIt == m_Map.end()) {
+                sIt = m_Map.emplace(aKey, Entry{}).first;
+                m_Lru.push_front(&sIt->first);
+                sIt->second.lru = m_Lru.begin();
+                m_Keys += aKey.size() + ENTRY_OVERHEAD;
+            } else {
+                m_Slab.Release(sIt->second.chunk, sIt->second.size);
+                m_Lru.splice(m_Lru.begin(), m_Lru, sIt->second.lru);
+            }
+            auto& sEntry = sIt->second;
+            sEntry.chunk = m_Slab.Allocate(aValue.size());
+            sEntry.size  = aValue.size();
+            memcpy(sEntry.chunk.data, aValue.data(), aValue.size());
+            Evict();
+        }
+
+    public:
+        explicit Shard(const ShardParams& aParams = {})
+        : m_Params(aParams)
+        {
+            if (m_Params.path.empty())
+                return;
+            m_Log = std::make_unique<Log>(m_Params.path);
+            m_Log->Replay([this](std::string_view aKey, std::string_view aValue) { Store(aKey, aValue); });
+        }
+
+        std::optional<std::string_view> Get(std::string_view aKey)
+        {
+            auto sIt = m_Map.find(aKey);
+            if (sIt == m_Map.end())
+                return std::nullopt;
+            m_Lru.splice(m_Lru.begin(), m_Lru, sIt->second.lru);
+            return sIt->second.view();
+        }
+
+        void Set(std::string_view aKey, std::string_view aValue)
+        {
+            if (aKey.size() + aValue.size() + ENTRY_OVERHEAD > m_Params.memory)
+                throw std::invalid_argument("KV::Shard: value too large");
+            if (m_Log)
+                m_Log->Append(aKey, aValue);
+            Store(aKey, aValue);
+        }
+
+        // end of batch: write log, compact if required
+        void Flush()
+        {
+            if (!m_Log)
+                return;
+            m_Log->Flush(m_Params.sync);
+            if (m_Log->Size() > m_Params.compact_min and m_Log->Size() > 2 * Used())
+                Compact();
+        }
+
+        // rewrite log with live entries, least recent first to keep LRU order on replay
+        void Compact()
+        {
+            if (!m_Log)
+                return;
+            m_Log->Rewrite([this](auto&& aAppend) {
+                for (auto sIt = m_Lru.rbegin(); sIt != m_Lru.rend(); ++sIt)
+                    aAppend(**sIt, m_Map.find(**sIt)->second.view());
+            });
+        }
+
+        size_t   Size() const { return m_Map.size(); }
+        size_t   Used() const { return m_Keys + m_Slab.Used(); }
+        uint64_t Evicted() const { return m_Evicted; }
+        uint64_t LogSize() const { return m_Log ? m_Log->Size() : 0; }
+    };
+} // namespace KV
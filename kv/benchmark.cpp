@@ -6,6 +6,7 @@
 
 #include <benchmark/Benchmark.hpp>
 #include <unsorted/Raii.hpp>
+#include <unsorted/Random.hpp>
 
 static void BM_Get(benchmark::State& state)
 {
@@ -44,4 +45,87 @@ static void BM_Get(benchmark::State& state)
 }
 BENCHMARK(BM_Get)->UseRealTime()->Arg(1)->Arg(100)->Arg(500)->Arg(1000)->Arg(2000)->Arg(3000)->Unit(benchmark::kMillisecond);
 
+static KV::Requests MixedBatch(unsigned aSize, unsigned aKeys)
+{
+    KV::Requests sRequests;
+    sRequests.reserve(aSize);
+    for (unsigned i = 0; i < aSize; i++) {
+        KV::Request sRequest{.key = std::to_string(Util::randomInt(aKeys))};
+        if (Util::randomInt(10) == 0)
+            sRequest.value = std::string(100, 'a' + i % 26);
+        sRequests.push_back(std::move(sRequest));
+    }
+    return sRequests;
+}
+
+// mixed batches: 90% get, 10% set over 100k keys, data logged to disk
+static void BM_Mixed(benchmark::State& state)
+{
+    using namespace AsioHttp;
+    constexpr unsigned BATCH = 100;
+    constexpr unsigned KEYS  = 100000;
+
+    const std::string sPath = std::filesystem::temp_directory_path() / "kv-benchmark";
+    std::filesystem::remove_all(sPath);
+
+    ba::io_service sAsio;
+    auto           sHttpServer = createServer({});
+    auto           sKvServer   = std::make_shared<KV::Server>(KV::ServerParams{.path = sPath});
+    sKvServer->Configure(sHttpServer);
+
+    ba::co_spawn(sAsio, [&]() -> ba::awaitable<void> { co_return co_await sHttpServer->run(); }, ba::detached);
+    std::thread sHttpThread([&]() { sAsio.run(); });
+    Util::Raii  sCleanup([&]() { sAsio.stop(); sHttpThread.join(); std::filesystem::remove_all(sPath); });
+
+    std::vector<std::unique_ptr<KV::Client>> sClients(state.range(0));
+    uint64_t                                 sOps = 0;
+    Time::Meter                              sMeter;
+    Benchmark::Coro(
+        state,
+        state.range(0),
+        [&]() -> boost::asio::awaitable<void> { co_return; },
+        [&](auto aSerial) -> boost::asio::awaitable<void> {
+            auto& sClient = sClients[aSerial];
+            if (!sClient)
+                sClient = std::make_unique<KV::Client>();
+            auto sResponses = co_await sClient->Call(MixedBatch(BATCH, KEYS));
+            sOps += sResponses.size();
+        },
+        [&]() -> boost::asio::awaitable<void> {
+            state.counters["ops"] = sOps / sMeter.get().to_double();
+            sClients.clear();
+            co_return;
+        });
+}
+BENCHMARK(BM_Mixed)->UseRealTime()->Arg(1)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
+
+// same load without http, storage engine only
+static void BM_Engine(benchmark::State& state)
+{
+    constexpr unsigned BATCH = 100;
+    constexpr unsigned KEYS  = 100000;
+
+    const std::string sPath = std::filesystem::temp_directory_path() / "kv-benchmark";
+    std::filesystem::remove_all(sPath);
+    Util::Raii sCleanup([&]() { std::filesystem::remove_all(sPath); });
+
+    auto        sKvServer = std::make_shared<KV::Server>(KV::ServerParams{.path = sPath});
+    uint64_t    sOps      = 0;
+    Time::Meter sMeter;
+    Benchmark::Coro(
+        state,
+        state.range(0),
+        [&]() -> boost::asio::awaitable<void> { co_return; },
+        [&](auto) -> boost::asio::awaitable<void> {
+            auto sRequests  = MixedBatch(BATCH, KEYS);
+            auto sResponses = co_await sKvServer->Call(sRequests);
+            sOps += sResponses.size();
+        },
+        [&]() -> boost::asio::awaitable<void> {
+            state.counters["ops"] = sOps / sMeter.get().to_double();
+            co_return;
+        });
+}
+BENCHMARK(BM_Engine)->UseRealTime()->Arg(1)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
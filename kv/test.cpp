@@ -1,9 +1,13 @@
 #define BOOST_TEST_MODULE Suites
 #include <boost/test/unit_test.hpp>
 
+#include <fstream>
+
 #include "Client.hpp"
 #include "Server.hpp"
 
+#include <unsorted/Raii.hpp>
+
 using namespace AsioHttp;
 using namespace std::chrono_literals;
 
@@ -79,4 +83,63 @@ BOOST_AUTO_TEST_CASE(batch)
     sAsio.run_for(200ms);
     BOOST_CHECK_EQUAL(sOk, COUNT);
 }
+BOOST_AUTO_TEST_CASE(storage)
+{
+    const std::string sPath = std::filesystem::temp_directory_path() / "kv-test-storage.log";
+    std::filesystem::remove(sPath);
+    Util::Raii sCleanup([&sPath]() { std::filesystem::remove(sPath); });
+
+    {
+        KV::Shard sShard({.path = sPath});
+        for (unsigned i = 0; i < 100; i++)
+            sShard.Set(std::to_string(i), std::string(i, 'x'));
+        sShard.Set("1", "foo");
+        sShard.Flush();
+    }
+    // partial record on crash
+    std::ofstream(sPath, std::ios::app) << "garbage";
+    {
+        KV::Shard sShard({.path = sPath});
+        BOOST_CHECK_EQUAL(sShard.Size(), 100);
+        BOOST_CHECK_EQUAL(sShard.Get("1").value(), "foo");
+        BOOST_CHECK_EQUAL(sShard.Get("99").value(), std::string(99, 'x'));
+        BOOST_CHECK(!sShard.Get("100"));
+
+        const auto sSize = sShard.LogSize();
+        sShard.Compact();
+        BOOST_CHECK_LT(sShard.LogSize(), sSize);
+        sShard.Set("100", "bar");
+        sShard.Flush();
+    }
+    {
+        KV::Shard sShard({.path = sPath});
+        BOOST_CHECK_EQUAL(sShard.Size(), 101);
+        BOOST_CHECK_EQUAL(sShard.Get("100").value(), "bar");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compact)
+{
+    const std::string sPath = std::filesystem::temp_directory_path() / "kv-test-compact";
+    std::filesystem::remove_all(sPath);
+    Util::Raii sCleanup([&sPath]() { std::filesystem::remove_all(sPath); });
+
+    auto sServer = std::make_shared<KV::Server>(KV::ServerParams{.path = sPath, .shards = 2});
+    sServer->Compact().get();
+
+    // log directory gone: error reported via future
+    std::filesystem::remove_all(sPath);
+    BOOST_CHECK_THROW(sServer->Compact().get(), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(eviction)
+{
+    KV::Shard sShard({.memory = 10000});
+    for (unsigned i = 0; i < 1000; i++)
+        sShard.Set(std::to_string(i), std::string(100, 'x'));
+    BOOST_CHECK_LE(sShard.Used(), 10000);
+    BOOST_CHECK_GT(sShard.Evicted(), 0);
+    BOOST_CHECK(!sShard.Get("0"));
+    BOOST_CHECK(sShard.Get("999"));
+}
 BOOST_AUTO_TEST_SUITE_END()
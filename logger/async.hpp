@@ -0,0 +1,234 @@
+
+#ifndef _LOGGER_ASYNC_HPP__
+#define _LOGGER_ASYNC_HPP__
+
+#include "logger.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <time.h>
+
+namespace Logger {
+namespace Async {
+
+	/*
+	   asynchronous backend.
+
+	   call site writes pointer to static Site (format id) and raw arguments
+	   to ring of current thread. no formatting, no allocation, no locks.
+	   background thread formats records and writes them in batches with writev.
+
+	   if ring is full - message dropped and counted, backend reports number of lost messages.
+	   if backend not started - message formatted and written in caller thread.
+	*/
+
+	void start(int fd = 2);
+	void stop();	// write everything queued and join backend thread
+	uint64_t dropped();	// total number of messages lost on full ring
+
+	// static descriptor of call site. pointer to it is format id in record
+	struct Site {
+		const char* format;	// {} replaced by next argument
+		int level;
+		void (*decode)(const char* format, const char* data, std::string& out);
+	};
+
+	// single producer, single consumer byte ring.
+	// positions grow monotonically, offset in buffer is position % SIZE.
+	// record: Header, packed arguments, padding to 8 bytes. size 0 means wrap to begin of buffer
+	class Ring {
+	public:
+		enum { SIZE = 1 << 20, MAX_RECORD = SIZE / 4 };
+
+		struct Header {
+			uint32_t size;
+			uint32_t reserved;
+			const Site* site;
+			uint64_t ns;	// CLOCK_REALTIME
+		};
+
+	private:
+		alignas(64) std::atomic<uint64_t> m_Head{0};	// written by producer
+		uint64_t m_Cached = 0;				// producer copy of m_Tail
+		uint64_t m_Pending = 0;
+		alignas(64) std::atomic<uint64_t> m_Tail{0};	// written by consumer
+		std::atomic<uint64_t> m_Dropped{0};
+		std::atomic<bool> m_Closed{false};
+		alignas(64) char m_Data[SIZE];
+
+	public:
+		// producer side
+		char* reserve(uint32_t aSize) {
+			const uint64_t sHead = m_Head.load(std::memory_order_relaxed);
+			const uint64_t sOffset = sHead % SIZE;
+			uint64_t sNeed = aSize;
+			if (sOffset + aSize > SIZE)
+				sNeed += SIZE - sOffset;	// rest of buffer skipped
+			if (sHead + sNeed - m_Cached > SIZE) {
+				m_Cached = m_Tail.load(std::memory_order_acquire);
+				if (sHead + sNeed - m_Cached > SIZE) {
+					m_Dropped.fetch_add(1, std::memory_order_relaxed);
+					return nullptr;
+				}
+			}
+			if (sNeed != aSize)
+				reinterpret_cast<Header*>(m_Data + sOffset)->size = 0;
+			m_Pending = sNeed;
+			return m_Data + (sHead + sNeed - aSize) % SIZE;
+		}
+		void commit() { m_Head.store(m_Head.load(std::memory_order_relaxed) + m_Pending, std::memory_order_release); }
+		void close() { m_Closed.store(true, std::memory_order_release); }
+
+		// consumer side
+		uint64_t head() const { return m_Head.load(std::memory_order_acquire); }
+		uint64_t tail() const { return m_Tail.load(std::memory_order_relaxed); }
+		void release(uint64_t aPos) { m_Tail.store(aPos, std::memory_order_release); }
+		uint64_t dropped() { return m_Dropped.exchange(0, std::memory_order_relaxed); }
+		bool closed() const { return m_Closed.load(std::memory_order_acquire); }
+
+		// record at aPos, aPos moved to next record
+		const Header* next(uint64_t& aPos) const {
+			auto sHeader = reinterpret_cast<const Header*>(m_Data + aPos % SIZE);
+			if (sHeader->size == 0) {
+				aPos += SIZE - aPos % SIZE;
+				sHeader = reinterpret_cast<const Header*>(m_Data);
+			}
+			aPos += sHeader->size;
+			return sHeader;
+		}
+	};
+
+	extern __thread Ring* t_ring;
+	Ring* attach();	// create and register ring for current thread
+	void sync(const Ring::Header& aHeader, const char* aData);
+
+	// formatting helpers, used by backend thread
+	const char* literal(const char* aFormat, std::string& aOut);	// copy format up to next {}
+	void append(std::string& aOut, int64_t aValue);
+	void append(std::string& aOut, uint64_t aValue);
+	void append(std::string& aOut, double aValue);
+	void append(std::string& aOut, const void* aValue);
+
+	// how argument stored in ring: arithmetic and pointers as is
+	template<class T>
+	struct Arg {
+		static_assert(std::is_arithmetic<T>::value || std::is_pointer<T>::value, "Logger: unsupported argument type");
+
+		static size_t size(T) { return sizeof(T); }
+		static char* put(char* aPtr, T aValue) {
+			memcpy(aPtr, &aValue, sizeof(T));
+			return aPtr + sizeof(T);
+		}
+		static const char* get(const char* aPtr, std::string& aOut) {
+			T sValue;
+			memcpy(&sValue, aPtr, sizeof(T));
+			if constexpr (std::is_same<T, bool>::value)
+				aOut.append(sValue ? "true" : "false");
+			else if constexpr (std::is_same<T, char>::value)
+				aOut.push_back(sValue);
+			else if constexpr (std::is_floating_point<T>::value)
+				append(aOut, double(sValue));
+			else if constexpr (std::is_pointer<T>::value)
+				append(aOut, static_cast<const void*>(sValue));
+			else if constexpr (std::is_signed<T>::value)
+				append(aOut, int64_t(sValue));
+			else
+				append(aOut, uint64_t(sValue));
+			return aPtr + sizeof(T);
+		}
+	};
+
+	// strings copied: length and bytes
+	struct Text {
+		static size_t size(std::string_view aValue) { return sizeof(uint32_t) + aValue.size(); }
+		static char* put(char* aPtr, std::string_view aValue) {
+			const uint32_t sSize = aValue.size();
+			memcpy(aPtr, &sSize, sizeof(sSize));
+			memcpy(aPtr + sizeof(sSize), aValue.data(), sSize);
+			return aPtr + sizeof(sSize) + sSize;
+		}
+		static const char* get(const char* aPtr, std::string& aOut) {
+			uint32_t sSize;
+			memcpy(&sSize, aPtr, sizeof(sSize));
+			aOut.append(aPtr + sizeof(sSize), sSize);
+			return aPtr + sizeof(sSize) + sSize;
+		}
+	};
+	template<> struct Arg<const char*> : Text {};
+	template<> struct Arg<char*> : Text {};
+	template<> struct Arg<std::string> : Text {};
+	template<> struct Arg<std::string_view> : Text {};
+
+	template<class... A>
+	struct Decoder {
+		static void decode(const char* aFormat, const char* aData, std::string& aOut) {
+			((aFormat = literal(aFormat, aOut), aData = Arg<A>::get(aData, aOut)), ...);
+			aOut.append(aFormat);
+		}
+	};
+
+	// only for decltype in LOG_ASYNC_CUSTOM
+	template<class... A>
+	Decoder<std::decay_t<A>...> decoder(const char* aFormat, const A&...);
+
+	template<class... A>
+	void write(const Site& aSite, const char*, const A&... aArgs) {
+		const size_t sSize = (sizeof(Ring::Header) + (size_t(0) + ... + Arg<std::decay_t<A>>::size(aArgs)) + 7) & ~size_t(7);
+		struct timespec sTime;
+		clock_gettime(CLOCK_REALTIME, &sTime);
+		const Ring::Header sHeader{uint32_t(sSize), 0, &aSite, uint64_t(sTime.tv_sec) * 1000000000 + sTime.tv_nsec};
+
+		auto sEncode = [&](char* aPtr) {
+			memcpy(aPtr, &sHeader, sizeof(sHeader));
+			aPtr += sizeof(sHeader);
+			((aPtr = Arg<std::decay_t<A>>::put(aPtr, aArgs)), ...);
+		};
+
+		if (!active.load(std::memory_order_relaxed)) {
+			std::string sTmp(sSize, '\0');
+			sEncode(&sTmp[0]);
+			sync(sHeader, sTmp.data() + sizeof(sHeader));
+			return;
+		}
+		if (sSize > Ring::MAX_RECORD)
+			return;
+		Ring* sRing = t_ring;
+		if (unlikely(sRing == nullptr))
+			sRing = attach();
+		char* sPtr = sRing->reserve(sSize);
+		if (sPtr == nullptr)
+			return;
+		sEncode(sPtr);
+		sRing->commit();
+	}
+
+} // namespace Async
+} // namespace Logger
+
+// format is string literal with {} for arguments. arguments: arithmetic, pointers and strings.
+// LOG_ASYNC_INFO("connect to {}:{} failed", host, port)
+#define LOG_ASYNC_FORMAT(_fmt, ...) _fmt
+
+#define LOG_ASYNC_CUSTOM(_key, _level, ...) \
+	do  { \
+		static Logger::log_state __attribute__((section("__logger"), used)) _marker(_key, 0); \
+		if (unlikely(_level <= _marker.level.load(std::memory_order_relaxed) || Logger::State::enabled)) { \
+			static constexpr Logger::Async::Site _site{LOG_ASYNC_FORMAT(__VA_ARGS__, 0), _level, \
+				&decltype(Logger::Async::decoder(__VA_ARGS__))::decode}; \
+			Logger::Async::write(_site, __VA_ARGS__); \
+		} \
+	} while(0)
+
+#define LOG_ASYNC(level, ...) LOG_ASYNC_CUSTOM(__func__, level, __VA_ARGS__)
+
+#define LOG_ASYNC_CRIT(...)    LOG_ASYNC(Logger::CRIT, __VA_ARGS__)
+#define LOG_ASYNC_ERROR(...)   LOG_ASYNC(Logger::ERROR, __VA_ARGS__)
+#define LOG_ASYNC_WARNING(...) LOG_ASYNC(Logger::WARNING, __VA_ARGS__)
+#define LOG_ASYNC_INFO(...)    LOG_ASYNC(Logger::INFO, __VA_ARGS__)
+#define LOG_ASYNC_DEBUG(...)   LOG_ASYNC(Logger::DEBUG, __VA_ARGS__)
+#define LOG_ASYNC_TRACE(...)   LOG_ASYNC(Logger::TRACE, __VA_ARGS__)
+
+#endif /* _LOGGER_ASYNC_HPP__ */
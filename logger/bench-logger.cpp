@@ -0,0 +1,85 @@
+
+/*
+	ns per log call, N threads logging at same time.
+
+	sync:         LOG_INFO, formatted and written to stderr in caller
+	async stream: LOG_INFO with async backend, formatted in caller, written by backend
+	async:        LOG_ASYNC_INFO, raw arguments to ring, formatted and written by backend
+
+	output goes to /dev/null. async numbers include dropped messages (ring full),
+	count reported in last columns.
+*/
+
+#include "logger.hpp"
+#include "async.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+static int calls = 200000;
+
+void __attribute__ ((noinline)) log_sync(int i, const std::string& s) { LOG_INFO("request " << i << " from " << s << " took " << 0.25 << "ms"); }
+void __attribute__ ((noinline)) log_async(int i, const std::string& s) { LOG_ASYNC_INFO("request {} from {} took {}ms", i, s, 0.25); }
+
+template<class F>
+double measure(unsigned threads, F f)
+{
+	std::vector<std::thread> workers;
+	std::vector<double> ns(threads);
+	for (unsigned t = 0; t < threads; t++)
+		workers.emplace_back([t, f, &ns]() {
+			const std::string name = "client-" + std::to_string(t);
+			const auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < calls; i++)
+				f(i, name);
+			ns[t] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+		});
+	double sum = 0;
+	for (unsigned t = 0; t < threads; t++) {
+		workers[t].join();
+		sum += ns[t];
+	}
+	return sum / threads;
+}
+
+LOG_ENABLE_FOR_MODULE
+
+int main(int argc, char** argv)
+{
+	// bench_logger [max threads] [calls per thread]. ring holds ~16k records of this bench,
+	// use small number of calls to see cost without dropped messages
+	const unsigned max_threads = argc > 1 ? atoi(argv[1]) : 8;
+	if (argc > 2)
+		calls = atoi(argv[2]);
+
+	Logger::init();
+	Logger::set_all(Logger::INFO);
+
+	const int null = open("/dev/null", O_WRONLY);
+	const int err = dup(2);
+
+	printf("threads,sync,async_stream,async,stream_dropped,async_dropped\n");
+	for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+		dup2(null, 2);
+		const double sync = measure(threads, log_sync);
+
+		const uint64_t before = Logger::Async::dropped();
+		Logger::Async::start(null);
+		const double stream = measure(threads, log_sync);
+		Logger::Async::stop();
+
+		const uint64_t middle = Logger::Async::dropped();
+		Logger::Async::start(null);
+		const double async = measure(threads, log_async);
+		Logger::Async::stop();
+		dup2(err, 2);
+
+		printf("%u,%.1f,%.1f,%.1f,%lu,%lu\n", threads, sync, stream, async, middle - before, Logger::Async::dropped() - middle);
+	}
+	return 0;
+}
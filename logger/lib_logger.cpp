@@ -1,12 +1,23 @@
 
 #include "logger.hpp"
+#include "async.hpp"
 
 #include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
 #include <iomanip>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <sys/time.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <link.h>
 #include <dlfcn.h>
+#include <unistd.h>
 
 namespace Logger {
 
@@ -120,5 +131,297 @@ namespace Logger {
         static __thread TimeFormatter formatter;
         return formatter();
     }
-}
 
+    namespace Async {
+
+        std::atomic<bool> active{false};
+        __thread Ring* t_ring;
+
+        const char* literal(const char* aFormat, std::string& aOut)
+        {
+            const char* sPos = strstr(aFormat, "{}");
+            if (sPos == nullptr) {
+                // more arguments than placeholders
+                aOut.append(aFormat);
+                aOut.push_back(' ');
+                return "";
+            }
+            aOut.append(aFormat, sPos);
+            return sPos + 2;
+        }
+
+        template<class T>
+        static void append_number(std::string& aOut, T aValue)
+        {
+            char sBuf[32];
+            auto sResult = std::to_chars(sBuf, sBuf + sizeof(sBuf), aValue);
+            aOut.append(sBuf, sResult.ptr);
+        }
+        void append(std::string& aOut, int64_t aValue) { append_number(aOut, aValue); }
+        void append(std::string& aOut, uint64_t aValue) { append_number(aOut, aValue); }
+        void append(std::string& aOut, double aValue) { append_number(aOut, aValue); }
+        void append(std::string& aOut, const void* aValue)
+        {
+            aOut.append("0x");
+            char sBuf[32];
+            auto sResult = std::to_chars(sBuf, sBuf + sizeof(sBuf), uintptr_t(aValue), 16);
+            aOut.append(sBuf, sResult.ptr);
+        }
+
+        // same format as format_time(), localtime_r called once per second
+        struct RecordFormatter
+        {
+            time_t sec = -1;
+            char prefix[32];
+            size_t prefix_len = 0;
+
+            void operator()(const Ring::Header& aHeader, const char* aData, std::string& aOut)
+            {
+                const time_t sSec = aHeader.ns / 1000000000;
+                if (sSec != sec) {
+                    struct tm sTm;
+                    localtime_r(&sSec, &sTm);
+                    prefix_len = strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S.", &sTm);
+                    sec = sSec;
+                }
+                const unsigned sMs = aHeader.ns / 1000000 % 1000;
+                aOut.append(prefix, prefix_len);
+                aOut.push_back('0' + sMs / 100);
+                aOut.push_back('0' + sMs / 10 % 10);
+                aOut.push_back('0' + sMs % 10);
+                aOut.append(" [");
+                aOut.append(levels[aHeader.site->level]);
+                aOut.append("] ");
+                aHeader.site->decode(aHeader.site->format, aData, aOut);
+                aOut.push_back('\n');
+            }
+        };
+
+        static void write_all(int aFd, std::vector<struct iovec>& aIov)
+        {
+            size_t sDone = 0;
+            while (sDone < aIov.size()) {
+                const int sCount = std::min<size_t>(aIov.size() - sDone, IOV_MAX);
+                ssize_t sWritten = writev(aFd, &aIov[sDone], sCount);
+                if (sWritten < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    return;     // nowhere to report
+                }
+                for (; sDone < aIov.size() && size_t(sWritten) >= aIov[sDone].iov_len; sDone++)
+                    sWritten -= aIov[sDone].iov_len;
+                if (sWritten > 0) {
+                    aIov[sDone].iov_base = (char*)aIov[sDone].iov_base + sWritten;
+                    aIov[sDone].iov_len -= sWritten;
+                }
+            }
+        }
+
+        class Backend
+        {
+            std::mutex m_Mutex;
+            std::condition_variable m_Cond;
+            std::vector<std::shared_ptr<Ring>> m_Rings;
+            std::thread m_Thread;
+            bool m_Stop = false;
+            int m_Fd = 2;
+            std::atomic<uint64_t> m_Dropped{0};
+
+            struct Entry {
+                const Ring::Header* header;
+                size_t ring;
+            };
+
+            // vectors reused between batches
+            std::vector<std::shared_ptr<Ring>> m_Snapshot;
+            std::vector<uint64_t> m_End;
+            std::vector<Entry> m_Batch;
+            std::vector<size_t> m_Offset;
+            std::vector<struct iovec> m_Iov;
+            std::string m_Text;
+            RecordFormatter m_Formatter;
+
+            // format all queued records, sorted by time. return false if nothing to write
+            bool batch()
+            {
+                {
+                    std::unique_lock<std::mutex> sLock(m_Mutex);
+                    m_Snapshot = m_Rings;
+                }
+                m_End.resize(m_Snapshot.size());
+                m_Batch.clear();
+                m_Offset.clear();
+                m_Text.clear();
+                uint64_t sDropped = 0;
+                for (size_t i = 0; i < m_Snapshot.size(); i++) {
+                    Ring& sRing = *m_Snapshot[i];
+                    const uint64_t sHead = sRing.head();
+                    uint64_t sPos = sRing.tail();
+                    while (sPos < sHead)
+                        m_Batch.push_back({sRing.next(sPos), i});
+                    m_End[i] = sPos;
+                    sDropped += sRing.dropped();
+                }
+                if (m_Batch.empty() && sDropped == 0)
+                    return false;
+
+                // rings are ordered per thread, merge them
+                std::stable_sort(m_Batch.begin(), m_Batch.end(), [](const Entry& a, const Entry& b) {
+                    return a.header->ns < b.header->ns;
+                });
+                for (const auto& x : m_Batch) {
+                    m_Offset.push_back(m_Text.size());
+                    m_Formatter(*x.header, reinterpret_cast<const char*>(x.header + 1), m_Text);
+                }
+                for (size_t i = 0; i < m_Snapshot.size(); i++)
+                    m_Snapshot[i]->release(m_End[i]);
+                if (sDropped > 0) {
+                    m_Dropped += sDropped;
+                    m_Offset.push_back(m_Text.size());
+                    m_Text.append("logger: ");
+                    append(m_Text, sDropped);
+                    m_Text.append(" messages dropped, ring full\n");
+                }
+
+                m_Iov.clear();
+                m_Offset.push_back(m_Text.size());
+                for (size_t i = 0; i + 1 < m_Offset.size(); i++)
+                    m_Iov.push_back({&m_Text[m_Offset[i]], m_Offset[i + 1] - m_Offset[i]});
+                write_all(m_Fd, m_Iov);
+                return true;
+            }
+
+            // forget rings of finished threads
+            void cleanup()
+            {
+                std::unique_lock<std::mutex> sLock(m_Mutex);
+                m_Rings.erase(std::remove_if(m_Rings.begin(), m_Rings.end(), [](const std::shared_ptr<Ring>& x) {
+                    return x->closed() && x->tail() == x->head();
+                }), m_Rings.end());
+            }
+
+            void run()
+            {
+                auto sSleep = std::chrono::microseconds(50);
+                while (true) {
+                    if (batch()) {
+                        sSleep = std::chrono::microseconds(50);
+                        continue;
+                    }
+                    cleanup();
+                    std::unique_lock<std::mutex> sLock(m_Mutex);
+                    if (m_Stop)
+                        break;
+                    // producers never notify, poll with backoff
+                    m_Cond.wait_for(sLock, sSleep);
+                    sSleep = std::min(sSleep * 2, std::chrono::microseconds(10000));
+                }
+                while (batch())
+                    ;
+            }
+
+        public:
+            void start(int aFd)
+            {
+                std::unique_lock<std::mutex> sLock(m_Mutex);
+                if (m_Thread.joinable())
+                    return;
+                m_Fd = aFd;
+                m_Stop = false;
+                m_Thread = std::thread(&Backend::run, this);
+                active = true;
+            }
+            void stop()
+            {
+                std::unique_lock<std::mutex> sLock(m_Mutex);
+                if (!m_Thread.joinable())
+                    return;
+                active = false;
+                m_Stop = true;
+                m_Cond.notify_one();
+                sLock.unlock();
+                m_Thread.join();
+            }
+            void add(std::shared_ptr<Ring> aRing)
+            {
+                std::unique_lock<std::mutex> sLock(m_Mutex);
+                m_Rings.push_back(std::move(aRing));
+            }
+            uint64_t dropped() const { return m_Dropped; }
+            ~Backend() { stop(); }
+        };
+        static Backend backend;
+
+        void start(int aFd) { backend.start(aFd); }
+        void stop() { backend.stop(); }
+        uint64_t dropped() { return backend.dropped(); }
+
+        // ring lives while thread running or while backend has records from it
+        struct Holder
+        {
+            std::shared_ptr<Ring> ring;
+            ~Holder()
+            {
+                if (ring)
+                    ring->close();
+                t_ring = nullptr;
+            }
+        };
+
+        Ring* attach()
+        {
+            static thread_local Holder holder;
+            holder.ring = std::make_shared<Ring>();
+            backend.add(holder.ring);
+            t_ring = holder.ring.get();
+            return t_ring;
+        }
+
+        void sync(const Ring::Header& aHeader, const char* aData)
+        {
+            static thread_local RecordFormatter formatter;
+            std::string sText;
+            formatter(aHeader, aData, sText);
+            std::cerr << sText;
+        }
+
+        // stream messages: formatted in caller thread, passed as one string argument
+        struct StreamBuffer : public std::streambuf
+        {
+            std::string data;
+            std::ostream stream{this};
+
+            int overflow(int c) override
+            {
+                if (c != EOF)
+                    data.push_back(c);
+                return c;
+            }
+            std::streamsize xsputn(const char* s, std::streamsize n) override
+            {
+                data.append(s, n);
+                return n;
+            }
+        };
+        static thread_local StreamBuffer stream_buffer;
+
+        static const Site stream_sites[MAX_LEVEL] = {
+            {"{}", CRIT, &Decoder<std::string_view>::decode},
+            {"{}", ERROR, &Decoder<std::string_view>::decode},
+            {"{}", WARNING, &Decoder<std::string_view>::decode},
+            {"{}", INFO, &Decoder<std::string_view>::decode},
+            {"{}", DEBUG, &Decoder<std::string_view>::decode},
+            {"{}", TRACE, &Decoder<std::string_view>::decode},
+        };
+
+        std::ostream& stream()
+        {
+            return stream_buffer.stream;
+        }
+        void flush(int level)
+        {
+            write(stream_sites[level], "{}", std::string_view(stream_buffer.data));
+            stream_buffer.data.clear();
+        }
+    } // namespace Async
+}
@@ -2,6 +2,7 @@
 #ifndef _LOGGER_HPP__
 #define _LOGGER_HPP__
 
+#include <atomic>
 #include <string>
 #include <iostream>
 #include <stdint.h>
@@ -21,10 +22,11 @@ namespace Logger {
 		MAX_LEVEL
 	};
 
+	// constant initialized, so add() works for functions not called yet
 	struct log_state {
 		const char* func;
-		volatile int level;
-		log_state(const char* f, int l) : func(f), level(l) {}
+		std::atomic<int> level;
+		constexpr log_state(const char* f, int l) : func(f), level(l) {}
 	};
 
 	// conditional logging (enable all logging in scope on some condition)
@@ -47,6 +49,14 @@ namespace Logger {
 	const char* format_time();
 	extern const char* levels[MAX_LEVEL];
 
+	// async backend (async.hpp). when started, stream messages formatted
+	// to per thread buffer and written by backend thread
+	namespace Async {
+		extern std::atomic<bool> active;
+		std::ostream& stream();
+		void flush(int level);
+	}
+
 #ifndef likely
 #define likely(x)       __builtin_expect((x),1)
 #endif
@@ -56,11 +66,16 @@ namespace Logger {
 
 #define LOG_CUSTOM_MESSAGE(_key, _level, _msg) \
 	do  { \
-		static Logger::log_state __attribute__((section("__logger"))) _marker(_key, 0); \
-		if (unlikely(_level <= _marker.level || Logger::State::enabled)) { \
-			std::cerr << Logger::format_time() \
-			          << '[' << Logger::levels[_level] << ']' << ' ' \
-					  << _msg << std::endl; \
+		static Logger::log_state __attribute__((section("__logger"), used)) _marker(_key, 0); \
+		if (unlikely(_level <= _marker.level.load(std::memory_order_relaxed) || Logger::State::enabled)) { \
+			if (Logger::Async::active.load(std::memory_order_relaxed)) { \
+				Logger::Async::stream() << _msg; \
+				Logger::Async::flush(_level); \
+			} else { \
+				std::cerr << Logger::format_time() \
+				          << '[' << Logger::levels[_level] << ']' << ' ' \
+						  << _msg << std::endl; \
+			} \
 		} \
 	} while(0)
 
@@ -78,7 +93,7 @@ extern "C" struct Logger::log_state __start___logger[];\
 extern "C" struct Logger::log_state __stop___logger[];\
 void create_start_stop(void) \
 { \
- 	static int tmp __attribute__((unused)) ;\
+ 	static volatile uintptr_t tmp __attribute__((unused));\
 	tmp = (uintptr_t)__start___logger | (uintptr_t)__stop___logger;\
 }\
 
@@ -17,13 +17,17 @@
  */
 
 #include "logger.hpp"
+#include "async.hpp"
 #include "user.hpp"
 
+#include <thread>
+
 
 void __attribute__ ((noinline)) f1(void){ LOG_ERROR("test f1 error"); }
 void __attribute__ ((noinline)) f2(void){ LOG_WARNING("test f2 warning"); }
 void __attribute__ ((noinline)) f3(void){ LOG_INFO("test f3 info"); }
 void __attribute__ ((noinline)) f4(void){ LOG_TRACE("test f4 trace"); }
+void __attribute__ ((noinline)) f6(int i){ LOG_ASYNC_INFO("test f6 async {} of {}, {}", i, std::string("f6"), 0.5); }
 
 void run_f()
 {
@@ -69,7 +73,20 @@ int main(void)
 	std::cerr << "enable f5 trace" << std::endl;
 	Logger::add("f5", Logger::TRACE);
 	run_f();
+	Logger::set_all(0);
 
+	std::cerr << "async f6 before start" << std::endl;
+	Logger::add("f6", Logger::INFO);
+	f6(0);
 
+	std::cerr << "async backend" << std::endl;
+	Logger::Async::start();
+	Logger::add("f4", Logger::TRACE);
+	run_f();
+	std::thread t([]() { for (int i = 1; i <= 3; i++) f6(i); });
+	t.join();
+	Logger::remove("f6");
+	f6(4);
+	Logger::Async::stop();
+	std::cerr << "async backend stopped" << std::endl;
 }
-
@@ -0,0 +1,594 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Util {
+
+    // columnar evaluation of ExprTK expressions.
+    // expression parsed once into register bytecode, every instruction processed
+    // for block of BLOCK rows by vector kernel (AVX2 with -mavx2).
+    // supported subset: + - * / % ^, comparisons, and/or/xor/nand/nor/xnor/not(),
+    // if(c,a,b), abs/sqrt/floor/ceil/exp/log/min/max, true/false.
+    // anything else throws std::invalid_argument, so caller can fall back to exprtk.
+    class ExprBatch
+    {
+    public:
+        static constexpr size_t BLOCK = 1024;
+        using Bitmap                  = std::vector<uint64_t>;
+        using Literal                 = std::function<double(const std::string&)>;
+
+    private:
+        using V                     = double __attribute__((vector_size(32)));
+        using U                     = uint64_t __attribute__((vector_size(32)));
+        static constexpr size_t WIDTH = sizeof(V) / sizeof(double);
+
+        enum Code : uint8_t
+        {
+            ADD,
+            SUB,
+            MUL,
+            DIV,
+            MOD,
+            POW,
+            IPOW,
+            MIN,
+            MAX,
+            LT,
+            LE,
+            GT,
+            GE,
+            EQ,
+            NE,
+            AND,
+            OR,
+            XOR,
+            NAND,
+            NOR,
+            XNOR,
+            NEG,
+            NOT,
+            ABS,
+            SQRT,
+            FLOOR,
+            CEIL,
+            EXP,
+            LOG,
+            IF,
+        };
+
+        enum Kind : uint8_t
+        {
+            REG,
+            CONST,
+            VAR,
+        };
+
+        struct Ref
+        {
+            Kind     kind  = REG;
+            uint32_t index = 0;
+        };
+
+        struct Op
+        {
+            Code code;
+            Ref  dst;
+            Ref  a;
+            Ref  b        = {};
+            Ref  c        = {};
+            int  exponent = 0; // IPOW
+        };
+
+        struct Var
+        {
+            std::string         name;
+            const double*       data = nullptr;
+            size_t              size = 0;
+            std::vector<double> fill; // scalar broadcasted to block
+        };
+
+        std::vector<Op>                  m_Code;
+        std::vector<std::vector<double>> m_Consts;
+        std::vector<Var>                 m_Vars;
+        std::vector<std::string>         m_Names;
+        Ref                              m_Root;
+        uint32_t                         m_Registers = 0;
+
+        template <class T>
+        static T fill(double aValue)
+        {
+            if constexpr (std::is_same_v<T, double>)
+                return aValue;
+            else
+                return T{} + aValue;
+        }
+
+        // exprtk returns 1/0 for all logical operations
+        template <class T, class C>
+        static T boolean(C aCond)
+        {
+            return aCond ? fill<T>(1) : fill<T>(0);
+        }
+
+        static V load(const double* aPtr)
+        {
+            V sValue;
+            std::memcpy(&sValue, aPtr, sizeof(V));
+            return sValue;
+        }
+
+        static void store(double* aPtr, V aValue) { std::memcpy(aPtr, &aValue, sizeof(V)); }
+
+        // same multiplication order as exprtk fast_exp, so results are bit exact
+        template <class T>
+        static T ipow(T v, unsigned n)
+        {
+            switch (n) {
+            case 0: return fill<T>(1);
+            case 1: return v;
+            case 2: return v * v;
+            case 3: return v * v * v;
+            case 4: { T v2 = v * v; return v2 * v2; }
+            case 5: return ipow(v, 4) * v;
+            case 6: { T v3 = ipow(v, 3); return v3 * v3; }
+            case 7: return ipow(v, 6) * v;
+            case 8: { T v4 = ipow(v, 4); return v4 * v4; }
+            case 9: return ipow(v, 8) * v;
+            case 10: { T v5 = ipow(v, 5); return v5 * v5; }
+            }
+            T l = fill<T>(1);
+            while (n) {
+                if (n & 1) {
+                    l *= v;
+                    --n;
+                }
+                v *= v;
+                n >>= 1;
+            }
+            return l;
+        }
+
+        template <class F>
+        static void unary(size_t aSize, double* aDst, const double* aA, F&& aFunc)
+        {
+            size_t i = 0;
+            for (; i + WIDTH <= aSize; i += WIDTH)
+                store(aDst + i, aFunc(load(aA + i)));
+            for (; i < aSize; i++)
+                aDst[i] = aFunc(aA[i]);
+        }
+
+        template <class F>
+        static void binary(size_t aSize, double* aDst, const double* aA, const double* aB, F&& aFunc)
+        {
+            size_t i = 0;
+            for (; i + WIDTH <= aSize; i += WIDTH)
+                store(aDst + i, aFunc(load(aA + i), load(aB + i)));
+            for (; i < aSize; i++)
+                aDst[i] = aFunc(aA[i], aB[i]);
+        }
+
+        // libm functions without vector form
+        template <class F>
+        static void scalar(size_t aSize, double* aDst, const double* aA, const double* aB, F&& aFunc)
+        {
+            for (size_t i = 0; i < aSize; i++)
+                aDst[i] = aFunc(aA[i], aB ? aB[i] : 0);
+        }
+
+        static void execute(const Op& aOp, size_t n, double* d, const double* a, const double* b, const double* c)
+        {
+            // clang-format off
+            switch (aOp.code) {
+            case ADD:   binary(n, d, a, b, [](auto x, auto y) { return x + y; }); break;
+            case SUB:   binary(n, d, a, b, [](auto x, auto y) { return x - y; }); break;
+            case MUL:   binary(n, d, a, b, [](auto x, auto y) { return x * y; }); break;
+            case DIV:   binary(n, d, a, b, [](auto x, auto y) { return x / y; }); break;
+            case MOD:   scalar(n, d, a, b, [](double x, double y) { return std::fmod(x, y); }); break;
+            case POW:   scalar(n, d, a, b, [](double x, double y) { return std::pow(x, y); }); break;
+            case IPOW:  if (const int e = aOp.exponent; e >= 0)
+                            unary(n, d, a, [e](auto x) { return ipow(x, e); });
+                        else
+                            unary(n, d, a, [e](auto x) { return fill<decltype(x)>(1) / ipow(x, -e); });
+                        break;
+            // same as std::min/std::max for NaN
+            case MIN:   binary(n, d, a, b, [](auto x, auto y) { return y < x ? y : x; }); break;
+            case MAX:   binary(n, d, a, b, [](auto x, auto y) { return x < y ? y : x; }); break;
+            case LT:    binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>(x < y); }); break;
+            case LE:    binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>(x <= y); }); break;
+            case GT:    binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>(x > y); }); break;
+            case GE:    binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>(x >= y); }); break;
+            case EQ:    binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>(x == y); }); break;
+            case NE:    binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>(x != y); }); break;
+            // exprtk: NaN is true, only zero is false
+            case AND:   binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>((x != 0) & (y != 0)); }); break;
+            case OR:    binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>((x != 0) | (y != 0)); }); break;
+            case XOR:   binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>((x != 0) ^ (y != 0)); }); break;
+            case NAND:  binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>((x == 0) | (y == 0)); }); break;
+            case NOR:   binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>((x == 0) & (y == 0)); }); break;
+            case XNOR:  binary(n, d, a, b, [](auto x, auto y) { return boolean<decltype(x)>((x != 0) == (y != 0)); }); break;
+            case NEG:   unary(n, d, a, [](auto x) { return -x; }); break;
+            case NOT:   unary(n, d, a, [](auto x) { return boolean<decltype(x)>(x == 0); }); break;
+            case ABS:   unary(n, d, a, [](auto x) {
+                            if constexpr (std::is_same_v<decltype(x), double>)
+                                return std::fabs(x);
+                            else
+                                return (V)((U)x & (U{} + 0x7FFFFFFFFFFFFFFFull));
+                        }); break;
+            case SQRT:  scalar(n, d, a, nullptr, [](double x, double) { return std::sqrt(x); }); break;
+            case FLOOR: scalar(n, d, a, nullptr, [](double x, double) { return std::floor(x); }); break;
+            case CEIL:  scalar(n, d, a, nullptr, [](double x, double) { return std::ceil(x); }); break;
+            case EXP:   scalar(n, d, a, nullptr, [](double x, double) { return std::exp(x); }); break;
+            case LOG:   scalar(n, d, a, nullptr, [](double x, double) { return std::log(x); }); break;
+            case IF: {
+                size_t i = 0;
+                for (; i + WIDTH <= n; i += WIDTH)
+                    store(d + i, load(a + i) != 0 ? load(b + i) : load(c + i));
+                for (; i < n; i++)
+                    d[i] = a[i] != 0 ? b[i] : c[i];
+                break;
+            }
+            }
+            // clang-format on
+        }
+
+        // recursive descent with exprtk precedence:
+        // or/nor/xor/xnor < and/nand < comparison < +- < */% < unary - < ^
+        class Parser
+        {
+            ExprBatch&         m_Parent;
+            const std::string& m_Input;
+            const Literal&     m_Literal;
+            size_t             m_Pos = 0;
+            std::string        m_Token;
+            bool               m_Number = false;
+            std::vector<Ref>   m_Free;
+
+            [[noreturn]] void fail(const std::string& aMsg) const
+            {
+                throw std::invalid_argument("ExprBatch: " + aMsg + " at position " + std::to_string(m_Pos) + " in `" + m_Input + "`");
+            }
+
+            void next()
+            {
+                m_Number = false;
+                while (m_Pos < m_Input.size() and std::isspace((unsigned char)m_Input[m_Pos]))
+                    m_Pos++;
+                if (m_Pos == m_Input.size()) {
+                    m_Token.clear();
+                    return;
+                }
+                const size_t sStart = m_Pos;
+                const char   c      = m_Input[m_Pos];
+                if (std::isdigit((unsigned char)c) or (c == '.' and m_Pos + 1 < m_Input.size() and std::isdigit((unsigned char)m_Input[m_Pos + 1]))) {
+                    while (m_Pos < m_Input.size() and (std::isdigit((unsigned char)m_Input[m_Pos]) or m_Input[m_Pos] == '.'))
+                        m_Pos++;
+                    if (m_Pos < m_Input.size() and (m_Input[m_Pos] == 'e' or m_Input[m_Pos] == 'E')) {
+                        m_Pos++;
+                        if (m_Pos < m_Input.size() and (m_Input[m_Pos] == '+' or m_Input[m_Pos] == '-'))
+                            m_Pos++;
+                        while (m_Pos < m_Input.size() and std::isdigit((unsigned char)m_Input[m_Pos]))
+                            m_Pos++;
+                    }
+                    m_Number = true;
+                } else if (std::isalpha((unsigned char)c) or c == '_') {
+                    while (m_Pos < m_Input.size() and (std::isalnum((unsigned char)m_Input[m_Pos]) or m_Input[m_Pos] == '_' or m_Input[m_Pos] == '.'))
+                        m_Pos++;
+                } else {
+                    static const char* sLong[] = {"<=", ">=", "==", "!=", "<>"};
+                    m_Pos++;
+                    for (auto x : sLong)
+                        if (m_Input.compare(sStart, 2, x) == 0) {
+                            m_Pos = sStart + 2;
+                            break;
+                        }
+                }
+                m_Token = m_Input.substr(sStart, m_Pos - sStart);
+                if (!m_Number)
+                    std::transform(m_Token.begin(), m_Token.end(), m_Token.begin(), [](unsigned char x) { return std::tolower(x); });
+            }
+
+            bool accept(std::string_view aToken)
+            {
+                if (m_Number or m_Token != aToken)
+                    return false;
+                next();
+                return true;
+            }
+
+            void expect(std::string_view aToken)
+            {
+                if (!accept(aToken))
+                    fail("expected `" + std::string(aToken) + "`");
+            }
+
+            Ref constant(double aValue)
+            {
+                m_Parent.m_Consts.emplace_back(BLOCK, aValue);
+                return Ref{CONST, uint32_t(m_Parent.m_Consts.size() - 1)};
+            }
+
+            Ref variable(const std::string& aName)
+            {
+                auto& sVars = m_Parent.m_Vars;
+                auto  sIt   = std::find_if(sVars.begin(), sVars.end(), [&aName](auto& x) { return x.name == aName; });
+                if (sIt == sVars.end()) {
+                    sVars.emplace_back().name = aName;
+                    m_Parent.m_Names.push_back(aName);
+                    sIt = sVars.end() - 1;
+                }
+                return Ref{VAR, uint32_t(sIt - sVars.begin())};
+            }
+
+            // inputs released before output allocated: kernels are elementwise, so in-place is fine
+            Ref emit(Code aCode, Ref a, Ref b = {CONST, 0}, Ref c = {CONST, 0})
+            {
+                for (auto x : {c, b, a})
+                    if (x.kind == REG)
+                        m_Free.push_back(x);
+                Ref sDst{REG, m_Parent.m_Registers};
+                if (!m_Free.empty()) {
+                    sDst = m_Free.back();
+                    m_Free.pop_back();
+                } else {
+                    m_Parent.m_Registers++;
+                }
+                m_Parent.m_Code.push_back(Op{aCode, sDst, a, b, c});
+                return sDst;
+            }
+
+            template <class F>
+            Ref binary(F&& aNext, std::initializer_list<std::pair<std::string_view, Code>> aOps)
+            {
+                Ref sLeft = aNext();
+                while (true) {
+                    auto sIt = std::find_if(aOps.begin(), aOps.end(), [this](auto& x) { return !m_Number and x.first == m_Token; });
+                    if (sIt == aOps.end())
+                        return sLeft;
+                    next();
+                    sLeft = emit(sIt->second, sLeft, aNext());
+                }
+            }
+
+            Ref parse_or() { return binary([this]() { return parse_and(); }, {{"or", OR}, {"|", OR}, {"nor", NOR}, {"xor", XOR}, {"xnor", XNOR}}); }
+            Ref parse_and() { return binary([this]() { return parse_compare(); }, {{"and", AND}, {"&", AND}, {"nand", NAND}}); }
+            Ref parse_compare()
+            {
+                return binary([this]() { return parse_sum(); }, {{"<", LT}, {"<=", LE}, {">", GT}, {">=", GE}, {"=", EQ}, {"==", EQ}, {"!=", NE}, {"<>", NE}});
+            }
+            Ref parse_sum() { return binary([this]() { return parse_product(); }, {{"+", ADD}, {"-", SUB}}); }
+            Ref parse_product() { return binary([this]() { return parse_unary(); }, {{"*", MUL}, {"/", DIV}, {"%", MOD}}); }
+
+            Ref parse_unary()
+            {
+                if (accept("-")) {
+                    if (!m_Number and m_Token == "-")
+                        fail("repeated unary minus");
+                    return emit(NEG, parse_power(true));
+                }
+                if (accept("+"))
+                    return parse_power(true);
+                return parse_power(false);
+            }
+
+            // associativity of chained ^ and binding of -x^y differ between math
+            // conventions, leave such expressions to exprtk.
+            // like exprtk, integer constant exponent up to 60 evaluated by multiplications
+            Ref parse_power(bool aNegated)
+            {
+                Ref sBase = parse_primary();
+                if (!accept("^"))
+                    return sBase;
+                if (aNegated)
+                    fail("unary minus before ^");
+                const bool sMinus = accept("-");
+                Ref        sExp   = parse_primary();
+                if (!m_Number and m_Token == "^")
+                    fail("chained ^");
+
+                // constant base folded by exprtk with std::pow
+                if (sExp.kind == CONST and sBase.kind != CONST) {
+                    const double sValue = m_Parent.m_Consts[sExp.index][0] * (sMinus ? -1 : 1);
+                    if (std::fabs(sValue) <= 60 and std::trunc(sValue) == sValue) {
+                        if (sValue == 0)
+                            return constant(1);
+                        Ref sDst                        = emit(IPOW, sBase);
+                        m_Parent.m_Code.back().exponent = int(sValue);
+                        return sDst;
+                    }
+                }
+                return emit(POW, sBase, sMinus ? emit(NEG, sExp) : sExp);
+            }
+
+            Ref parse_primary()
+            {
+                if (m_Number) {
+                    const std::string sText = m_Token;
+                    next();
+                    if (m_Literal)
+                        return constant(m_Literal(sText));
+                    double sValue = 0;
+                    auto [sPtr, sError] = std::from_chars(sText.data(), sText.data() + sText.size(), sValue);
+                    if (sError != std::errc() or sPtr != sText.data() + sText.size())
+                        fail("invalid number " + sText);
+                    return constant(sValue);
+                }
+                if (accept("(")) {
+                    Ref sResult = parse_or();
+                    expect(")");
+                    return sResult;
+                }
+                if (m_Token.empty() or !(std::isalpha((unsigned char)m_Token[0]) or m_Token[0] == '_'))
+                    fail(m_Token.empty() ? "unexpected end" : "unexpected token `" + m_Token + "`");
+
+                const std::string sName = m_Token;
+                next();
+                if (sName == "true")
+                    return constant(1);
+                if (sName == "false")
+                    return constant(0);
+                if (m_Number or m_Token != "(")
+                    return variable(sName);
+
+                static const std::pair<std::string_view, Code> sUnary[] = {
+                    {"not", NOT}, {"abs", ABS}, {"sqrt", SQRT}, {"floor", FLOOR}, {"ceil", CEIL}, {"exp", EXP}, {"log", LOG}};
+                static const std::pair<std::string_view, Code> sBinary[] = {{"min", MIN}, {"max", MAX}};
+                next();
+                for (auto& [sFunc, sCode] : sUnary)
+                    if (sFunc == sName) {
+                        Ref sArg = parse_or();
+                        expect(")");
+                        return emit(sCode, sArg);
+                    }
+                for (auto& [sFunc, sCode] : sBinary)
+                    if (sFunc == sName) {
+                        Ref sA = parse_or();
+                        expect(",");
+                        Ref sB = parse_or();
+                        expect(")");
+                        return emit(sCode, sA, sB);
+                    }
+                if (sName == "if") {
+                    Ref sCond = parse_or();
+                    expect(",");
+                    Ref sA = parse_or();
+                    expect(",");
+                    Ref sB = parse_or();
+                    expect(")");
+                    return emit(IF, sCond, sA, sB);
+                }
+                fail("unsupported function " + sName);
+            }
+
+        public:
+            Parser(ExprBatch& aParent, const std::string& aInput, const Literal& aLiteral)
+            : m_Parent(aParent)
+            , m_Input(aInput)
+            , m_Literal(aLiteral)
+            {
+                next();
+            }
+
+            Ref parse()
+            {
+                Ref sResult = parse_or();
+                if (!m_Token.empty())
+                    fail("unexpected token `" + m_Token + "`");
+                return sResult;
+            }
+        };
+
+        const double* resolve(Ref aRef, size_t aBase, double* aRegisters) const
+        {
+            switch (aRef.kind) {
+            case REG: return aRegisters + aRef.index * BLOCK;
+            case CONST: return m_Consts[aRef.index].data();
+            case VAR: {
+                auto& sVar = m_Vars[aRef.index];
+                return sVar.fill.empty() ? sVar.data + aBase : sVar.fill.data();
+            }
+            }
+            return nullptr;
+        }
+
+        // evaluate rows [aBase, aBase + aSize), aSize <= BLOCK
+        const double* block(size_t aBase, size_t aSize, double* aRegisters) const
+        {
+            for (auto& x : m_Code) {
+                double* sDst = aRegisters + x.dst.index * BLOCK;
+                execute(x, aSize, sDst, resolve(x.a, aBase, aRegisters), resolve(x.b, aBase, aRegisters), resolve(x.c, aBase, aRegisters));
+            }
+            return resolve(m_Root, aBase, aRegisters);
+        }
+
+        void check(size_t aRows) const
+        {
+            for (auto& x : m_Vars) {
+                if (x.data == nullptr and x.fill.empty())
+                    throw std::invalid_argument("ExprBatch: variable " + x.name + " is not bound");
+                if (x.fill.empty() and x.size < aRows)
+                    throw std::invalid_argument("ExprBatch: column " + x.name + " is too short");
+            }
+        }
+
+        Var* find(const std::string& aName)
+        {
+            std::string sName = aName;
+            std::transform(sName.begin(), sName.end(), sName.begin(), [](unsigned char x) { return std::tolower(x); });
+            for (auto& x : m_Vars)
+                if (x.name == sName)
+                    return &x;
+            return nullptr;
+        }
+
+    public:
+        // aLiteral converts numbers, to get exactly the same constants as in parser of row evaluator
+        explicit ExprBatch(const std::string& aExpr, const Literal& aLiteral = {})
+        {
+            m_Consts.emplace_back(BLOCK, 0.0); // placeholder for unused operands
+            m_Root = Parser(*this, aExpr, aLiteral).parse();
+        }
+
+        // variable names (lower case) in order of appearance
+        const std::vector<std::string>& variables() const { return m_Names; }
+
+        // column must be alive until eval/select. unknown names ignored
+        void bind(const std::string& aName, std::span<const double> aColumn)
+        {
+            if (auto sVar = find(aName)) {
+                sVar->data = aColumn.data();
+                sVar->size = aColumn.size();
+                sVar->fill.clear();
+            }
+        }
+
+        // same value for all rows
+        void bind(const std::string& aName, double aValue)
+        {
+            if (auto sVar = find(aName))
+                sVar->fill.assign(BLOCK, aValue);
+        }
+
+        // result column, one value per row
+        void eval(std::span<double> aResult) const
+        {
+            check(aResult.size());
+            std::vector<double> sRegisters(std::max(1u, m_Registers) * BLOCK);
+            for (size_t sBase = 0; sBase < aResult.size(); sBase += BLOCK) {
+                const size_t sSize = std::min(BLOCK, aResult.size() - sBase);
+                std::memcpy(aResult.data() + sBase, block(sBase, sSize, sRegisters.data()), sSize * sizeof(double));
+            }
+        }
+
+        // selection bitmap: bit i set if row i is true (not zero)
+        Bitmap select(size_t aRows) const
+        {
+            static_assert(BLOCK % 64 == 0);
+            check(aRows);
+            Bitmap              sResult((aRows + 63) / 64);
+            std::vector<double> sRegisters(std::max(1u, m_Registers) * BLOCK);
+            for (size_t sBase = 0; sBase < aRows; sBase += BLOCK) {
+                const size_t  sSize  = std::min(BLOCK, aRows - sBase);
+                const double* sValue = block(sBase, sSize, sRegisters.data());
+                for (size_t i = 0; i < sSize; i += 64) {
+                    uint64_t     sBits = 0;
+                    const size_t sLast = std::min<size_t>(64, sSize - i);
+                    for (size_t j = 0; j < sLast; j++)
+                        sBits |= uint64_t(sValue[i + j] != 0) << j;
+                    sResult[(sBase + i) / 64] = sBits;
+                }
+            }
+            return sResult;
+        }
+    };
+} // namespace Util
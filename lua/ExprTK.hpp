@@ -1,11 +1,15 @@
 #pragma once
 
+#include <map>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
 #include <exprtk.hpp>
 
+#include "ExprBatch.hpp"
+
 extern template class exprtk::symbol_table<double>;
 extern template class exprtk::expression<double>;
 extern template class exprtk::parser<double>;
@@ -17,12 +21,16 @@ namespace Util {
         using expression_t   = exprtk::expression<double>;
         using parser_t       = exprtk::parser<double>;
         using settings_t     = parser_t::settings_t;
+        using Columns        = std::map<std::string, std::span<const double>>;
 
         settings_t     m_Settings;
         symbol_table_t m_Table;
         expression_t   m_Expression;
         parser_t       m_Parser;
 
+        // vectorized form, if expression supported by ExprBatch
+        std::optional<ExprBatch> m_Batch;
+
         ExprTK()
         : m_Settings(settings_t::compile_all_opts)
         , m_Parser(m_Settings)
@@ -32,12 +40,80 @@ namespace Util {
 
         void compile(const std::string& aStr)
         {
+            m_Batch.reset();
             if (!m_Parser.compile(aStr, m_Expression))
                 throw std::invalid_argument("Exprtk: fail to compile: " + m_Parser.error());
+
+            // numbers converted by exprtk itself to get bit exact constants
+            try {
+                m_Batch.emplace(aStr, [this](const std::string& aLiteral) {
+                    expression_t sExpr;
+                    if (!m_Parser.compile(aLiteral, sExpr))
+                        throw std::invalid_argument("Exprtk: fail to compile: " + m_Parser.error());
+                    return sExpr.value();
+                });
+            } catch (const std::invalid_argument&) {
+                m_Batch.reset();
+            }
         }
         double eval()
         {
             return m_Expression.value();
         }
+
+        // columnar evaluation: variables without column keep current value from symbol table
+        void eval(const Columns& aColumns, std::span<double> aResult)
+        {
+            if (m_Batch) {
+                bindBatch(aColumns);
+                m_Batch->eval(aResult);
+                return;
+            }
+            evalRows(aColumns, aResult.size(), [&aResult](size_t i, double x) { aResult[i] = x; });
+        }
+
+        // selection bitmap: bit i set if expression is true for row i
+        ExprBatch::Bitmap select(const Columns& aColumns, size_t aRows)
+        {
+            if (m_Batch) {
+                bindBatch(aColumns);
+                return m_Batch->select(aRows);
+            }
+            ExprBatch::Bitmap sResult((aRows + 63) / 64);
+            evalRows(aColumns, aRows, [&sResult](size_t i, double x) {
+                if (x != 0)
+                    sResult[i / 64] |= uint64_t(1) << (i % 64);
+            });
+            return sResult;
+        }
+
+    private:
+        void bindBatch(const Columns& aColumns)
+        {
+            for (auto& x : m_Batch->variables())
+                if (auto sVar = m_Table.get_variable(x))
+                    m_Batch->bind(x, sVar->ref());
+            for (auto& [sName, sColumn] : aColumns)
+                m_Batch->bind(sName, sColumn);
+        }
+
+        template <class F>
+        void evalRows(const Columns& aColumns, size_t aRows, F&& aOut)
+        {
+            std::vector<std::pair<double*, const double*>> sBind;
+            for (auto& [sName, sColumn] : aColumns) {
+                auto sVar = m_Table.get_variable(sName);
+                if (!sVar)
+                    throw std::invalid_argument("Exprtk: unknown variable " + sName);
+                if (sColumn.size() < aRows)
+                    throw std::invalid_argument("Exprtk: column " + sName + " is too short");
+                sBind.emplace_back(&sVar->ref(), sColumn.data());
+            }
+            for (size_t i = 0; i < aRows; i++) {
+                for (auto& [sDst, sSrc] : sBind)
+                    *sDst = sSrc[i];
+                aOut(i, m_Expression.value());
+            }
+        }
     };
 } // namespace Util
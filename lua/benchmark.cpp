@@ -32,6 +32,51 @@ BM_Exprtk(benchmark::State& aState)
 }
 BENCHMARK(BM_Exprtk);
 
+// same expression over column, row by row vs vectorized
+static void BM_ExprtkColumn(benchmark::State& aState)
+{
+    std::vector<double> sX(aState.range(1));
+    for (size_t i = 0; i < sX.size(); i++)
+        sX[i] = i % 40;
+    std::vector<double> sResult(sX.size());
+
+    Util::ExprTK sExpr;
+    sExpr.m_Table.create_variable("x");
+    sExpr.compile("(x > 5 and x < 20) or (x > 20 and x < 30)");
+    if (!aState.range(0))
+        sExpr.m_Batch.reset();
+
+    const Util::ExprTK::Columns sColumns{{"x", sX}};
+    for (auto _ : aState) {
+        sExpr.eval(sColumns, sResult);
+        benchmark::DoNotOptimize(sResult.data());
+    }
+    aState.SetItemsProcessed(aState.iterations() * sX.size());
+}
+BENCHMARK(BM_ExprtkColumn)->ArgNames({"batch", "rows"})->Args({0, 1 << 16})->Args({1, 1 << 16});
+
+static void BM_ExprtkSelect(benchmark::State& aState)
+{
+    std::vector<double> sX(aState.range(1)), sY(sX.size());
+    for (size_t i = 0; i < sX.size(); i++) {
+        sX[i] = i % 40;
+        sY[i] = i % 17 * 0.5;
+    }
+
+    Util::ExprTK sExpr;
+    sExpr.m_Table.create_variable("x");
+    sExpr.m_Table.create_variable("y");
+    sExpr.compile("x * 2 + y > 30 and abs(y - x) < 10");
+    if (!aState.range(0))
+        sExpr.m_Batch.reset();
+
+    const Util::ExprTK::Columns sColumns{{"x", sX}, {"y", sY}};
+    for (auto _ : aState)
+        benchmark::DoNotOptimize(sExpr.select(sColumns, sX.size()));
+    aState.SetItemsProcessed(aState.iterations() * sX.size());
+}
+BENCHMARK(BM_ExprtkSelect)->ArgNames({"batch", "rows"})->Args({0, 1 << 16})->Args({1, 1 << 16});
+
 static void BM_Lua(benchmark::State& aState)
 {
     sol::state sLua;
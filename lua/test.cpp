@@ -7,6 +7,8 @@
 #include <sol/sol.hpp>
 #pragma GCC diagnostic pop
 
+#include "ExprTK.hpp"
+
 #include <unsorted/Tcc.hpp>
 
 BOOST_AUTO_TEST_SUITE(Lua)
@@ -52,3 +54,67 @@ BOOST_AUTO_TEST_CASE(Simple)
     BOOST_CHECK_EQUAL(sPtr(10), 1);
 }
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(ExprTK)
+BOOST_AUTO_TEST_CASE(Batch)
+{
+    const size_t        sRows = 3000;
+    std::vector<double> sX(sRows), sY(sRows);
+    for (size_t i = 0; i < sRows; i++) {
+        sX[i] = double(i % 41) - 5;
+        sY[i] = std::sin(i) * 50;
+    }
+    sX[7] = std::nan("");
+
+    Util::ExprTK sExpr;
+    sExpr.m_Table.create_variable("x");
+    sExpr.m_Table.create_variable("y");
+    sExpr.m_Table.create_variable("k", 3);
+    const Util::ExprTK::Columns sColumns{{"x", sX}, {"y", sY}};
+
+    for (std::string sStr : {"(x > 5 and x < 20) or (x > 20 and x < 30)",
+                             "x * k + y / 3 - 1.1",
+                             "if(x <> 3, min(x, y), abs(y) % 7) >= 2.5 xor not(y < 0)",
+                             "sqrt(abs(y)) + x^2 - floor(y) * ceil(x / 4)",
+                             "x^3 + y^3 * x^-2",
+                             "y^13 - y^-7 + y^0.5",
+                             "1 or 1 xor 1",
+                             "x > 3 xor y > 0 or x > 10 and y < 20 xnor x < 30",
+                             "x < 0 nor y > 0 xor x > 30 and not(y < -20)",
+                             "clamp(-10, x, 10) + y"}) {
+        BOOST_TEST_CONTEXT(sStr)
+        {
+            sExpr.compile(sStr);
+            BOOST_CHECK_EQUAL(sExpr.m_Batch.has_value(), sStr.find("clamp") == std::string::npos);
+
+            std::vector<double> sResult(sRows);
+            sExpr.eval(sColumns, sResult);
+            const auto sBitmap = sExpr.select(sColumns, sRows);
+            BOOST_REQUIRE_EQUAL(sBitmap.size(), (sRows + 63) / 64);
+
+            for (size_t i = 0; i < sRows; i++) {
+                sExpr.m_Table.get_variable("x")->ref() = sX[i];
+                sExpr.m_Table.get_variable("y")->ref() = sY[i];
+                const double sExpected = sExpr.eval();
+                BOOST_CHECK(sExpected == sResult[i] or (std::isnan(sExpected) and std::isnan(sResult[i])));
+                BOOST_CHECK_EQUAL(sExpected != 0, bool((sBitmap[i / 64] >> (i % 64)) & 1));
+            }
+        }
+    }
+}
+BOOST_AUTO_TEST_CASE(BatchErrors)
+{
+    for (auto sStr : {"x ^ 2 ^ 3", "-x^2", "foo(x)", "(x", "x y"})
+        BOOST_CHECK_THROW(Util::ExprBatch{sStr}, std::invalid_argument);
+
+    Util::ExprBatch     sExpr("x + z");
+    std::vector<double> sX(10), sResult(10);
+    sExpr.bind("x", sX);
+    BOOST_CHECK_THROW(sExpr.eval(sResult), std::invalid_argument);
+    sExpr.bind("z", 1.5);
+    sExpr.eval(sResult);
+    BOOST_CHECK_EQUAL(sResult[9], 1.5);
+    sExpr.bind("z", std::span<const double>(sX.data(), 5));
+    BOOST_CHECK_THROW(sExpr.eval(sResult), std::invalid_argument);
+}
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// gradient boosted trees, logistic loss, histogram split finder (like xgboost `hist`).
+// features quantized once into 256 bins, node histogram built over row index range,
+// histogram of larger child is parent minus smaller one.
+// trees stored in flat node array, children of node are adjacent.
+template<int MAX>
+struct Gbdt
+{
+    // Parser API
+    using Vector = std::array<double, MAX>;
+    using Entry = std::pair<bool, Vector>;
+    using List = std::vector<Entry>;
+    enum {max_features = MAX};
+    enum {initial_one = 0};
+    //
+
+    enum {max_bins = 256};
+    enum {sample = 1 << 18};     // rows to find bin boundaries
+
+    struct Params
+    {
+        size_t trees = 30;
+        size_t depth = 6;
+        double eta = 0.3;
+        double lambda = 1.;
+        double min_child_weight = 1.;
+        unsigned threads = std::thread::hardware_concurrency();
+    };
+
+    struct Node
+    {
+        double value = 0;       // threshold (go left if feature <= value) or leaf weight
+        int32_t feature = -1;   // -1 for leaf
+        uint32_t left = 0;      // right child is left + 1
+    };
+
+    Params params;
+    double base = 0;            // initial margin
+    std::vector<Node> nodes;
+    std::vector<uint32_t> roots;
+
+    Gbdt() : Gbdt(Params()) {}
+    Gbdt(const Params& p) : params(p) {}
+
+    double sigmoid(const double a) const
+    {
+        return 1. / (1. + std::exp(-a));
+    }
+
+    double margin(const Vector& fv) const
+    {
+        double res = base;
+        for (auto n : roots) {
+            while (nodes[n].feature >= 0)
+                n = nodes[n].left + (fv[nodes[n].feature] > nodes[n].value);
+            res += nodes[n].value;
+        }
+        return res;
+    }
+
+    double predict(const Vector& fv) const
+    {
+        return sigmoid(margin(fv));
+    }
+
+    // tree by tree over all rows: nodes of one tree stay in cache
+    std::vector<double> predict(const List& list) const
+    {
+        std::vector<double> res(list.size(), base);
+        for (auto root : roots) {
+            for (size_t i = 0; i < list.size(); i++) {
+                auto n = root;
+                while (nodes[n].feature >= 0)
+                    n = nodes[n].left + (list[i].second[nodes[n].feature] > nodes[n].value);
+                res[i] += nodes[n].value;
+            }
+        }
+        for (auto& x : res)
+            x = sigmoid(x);
+        return res;
+    }
+
+    double logloss(bool y, double p) const
+    {
+        p = std::min(std::max(p, 1e-15), 1 - 1e-15);
+        return -std::log(y ? p : (1 - p));
+    }
+
+    double calc_error(const List& list) const
+    {
+        const auto p = predict(list);
+        double c = 0;
+        for (size_t i = 0; i < list.size(); i++)
+            c += logloss(list[i].first, p[i]);
+        return c / double(list.size());
+    }
+
+    void train(const List& fv)
+    {
+        nodes.clear();
+        roots.clear();
+        if (fv.empty())
+            return;
+        Builder b(*this, fv);
+        for (size_t i = 0; i < params.trees; i++)
+            b.tree();
+    }
+
+private:
+    struct Bin
+    {
+        double g = 0;
+        double h = 0;
+    };
+    using Histogram = std::vector<Bin>;     // max_bins per feature
+
+    struct Builder
+    {
+        Gbdt& model;
+        const List& fv;
+        const size_t rows;
+
+        std::array<std::vector<double>, MAX> cuts;    // upper bound of every bin
+        std::array<std::vector<uint8_t>, MAX> bins;   // column of bin numbers per feature
+        std::vector<Bin> grad;                        // gradient and hessian of every row
+        std::vector<double> margin;
+        std::vector<uint32_t> index;                  // rows of every node are contiguous range
+        std::vector<uint32_t> scratch;                // partition buffer
+
+        Builder(Gbdt& m, const List& list)
+        : model(m), fv(list), rows(list.size()), grad(rows), margin(rows), index(rows), scratch(rows)
+        {
+            parallel(MAX, sample * MAX, [this](size_t f) { quantize(f); });
+            const size_t parts = std::max(1u, model.params.threads);
+            parallel(parts, rows * MAX, [this, parts](size_t k) { assign_bins(rows * k / parts, rows * (k + 1) / parts); });
+
+            size_t positive = 0;
+            for (auto& x : fv)
+                positive += x.first;
+            const double p = std::min(std::max(positive / double(rows), 1e-6), 1 - 1e-6);
+            model.base = std::log(p / (1 - p));
+            std::fill(margin.begin(), margin.end(), model.base);
+        }
+
+        // run f(0..count) in threads, if work is big enough
+        template<class F>
+        void parallel(size_t count, size_t work, F f)
+        {
+            const size_t threads = std::min<size_t>(model.params.threads, count);
+            if (threads <= 1 or work < 65536) {
+                for (size_t i = 0; i < count; i++)
+                    f(i);
+                return;
+            }
+            std::vector<std::thread> pool;
+            for (size_t t = 0; t < threads; t++)
+                pool.emplace_back([t, threads, count, &f]() {
+                    for (size_t i = t; i < count; i += threads)
+                        f(i);
+                });
+            for (auto& x : pool)
+                x.join();
+        }
+
+        // all unique values if there are few of them, quantiles otherwise.
+        // cuts found on strided sample, values above last cut go to last bin
+        void quantize(size_t f)
+        {
+            const size_t step = std::max<size_t>(1, rows / sample);
+            std::vector<double> v;
+            v.reserve(rows / step + 1);
+            for (size_t i = 0; i < rows; i += step)
+                v.push_back(fv[i].second[f]);
+            std::sort(v.begin(), v.end());
+
+            auto& c = cuts[f];
+            c = v;
+            c.erase(std::unique(c.begin(), c.end()), c.end());
+            if (c.size() > max_bins) {
+                c.clear();
+                for (size_t k = 1; k < max_bins; k++)
+                    c.push_back(v[k * v.size() / max_bins]);
+                c.push_back(v.back());
+                c.erase(std::unique(c.begin(), c.end()), c.end());
+            }
+            bins[f].resize(rows);
+        }
+
+        // row by row, all features at once. branchless lower_bound over cuts padded with last cut
+        void assign_bins(size_t from, size_t to)
+        {
+            std::vector<std::array<double, max_bins>> padded(MAX);
+            for (size_t f = 0; f < MAX; f++) {
+                std::fill(padded[f].begin(), padded[f].end(), cuts[f].back());
+                std::copy(cuts[f].begin(), cuts[f].end(), padded[f].begin());
+            }
+            for (size_t i = from; i < to; i++) {
+                for (size_t f = 0; f < MAX; f++) {
+                    const double* c = padded[f].data();
+                    const double x = fv[i].second[f];
+                    size_t pos = 0;
+                    for (size_t step = max_bins / 2; step > 0; step /= 2)
+                        pos += (c[pos + step - 1] < x) ? step : 0;
+                    bins[f][i] = std::min<size_t>(pos, cuts[f].size() - 1);
+                }
+            }
+        }
+
+        // features split between threads, every thread walks all rows of node
+        void histogram(size_t begin, size_t end, Histogram& hist)
+        {
+            hist.assign(MAX * max_bins, Bin());
+            const size_t parts = std::min<size_t>(MAX, std::max(1u, model.params.threads));
+            parallel(parts, (end - begin) * MAX, [this, begin, end, parts, &hist](size_t k) {
+                const size_t f0 = MAX * k / parts;
+                const size_t f1 = MAX * (k + 1) / parts;
+                for (size_t i = begin; i < end; i++) {
+                    const auto r = index[i];
+                    const Bin x = grad[r];
+                    for (size_t f = f0; f < f1; f++) {
+                        Bin& res = hist[f * max_bins + bins[f][r]];
+                        res.g += x.g;
+                        res.h += x.h;
+                    }
+                }
+            });
+        }
+
+        // stable: rows stay sorted, so later passes read columns forward
+        size_t partition(size_t begin, size_t end, const uint8_t* col, size_t bin)
+        {
+            size_t left = begin;
+            size_t right = 0;
+            for (size_t i = begin; i < end; i++) {
+                const auto r = index[i];
+                if (col[r] <= bin)
+                    index[left++] = r;
+                else
+                    scratch[right++] = r;
+            }
+            std::copy(scratch.begin(), scratch.begin() + right, index.begin() + left);
+            return left;
+        }
+
+        double score(double G, double H) const
+        {
+            return G * G / (H + model.params.lambda);
+        }
+
+        void leaf(uint32_t id, size_t begin, size_t end, double G, double H)
+        {
+            const double w = -G / (H + model.params.lambda) * model.params.eta;
+            model.nodes[id] = Node{w, -1, 0};
+            for (size_t i = begin; i < end; i++)
+                margin[index[i]] += w;
+        }
+
+        void grow(uint32_t id, size_t begin, size_t end, Histogram& hist, size_t depth, double G, double H)
+        {
+            if (depth == model.params.depth or end - begin < 2) {
+                leaf(id, begin, end, G, H);
+                return;
+            }
+
+            // best split over all features and bins
+            const auto& p = model.params;
+            double best_gain = 0;
+            int best_f = -1;
+            size_t best_b = 0;
+            double best_G = 0, best_H = 0;
+            for (size_t f = 0; f < MAX; f++) {
+                const Bin* b = &hist[f * max_bins];
+                double GL = 0, HL = 0;
+                for (size_t k = 0; k + 1 < cuts[f].size(); k++) {
+                    GL += b[k].g;
+                    HL += b[k].h;
+                    const double GR = G - GL, HR = H - HL;
+                    if (HL < p.min_child_weight or HR < p.min_child_weight)
+                        continue;
+                    const double gain = score(GL, HL) + score(GR, HR) - score(G, H);
+                    if (gain > best_gain) {
+                        best_gain = gain;
+                        best_f = f;
+                        best_b = k;
+                        best_G = GL;
+                        best_H = HL;
+                    }
+                }
+            }
+            if (best_f < 0) {
+                leaf(id, begin, end, G, H);
+                return;
+            }
+
+            const size_t mid = partition(begin, end, bins[best_f].data(), best_b);
+
+            const uint32_t left = model.nodes.size();
+            model.nodes.resize(left + 2);
+            model.nodes[id] = Node{cuts[best_f][best_b], best_f, left};
+
+            // histogram only for smaller child, parent histogram becomes histogram of larger one
+            Histogram small;
+            const bool left_small = mid - begin < end - mid;
+            if (left_small)
+                histogram(begin, mid, small);
+            else
+                histogram(mid, end, small);
+            for (size_t i = 0; i < hist.size(); i++) {
+                hist[i].g -= small[i].g;
+                hist[i].h -= small[i].h;
+            }
+            Histogram& hl = left_small ? small : hist;
+            Histogram& hr = left_small ? hist : small;
+            grow(left,     begin, mid, hl, depth + 1, best_G,     best_H);
+            grow(left + 1, mid,   end, hr, depth + 1, G - best_G, H - best_H);
+        }
+
+        void tree()
+        {
+            double G = 0, H = 0;
+            for (size_t i = 0; i < rows; i++) {
+                const double p = 1. / (1. + std::exp(-margin[i]));
+                grad[i].g = p - (fv[i].first ? 1 : 0);
+                grad[i].h = p * (1 - p);
+                G += grad[i].g;
+                H += grad[i].h;
+                index[i] = i;
+            }
+            Histogram hist;
+            histogram(0, rows, hist);
+
+            const uint32_t root = model.nodes.size();
+            model.nodes.emplace_back();
+            model.roots.push_back(root);
+            grow(root, 0, rows, hist, 0, G, H);
+        }
+    };
+};
@@ -2,6 +2,9 @@
 #pragma once
 #include <Csv.hpp>
 
+#include <cstdlib>
+#include <unordered_map>
+
 template<typename T>
 struct Parser
 {
@@ -48,3 +51,56 @@ struct Parser
     }
 };
 
+
+// hashed sparse features for T = SparseFtrl.
+// numeric column gives feature hash(name) with normalized value,
+// any other column gives feature hash(name=value) with value 1.
+// last column is the target, constant bias feature added to every row.
+template<typename T>
+struct SparseParser
+{
+    typename T::List operator()(const std::string& fname, const std::string& s_true)
+    {
+        typename T::List res;
+        std::vector<std::string> names;
+        const uint32_t bias = T::hash("bias");
+
+        CSV::read(fname, [&res, &s_true, &names, bias](const std::string& line) {
+            CSV::csv_separator sep;
+            CSV::Tokenizer tok(line, sep);
+            if (names.empty()) {
+                names.assign(tok.begin(), tok.end());
+                return;
+            }
+            std::vector<std::string> items(tok.begin(), tok.end());
+            if (items.size() != names.size())
+                throw CSV::csv_error("unexpected number of columns");
+
+            typename T::Entry entry;
+            entry.first = items.back() == s_true;
+            entry.second.emplace_back(bias, 1.);
+            for (size_t i = 0; i + 1 < items.size(); i++) {
+                char* end = nullptr;
+                const double v = std::strtod(items[i].c_str(), &end);
+                if (!items[i].empty() && *end == 0)
+                    entry.second.emplace_back(T::hash(names[i]), v);
+                else
+                    entry.second.emplace_back(T::hash(names[i] + '=' + items[i]), 1.);
+            }
+            res.push_back(std::move(entry));
+        });
+
+        // normalize, same as dense Parser
+        std::unordered_map<uint32_t, double> m;
+        for (auto& n : res) {
+            for (auto& f : n.second) {
+                auto it = m.emplace(f.first, 1.0).first;
+                it->second = std::max(it->second, f.second);
+            }
+        }
+        for (auto& n : res)
+            for (auto& f : n.second)
+                f.second = f.second / m[f.first];
+        return res;
+    }
+};
@@ -0,0 +1,265 @@
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// FTRL-Proximal over hashed sparse features.
+// weights are not stored: w[i] is computed from z[i] and n[i] only for features present in row.
+// multithreaded train is Hogwild: threads update shared state without locks,
+// collisions on rare common features are tolerated by algorithm.
+struct SparseFtrl
+{
+    struct Params
+    {
+        double   alpha = 0.1;
+        double   beta  = 1.;
+        double   L1    = 1.;
+        double   L2    = 1.;
+        unsigned bits  = 20; // 2^bits hashed dimensions
+    };
+
+    using Feature = std::pair<uint32_t, double>; // hashed index and value
+    using Row     = std::vector<Feature>;
+    using Entry   = std::pair<bool, Row>;
+    using List    = std::vector<Entry>;
+
+    // z and n side by side: one cache miss per feature
+    struct Cell
+    {
+        double z = 0;
+        double n = 0;
+    };
+
+    // file layout: Header, then 2^bits cells. suitable for mmap
+    struct Header
+    {
+        char     magic[8] = {'F', 'T', 'R', 'L', 'v', '1', 0, 0};
+        uint32_t bits     = 0;
+        uint32_t reserved = 0;
+        double   alpha    = 0;
+        double   beta     = 0;
+        double   L1       = 0;
+        double   L2       = 0;
+    };
+
+    static uint32_t hash(std::string_view s) // FNV-1a
+    {
+        uint32_t h = 2166136261u;
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    SparseFtrl()
+    : SparseFtrl(Params())
+    {
+    }
+
+    SparseFtrl(const Params& p)
+    : params(check(p))
+    , owned(size_t(1) << p.bits)
+    , cells(owned.data())
+    , mask((uint32_t(1) << p.bits) - 1)
+    {
+    }
+
+    SparseFtrl(const SparseFtrl&)            = delete;
+    SparseFtrl& operator=(const SparseFtrl&) = delete;
+
+    ~SparseFtrl() { unmap(); }
+
+    const Params& get_params() const { return params; }
+
+    double sigmoid(const double a) const
+    {
+        return 1. / (1. + std::exp(-a));
+    }
+
+    double logloss(bool y, const Row& fv) const
+    {
+        const double p = std::clamp(predict(fv), 1e-15, 1 - 1e-15);
+        return -std::log(y ? p : (1 - p));
+    }
+
+    double predict(const Row& fv) const
+    {
+        double res = 0;
+        for (const auto& [i, v] : fv)
+            res += weight(cell(i)) * v;
+        return sigmoid(res);
+    }
+
+    // one SGD step, lazy: only features of row are touched
+    void train(const bool y, const Row& fv)
+    {
+        thread_local std::vector<double> w;
+        w.resize(fv.size());
+
+        double res = 0;
+        for (size_t k = 0; k < fv.size(); k++) {
+            w[k] = weight(cell(fv[k].first));
+            res += w[k] * fv[k].second;
+        }
+        const double p = sigmoid(res);
+
+        for (size_t k = 0; k < fv.size(); k++) {
+            Cell&        c  = cell(fv[k].first);
+            const double g  = (p - (y ? 1 : 0)) * fv[k].second;
+            const double n  = load(c.n);
+            const double s  = (std::sqrt(n + g * g) - std::sqrt(n)) / params.alpha;
+            store(c.z, load(c.z) + g - s * w[k]);
+            store(c.n, n + g * g);
+        }
+    }
+
+    // one pass over list. with threads > 1 list is split in contiguous parts
+    void train(const List& list, unsigned threads = 1)
+    {
+        threads = std::max(1u, std::min<unsigned>(threads, list.size()));
+        if (threads == 1) {
+            for (const auto& x : list)
+                train(x.first, x.second);
+            return;
+        }
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; t++) {
+            pool.emplace_back([this, &list, t, threads]() {
+                const size_t from = list.size() * t / threads;
+                const size_t to   = list.size() * (t + 1) / threads;
+                for (size_t i = from; i < to; i++)
+                    train(list[i].first, list[i].second);
+            });
+        }
+        for (auto& x : pool)
+            x.join();
+    }
+
+    double calc_error(const List& list) const
+    {
+        double c = 0;
+        for (const auto& x : list)
+            c += logloss(x.first, x.second);
+        return c / double(list.size());
+    }
+
+    void save(const std::string& fname) const
+    {
+        Header h;
+        h.bits  = params.bits;
+        h.alpha = params.alpha;
+        h.beta  = params.beta;
+        h.L1    = params.L1;
+        h.L2    = params.L2;
+
+        const std::string tmp = fname + ".tmp";
+        const int         fd  = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1)
+            throw std::runtime_error("SparseFtrl: fail to create " + tmp + ": " + strerror(errno));
+        auto write_all = [fd](const void* ptr, size_t size) {
+            auto data = static_cast<const char*>(ptr);
+            while (size > 0) {
+                const ssize_t rc = ::write(fd, data, size);
+                if (rc < 0 and errno == EINTR)
+                    continue;
+                if (rc <= 0)
+                    return false;
+                data += rc;
+                size -= rc;
+            }
+            return true;
+        };
+        const bool ok = write_all(&h, sizeof(h)) and write_all(cells, sizeof(Cell) * (size_t(mask) + 1)) and ::fsync(fd) == 0;
+        ::close(fd);
+        if (!ok or ::rename(tmp.c_str(), fname.c_str()) != 0) {
+            ::unlink(tmp.c_str());
+            throw std::runtime_error("SparseFtrl: fail to write " + fname + ": " + strerror(errno));
+        }
+    }
+
+    // model mapped copy-on-write: pages read on demand, file never modified by train().
+    void load(const std::string& fname)
+    {
+        const int fd = ::open(fname.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw std::runtime_error("SparseFtrl: fail to open " + fname + ": " + strerror(errno));
+        struct stat st;
+        if (::fstat(fd, &st) != 0 or size_t(st.st_size) < sizeof(Header)) {
+            ::close(fd);
+            throw std::runtime_error("SparseFtrl: bad file " + fname);
+        }
+        void* ptr = ::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (ptr == MAP_FAILED)
+            throw std::runtime_error("SparseFtrl: fail to mmap " + fname + ": " + strerror(errno));
+
+        const Header& h = *static_cast<const Header*>(ptr);
+        if (std::memcmp(h.magic, Header().magic, sizeof(h.magic)) != 0 or h.bits == 0 or h.bits > 31 or
+            size_t(st.st_size) != sizeof(Header) + sizeof(Cell) * (size_t(1) << h.bits)) {
+            ::munmap(ptr, st.st_size);
+            throw std::runtime_error("SparseFtrl: bad file " + fname);
+        }
+
+        unmap();
+        owned.clear();
+        owned.shrink_to_fit();
+        mapped      = ptr;
+        mapped_size = st.st_size;
+        params      = Params{h.alpha, h.beta, h.L1, h.L2, h.bits};
+        mask        = (uint32_t(1) << h.bits) - 1;
+        cells       = reinterpret_cast<Cell*>(static_cast<char*>(ptr) + sizeof(Header));
+    }
+
+private:
+    Params            params;
+    std::vector<Cell> owned;
+    Cell*             cells       = nullptr;
+    uint32_t          mask        = 0;
+    void*             mapped      = nullptr;
+    size_t            mapped_size = 0;
+
+    // relaxed atomics: plain loads and stores, but no data race UB in Hogwild
+    static double load(const double& x) { return std::atomic_ref<double>(const_cast<double&>(x)).load(std::memory_order_relaxed); }
+    static void   store(double& x, double v) { std::atomic_ref<double>(x).store(v, std::memory_order_relaxed); }
+
+    static const Params& check(const Params& p)
+    {
+        if (p.bits == 0 or p.bits > 31)
+            throw std::invalid_argument("SparseFtrl: bits must be in 1..31");
+        return p;
+    }
+
+    Cell& cell(uint32_t i) const { return cells[i & mask]; }
+
+    double weight(const Cell& c) const
+    {
+        const double z = load(c.z);
+        if (std::abs(z) <= params.L1)
+            return 0;
+        const double sign = z >= 0 ? 1. : -1.;
+        return -(z - sign * params.L1) / (params.L2 + (params.beta + std::sqrt(load(c.n))) / params.alpha);
+    }
+
+    void unmap()
+    {
+        if (mapped)
+            ::munmap(mapped, mapped_size);
+        mapped = nullptr;
+    }
+};
@@ -1,6 +1,18 @@
 
+#include <chrono>
+#include <random>
+
 #include <Parser.hpp>
 #include <Dt.hpp>
+#include <Gbdt.hpp>
+
+template<class F>
+double elapsed(F f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
 
 void wine_test()
 {
@@ -26,7 +38,8 @@ void wine_test()
         std::cout << std::endl;
     }
 
-    wine.train(d_train);
+    const double spent = elapsed([&]() { wine.train(d_train); });
+    std::cout << "Dt trained in " << spent << "s" << std::endl;
 
     std::cout << std::endl;
     wine.print();
@@ -43,6 +56,50 @@ void wine_test()
               << std::endl;
 }
 
+// same split as xgb.py, 30 rounds with xgboost default parameters
+void wine_gbdt_test()
+{
+    using GBDT = Gbdt<12>;
+    GBDT wine;
+    Parser<GBDT> loader;
+    auto d = loader("wine.csv", "White");
+
+    size_t split_at = d.size() * 0.75;
+    GBDT::List d_train(d.begin(), d.begin() + split_at);
+    GBDT::List d_test(d.begin() + split_at, d.end());
+    d.clear();
+
+    const double spent = elapsed([&]() { wine.train(d_train); });
+    std::cout << "Gbdt trained in " << spent << "s, " << wine.nodes.size() << " nodes, "
+              << "train logloss " << wine.calc_error(d_train) << ", "
+              << "test logloss " << wine.calc_error(d_test) << std::endl;
+
+    size_t ok = 0;
+    const auto p = wine.predict(d_test);
+    for (size_t i = 0; i < d_test.size(); i++)
+        if (d_test[i].first == (p[i] > 0.5)) ok++;
+    std::cout << "OK is " << ok << " (" << ok / (double)d_test.size() * 100.<< "%)"
+              << std::endl;
+}
+
+// training time on big random set: label depends on few features with noise
+void synthetic_gbdt_test(size_t rows = 2000000)
+{
+    using GBDT = Gbdt<12>;
+    GBDT::List d(rows);
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> dis(0, 1);
+    for (auto& x : d) {
+        for (auto& v : x.second)
+            v = dis(gen);
+        x.first = x.second[0] + x.second[1] * x.second[2] + 0.2 * dis(gen) > 0.8;
+    }
+
+    GBDT model;
+    const double spent = elapsed([&]() { model.train(d); });
+    std::cout << "Gbdt on " << rows << " rows trained in " << spent << "s, logloss " << model.calc_error(d) << std::endl;
+}
+
 enum {SUN, OVERCAST, RAIN};
 enum {HOT, COOL, MILD};
 enum {HIGH, NORMAL};
@@ -112,6 +169,8 @@ int main(void)
     tennis_test();
 #else
     wine_test();
+    wine_gbdt_test();
+    synthetic_gbdt_test();
 #endif
     return 0;
 }
@@ -1,6 +1,18 @@
 
+#include <chrono>
+#include <thread>
+
 #include <Ftrl.hpp>
 #include <Parser.hpp>
+#include <SparseFtrl.hpp>
+
+template<class F>
+double elapsed(F f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
 
 void wine_test(size_t steps = 100)
 {
@@ -17,11 +29,14 @@ void wine_test(size_t steps = 100)
     d.clear();
 
     std::cout << "train on " << d_train.size() << " elements" << std::endl;
+    double spent = 0;
     for (size_t i = 0; i < steps; i++)
     {
-        wine.train(d_train);
+        spent += elapsed([&]() { wine.train(d_train); });
         std::cout << "last error: " << wine.calc_error(d_train) << std::endl;
     }
+    std::cout << "dense: " << d_train.size() * steps / spent << " rows/s, "
+              << "test logloss " << wine.calc_error(d_test) << std::endl;
 
     size_t ok = 0;
     for (const auto& x : d_test) {
@@ -33,6 +48,41 @@ void wine_test(size_t steps = 100)
     std::cout << "OK is " << ok << "(" << ok / (double)d_test.size() * 100.<< "%)" << std::endl;
 }
 
+// same data as hashed sparse features, Hogwild training
+void wine_sparse_test(size_t steps = 100, unsigned threads = std::thread::hardware_concurrency())
+{
+    SparseFtrl wine({.alpha = 1., .beta = 1., .L1 = 1., .L2 = 1., .bits = 20});
+    SparseParser<SparseFtrl> loader;
+    auto d = loader("wine.csv", "White");
+
+    size_t split_at = d.size() * 0.75;
+    SparseFtrl::List d_train(d.begin(), d.begin() + split_at);
+    SparseFtrl::List d_test(d.begin() + split_at, d.end());
+    d.clear();
+
+    double spent = 0;
+    for (size_t i = 0; i < steps; i++)
+        spent += elapsed([&]() { wine.train(d_train, threads); });
+    std::cout << "sparse, " << threads << " threads: " << d_train.size() * steps / spent << " rows/s, "
+              << "train logloss " << wine.calc_error(d_train) << ", "
+              << "test logloss " << wine.calc_error(d_test) << std::endl;
+
+    // serve from memory mapped file
+    const std::string fname = "ftrl.model";
+    wine.save(fname);
+    SparseFtrl loaded;
+    loaded.load(fname);
+    std::remove(fname.c_str());
+
+    size_t ok = 0;
+    for (const auto& x : d_test) {
+        const auto p = loaded.predict(x.second);
+        if (x.first == false && p < 0.5) ok++;
+        if (x.first == true  && p > 0.5) ok++;
+    }
+    std::cout << "OK is " << ok << "(" << ok / (double)d_test.size() * 100.<< "%)" << std::endl;
+}
+
 int main(void)
 {
 #if 0
@@ -57,6 +107,8 @@ int main(void)
 
 #else
     wine_test();
+    wine_sparse_test(100, 1);
+    wine_sparse_test();
 #endif
 
     return 0;
@@ -0,0 +1,423 @@
+#pragma once
+
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#define FILE_NO_ARCHIVE
+#include "Once.hpp"
+#include "Quote.hpp"
+
+#include <file/File.hpp>
+#include <unsorted/Log4cxx.hpp>
+
+namespace MySQL::Bulk {
+
+    struct Params
+    {
+        unsigned connections   = 1;         // partitions loaded in parallel. order between partitions is lost if > 1
+        size_t   max_statement = 1 << 20;   // coalesced INSERT or LOAD DATA chunk, keep below max_allowed_packet
+        size_t   partition     = 16 << 20;  // source bytes per transaction
+        size_t   queue         = 4;         // parsed partitions waiting for free connection
+        bool     load_data     = false;     // Load() via LOAD DATA LOCAL INFILE, needs Config::local_infile
+    };
+
+    // `INSERT ... VALUES (..),(..)` split into head and tuples
+    struct Insert
+    {
+        std::string_view head;   // up to and including `VALUES `
+        std::string_view values; // from first `(` to last `)`
+        size_t           rows = 0;
+    };
+
+    // return nothing if statement is not plain insert (ON DUPLICATE KEY, SELECT, ...)
+    inline std::optional<Insert> ParseInsert(std::string_view aQuery)
+    {
+        auto sNoCase = [](std::string_view a, std::string_view b) {
+            if (a.size() < b.size())
+                return false;
+            for (size_t i = 0; i < b.size(); i++)
+                if (std::toupper(a[i]) != b[i])
+                    return false;
+            return true;
+        };
+        if (!sNoCase(aQuery, "INSERT "))
+            return std::nullopt;
+
+        // head: find VALUES keyword outside of backticks
+        size_t sPos   = 0;
+        bool   sQuote = false;
+        for (; sPos < aQuery.size(); sPos++) {
+            const char c = aQuery[sPos];
+            if (c == '`')
+                sQuote = !sQuote;
+            else if (!sQuote and (c == ' ' or c == ')') and sNoCase(aQuery.substr(sPos + 1), "VALUES"))
+                break;
+            else if (!sQuote and (c == '\'' or c == '"'))
+                return std::nullopt;
+        }
+        sPos += 7;
+        while (sPos < aQuery.size() and aQuery[sPos] == ' ')
+            sPos++;
+        if (sPos >= aQuery.size() or aQuery[sPos] != '(')
+            return std::nullopt;
+
+        Insert sResult{aQuery.substr(0, sPos), {}, 0};
+        const size_t sBegin = sPos;
+        size_t       sEnd   = sPos;
+
+        // tuples: strings quoted with ' or ", backslash escapes
+        while (true) {
+            if (sPos >= aQuery.size() or aQuery[sPos] != '(')
+                return std::nullopt;
+            int  sDepth = 0;
+            char sOpen  = 0;
+            for (; sPos < aQuery.size(); sPos++) {
+                const char c = aQuery[sPos];
+                if (sOpen) {
+                    if (c == '\\')
+                        sPos++;
+                    else if (c == sOpen)
+                        sOpen = 0;
+                } else if (c == '\'' or c == '"') {
+                    sOpen = c;
+                } else if (c == '(') {
+                    sDepth++;
+                } else if (c == ')' and --sDepth == 0) {
+                    break;
+                }
+            }
+            if (sPos >= aQuery.size())
+                return std::nullopt;
+            sResult.rows++;
+            sEnd = ++sPos;
+            while (sPos < aQuery.size() and std::isspace(aQuery[sPos]))
+                sPos++;
+            if (sPos < aQuery.size() and aQuery[sPos] == ',') {
+                sPos++;
+                while (sPos < aQuery.size() and std::isspace(aQuery[sPos]))
+                    sPos++;
+                continue;
+            }
+            break;
+        }
+        if (sPos < aQuery.size() and aQuery[sPos] == ';')
+            sPos++;
+        while (sPos < aQuery.size() and std::isspace(aQuery[sPos]))
+            sPos++;
+        if (sPos != aQuery.size())
+            return std::nullopt;
+
+        sResult.values = aQuery.substr(sBegin, sEnd - sBegin);
+        return sResult;
+    }
+
+    // unit of exactly-once loading: executed in one transaction on one connection
+    struct Partition
+    {
+        std::string              query;  // LOAD DATA statement, empty for plain statements
+        std::vector<std::string> chunks; // statements or LOAD DATA payload
+        uint64_t                 rows  = 0;
+        size_t                   size  = 0;
+        uint64_t                 begin = 0; // input range: bytes for Replay, rows for Load.
+        uint64_t                 end   = 0; // used as exactly-once key
+    };
+
+    // rows for Load(). fields can be numbers, strings or nullptr (NULL)
+    class Sink
+    {
+        using Push = std::function<void(Partition&&)>;
+
+        const Params&     m_Params;
+        const Push&       m_Push;
+        const std::string m_Head; // INSERT head, empty for LOAD DATA
+        const std::string m_Query;
+        Partition         m_Part;
+        std::string       m_Row;
+        uint64_t          m_Index = 0; // rows seen
+
+        template <class T>
+        void format(const T& aValue)
+        {
+            if constexpr (std::is_same_v<T, std::nullptr_t>) {
+                m_Row.append(m_Head.empty() ? "\\N" : "NULL");
+            } else if constexpr (std::is_same_v<T, bool>) {
+                m_Row.push_back(aValue ? '1' : '0');
+            } else if constexpr (std::is_arithmetic_v<T>) {
+                fmt::format_to(std::back_inserter(m_Row), "{}", aValue);
+            } else if (m_Head.empty()) {
+                for (const char c : std::string_view(aValue)) {
+                    switch (c) {
+                        case '\\': m_Row.append("\\\\"); break;
+                        case '\t': m_Row.append("\\t"); break;
+                        case '\n': m_Row.append("\\n"); break;
+                        case '\0': m_Row.append("\\0"); break;
+                        default: m_Row.push_back(c);
+                    }
+                }
+            } else {
+                m_Row.push_back('\'');
+                Quote(m_Row, std::string_view(aValue));
+                m_Row.push_back('\'');
+            }
+        }
+
+    public:
+        Sink(const Params& aParams, const Push& aPush, const std::string& aTable, const std::string& aColumns)
+        : m_Params(aParams)
+        , m_Push(aPush)
+        , m_Head(aParams.load_data ? "" : fmt::format("INSERT INTO {} ({}) VALUES ", aTable, aColumns))
+        , m_Query(aParams.load_data ? fmt::format("LOAD DATA LOCAL INFILE 'bulk' INTO TABLE {} CHARACTER SET utf8mb4 ({})", aTable, aColumns) : "")
+        {
+            m_Part.query = m_Query;
+        }
+
+        template <class... A>
+        void operator()(const A&... aFields)
+        {
+            m_Row.clear();
+            m_Row.push_back(m_Head.empty() ? '\n' : ',');
+            if (!m_Head.empty())
+                m_Row.push_back('(');
+            bool sFirst = true;
+            auto sField = [this, &sFirst](const auto& x) {
+                if (!sFirst)
+                    m_Row.push_back(m_Head.empty() ? '\t' : ',');
+                sFirst = false;
+                format(x);
+            };
+            (sField(aFields), ...);
+            if (!m_Head.empty())
+                m_Row.push_back(')');
+
+            // separator skipped at start of chunk
+            if (m_Part.chunks.empty() or m_Part.chunks.back().size() + m_Row.size() > m_Params.max_statement) {
+                m_Part.chunks.emplace_back(m_Head);
+                m_Part.chunks.back().append(m_Row, 1);
+            } else {
+                m_Part.chunks.back().append(m_Row);
+            }
+            m_Part.rows++;
+            m_Part.size += m_Row.size();
+            m_Part.end = ++m_Index;
+            if (m_Part.size >= m_Params.partition)
+                flush();
+        }
+
+        void flush()
+        {
+            if (m_Part.chunks.empty())
+                return;
+            m_Push(std::move(m_Part));
+            m_Part       = {};
+            m_Part.query = m_Query;
+            m_Part.begin = m_Index;
+        }
+    };
+
+    // parse and send in parallel:
+    // producer cuts input into partitions, every connection takes next partition and
+    // loads it in own transaction, registered in transaction_log as (service, task, `part-<begin>-<end>`).
+    // partition bounds depend only on input and Params::partition, so reload of same input skips
+    // committed partitions. Params::partition recorded as `layout-N`, reload with other value refused.
+    class Loader
+    {
+        const Config m_Config;
+        const Params m_Params;
+
+        std::atomic<uint64_t> m_Rows{0};
+        std::atomic<uint64_t> m_Statements{0};
+        std::atomic<uint64_t> m_Skipped{0};
+
+        using Push = std::function<void(Partition&&)>;
+
+        struct Pipe
+        {
+            std::mutex              mutex;
+            std::condition_variable cond;
+            std::deque<Partition>   queue;
+            bool                    done = false;
+            std::exception_ptr      error;
+        };
+
+        void Worker(Pipe& aPipe, const std::string& aService, const std::string& aTask)
+        {
+            Connection sClient(m_Config);
+            while (true) {
+                Partition sPart;
+                {
+                    std::unique_lock sLock(aPipe.mutex);
+                    aPipe.cond.wait(sLock, [&aPipe]() { return aPipe.error or aPipe.done or !aPipe.queue.empty(); });
+                    if (aPipe.error or aPipe.queue.empty())
+                        return;
+                    sPart = std::move(aPipe.queue.front());
+                    aPipe.queue.pop_front();
+                }
+                aPipe.cond.notify_all(); // room for producer
+
+                bool sLoaded = false;
+                Once::transaction(&sClient, aService, aTask, fmt::format("part-{}-{}", sPart.begin, sPart.end), [&](auto*) {
+                    for (auto& x : sPart.chunks) {
+                        if (sPart.query.empty())
+                            sClient.Query(x);
+                        else
+                            sClient.Load(sPart.query, x);
+                    }
+                    sLoaded = true;
+                });
+                if (sLoaded) {
+                    m_Rows += sPart.rows;
+                    m_Statements += sPart.chunks.size();
+                } else {
+                    m_Skipped++;
+                }
+            }
+        }
+
+        // partition bounds depend on Params::partition: refuse to resume task loaded with other value
+        void Layout(const std::string& aService, const std::string& aTask)
+        {
+            Connection        sClient(m_Config);
+            const std::string sLayout = fmt::format("layout-{}", m_Params.partition);
+            std::string       sOther;
+            sClient.Query(fmt::format("SELECT id FROM transaction_log WHERE service='{}' AND task='{}' AND id LIKE 'layout-%' AND id <> '{}'", aService, aTask, sLayout));
+            sClient.Use([&sOther](const Row& aRow) { sOther = aRow[0].as_string(); });
+            if (!sOther.empty())
+                throw std::invalid_argument(fmt::format("MySQL::Bulk: task {} started with {}, now {}", aTask, sOther, sLayout));
+            Once::transaction(&sClient, aService, aTask, sLayout, [](auto*) {});
+        }
+
+        // aProducer(Push) called in current thread
+        template <class P>
+        void Run(const std::string& aService, const std::string& aTask, P&& aProducer)
+        {
+            Layout(aService, aTask);
+
+            Pipe sPipe;
+            auto sFail = [&sPipe](std::exception_ptr aError) {
+                {
+                    std::unique_lock sLock(sPipe.mutex);
+                    if (!sPipe.error)
+                        sPipe.error = aError;
+                }
+                sPipe.cond.notify_all();
+            };
+
+            std::vector<std::thread> sWorkers;
+            for (unsigned i = 0; i < std::max(1u, m_Params.connections); i++)
+                sWorkers.emplace_back([&]() {
+                    try {
+                        Worker(sPipe, aService, aTask);
+                    } catch (...) {
+                        sFail(std::current_exception());
+                    }
+                });
+
+            const Push sPush = [this, &sPipe](Partition&& aPart) {
+                std::unique_lock sLock(sPipe.mutex);
+                sPipe.cond.wait(sLock, [this, &sPipe]() { return sPipe.error or sPipe.queue.size() < m_Params.queue; });
+                if (sPipe.error)
+                    std::rethrow_exception(sPipe.error);
+                sPipe.queue.push_back(std::move(aPart));
+                sPipe.cond.notify_all();
+            };
+
+            try {
+                aProducer(sPush);
+            } catch (...) {
+                sFail(std::current_exception());
+            }
+            {
+                std::unique_lock sLock(sPipe.mutex);
+                sPipe.done = true;
+            }
+            sPipe.cond.notify_all();
+            for (auto& x : sWorkers)
+                x.join();
+            if (sPipe.error)
+                std::rethrow_exception(sPipe.error);
+        }
+
+    public:
+        Loader(const Config& aConfig, const Params& aParams = {})
+        : m_Config(aConfig)
+        , m_Params(aParams)
+        {
+            // producer waits for room in queue
+            if (m_Params.queue == 0)
+                throw std::invalid_argument("MySQL::Bulk: queue size must be positive");
+        }
+
+        // upload file: one statement per line.
+        // consecutive INSERTs with same head merged into one statement up to max_statement.
+        // string params must be quoted by user
+        void Replay(const std::string& aService, const std::string& aTask, const std::string& aFileName)
+        {
+            Run(aService, aTask, [this, &aFileName](const Push& aPush) {
+                Partition   sPart;
+                std::string sHead;       // head of last chunk if it can be extended
+                uint64_t    sOffset = 0; // of current line in file
+                File::by_string(aFileName, [&](std::string_view aLine) {
+                    if (sPart.chunks.empty())
+                        sPart.begin = sOffset;
+                    sOffset += aLine.size() + 1;
+                    sPart.end = sOffset;
+                    while (!aLine.empty() and std::isspace(aLine.back()))
+                        aLine.remove_suffix(1);
+                    if (aLine.empty())
+                        return;
+
+                    const auto sInsert = ParseInsert(aLine);
+                    if (sInsert and !sPart.chunks.empty() and sHead == sInsert->head and
+                        sPart.chunks.back().size() + 1 + sInsert->values.size() <= m_Params.max_statement) {
+                        sPart.chunks.back().push_back(',');
+                        sPart.chunks.back().append(sInsert->values);
+                    } else if (sInsert) {
+                        sHead = sInsert->head;
+                        sPart.chunks.emplace_back(sInsert->head);
+                        sPart.chunks.back().append(sInsert->values);
+                    } else {
+                        sHead.clear();
+                        sPart.chunks.emplace_back(aLine);
+                    }
+                    sPart.rows += sInsert ? sInsert->rows : 0;
+                    sPart.size += aLine.size();
+                    if (sPart.size >= m_Params.partition) {
+                        aPush(std::move(sPart));
+                        sPart = {};
+                        sHead.clear();
+                    }
+                });
+                if (!sPart.chunks.empty())
+                    aPush(std::move(sPart));
+            });
+        }
+
+        // aProducer(Sink& aSink) calls aSink(field1, field2, ...) for every row.
+        // aColumns is comma separated list of columns
+        template <class P>
+        void Load(const std::string& aService, const std::string& aTask, const std::string& aTable, const std::string& aColumns, P&& aProducer)
+        {
+            Run(aService, aTask, [&](const Push& aPush) {
+                Sink sSink(m_Params, aPush, aTable, aColumns);
+                aProducer(sSink);
+                sSink.flush();
+            });
+        }
+
+        uint64_t Rows() const { return m_Rows; }             // rows inserted
+        uint64_t Statements() const { return m_Statements; } // statements sent
+        uint64_t Skipped() const { return m_Skipped; }       // partitions already loaded before
+    };
+} // namespace MySQL::Bulk
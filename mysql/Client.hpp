@@ -29,6 +29,7 @@ namespace MySQL {
         time_t      timeout      = 10;
         std::string program_name = "";
         bool        store_result = true;
+        bool        local_infile = false; // allow LOAD DATA LOCAL INFILE, server must have local_infile=ON
     };
 
     struct Error : public std::runtime_error
@@ -342,6 +343,10 @@ namespace MySQL {
             mysql_options(&m_Handle, MYSQL_OPT_CONNECT_TIMEOUT, &sReconnectTimeout);
             mysql_options(&m_Handle, MYSQL_OPT_READ_TIMEOUT, &m_Cfg.timeout);
             mysql_options(&m_Handle, MYSQL_OPT_WRITE_TIMEOUT, &m_Cfg.timeout);
+            if (m_Cfg.local_infile) {
+                unsigned sLocalInfile = 1;
+                mysql_options(&m_Handle, MYSQL_OPT_LOCAL_INFILE, &sLocalInfile);
+            }
             if (!m_Cfg.program_name.empty())
                 mysql_options4(&m_Handle, MYSQL_OPT_CONNECT_ATTR_ADD, "program_name", m_Cfg.program_name.c_str());
             if (!mysql_real_connect(&m_Handle, m_Cfg.host.data(), m_Cfg.username.data(), m_Cfg.password.data(), m_Cfg.database.data(), m_Cfg.port, NULL, 0)) {
@@ -391,12 +396,39 @@ namespace MySQL {
             if (m_Closed)
                 throw Error("attempt to use closed connection");
 
-            INFO("query " << aQuery);
-            int rc = mysql_query(&m_Handle, aQuery.data());
+            INFO("query " << (aQuery.size() > 1024 ? aQuery.substr(0, 1024) + "..." : aQuery));
+            int rc = mysql_real_query(&m_Handle, aQuery.data(), aQuery.size());
             if (rc)
                 report("mysql_query");
         }
 
+        // LOAD DATA LOCAL INFILE with data from memory, file name in query ignored.
+        // needs Config::local_infile
+        void Load(const std::string& aQuery, std::string_view aData)
+        {
+            mysql_set_local_infile_handler(
+                &m_Handle,
+                [](void** aPtr, const char*, void* aUser) -> int {
+                    *aPtr = aUser;
+                    return 0;
+                },
+                [](void* aPtr, char* aBuf, unsigned aSize) -> int {
+                    auto&        sData = *static_cast<std::string_view*>(aPtr);
+                    const size_t sSize = std::min<size_t>(aSize, sData.size());
+                    memcpy(aBuf, sData.data(), sSize);
+                    sData.remove_prefix(sSize);
+                    return sSize;
+                },
+                [](void*) {},
+                [](void*, char* aBuf, unsigned aSize) -> int {
+                    snprintf(aBuf, aSize, "local infile read error");
+                    return CR_UNKNOWN_ERROR;
+                },
+                &aData);
+            Util::Raii sCleanup([this]() { mysql_set_local_infile_default(&m_Handle); });
+            Query(aQuery);
+        }
+
         void Use(UseCB aHandler) override
         {
             MYSQL_RES* sResult = nullptr;
@@ -6,6 +6,15 @@
 
 namespace MySQL::Once {
 
+    // string params must be quoted by user
+    inline bool exists(ConnectionFace* aClient, const std::string& aService, const std::string& aTask, const std::string& aId)
+    {
+        bool sAlready = false;
+        aClient->Query(fmt::format("SELECT COUNT(1) FROM transaction_log WHERE service='{}' AND task='{}' AND id='{}'", aService, aTask, aId));
+        aClient->Use([&sAlready](const MySQL::Row& aRow) { sAlready = aRow[0].as_int64() > 0; });
+        return sAlready;
+    }
+
     // string params must be quoted by user
     template <class T>
     void transaction(ConnectionFace* aClient, const std::string& aService, const std::string& aTask, const std::string& aId, T&& aHandler)
@@ -13,10 +22,7 @@ namespace MySQL::Once {
         const std::string_view sTable = "transaction_log";
         aClient->Query("BEGIN");
 
-        bool sAlready = false;
-        aClient->Query(fmt::format("SELECT COUNT(1) FROM {} WHERE service='{}' AND task='{}' AND id='{}'", sTable, aService, aTask, aId));
-        aClient->Use([&sAlready](const MySQL::Row& aRow) { sAlready = aRow[0].as_int64() > 0; });
-        if (!sAlready) {
+        if (!exists(aClient, aService, aTask, aId)) {
             aClient->Query(fmt::format("INSERT INTO {} (service,task,id) VALUES ('{}','{}','{}')", sTable, aService, aTask, aId));
             aHandler(aClient);
         }
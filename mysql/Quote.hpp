@@ -1,15 +1,13 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 namespace MySQL
 {
-    // does not corrupt UTF-8 string
-    inline std::string Quote(const std::string aStr)
+    // append escaped string, does not corrupt UTF-8 string
+    inline void Quote(std::string& aDest, std::string_view aStr)
     {
-        std::string sResult;
-        sResult.reserve(aStr.size() * 2);
-
         for (const char a : aStr)
         {
             switch (a) {
@@ -20,13 +18,20 @@ namespace MySQL
                 case '\n':
                 case '\r':
                 case '`':
-                    sResult.push_back('\\');
+                    aDest.push_back('\\');
                     [[fallthrough]];
                 default:
-                    sResult.push_back(a);
+                    aDest.push_back(a);
             }
         }
+    }
 
+    // does not corrupt UTF-8 string
+    inline std::string Quote(const std::string aStr)
+    {
+        std::string sResult;
+        sResult.reserve(aStr.size() * 2);
+        Quote(sResult, aStr);
         return sResult;
     }
 }
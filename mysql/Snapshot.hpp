@@ -0,0 +1,286 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <exception/Error.hpp>
+#include <unsorted/Raii.hpp>
+
+namespace MySQL {
+
+    // immutable sorted index over Updateable container.
+    // for std::string and trivially copyable keys/values index is one flat buffer, same layout in memory and in file:
+    //   Header, Timestamp (padded to 8), uint64 offsets of records sorted by key, records
+    //   record: uint32 key size, key, uint32 value size, value
+    // so saved snapshot mapped and used as is, without decoding.
+    // other types stored as sorted vector of pairs and can't be saved.
+    template <class Key, class Value, class Timestamp>
+    class Snapshot : public boost::noncopyable
+    {
+        template <class T>
+        static constexpr bool is_flat_v = std::is_same_v<T, std::string> or std::is_trivially_copyable_v<T>;
+
+    public:
+        static constexpr bool flat = is_flat_v<Key> and is_flat_v<Value> and std::is_trivially_copyable_v<Timestamp>;
+
+    private:
+        struct Header
+        {
+            char     magic[8] = {'S', 'N', 'A', 'P', 'v', '1', 0, 0};
+            uint64_t count    = 0;
+            uint64_t key      = 0; // sizeof(Key), 0 for std::string
+            uint64_t value    = 0; // sizeof(Value), 0 for std::string
+        };
+        static constexpr size_t TIMESTAMP_SIZE = (sizeof(Timestamp) + 7) / 8 * 8;
+
+        using Pairs = std::vector<std::pair<Key, Value>>;
+
+        Timestamp        m_Timestamp{};
+        size_t           m_Count = 0;
+        std::string      m_Buffer;            // built in memory
+        void*            m_Map     = nullptr; // or mapped from file
+        size_t           m_MapSize = 0;
+        std::string_view m_Data;              // one of above
+        const uint64_t*  m_Index = nullptr;
+        Pairs            m_Pairs; // not flat types
+
+        template <class T>
+        static constexpr uint64_t type_size()
+        {
+            if constexpr (std::is_same_v<T, std::string>)
+                return 0;
+            else
+                return sizeof(T);
+        }
+
+        template <class T>
+        static void append(std::string& aBuf, const T& aValue)
+        {
+            if constexpr (std::is_same_v<T, std::string>) {
+                const uint32_t sSize = aValue.size();
+                aBuf.append(reinterpret_cast<const char*>(&sSize), sizeof(sSize));
+                aBuf.append(aValue);
+            } else {
+                const uint32_t sSize = sizeof(T);
+                aBuf.append(reinterpret_cast<const char*>(&sSize), sizeof(sSize));
+                aBuf.append(reinterpret_cast<const char*>(&aValue), sizeof(T));
+            }
+        }
+
+        // field at aOffset, aOffset moved after it
+        std::string_view field(uint64_t& aOffset) const
+        {
+            uint32_t sSize = 0;
+            if (aOffset + sizeof(sSize) > m_Data.size())
+                throw std::runtime_error("MySQL::Snapshot: corrupted");
+            memcpy(&sSize, m_Data.data() + aOffset, sizeof(sSize));
+            aOffset += sizeof(sSize);
+            if (aOffset + sSize > m_Data.size())
+                throw std::runtime_error("MySQL::Snapshot: corrupted");
+            aOffset += sSize;
+            return m_Data.substr(aOffset - sSize, sSize);
+        }
+
+        template <class T>
+        static T decode(std::string_view aField)
+        {
+            if constexpr (std::is_same_v<T, std::string>) {
+                return std::string(aField);
+            } else {
+                if (aField.size() != sizeof(T))
+                    throw std::runtime_error("MySQL::Snapshot: corrupted");
+                T sResult;
+                memcpy(&sResult, aField.data(), sizeof(T));
+                return sResult;
+            }
+        }
+
+        // strings compared without copy
+        static bool less(std::string_view aField, const Key& aKey)
+        {
+            if constexpr (std::is_same_v<Key, std::string>)
+                return aField < std::string_view(aKey);
+            else
+                return decode<Key>(aField) < aKey;
+        }
+        static bool greater(std::string_view aField, const Key& aKey)
+        {
+            if constexpr (std::is_same_v<Key, std::string>)
+                return std::string_view(aKey) < aField;
+            else
+                return aKey < decode<Key>(aField);
+        }
+
+        void attach(std::string_view aData)
+        {
+            m_Data = aData;
+            Header sHeader;
+            if (m_Data.size() < sizeof(Header) + TIMESTAMP_SIZE)
+                throw std::runtime_error("MySQL::Snapshot: corrupted");
+            memcpy(&sHeader, m_Data.data(), sizeof(Header));
+            if (memcmp(sHeader.magic, Header().magic, sizeof(sHeader.magic)) != 0 or sHeader.key != type_size<Key>() or sHeader.value != type_size<Value>())
+                throw std::runtime_error("MySQL::Snapshot: bad header");
+            if (sHeader.count > (m_Data.size() - sizeof(Header) - TIMESTAMP_SIZE) / sizeof(uint64_t))
+                throw std::runtime_error("MySQL::Snapshot: corrupted");
+            memcpy(&m_Timestamp, m_Data.data() + sizeof(Header), sizeof(Timestamp));
+            m_Count = sHeader.count;
+            m_Index = reinterpret_cast<const uint64_t*>(m_Data.data() + sizeof(Header) + TIMESTAMP_SIZE);
+        }
+
+        Snapshot() = default;
+
+    public:
+        template <class Container>
+        static std::unique_ptr<Snapshot> build(const Container& aData, Timestamp aTimestamp)
+        {
+            std::vector<const typename Container::value_type*> sSorted;
+            sSorted.reserve(aData.size());
+            for (auto& x : aData)
+                sSorted.push_back(&x);
+            auto sLess = [](auto a, auto b) { return a->first < b->first; };
+            if (!std::is_sorted(sSorted.begin(), sSorted.end(), sLess))
+                std::sort(sSorted.begin(), sSorted.end(), sLess);
+
+            std::unique_ptr<Snapshot> sResult(new Snapshot);
+            sResult->m_Timestamp = aTimestamp;
+            sResult->m_Count     = sSorted.size();
+            if constexpr (!flat) {
+                sResult->m_Pairs.reserve(sSorted.size());
+                for (auto x : sSorted)
+                    sResult->m_Pairs.emplace_back(x->first, x->second);
+            } else {
+                std::string& sBuf = sResult->m_Buffer;
+                Header       sHeader;
+                sHeader.count = sSorted.size();
+                sHeader.key   = type_size<Key>();
+                sHeader.value = type_size<Value>();
+                sBuf.append(reinterpret_cast<const char*>(&sHeader), sizeof(sHeader));
+                sBuf.append(reinterpret_cast<const char*>(&aTimestamp), sizeof(aTimestamp));
+                sBuf.resize(sizeof(Header) + TIMESTAMP_SIZE + sSorted.size() * sizeof(uint64_t));
+                for (size_t i = 0; i < sSorted.size(); i++) {
+                    const uint64_t sOffset = sBuf.size();
+                    memcpy(&sBuf[sizeof(Header) + TIMESTAMP_SIZE + i * sizeof(uint64_t)], &sOffset, sizeof(sOffset));
+                    append(sBuf, sSorted[i]->first);
+                    append(sBuf, sSorted[i]->second);
+                }
+                sResult->attach(sBuf);
+            }
+            return sResult;
+        }
+
+        // pages read on demand, so startup time does not depend on snapshot size
+        static std::unique_ptr<Snapshot> map(const std::string& aPath)
+        requires flat
+        {
+            const int sFD = ::open(aPath.c_str(), O_RDONLY);
+            if (sFD == -1)
+                throw Exception::ErrnoError("MySQL::Snapshot: fail to open " + aPath);
+            Util::Raii  sClose([sFD]() { ::close(sFD); });
+            struct stat sStat;
+            if (::fstat(sFD, &sStat) == -1)
+                throw Exception::ErrnoError("MySQL::Snapshot: fail to stat " + aPath);
+
+            std::unique_ptr<Snapshot> sResult(new Snapshot);
+            if (sStat.st_size > 0) {
+                sResult->m_Map = ::mmap(nullptr, sStat.st_size, PROT_READ, MAP_SHARED, sFD, 0);
+                if (sResult->m_Map == MAP_FAILED) {
+                    sResult->m_Map = nullptr;
+                    throw Exception::ErrnoError("MySQL::Snapshot: fail to mmap " + aPath);
+                }
+                sResult->m_MapSize = sStat.st_size;
+            }
+            sResult->attach(std::string_view(static_cast<const char*>(sResult->m_Map), sResult->m_MapSize));
+            return sResult;
+        }
+
+        // write via temporary file and rename, so mapped old version stays valid
+        void save(const std::string& aPath) const
+        requires flat
+        {
+            const std::string sTmp = aPath + ".tmp";
+            const int         sFD  = ::open(sTmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (sFD == -1)
+                throw Exception::ErrnoError("MySQL::Snapshot: fail to create " + sTmp);
+            std::string_view sData = m_Data;
+            while (!sData.empty()) {
+                const ssize_t sRC = ::write(sFD, sData.data(), sData.size());
+                if (sRC < 0 and errno == EINTR)
+                    continue;
+                if (sRC <= 0)
+                    break;
+                sData.remove_prefix(sRC);
+            }
+            const bool sOk = sData.empty() and ::fsync(sFD) == 0;
+            ::close(sFD);
+            if (!sOk or ::rename(sTmp.c_str(), aPath.c_str()) != 0) {
+                ::unlink(sTmp.c_str());
+                throw Exception::ErrnoError("MySQL::Snapshot: fail to write " + aPath);
+            }
+        }
+
+        ~Snapshot()
+        {
+            if (m_Map)
+                ::munmap(m_Map, m_MapSize);
+        }
+
+        std::optional<Value> find(const Key& aKey) const
+        {
+            if constexpr (!flat) {
+                auto sIter = std::lower_bound(m_Pairs.begin(), m_Pairs.end(), aKey, [](const auto& a, const Key& b) { return a.first < b; });
+                if (sIter == m_Pairs.end() or aKey < sIter->first)
+                    return std::nullopt;
+                return sIter->second;
+            } else {
+                size_t sFrom = 0;
+                size_t sTo   = m_Count;
+                while (sFrom < sTo) {
+                    const size_t sMid    = sFrom + (sTo - sFrom) / 2;
+                    uint64_t     sOffset = m_Index[sMid];
+                    if (less(field(sOffset), aKey))
+                        sFrom = sMid + 1;
+                    else
+                        sTo = sMid;
+                }
+                if (sFrom == m_Count)
+                    return std::nullopt;
+                uint64_t         sOffset = m_Index[sFrom];
+                if (greater(field(sOffset), aKey))
+                    return std::nullopt;
+                return decode<Value>(field(sOffset));
+            }
+        }
+
+        // decode all entries, in key order
+        template <class H>
+        void for_each(H&& aHandler) const
+        {
+            if constexpr (!flat) {
+                for (auto& [sKey, sValue] : m_Pairs)
+                    aHandler(sKey, sValue);
+            } else {
+                for (size_t i = 0; i < m_Count; i++) {
+                    uint64_t   sOffset = m_Index[i];
+                    const auto sKey    = field(sOffset);
+                    aHandler(decode<Key>(sKey), decode<Value>(field(sOffset)));
+                }
+            }
+        }
+
+        Timestamp timestamp() const { return m_Timestamp; }
+        size_t    size() const { return m_Count; }
+        bool      empty() const { return m_Count == 0; }
+    };
+} // namespace MySQL
@@ -1,16 +1,22 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <optional>
 
 #include "Client.hpp"
+#include "Snapshot.hpp"
 
 #include <cache/Expiration.hpp>
 #include <cache/LRU.hpp>
 #include <cbor/cbor.hpp>
 #include <file/Interface.hpp>
+#include <threads/Rcu.hpp>
 
 namespace MySQL {
+    // readers use immutable snapshot via RCU, without locks.
+    // update() merges into m_Data under mutex and publishes new snapshot.
+    // entries from fallback queries kept in m_Extra until next update.
     template <class Policy>
     class Updateable : public File::Dumpable
     {
@@ -19,10 +25,16 @@ namespace MySQL {
 
         typename Policy::Timestamp m_Timestamp = 0;
         typename Policy::Container m_Data;
+        typename Policy::Container m_Extra;
+        std::atomic<size_t>        m_ExtraSize{0};
+        bool                       m_Lazy = false; // m_Data not filled after load()
 
         using Key   = typename Policy::Container::key_type;
         using Value = typename Policy::Container::mapped_type;
         using Iter  = typename Policy::Container::iterator;
+        using Index = Snapshot<Key, Value, typename Policy::Timestamp>;
+
+        Threads::Rcu<Index> m_Index{Index::build(typename Policy::Container(), 0)};
 
         static constexpr size_t MISS_MAX_SIZE = 1000;
         static constexpr time_t MISS_TTL      = 10;
@@ -45,13 +57,40 @@ namespace MySQL {
             });
 
             if (sFound) {
+                m_Data.insert(sResponse);
                 bool sUnused;
-                std::tie(aIter, sUnused) = m_Data.emplace(std::move(sResponse));
+                std::tie(aIter, sUnused) = m_Extra.emplace(std::move(sResponse));
+                m_ExtraSize = m_Extra.size();
             } else {
                 m_MissMap.Put(aKey, true, now());
             }
         }
 
+        // lock must be held
+        void materialize()
+        {
+            if (!m_Lazy)
+                return;
+            m_Index.read()->for_each([this](auto&& aKey, auto&& aValue) { m_Data.emplace(std::move(aKey), std::move(aValue)); });
+            m_Lazy = false;
+        }
+
+        // lock must be held
+        void publish()
+        {
+            m_Index.update(Index::build(m_Data, m_Timestamp));
+            m_Extra.clear();
+            m_ExtraSize = 0;
+        }
+
+        std::optional<Value> find_extra(const Key& aKey) const
+        {
+            auto sIter = m_Extra.find(aKey);
+            if (sIter == m_Extra.end())
+                return std::nullopt;
+            return std::make_optional<Value>(Value{sIter->second});
+        }
+
     public:
         Updateable()
         : m_MissMap(MISS_MAX_SIZE, MISS_TTL)
@@ -61,6 +100,7 @@ namespace MySQL {
         void dump(File::IWriter* aWriter) override
         {
             Lock lk(m_Mutex);
+            materialize();
             cbor::write(*aWriter, m_Timestamp, m_Data);
         }
 
@@ -71,49 +111,82 @@ namespace MySQL {
             cbor::read(*aReader, sTimestamp, sData);
             Lock lk(m_Mutex);
             m_Timestamp = sTimestamp;
+            m_Lazy      = false;
             std::swap(m_Data, sData);
-            lk.unlock();
+            publish();
+        }
+
+        // snapshot file can be mapped by load()
+        void save(const std::string& aPath) const
+        requires Index::flat
+        {
+            m_Index.read()->save(aPath);
+        }
+
+        // map snapshot file: no decoding, container filled on first update
+        void load(const std::string& aPath)
+        requires Index::flat
+        {
+            auto sIndex = Index::map(aPath);
+            Lock lk(m_Mutex);
+            m_Timestamp = sIndex->timestamp();
+            m_Data.clear();
+            m_Lazy = true;
+            m_Index.update(std::move(sIndex));
+            m_Extra.clear();
+            m_ExtraSize = 0;
         }
 
         void update(MySQL::Connection& aConnection)
         {
             typename Policy::Container sData;
-            aConnection.Query(Policy::query(m_Timestamp));
+            Lock                       lk(m_Mutex);
+            const auto                 sTimestamp = m_Timestamp;
+            lk.unlock();
+
+            aConnection.Query(Policy::query(sTimestamp));
             aConnection.Use([&sData](const MySQL::Row& aRow) { sData.emplace(Policy::parse(aRow)); });
 
-            Lock lk(m_Mutex);
+            lk.lock();
+            materialize();
             m_Timestamp = Policy::merge(sData, m_Data);
-            lk.unlock();
+            publish();
         }
         std::optional<Value> find(const Key& aKey, MySQL::Connection& aConnection)
         requires std::is_invocable_v<decltype(&Policy::fallback), Key>
         {
+            if (auto sResult = m_Index.read()->find(aKey))
+                return sResult;
+
             Lock lk(m_Mutex);
-            auto sIter = m_Data.find(aKey);
-            if (sIter == m_Data.end() and m_MissMap.Get(aKey, now()) == nullptr) {
+            auto sIter = m_Extra.find(aKey);
+            if (sIter == m_Extra.end() and m_MissMap.Get(aKey, now()) == nullptr) {
+                // snapshot could be replaced while we waited for lock
+                if (auto sResult = m_Index.read()->find(aKey))
+                    return sResult;
                 fallback(sIter, aKey, aConnection);
             }
-            if (sIter == m_Data.end())
+            if (sIter == m_Extra.end())
                 return std::nullopt;
             return std::make_optional<Value>(Value{sIter->second});
         }
-        std::optional<Value> find(const Key& aKey)
+        std::optional<Value> find(const Key& aKey) const
         {
-            Lock lk(m_Mutex);
-            auto sIter = m_Data.find(aKey);
-            if (sIter == m_Data.end())
+            if (auto sResult = m_Index.read()->find(aKey))
+                return sResult;
+            if (m_ExtraSize == 0)
                 return std::nullopt;
-            return std::make_optional<Value>(Value{sIter->second});
+            Lock lk(m_Mutex);
+            return find_extra(aKey);
         }
         size_t size() const
         {
             Lock lk(m_Mutex);
-            return m_Data.size();
+            return m_Index.read()->size() + m_Extra.size();
         }
         bool empty() const
         {
-            Lock lk(m_Mutex);
-            return m_Data.empty();
+            return size() == 0;
         }
     };
 } // namespace MySQL
@@ -1,12 +1,13 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <vector>
 
 #include <boost/algorithm/string/predicate.hpp>
 
 #define FILE_NO_ARCHIVE
-#include "Once.hpp"
+#include "Bulk.hpp"
 
 #include <file/Dir.hpp>
 #include <file/File.hpp>
@@ -20,27 +21,44 @@ namespace MySQL::Upload {
 
     class Consumer
     {
-        Threads::DiskQueue::Consumer m_Consumer;
-        const MySQL::Config          m_Config;
+        Threads::DiskQueue::Consumer      m_Consumer;
+        const MySQL::Config               m_Config;
+        const std::optional<Bulk::Params> m_Params;
 
         void upload(const std::string& sName)
         {
             INFO("start uploading " << sName);
             const std::string sFileName = File::getFilename(sName);
-            MySQL::Connection sClient(m_Config);
 
-            MySQL::Once::transaction(&sClient, "uploader", File::getFilename(sName), "as-one", [&sName](auto* aClient) {
-                File::by_string(sName, [aClient](auto sView) {
-                    aClient->Query(std::string(sView));
+            // file loaded in one transaction, or in partitions if Bulk::Params given.
+            // files already uploaded as one are skipped in both modes
+            if (!m_Params) {
+                MySQL::Connection sClient(m_Config);
+                MySQL::Once::transaction(&sClient, "uploader", sFileName, "as-one", [&sName](auto* aClient) {
+                    File::by_string(sName, [aClient](auto sView) {
+                        aClient->Query(std::string(sView));
+                    });
                 });
-            });
-            INFO("success");
+                INFO("success");
+                return;
+            }
+            {
+                MySQL::Connection sClient(m_Config);
+                if (MySQL::Once::exists(&sClient, "uploader", sFileName, "as-one")) {
+                    INFO("already uploaded as one transaction");
+                    return;
+                }
+            }
+            Bulk::Loader sLoader(m_Config, *m_Params);
+            sLoader.Replay("uploader", sFileName, sName);
+            INFO("success: " << sLoader.Rows() << " rows in " << sLoader.Statements() << " statements");
         }
 
     public:
-        Consumer(const std::string& aBase, const Config& aConfig)
+        Consumer(const std::string& aBase, const Config& aConfig, const std::optional<Bulk::Params>& aParams = std::nullopt)
         : m_Consumer({.base = aBase, .ext = ".upload.sql"}, [this](const std::string& aName) { upload(aName); })
         , m_Config(aConfig)
+        , m_Params(aParams)
         {
         }
 
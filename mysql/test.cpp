@@ -5,12 +5,14 @@
 
 #include <cassert>
 #include <iostream>
+#include <unordered_map>
 
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/use_future.hpp>
 
 #include "Cacheable.hpp"
+#include "Bulk.hpp"
 #include "Client.hpp"
 #include "Coro.hpp"
 #include "Format.hpp"
@@ -136,6 +138,62 @@ BOOST_AUTO_TEST_CASE(updateable)
     MySQL::Updateable<Departments> upd2;
     upd2.restore(&sRestore);
     BOOST_CHECK_EQUAL(upd2.find("d006").value(), "Quality Management");
+
+    // mapped snapshot
+    const std::string sPath = "/tmp/mysql-updateable.snap";
+    upd.update(c);
+    upd.save(sPath);
+    MySQL::Updateable<Departments> upd3;
+    upd3.load(sPath);
+    BOOST_CHECK_EQUAL(upd3.size(), upd.size());
+    BOOST_CHECK_EQUAL(upd3.find("d008").value(), "Research");
+    BOOST_CHECK(!upd3.find("d001"));
+    upd3.update(c);
+    BOOST_CHECK_EQUAL(upd3.find("d006").value(), "Quality Management");
+    ::unlink(sPath.c_str());
+}
+BOOST_AUTO_TEST_CASE(snapshot)
+{
+    using Index = MySQL::Snapshot<std::string, std::string, time_t>;
+    std::map<std::string, std::string> sData;
+    for (int i = 0; i < 1000; i++)
+        sData["key" + std::to_string(i * 2)] = "value" + std::to_string(i);
+
+    auto sIndex = Index::build(sData, 42);
+    BOOST_CHECK_EQUAL(sIndex->size(), 1000);
+    BOOST_CHECK_EQUAL(sIndex->find("key10").value(), "value5");
+    BOOST_CHECK(!sIndex->find("key11"));
+    BOOST_CHECK(!sIndex->find(""));
+    BOOST_CHECK(!sIndex->find("zzz"));
+
+    const std::string sPath = "/tmp/mysql-snapshot.snap";
+    sIndex->save(sPath);
+    auto sMapped = Index::map(sPath);
+    BOOST_CHECK_EQUAL(sMapped->timestamp(), 42);
+    BOOST_CHECK_EQUAL(sMapped->size(), 1000);
+    for (auto& [sKey, sValue] : sData)
+        BOOST_CHECK_EQUAL(sMapped->find(sKey).value(), sValue);
+    size_t sCount = 0;
+    sMapped->for_each([&sCount, &sData](const std::string& aKey, const std::string& aValue) {
+        BOOST_CHECK_EQUAL(sData[aKey], aValue);
+        sCount++;
+    });
+    BOOST_CHECK_EQUAL(sCount, sData.size());
+    ::unlink(sPath.c_str());
+
+    // unordered container with integer keys
+    using IntIndex = MySQL::Snapshot<int, double, time_t>;
+    std::unordered_map<int, double> sNumbers{{5, 0.5}, {-1, -0.1}, {3, 0.3}};
+    auto                            sInt = IntIndex::build(sNumbers, 0);
+    BOOST_CHECK_EQUAL(sInt->find(-1).value(), -0.1);
+    BOOST_CHECK_EQUAL(sInt->find(3).value(), 0.3);
+    BOOST_CHECK(!sInt->find(4));
+
+    // not flat value: kept as pairs
+    using ListIndex = MySQL::Snapshot<int, std::list<int>, time_t>;
+    static_assert(!ListIndex::flat);
+    std::map<int, std::list<int>> sLists{{1, {1, 2}}, {2, {3}}};
+    BOOST_CHECK_EQUAL(ListIndex::build(sLists, 0)->find(1).value().size(), 2);
 }
 BOOST_AUTO_TEST_CASE(once)
 {
@@ -191,6 +249,107 @@ BOOST_AUTO_TEST_CASE(upload)
         BOOST_TEST_MESSAGE("transaction_log entry created at: " << aRow[0].as_string());
     });
 }
+BOOST_AUTO_TEST_CASE(bulk_parse)
+{
+    auto sInsert = MySQL::Bulk::ParseInsert("INSERT INTO test_data VALUES (0, 'a,b'), (0, 'c\\')'),(0,\"d\");");
+    BOOST_REQUIRE(sInsert);
+    BOOST_CHECK_EQUAL(sInsert->head, "INSERT INTO test_data VALUES ");
+    BOOST_CHECK_EQUAL(sInsert->values, "(0, 'a,b'), (0, 'c\\')'),(0,\"d\")");
+    BOOST_CHECK_EQUAL(sInsert->rows, 3);
+
+    BOOST_CHECK(!MySQL::Bulk::ParseInsert("INSERT INTO test_data VALUES (1, 'a') ON DUPLICATE KEY UPDATE name='b'"));
+    BOOST_CHECK(!MySQL::Bulk::ParseInsert("INSERT INTO test_data SELECT * FROM other"));
+    BOOST_CHECK(!MySQL::Bulk::ParseInsert("UPDATE test_data SET name='x'"));
+
+    BOOST_CHECK_THROW(MySQL::Bulk::Loader(MySQL::Config{}, {.queue = 0}), std::invalid_argument);
+}
+BOOST_AUTO_TEST_CASE(bulk)
+{
+    MySQL::Connection c(MySQL::Config{.database = "test"});
+    auto              sCount = [&c]() {
+        unsigned sRowCount = 0;
+        c.Query("select count(1) from test_data");
+        c.Use([&sRowCount](const MySQL::Row& aRow) mutable { sRowCount = aRow[0]; });
+        return sRowCount;
+    };
+    c.Query("TRUNCATE TABLE transaction_log");
+    c.Query("TRUNCATE TABLE test_data");
+
+    const unsigned    sRows = 200000;
+    const std::string sName = "/tmp/bulk-test.upload.sql";
+    File::write(sName, [](auto* aFile) {
+        for (unsigned i = 0; i < sRows; i++) {
+            const std::string sLine = "INSERT INTO test_data VALUES (0, 'row-" + std::to_string(i) + "');\n";
+            aFile->write(sLine.data(), sLine.size());
+        }
+    });
+
+    // one statement per query, as Upload::Consumer does by default
+    {
+        Time::Meter    m;
+        const unsigned sBaseline = 10000;
+        c.Query("BEGIN");
+        for (unsigned i = 0; i < sBaseline; i++)
+            c.Query("INSERT INTO test_data VALUES (0, 'row-" + std::to_string(i) + "')");
+        c.Query("ROLLBACK");
+        BOOST_TEST_MESSAGE("one by one: " << sBaseline / m.get().to_double() << " rows/sec");
+    }
+
+    MySQL::Bulk::Params sParams{.connections = 4, .max_statement = 256 * 1024, .partition = 1024 * 1024};
+    {
+        MySQL::Bulk::Loader sLoader(MySQL::Config{.database = "test"}, sParams);
+        Time::Meter         m;
+        sLoader.Replay("bulk", "bulk-test.upload.sql", sName);
+        BOOST_TEST_MESSAGE("replay: " << sRows / m.get().to_double() << " rows/sec, " << sLoader.Statements() << " statements");
+        BOOST_CHECK_EQUAL(sLoader.Rows(), sRows);
+        BOOST_CHECK_EQUAL(sLoader.Skipped(), 0);
+    }
+    BOOST_CHECK_EQUAL(sCount(), sRows);
+
+    // exactly once: all partitions registered in transaction_log
+    {
+        MySQL::Bulk::Loader sLoader(MySQL::Config{.database = "test"}, sParams);
+        sLoader.Replay("bulk", "bulk-test.upload.sql", sName);
+        BOOST_CHECK_EQUAL(sLoader.Rows(), 0);
+        BOOST_CHECK_GT(sLoader.Skipped(), 0);
+    }
+    BOOST_CHECK_EQUAL(sCount(), sRows);
+
+    // other partition bounds: committed partitions can't be matched
+    {
+        MySQL::Bulk::Loader sLoader(MySQL::Config{.database = "test"}, {.partition = 64 * 1024});
+        BOOST_CHECK_THROW(sLoader.Replay("bulk", "bulk-test.upload.sql", sName), std::invalid_argument);
+    }
+    BOOST_CHECK_EQUAL(sCount(), sRows);
+
+    // rows from code, multi-row INSERT and LOAD DATA if server allows it
+    bool sLocalInfile = false;
+    c.Query("SELECT @@local_infile");
+    c.Use([&sLocalInfile](const MySQL::Row& aRow) mutable { sLocalInfile = aRow[0].as_int64() > 0; });
+    for (bool sLoadData : {false, true}) {
+        if (sLoadData and !sLocalInfile) {
+            BOOST_TEST_MESSAGE("LOAD DATA skipped: local_infile disabled on server");
+            continue;
+        }
+        c.Query("TRUNCATE TABLE test_data");
+        sParams.load_data = sLoadData;
+        MySQL::Bulk::Loader sLoader(MySQL::Config{.database = "test", .local_infile = sLoadData}, sParams);
+        Time::Meter         m;
+        sLoader.Load("bulk", sLoadData ? "load-data" : "insert", "test_data", "name", [](auto& aSink) {
+            for (unsigned i = 0; i < sRows; i++)
+                aSink("name\t'" + std::to_string(i) + "'");
+        });
+        BOOST_TEST_MESSAGE((sLoadData ? "load data: " : "insert: ") << sRows / m.get().to_double() << " rows/sec");
+        BOOST_CHECK_EQUAL(sLoader.Rows(), sRows);
+        BOOST_CHECK_EQUAL(sCount(), sRows);
+
+        std::string sValue;
+        c.Query("SELECT name FROM test_data WHERE name LIKE '%\\'7\\'' LIMIT 1");
+        c.Use([&sValue](const MySQL::Row& aRow) mutable { sValue = aRow[0].as_string(); });
+        BOOST_CHECK_EQUAL(sValue, "name\t'7'");
+    }
+    ::unlink(sName.c_str());
+}
 BOOST_AUTO_TEST_CASE(prepare)
 {
     MySQL::Connection c(cfg);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <limits.h>
+
 #include <threads/SafeQueue.hpp>
 
 #include "EPoll.hpp"
@@ -163,6 +165,48 @@ namespace Tcp {
             }
         }
 
+        // gather write, used to send header and body parts without concatenation
+        void write(const iovec* aIov, size_t aCount, bool aForceBuffer = false)
+        {
+            if (m_Error)
+                return;
+
+            auto sAppend = [this](const iovec* aIov, size_t aCount, size_t aSkip) {
+                for (size_t i = 0; i < aCount; i++) {
+                    const size_t sSkip = std::min(aSkip, aIov[i].iov_len);
+                    m_WriteOut.append((const char*)aIov[i].iov_base + sSkip, aIov[i].iov_len - sSkip);
+                    aSkip -= sSkip;
+                }
+            };
+
+            std::unique_lock<std::mutex> lk(m_Write);
+            const bool                   sIdle = m_WriteOut.empty();
+            if (sIdle) {
+                if (aForceBuffer or queueSize() > 1 or aCount > IOV_MAX) {
+                    sAppend(aIov, aCount, 0);
+                    m_EPoll->schedule(this->shared_from_this(), 1);
+                    return;
+                }
+                size_t sTotal = 0;
+                for (size_t i = 0; i < aCount; i++)
+                    sTotal += aIov[i].iov_len;
+                ssize_t sSize = 0;
+                try {
+                    sSize = m_Socket.writev(aIov, aCount);
+                } catch (...) {
+                    on_error();
+                    self_close();
+                    return;
+                }
+                if (sSize == (ssize_t)sTotal)
+                    return;
+                sAppend(aIov, aCount, sSize > 0 ? sSize : 0); // if EAGAIN - sSize < 0
+                m_EPoll->schedule(this->shared_from_this(), 1);
+            } else {
+                sAppend(aIov, aCount, 0);
+            }
+        }
+
         // called if async request processed
         void notify(UserResult sResult)
         {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <netinet/tcp.h>
+#include <sys/uio.h>
 
 #include "CoreSocket.hpp"
 
@@ -59,6 +60,11 @@ namespace Tcp {
             return checkCall([&]() { return ::send(m_Fd, aPtr, aSize, 0); }, "send");
         }
 
+        ssize_t writev(const iovec* aIov, int aCount)
+        {
+            return checkCall([&]() { return ::writev(m_Fd, aIov, aCount); }, "writev");
+        }
+
         void set_quick_ack()
         {
             int sVal = 1;
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 // via: https://github.com/mvorbrodt/blog/blob/master/src/base64.hpp
 namespace Parser {
 
@@ -13,7 +18,53 @@ namespace Parser {
         BASE64_URL_SAFE   = 2,
     };
 
-    inline std::string Base64(const std::string_view& aStr, const unsigned aFlags = {})
+#ifdef __AVX2__
+    namespace aux {
+        // Muła, Lemire. Faster Base64 Encoding and Decoding Using AVX2 Instructions.
+        // 32 characters to 24 bytes, false if block has characters out of alphabet (or padding)
+        inline bool base64_block(const char* aPtr, char* aOut, bool aUrlSafe)
+        {
+            __m256i sInput = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPtr));
+            if (aUrlSafe) {
+                // translate -_ to +/
+                const __m256i sStd = _mm256_or_si256(_mm256_cmpeq_epi8(sInput, _mm256_set1_epi8('+')), _mm256_cmpeq_epi8(sInput, _mm256_set1_epi8('/')));
+                if (!_mm256_testz_si256(sStd, sStd))
+                    return false;
+                sInput = _mm256_blendv_epi8(sInput, _mm256_set1_epi8('+'), _mm256_cmpeq_epi8(sInput, _mm256_set1_epi8('-')));
+                sInput = _mm256_blendv_epi8(sInput, _mm256_set1_epi8('/'), _mm256_cmpeq_epi8(sInput, _mm256_set1_epi8('_')));
+            }
+
+            // classify by nibbles: lo & hi not zero for invalid characters
+            const __m256i sLutLo   = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                                      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+            const __m256i sLutHi   = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                                      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+            const __m256i sLutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+            const __m256i sHiNibbles = _mm256_and_si256(_mm256_srli_epi32(sInput, 4), _mm256_set1_epi8(0x0F));
+            const __m256i sLoNibbles = _mm256_and_si256(sInput, _mm256_set1_epi8(0x0F));
+            if (!_mm256_testz_si256(_mm256_shuffle_epi8(sLutLo, sLoNibbles), _mm256_shuffle_epi8(sLutHi, sHiNibbles)))
+                return false;
+
+            // character to 6 bit value: add offset selected by high nibble, '/' shares it with '+'
+            const __m256i sSlash  = _mm256_cmpeq_epi8(sInput, _mm256_set1_epi8('/'));
+            const __m256i sValues = _mm256_add_epi8(sInput, _mm256_shuffle_epi8(sLutRoll, _mm256_add_epi8(sSlash, sHiNibbles)));
+
+            // 4 x 6 bits to 3 bytes
+            const __m256i sMerged = _mm256_madd_epi16(_mm256_maddubs_epi16(sValues, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+            const __m256i sBytes  = _mm256_shuffle_epi8(sMerged, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                                                 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+            const __m256i sPacked = _mm256_permutevar8x32_epi32(sBytes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aOut), _mm256_castsi256_si128(sPacked));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(aOut + 16), _mm256_extracti128_si256(sPacked, 1));
+            return true;
+        }
+    } // namespace aux
+#endif
+
+    // aOut must have space for aStr.size() / 4 * 3 + 2 bytes. return end of output
+    inline char* Base64(std::string_view aStr, char* aOut, const unsigned aFlags = {})
     {
         unsigned char sPadCharacter = '=';
         unsigned char sPlus         = '+';
@@ -24,24 +75,23 @@ namespace Parser {
             sSlash        = '_';
         }
 
-        size_t padding{};
-
         if ((aFlags & BASE64_NO_PADDING) == 0) {
             if (aStr.size() % 4)
                 throw std::invalid_argument("Format::Base64: invalid size");
-            if (aStr.size() > 2) {
-                if (aStr[aStr.length() - 1] == sPadCharacter)
-                    padding++;
-                if (aStr[aStr.length() - 2] == sPadCharacter)
-                    padding++;
-            }
         }
 
-        std::string decoded;
-        decoded.reserve(((aStr.size() / 4) * 3) - padding);
+        auto it = aStr.begin();
+
+#ifdef __AVX2__
+        // full blocks, last 4 characters (with padding) left for scalar code.
+        // invalid block left too, to report error
+        while (aStr.end() - it >= 36 and aux::base64_block(&*it, aOut, aFlags & BASE64_URL_SAFE)) {
+            it += 32;
+            aOut += 24;
+        }
+#endif
 
         std::uint32_t temp{};
-        auto          it = aStr.begin();
 
         while (it < aStr.end()) {
             for (std::size_t i = 0; i < 4; ++i) {
@@ -76,12 +126,12 @@ namespace Parser {
 
                     switch (sPadSize) {
                     case 1:
-                        decoded.push_back((temp >> 16) & 0x000000FF);
-                        decoded.push_back((temp >> 8) & 0x000000FF);
-                        return decoded;
+                        *aOut++ = (temp >> 16) & 0x000000FF;
+                        *aOut++ = (temp >> 8) & 0x000000FF;
+                        return aOut;
                     case 2:
-                        decoded.push_back((temp >> 10) & 0x000000FF);
-                        return decoded;
+                        *aOut++ = (temp >> 10) & 0x000000FF;
+                        return aOut;
                     default:
                         throw std::invalid_argument("Format::Base64: invalid padding");
                     }
@@ -92,11 +142,31 @@ namespace Parser {
                     it++;
             }
 
-            decoded.push_back((temp >> 16) & 0x000000FF);
-            decoded.push_back((temp >> 8) & 0x000000FF);
-            decoded.push_back((temp)&0x000000FF);
+            *aOut++ = (temp >> 16) & 0x000000FF;
+            *aOut++ = (temp >> 8) & 0x000000FF;
+            *aOut++ = (temp)&0x000000FF;
         }
 
+        return aOut;
+    }
+
+    // append to aOut
+    inline void Base64(std::string_view aStr, std::string& aOut, const unsigned aFlags = {})
+    {
+        const size_t sSize = aOut.size();
+        aOut.resize(sSize + aStr.size() / 4 * 3 + 2);
+        try {
+            aOut.resize(Base64(aStr, aOut.data() + sSize, aFlags) - aOut.data());
+        } catch (...) {
+            aOut.resize(sSize);
+            throw;
+        }
+    }
+
+    inline std::string Base64(const std::string_view& aStr, const unsigned aFlags = {})
+    {
+        std::string decoded;
+        Base64(aStr, decoded, aFlags);
         return decoded;
     }
 } // namespace Parser
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <cstring>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 namespace Parser {
     namespace aux {
         inline char restore(const char a)
@@ -15,19 +21,60 @@ namespace Parser {
                 return a - 'A' + 10;
             throw std::invalid_argument("bad hex value");
         }
+
+#ifdef __AVX2__
+        // 32 hex digits to 16 bytes, false if block has other characters
+        inline bool from_hex_block(const char* aPtr, char* aOut)
+        {
+            const __m256i sInput  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPtr));
+            const __m256i sDigit  = _mm256_sub_epi8(sInput, _mm256_set1_epi8('0'));
+            const __m256i sLetter = _mm256_sub_epi8(_mm256_or_si256(sInput, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+            const __m256i sIsDigit  = _mm256_cmpeq_epi8(_mm256_min_epu8(sDigit, _mm256_set1_epi8(9)), sDigit);
+            const __m256i sIsLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(sLetter, _mm256_set1_epi8(5)), sLetter);
+            if (_mm256_movemask_epi8(_mm256_or_si256(sIsDigit, sIsLetter)) != -1)
+                return false;
+            const __m256i sNibbles = _mm256_blendv_epi8(_mm256_add_epi8(sLetter, _mm256_set1_epi8(10)), sDigit, sIsDigit);
+            // high * 16 + low in every 16 bit lane
+            const __m256i sBytes = _mm256_maddubs_epi16(sNibbles, _mm256_set1_epi16(0x0110));
+            const __m256i sPacked = _mm256_permute4x64_epi64(_mm256_packus_epi16(sBytes, sBytes), 0b1000);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aOut), _mm256_castsi256_si128(sPacked));
+            return true;
+        }
+#endif
     } // namespace aux
 
-    inline std::string from_hex(std::string_view x)
+    // aOut must have space for x.size() / 2 bytes. return end of output
+    inline char* from_hex(std::string_view x, char* aOut)
     {
-        std::string sResult;
         if (x.size() % 2 != 0)
             throw std::invalid_argument("Parser::from_hex");
-        sResult.reserve(x.size() / 2);
-        for (unsigned i = 0; i < x.size() / 2; i++) {
-            auto a1 = x[i * 2];
-            auto a2 = x[i * 2 + 1];
-            sResult.push_back((aux::restore(a1) << 4) + aux::restore(a2));
+        size_t i = 0;
+#ifdef __AVX2__
+        for (; i + 32 <= x.size() and aux::from_hex_block(x.data() + i, aOut); i += 32)
+            aOut += 16;
+#endif
+        for (; i < x.size(); i += 2)
+            *aOut++ = (aux::restore(x[i]) << 4) + aux::restore(x[i + 1]);
+        return aOut;
+    }
+
+    // append to aOut
+    inline void from_hex(std::string_view x, std::string& aOut)
+    {
+        const size_t sSize = aOut.size();
+        aOut.resize(sSize + x.size() / 2);
+        try {
+            from_hex(x, aOut.data() + sSize);
+        } catch (...) {
+            aOut.resize(sSize);
+            throw;
         }
+    }
+
+    inline std::string from_hex(std::string_view x)
+    {
+        std::string sResult;
+        from_hex(x, sResult);
         return sResult;
     }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstring>
 #include <stdexcept>
 #include <string>
 
@@ -9,42 +10,75 @@
 #include <string/String.hpp>
 
 namespace Parser {
-    inline std::string url_decode(std::string_view aData)
-    {
-        enum
+    namespace aux {
+        // first '%' (or '+' in form encoding)
+        inline const char* url_special(const char* aPtr, const char* aEnd, bool aForm)
         {
-            STAGE_INITIAL = 0,
-            STAGE_FIRST,
-            STAGE_SECOND
-        };
+#ifdef __AVX2__
+            for (; aEnd - aPtr >= 32; aPtr += 32) {
+                const __m256i sInput = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPtr));
+                __m256i       sMatch = _mm256_cmpeq_epi8(sInput, _mm256_set1_epi8('%'));
+                if (aForm)
+                    sMatch = _mm256_or_si256(sMatch, _mm256_cmpeq_epi8(sInput, _mm256_set1_epi8('+')));
+                if (const unsigned sMask = _mm256_movemask_epi8(sMatch))
+                    return aPtr + __builtin_ctz(sMask);
+            }
+#endif
+            for (; aPtr < aEnd; aPtr++)
+                if (*aPtr == '%' or (aForm and *aPtr == '+'))
+                    break;
+            return aPtr;
+        }
+    } // namespace aux
 
-        std::string sResult;
-        sResult.reserve(aData.size());
-
-        uint8_t stage  = 0;
-        uint8_t decode = 0;
-
-        for (const uint8_t i : aData) {
-            switch (stage) {
-            case STAGE_INITIAL:
-                if (i != '%')
-                    sResult.push_back(i);
-                else
-                    stage = STAGE_FIRST;
-                break;
-            case STAGE_FIRST:
-                decode = (aux::restore(i) << 4);
-                stage  = STAGE_SECOND;
+    // aForm: application/x-www-form-urlencoded, '+' is space.
+    // aOut must have space for aData.size() bytes. return end of output
+    inline char* url_decode(std::string_view aData, char* aOut, bool aForm = false)
+    {
+        const char* sPtr = aData.data();
+        const char* sEnd = sPtr + aData.size();
+
+        while (sPtr < sEnd) {
+            const char* sNext = aux::url_special(sPtr, sEnd, aForm);
+            memcpy(aOut, sPtr, sNext - sPtr);
+            aOut += sNext - sPtr;
+            sPtr = sNext;
+            if (sPtr == sEnd)
                 break;
-            case STAGE_SECOND:
-                decode += aux::restore(i);
-                sResult.push_back(decode);
-                decode = 0;
-                stage  = STAGE_INITIAL;
+            if (*sPtr == '+') {
+                *aOut++ = ' ';
+                sPtr++;
+                continue;
+            }
+            // incomplete escape at end ignored
+            if (sEnd - sPtr < 3) {
+                if (sEnd - sPtr == 2)
+                    aux::restore(sPtr[1]);
                 break;
             }
+            *aOut++ = (aux::restore(sPtr[1]) << 4) + aux::restore(sPtr[2]);
+            sPtr += 3;
+        }
+        return aOut;
+    }
+
+    // append to aOut
+    inline void url_decode(std::string_view aData, std::string& aOut, bool aForm = false)
+    {
+        const size_t sSize = aOut.size();
+        aOut.resize(sSize + aData.size());
+        try {
+            aOut.resize(url_decode(aData, aOut.data() + sSize, aForm) - aOut.data());
+        } catch (...) {
+            aOut.resize(sSize);
+            throw;
         }
+    }
 
+    inline std::string url_decode(std::string_view aData, bool aForm = false)
+    {
+        std::string sResult;
+        url_decode(aData, sResult, aForm);
         return sResult;
     }
 
@@ -112,7 +146,7 @@ namespace Parser {
                 if (sEnd != std::string_view::npos) {
                     auto sKey   = aStr.substr(0, sEnd);
                     auto sValue = aStr.substr(sEnd + 1);
-                    aHandler(sKey, url_decode(sValue));
+                    aHandler(sKey, url_decode(sValue, true));
                 } else
                     aHandler(aStr, std::string_view());
             },
@@ -9,9 +9,15 @@
 #include <iostream>
 #include <vector>
 
+#include "Base64.hpp"
+#include "Hex.hpp"
 #include "Json.hpp"
+#include "Url.hpp"
 
 #include <cbor/cbor.hpp>
+#include <format/Base64.hpp>
+#include <format/Hex.hpp>
+#include <format/Url.hpp>
 #include <nlohmann/json.hpp>
 #include <rapidjson/error/en.h>
 #pragma GCC diagnostic push
@@ -29,14 +35,16 @@ struct Tmp
         Parser::Json::from_object(aJson, "base", base);
         Parser::Json::from_object(aJson, "index", index);
     }
-    void cbor_read(cbor::istream& sIn)
+    template <class S>
+    void cbor_read(S& sIn)
     {
         size_t sSize = cbor::get_uint(sIn, cbor::ensure_type(sIn, cbor::CBOR_LIST));
         assert(sSize == 2);
         cbor::read(sIn, base);
         cbor::read(sIn, index);
     }
-    void cbor_write(cbor::ostream& sOut) const
+    template <class S>
+    void cbor_write(S& sOut) const
     {
         cbor::write_type_value(sOut, cbor::CBOR_LIST, 2);
         cbor::write(sOut, base);
@@ -333,4 +341,192 @@ static void BM_Cbor(benchmark::State& state)
 }
 BENCHMARK(BM_Cbor);
 
+static void BM_CborSpan(benchmark::State& state)
+{
+    std::vector<Tmp> sTmp;
+    for (auto _ : state) {
+        cbor::ispan sIn(gCborStr);
+        cbor::read(sIn, sTmp);
+        sTmp.clear();
+    }
+}
+BENCHMARK(BM_CborSpan);
+
+static void BM_CborWrite(benchmark::State& state)
+{
+    std::vector<Tmp> sTmp;
+    cbor::from_string(gCborStr, sTmp);
+    std::string sBuffer;
+    for (auto _ : state) {
+        sBuffer.clear();
+        cbor::obuffer sOut(sBuffer);
+        cbor::write(sOut, sTmp);
+        benchmark::DoNotOptimize(sBuffer.data());
+    }
+}
+BENCHMARK(BM_CborWrite);
+
+// 1000 doubles as list of items vs typed array
+static void BM_CborNumbers(benchmark::State& state)
+{
+    std::vector<double> sData(1000);
+    for (unsigned i = 0; i < sData.size(); i++)
+        sData[i] = i * 0.5;
+    const std::string sBinary = state.range(0) ? cbor::to_string(sData) : cbor::to_string(std::list<double>(sData.begin(), sData.end()));
+    for (auto _ : state) {
+        cbor::ispan sIn(sBinary);
+        cbor::read(sIn, sData);
+        benchmark::DoNotOptimize(sData.data());
+    }
+    state.SetBytesProcessed(state.iterations() * sBinary.size());
+}
+BENCHMARK(BM_CborNumbers)->Arg(0)->Arg(1);
+
+// byte at a time codecs, as they were before vector versions
+namespace Scalar {
+    inline std::string to_hex(std::string_view x)
+    {
+        static const char sDict[] = "0123456789abcdef";
+        std::string       sResult;
+        sResult.reserve(x.size() * 2);
+        for (const uint8_t i : x) {
+            sResult.push_back(sDict[i >> 4]);
+            sResult.push_back(sDict[i & 0x0F]);
+        }
+        return sResult;
+    }
+
+    inline std::string from_hex(std::string_view x)
+    {
+        std::string sResult;
+        sResult.reserve(x.size() / 2);
+        for (unsigned i = 0; i < x.size() / 2; i++)
+            sResult.push_back((Parser::aux::restore(x[i * 2]) << 4) + Parser::aux::restore(x[i * 2 + 1]));
+        return sResult;
+    }
+
+    inline std::string base64(std::string_view aStr)
+    {
+        static const char sLookup[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string       sResult;
+        sResult.reserve((aStr.size() + 2) / 3 * 4);
+        auto it = reinterpret_cast<const unsigned char*>(aStr.data());
+        for (size_t i = 0; i < aStr.size() / 3; ++i, it += 3) {
+            const uint32_t sTemp = it[0] << 16 | it[1] << 8 | it[2];
+            sResult.append(1, sLookup[(sTemp >> 18) & 0x3F]);
+            sResult.append(1, sLookup[(sTemp >> 12) & 0x3F]);
+            sResult.append(1, sLookup[(sTemp >> 6) & 0x3F]);
+            sResult.append(1, sLookup[sTemp & 0x3F]);
+        }
+        return sResult;
+    }
+
+    inline std::string from_base64(std::string_view aStr)
+    {
+        std::string sResult;
+        sResult.reserve(aStr.size() / 4 * 3);
+        uint32_t sTemp = 0;
+        for (size_t i = 0; i < aStr.size(); i++) {
+            const unsigned c = aStr[i];
+            sTemp <<= 6;
+            if (c >= 'A' && c <= 'Z')
+                sTemp |= c - 'A';
+            else if (c >= 'a' && c <= 'z')
+                sTemp |= c - 'a' + 26;
+            else if (c >= '0' && c <= '9')
+                sTemp |= c - '0' + 52;
+            else if (c == '+')
+                sTemp |= 0x3E;
+            else if (c == '/')
+                sTemp |= 0x3F;
+            else
+                throw std::invalid_argument("bad base64");
+            if (i % 4 == 3) {
+                sResult.push_back(sTemp >> 16);
+                sResult.push_back(sTemp >> 8);
+                sResult.push_back(sTemp);
+            }
+        }
+        return sResult;
+    }
+
+    inline std::string url_decode(std::string_view aData)
+    {
+        std::string sResult;
+        sResult.reserve(aData.size());
+        for (size_t i = 0; i < aData.size(); i++) {
+            if (aData[i] != '%' or i + 2 >= aData.size())
+                sResult.push_back(aData[i]);
+            else {
+                sResult.push_back((Parser::aux::restore(aData[i + 1]) << 4) + Parser::aux::restore(aData[i + 2]));
+                i += 2;
+            }
+        }
+        return sResult;
+    }
+} // namespace Scalar
+
+// 3k of random bytes, arg: 0 - scalar, 1 - new function returning string, 2 - output to buffer
+const std::string gBinary = []() {
+    std::string sResult(3 * 1024, 0);
+    for (size_t i = 0; i < sResult.size(); i++)
+        sResult[i] = i * 2654435761u >> 13;
+    return sResult;
+}();
+
+template <class S, class F, class B>
+static void Codec(benchmark::State& state, std::string_view aInput, size_t aOutSize, S&& aScalar, F&& aFunc, B&& aBuffer)
+{
+    std::string sBuffer(aOutSize, 0);
+    for (auto _ : state) {
+        switch (state.range(0)) {
+        case 0: benchmark::DoNotOptimize(aScalar(aInput)); break;
+        case 1: benchmark::DoNotOptimize(aFunc(aInput)); break;
+        case 2: benchmark::DoNotOptimize(aBuffer(aInput, sBuffer.data())); break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * aInput.size());
+}
+
+static void BM_ToHex(benchmark::State& state)
+{
+    Codec(
+        state, gBinary, gBinary.size() * 2, Scalar::to_hex, [](auto x) { return Format::to_hex(x); }, [](auto x, char* aOut) { return Format::to_hex(x, aOut); });
+}
+BENCHMARK(BM_ToHex)->Arg(0)->Arg(1)->Arg(2);
+
+static void BM_FromHex(benchmark::State& state)
+{
+    const std::string sHex = Format::to_hex(gBinary);
+    Codec(
+        state, sHex, gBinary.size(), Scalar::from_hex, [](auto x) { return Parser::from_hex(x); }, [](auto x, char* aOut) { return Parser::from_hex(x, aOut); });
+}
+BENCHMARK(BM_FromHex)->Arg(0)->Arg(1)->Arg(2);
+
+static void BM_ToBase64(benchmark::State& state)
+{
+    Codec(
+        state, gBinary, gBinary.size() / 3 * 4, Scalar::base64, [](auto x) { return Format::Base64(x); }, [](auto x, char* aOut) { return Format::Base64(x, aOut); });
+}
+BENCHMARK(BM_ToBase64)->Arg(0)->Arg(1)->Arg(2);
+
+static void BM_FromBase64(benchmark::State& state)
+{
+    const std::string sBase64 = Format::Base64(gBinary);
+    Codec(
+        state, sBase64, gBinary.size(), Scalar::from_base64, [](auto x) { return Parser::Base64(x); }, [](auto x, char* aOut) { return Parser::Base64(x, aOut); });
+}
+BENCHMARK(BM_FromBase64)->Arg(0)->Arg(1)->Arg(2);
+
+// typical query string: mostly plain text with some escapes
+static void BM_UrlDecode(benchmark::State& state)
+{
+    std::string sUrl;
+    while (sUrl.size() < 3 * 1024)
+        sUrl += "/bucket/some/long/object/name%20with%20spaces-and-more-text_" + std::to_string(sUrl.size()) + "?x-amz-date=20240101T000000Z&";
+    Codec(
+        state, sUrl, sUrl.size(), Scalar::url_decode, [](auto x) { return Parser::url_decode(x); }, [](auto x, char* aOut) { return Parser::url_decode(x, aOut); });
+}
+BENCHMARK(BM_UrlDecode)->Arg(0)->Arg(1)->Arg(2);
+
 BENCHMARK_MAIN();
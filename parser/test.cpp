@@ -14,6 +14,8 @@
 #include "Url.hpp"
 #include "format/Base64.hpp"
 
+#include <random>
+
 #include <file/Tmp.hpp>
 #include <format/Hex.hpp>
 #include <format/ULeb128.hpp>
@@ -96,6 +98,9 @@ BOOST_AUTO_TEST_CASE(query)
         sCalled = true;
     });
     BOOST_CHECK_EQUAL(sCalled, true);
+
+    // form encoding
+    Parser::http_query("?q=random+word%2B", [&](auto, auto value) { BOOST_CHECK_EQUAL(value, "random word+"); });
 }
 BOOST_AUTO_TEST_CASE(header_kv)
 {
@@ -214,6 +219,58 @@ BOOST_AUTO_TEST_CASE(base64)
         BOOST_CHECK_EQUAL(Format::to_hex(sStr), Format::to_hex(Parser::Base64(sBase64, Format::BASE64_URL_SAFE)));
     }
 }
+BOOST_AUTO_TEST_CASE(codec)
+{
+    // vector and scalar paths: compare with encoding of small pieces
+    std::mt19937 sGen(1);
+    for (size_t sSize = 0; sSize < 200; sSize++) {
+        std::string sStr(sSize, 0);
+        for (auto& x : sStr)
+            x = sGen();
+
+        std::string sHex;
+        for (auto x : sStr)
+            sHex += Format::to_hex(std::string_view(&x, 1));
+        BOOST_CHECK_EQUAL(Format::to_hex(sStr), sHex);
+        BOOST_CHECK_EQUAL(Parser::from_hex(sHex), sStr);
+        std::transform(sHex.begin(), sHex.end(), sHex.begin(), ::toupper);
+        BOOST_CHECK_EQUAL(Parser::from_hex(sHex), sStr);
+        if (sSize > 0) {
+            sHex[sGen() % sHex.size()] = 'g';
+            BOOST_CHECK_THROW(Parser::from_hex(sHex), std::invalid_argument);
+        }
+
+        for (unsigned sFlags = 0; sFlags < 4; sFlags++) {
+            std::string sBase64;
+            for (size_t i = 0; i < sSize; i += 3)
+                sBase64 += Format::Base64(sStr.substr(i, 3), i + 3 < sSize ? sFlags | Format::BASE64_NO_PADDING : sFlags);
+            BOOST_CHECK_EQUAL(Format::Base64(sStr, sFlags), sBase64);
+            BOOST_CHECK_EQUAL(Parser::Base64(sBase64, sFlags), sStr);
+            if (sBase64.size() > 4) {
+                sBase64[sGen() % (sBase64.size() - 4)] = sFlags & Format::BASE64_URL_SAFE ? '+' : '-';
+                BOOST_CHECK_THROW(Parser::Base64(sBase64, sFlags), std::invalid_argument);
+            }
+        }
+
+        std::string sUrl;
+        for (auto x : sStr)
+            sUrl += Format::url_encode(std::string_view(&x, 1));
+        BOOST_CHECK_EQUAL(Format::url_encode(sStr), sUrl);
+        BOOST_CHECK_EQUAL(Parser::url_decode(sUrl), sStr);
+    }
+
+    // output to buffer and append
+    char sBuf[16];
+    BOOST_CHECK_EQUAL(Format::to_hex("\x01\xAB", sBuf) - sBuf, 4);
+    BOOST_CHECK_EQUAL(std::string_view(sBuf, 4), "01ab");
+    std::string sOut = "x=";
+    Parser::url_decode("a+b%20c", sOut, true);
+    BOOST_CHECK_EQUAL(sOut, "x=a b c");
+    BOOST_CHECK_THROW(Parser::Base64("Mf8*", sOut), std::invalid_argument);
+    BOOST_CHECK_EQUAL(sOut, "x=a b c");
+    Parser::Base64("Mf8=", sOut);
+    BOOST_CHECK_EQUAL(sOut, "x=a b c1\xff");
+}
 BOOST_AUTO_TEST_CASE(json)
 {
     struct Tmp
@@ -3,6 +3,9 @@
 /*
  * chrome dev tools compatible tracing
  *   to view json: F12, Performance, Load profile
+ *
+ * CATAPULT_PROFILE: json written by background thread
+ * CATAPULT_BINARY:  binary per thread rings, see Trace.hpp
  */
 
 #ifdef CATAPULT_PROFILE
@@ -369,6 +372,54 @@ namespace Profile::Catapult {
 
 #define CATAPULT_DONE() sCatapultManager.done();
 
+#elif defined(CATAPULT_BINARY)
+
+#include <fstream>
+
+#include "Trace.hpp"
+
+namespace Profile::Catapult {
+
+    // same macros over binary tracer (Trace.hpp).
+    // trace saved to file on CATAPULT_DONE, convert it with trace2json
+    class Binary : boost::noncopyable
+    {
+        const std::string               m_Filename;
+        std::unique_ptr<Trace::Manager> m_Manager;
+
+    public:
+        Binary(const std::string& aFilename)
+        : m_Filename(aFilename)
+        {
+            if (!m_Filename.empty())
+                m_Manager = std::make_unique<Trace::Manager>();
+        }
+
+        template <class T>
+        void start(T&)
+        {}
+
+        void done()
+        {
+            if (!m_Manager)
+                return;
+            const std::string sData = m_Manager->snapshot().serialize();
+            m_Manager.reset();
+            std::ofstream sFile(m_Filename, std::ios::binary | std::ios::trunc);
+            sFile.write(sData.data(), sData.size());
+        }
+    };
+
+} // namespace Profile::Catapult
+
+#define CATAPULT_MANAGER(x)       Profile::Catapult::Binary sCatapultManager(x);
+#define CATAPULT_START(x)         sCatapultManager.start(x);
+#define CATAPULT_THREAD(x)        TRACE_THREAD(x);
+#define CATAPULT_COUNTER(c, n, v) TRACE_COUNTER(c, n, v);
+#define CATAPULT_EVENT(c, n)      TRACE_EVENT(c, n)
+#define CATAPULT_MARK(c, n)       TRACE_MARK(c, n);
+#define CATAPULT_DONE()           sCatapultManager.done();
+
 #else
 #define CATAPULT_MANAGER(x)       ;
 #define CATAPULT_START(x)         ;
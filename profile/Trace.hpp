@@ -0,0 +1,538 @@
+#pragma once
+
+/*
+ * always-on binary tracing, cheap enough for production.
+ *
+ *   category and name interned once per call site, event is 32 bytes,
+ *   written to ring of current thread. ring never blocks: oldest events overwritten.
+ *   time is TSC, converted to us only on export.
+ *
+ *   snapshot() returns binary dump of all rings, to_chrome() converts it to
+ *   chrome trace json (load in chrome dev tools or ui.perfetto.dev).
+ *   trace2json tool does the same offline.
+ *
+ *   if <sys/sdt.h> available, same call sites are SDT probes (provider catapult),
+ *   see sdt/README to use them with perf.
+ */
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TRACE_SDT                  1
+#define TRACE_SDT_BEGIN(c, n)      DTRACE_PROBE2(catapult, begin, c, n)
+#define TRACE_SDT_END(id, ticks)   DTRACE_PROBE2(catapult, end, id, ticks)
+#define TRACE_SDT_COUNTER(c, n, v) DTRACE_PROBE3(catapult, counter, c, n, v)
+#define TRACE_SDT_MARK(c, n)       DTRACE_PROBE2(catapult, mark, c, n)
+#else
+#define TRACE_SDT                  0
+#define TRACE_SDT_BEGIN(c, n)
+#define TRACE_SDT_END(id, ticks)
+#define TRACE_SDT_COUNTER(c, n, v)
+#define TRACE_SDT_MARK(c, n)
+#endif
+
+namespace Profile::Trace {
+
+    inline uint64_t ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        struct timespec sTime;
+        clock_gettime(CLOCK_MONOTONIC, &sTime);
+        return sTime.tv_sec * 1000000000ul + sTime.tv_nsec;
+#endif
+    }
+
+    // pair of ticks and clocks, to convert ticks to time
+    struct Clock
+    {
+        uint64_t ticks    = 0;
+        uint64_t steady   = 0; // CLOCK_MONOTONIC, ns
+        uint64_t realtime = 0; // CLOCK_REALTIME, ns
+
+        static Clock now()
+        {
+            struct timespec sSteady, sReal;
+            clock_gettime(CLOCK_MONOTONIC, &sSteady);
+            const uint64_t sTicks = Trace::ticks();
+            clock_gettime(CLOCK_REALTIME, &sReal);
+            return {sTicks,
+                    sSteady.tv_sec * 1000000000ul + sSteady.tv_nsec,
+                    sReal.tv_sec * 1000000000ul + sReal.tv_nsec};
+        }
+    };
+
+    // category and name pairs. id never changes, so it can be cached in call site
+    class Names : boost::noncopyable
+    {
+        mutable std::mutex                                       m_Mutex;
+        std::deque<std::pair<std::string, std::string>>          m_List;
+        std::map<std::pair<std::string, std::string>, uint32_t> m_Index;
+
+    public:
+        uint32_t intern(std::string_view aCat, std::string_view aName)
+        {
+            std::unique_lock sLock(m_Mutex);
+            auto [sIt, sNew] = m_Index.try_emplace({std::string(aCat), std::string(aName)}, m_List.size());
+            if (sNew)
+                m_List.push_back(sIt->first);
+            return sIt->second;
+        }
+
+        std::vector<std::pair<std::string, std::string>> list() const
+        {
+            std::unique_lock sLock(m_Mutex);
+            return {m_List.begin(), m_List.end()};
+        }
+
+        static Names& instance()
+        {
+            static Names sNames;
+            return sNames;
+        }
+    };
+
+    inline uint32_t intern(std::string_view aCat, std::string_view aName) { return Names::instance().intern(aCat, aName); }
+
+    struct Event
+    {
+        enum Kind : uint32_t
+        {
+            DURATION = 1,
+            COUNTER  = 2,
+            MARK     = 3,
+        };
+
+        uint64_t ticks    = 0; // start
+        uint64_t duration = 0; // in ticks
+        uint64_t value    = 0; // counter
+        uint32_t id       = 0;
+        uint32_t kind     = 0;
+    };
+    static_assert(sizeof(Event) == 32);
+
+    // single writer ring, events overwritten in place.
+    // reader validates copy with claim counter, like seqlock
+    class Ring : boost::noncopyable
+    {
+        const uint64_t           m_Mask;
+        std::unique_ptr<Event[]> m_Events;
+        std::atomic<uint64_t>    m_Claim{0}; // slot of event m_Claim - 1 may be written now
+        std::atomic<uint64_t>    m_Pos{0};   // events before m_Pos are complete
+        std::atomic<bool>        m_Enabled{true};
+
+    public:
+        const pid_t       m_Tid = gettid();
+        const std::string m_Name;
+
+        Ring(size_t aSize, const std::string& aName)
+        : m_Mask(aSize - 1)
+        , m_Events(new Event[aSize])
+        , m_Name(aName)
+        {
+            if (aSize == 0 or (aSize & m_Mask) != 0)
+                throw std::invalid_argument("Trace: ring size must be power of 2");
+        }
+
+        bool enabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+        void disable() { m_Enabled.store(false, std::memory_order_relaxed); }
+
+        void push(const Event& aEvent)
+        {
+            const uint64_t sPos = m_Pos.load(std::memory_order_relaxed);
+            m_Claim.store(sPos + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            // word by word, reader can copy slot at same time
+            uint64_t sWords[4];
+            memcpy(sWords, &aEvent, sizeof(sWords));
+            auto* sSlot = reinterpret_cast<uint64_t*>(&m_Events[sPos & m_Mask]);
+            for (unsigned i = 0; i < 4; i++)
+                std::atomic_ref(sSlot[i]).store(sWords[i], std::memory_order_relaxed);
+
+            m_Pos.store(sPos + 1, std::memory_order_release);
+        }
+
+        // append complete events to aOut, oldest first
+        void copy(std::vector<Event>& aOut)
+        {
+            const uint64_t sPos   = m_Pos.load(std::memory_order_acquire);
+            const uint64_t sSize  = m_Mask + 1;
+            const uint64_t sFirst = sPos > sSize ? sPos - sSize : 0;
+            const size_t   sBase  = aOut.size();
+
+            aOut.resize(sBase + (sPos - sFirst));
+            for (uint64_t i = sFirst; i < sPos; i++) {
+                auto*    sSlot = reinterpret_cast<uint64_t*>(&m_Events[i & m_Mask]);
+                uint64_t sWords[4];
+                for (unsigned j = 0; j < 4; j++)
+                    sWords[j] = std::atomic_ref(sSlot[j]).load(std::memory_order_relaxed);
+                memcpy(&aOut[sBase + i - sFirst], sWords, sizeof(sWords));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // drop events overwritten while copying
+            const uint64_t sClaim = m_Claim.load(std::memory_order_relaxed);
+            if (sClaim > sFirst + sSize) {
+                const uint64_t sLost = std::min(sClaim - sSize - sFirst, sPos - sFirst);
+                aOut.erase(aOut.begin() + sBase, aOut.begin() + sBase + sLost);
+            }
+        }
+    };
+
+    // binary dump of all rings
+    struct Snapshot
+    {
+        struct Thread
+        {
+            pid_t              tid = 0;
+            std::string        name;
+            std::vector<Event> events;
+        };
+
+        Clock                                            start;
+        Clock                                            stop;
+        pid_t                                            pid = 0;
+        std::vector<std::pair<std::string, std::string>> names;
+        std::vector<Thread>                              threads;
+
+        static constexpr uint32_t MAGIC = 0x43525443; // CTRC
+
+        std::string serialize() const;
+        static Snapshot parse(std::string_view aData);
+
+        // us since start
+        double to_us(uint64_t aTicks) const
+        {
+            const double sScale = stop.ticks > start.ticks ? double(stop.steady - start.steady) / (stop.ticks - start.ticks) : 1.0;
+            return (int64_t(aTicks - start.ticks) * sScale) / 1000.0;
+        }
+    };
+
+    class Manager;
+    inline std::atomic<Manager*>    g_Manager = nullptr;
+    inline thread_local Ring*       g_Ring    = nullptr;
+    inline thread_local std::shared_ptr<Ring> g_Holder;
+
+    class Manager : boost::noncopyable
+    {
+        const size_t m_Size;
+        const Clock  m_Start = Clock::now();
+
+        mutable std::mutex                 m_Mutex;
+        std::vector<std::shared_ptr<Ring>> m_Rings;
+
+    public:
+        // aSize: events per thread, power of 2. 32 bytes each
+        explicit Manager(size_t aSize = 1 << 16)
+        : m_Size(aSize)
+        {
+            Manager* sExpected = nullptr;
+            if (!g_Manager.compare_exchange_strong(sExpected, this))
+                throw std::logic_error("Trace: manager already exists");
+        }
+
+        ~Manager()
+        {
+            g_Manager = nullptr;
+            std::unique_lock sLock(m_Mutex);
+            for (auto& x : m_Rings)
+                x->disable();
+        }
+
+        // register current thread. unnamed threads registered on first event
+        Ring* thread(const std::string& aName)
+        {
+            if (g_Ring != nullptr and g_Ring->enabled())
+                return g_Ring;
+            auto sRing = std::make_shared<Ring>(m_Size, aName);
+            {
+                std::unique_lock sLock(m_Mutex);
+                // forget rings of finished threads
+                std::erase_if(m_Rings, [](const auto& x) { return x.use_count() == 1; });
+                m_Rings.push_back(sRing);
+            }
+            g_Holder = sRing;
+            g_Ring   = sRing.get();
+            return g_Ring;
+        }
+
+        Snapshot snapshot() const
+        {
+            Snapshot sResult;
+            sResult.start = m_Start;
+            sResult.pid   = getpid();
+
+            std::unique_lock sLock(m_Mutex);
+            for (auto& x : m_Rings) {
+                Snapshot::Thread sThread{.tid = x->m_Tid, .name = x->m_Name, .events = {}};
+                x->copy(sThread.events);
+                sResult.threads.push_back(std::move(sThread));
+            }
+            sLock.unlock();
+
+            sResult.names = Names::instance().list();
+            sResult.stop  = Clock::now();
+            return sResult;
+        }
+    };
+
+    inline Ring* attach()
+    {
+        Manager* sManager = g_Manager.load(std::memory_order_acquire);
+        if (sManager == nullptr)
+            return nullptr;
+        return sManager->thread({});
+    }
+
+    // ring of current thread or nullptr if tracing disabled
+    inline Ring* ring()
+    {
+        Ring* sRing = g_Ring;
+        if (sRing != nullptr and sRing->enabled()) [[likely]]
+            return sRing;
+        return attach();
+    }
+
+    inline void counter(uint32_t aId, uint64_t aValue)
+    {
+        if (Ring* sRing = ring())
+            sRing->push({.ticks = ticks(), .value = aValue, .id = aId, .kind = Event::COUNTER});
+    }
+
+    inline void mark(uint32_t aId)
+    {
+        if (Ring* sRing = ring())
+            sRing->push({.ticks = ticks(), .id = aId, .kind = Event::MARK});
+    }
+
+    // duration event written on scope exit.
+    // end probe fired even if tracing disabled: usdt consumers don't need Manager
+    class Scope : boost::noncopyable
+    {
+        Ring* const    m_Ring = ring();
+        const uint32_t m_Id;
+        const uint64_t m_Start = (TRACE_SDT or m_Ring) ? ticks() : 0;
+
+    public:
+        explicit Scope(uint32_t aId)
+        : m_Id(aId)
+        {}
+
+        ~Scope()
+        {
+            if (!TRACE_SDT and m_Ring == nullptr)
+                return;
+            const uint64_t sDuration = ticks() - m_Start;
+            TRACE_SDT_END(m_Id, sDuration);
+            if (m_Ring != nullptr and m_Ring->enabled())
+                m_Ring->push({.ticks = m_Start, .duration = sDuration, .id = m_Id, .kind = Event::DURATION});
+        }
+    };
+
+    inline std::string Snapshot::serialize() const
+    {
+        std::string sOut;
+        auto        sPut = [&sOut](const auto& aValue) { sOut.append(reinterpret_cast<const char*>(&aValue), sizeof(aValue)); };
+        auto        sStr = [&](const std::string& aValue) {
+            sPut(uint32_t(aValue.size()));
+            sOut.append(aValue);
+        };
+
+        sPut(MAGIC);
+        sPut(start);
+        sPut(stop);
+        sPut(int32_t(pid));
+        sPut(uint32_t(names.size()));
+        for (auto& [sCat, sName] : names) {
+            sStr(sCat);
+            sStr(sName);
+        }
+        sPut(uint32_t(threads.size()));
+        for (auto& x : threads) {
+            sPut(int32_t(x.tid));
+            sStr(x.name);
+            sPut(uint64_t(x.events.size()));
+            sOut.append(reinterpret_cast<const char*>(x.events.data()), x.events.size() * sizeof(Event));
+        }
+        return sOut;
+    }
+
+    inline Snapshot Snapshot::parse(std::string_view aData)
+    {
+        auto sGet = [&aData](auto& aValue) {
+            if (aData.size() < sizeof(aValue))
+                throw std::runtime_error("Trace: truncated snapshot");
+            memcpy(&aValue, aData.data(), sizeof(aValue));
+            aData.remove_prefix(sizeof(aValue));
+        };
+        auto sStr = [&](std::string& aValue) {
+            uint32_t sSize = 0;
+            sGet(sSize);
+            if (aData.size() < sSize)
+                throw std::runtime_error("Trace: truncated snapshot");
+            aValue.assign(aData.substr(0, sSize));
+            aData.remove_prefix(sSize);
+        };
+
+        Snapshot sResult;
+        uint32_t sMagic = 0;
+        sGet(sMagic);
+        if (sMagic != MAGIC)
+            throw std::runtime_error("Trace: bad snapshot magic");
+        sGet(sResult.start);
+        sGet(sResult.stop);
+        int32_t sPid = 0;
+        sGet(sPid);
+        sResult.pid = sPid;
+
+        uint32_t sCount = 0;
+        sGet(sCount);
+        sResult.names.resize(sCount);
+        for (auto& [sCat, sName] : sResult.names) {
+            sStr(sCat);
+            sStr(sName);
+        }
+        sGet(sCount);
+        sResult.threads.resize(sCount);
+        for (auto& x : sResult.threads) {
+            int32_t  sTid    = 0;
+            uint64_t sEvents = 0;
+            sGet(sTid);
+            x.tid = sTid;
+            sStr(x.name);
+            sGet(sEvents);
+            if (aData.size() / sizeof(Event) < sEvents)
+                throw std::runtime_error("Trace: truncated snapshot");
+            x.events.resize(sEvents);
+            memcpy(x.events.data(), aData.data(), sEvents * sizeof(Event));
+            aData.remove_prefix(sEvents * sizeof(Event));
+        }
+        return sResult;
+    }
+
+    namespace aux {
+        inline void escape(std::ostream& aOut, std::string_view aStr)
+        {
+            aOut << '"';
+            for (char c : aStr) {
+                switch (c) {
+                case '"': aOut << "\\\""; break;
+                case '\\': aOut << "\\\\"; break;
+                case '\n': aOut << "\\n"; break;
+                case '\t': aOut << "\\t"; break;
+                default:
+                    if (uint8_t(c) < 0x20) {
+                        char sTmp[8];
+                        snprintf(sTmp, sizeof(sTmp), "\\u%04x", c);
+                        aOut << sTmp;
+                    } else
+                        aOut << c;
+                }
+            }
+            aOut << '"';
+        }
+    } // namespace aux
+
+    // chrome trace json, same layout as Catapult::Manager writes
+    inline void to_chrome(const Snapshot& aSnapshot, std::ostream& aOut)
+    {
+        aOut << R"({"beginningOfTime":)" << aSnapshot.start.realtime / 1000 << R"(,"traceEvents":[)" << '\n';
+        bool sComma = false;
+        auto sBegin = [&](pid_t aTid, const char* aPhase, double aTs) {
+            if (sComma)
+                aOut << ",\n";
+            sComma = true;
+            aOut << R"({"pid":)" << aSnapshot.pid << R"(,"tid":)" << aTid << R"(,"ph":")" << aPhase << R"(","ts":)" << aTs;
+        };
+
+        aOut.precision(3);
+        aOut << std::fixed;
+        for (auto& sThread : aSnapshot.threads) {
+            for (auto& x : sThread.events) {
+                if (x.id >= aSnapshot.names.size())
+                    continue;
+                const auto& [sCat, sName] = aSnapshot.names[x.id];
+                switch (x.kind) {
+                case Event::DURATION:
+                    sBegin(sThread.tid, "X", aSnapshot.to_us(x.ticks));
+                    aOut << R"(,"dur":)" << aSnapshot.to_us(aSnapshot.start.ticks + x.duration);
+                    break;
+                case Event::COUNTER:
+                    sBegin(sThread.tid, "C", aSnapshot.to_us(x.ticks));
+                    aOut << R"(,"args":{"value":)" << x.value << '}';
+                    break;
+                case Event::MARK:
+                    sBegin(sThread.tid, "I", aSnapshot.to_us(x.ticks));
+                    aOut << R"(,"s":"g")";
+                    break;
+                default: continue;
+                }
+                aOut << R"(,"cat":)";
+                aux::escape(aOut, sCat);
+                aOut << R"(,"name":)";
+                aux::escape(aOut, sName);
+                aOut << '}';
+            }
+        }
+        for (auto& sThread : aSnapshot.threads) {
+            if (sThread.name.empty())
+                continue;
+            sBegin(sThread.tid, "M", 0);
+            aOut << R"(,"cat":"__metadata","name":"thread_name","args":{"name":)";
+            aux::escape(aOut, sThread.name);
+            aOut << "}}";
+        }
+        aOut << "\n]}";
+    }
+
+} // namespace Profile::Trace
+
+// id cached in call site, so category and name must be same for every call
+#define TRACE_ID(c, n) []() { static const uint32_t sId = Profile::Trace::intern(c, n); return sId; }()
+
+#define TRACE_THREAD(x)                                                            \
+    do {                                                                           \
+        if (auto sTraceManager = Profile::Trace::g_Manager.load(); sTraceManager) \
+            sTraceManager->thread(x);                                              \
+    } while (0)
+
+#define TRACE_EVENT(c, n)    \
+    TRACE_SDT_BEGIN(c, n);   \
+    Profile::Trace::Scope sTraceScope(TRACE_ID(c, n));
+
+#define TRACE_COUNTER(c, n, v)                      \
+    do {                                            \
+        TRACE_SDT_COUNTER(c, n, v);                 \
+        Profile::Trace::counter(TRACE_ID(c, n), v); \
+    } while (0)
+
+#define TRACE_MARK(c, n)                      \
+    do {                                      \
+        TRACE_SDT_MARK(c, n);                 \
+        Profile::Trace::mark(TRACE_ID(c, n)); \
+    } while (0)
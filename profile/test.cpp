@@ -4,7 +4,9 @@
 #define CATAPULT_PROFILE
 #include "Catapult.hpp"
 #include "Profile.hpp"
+#include "Trace.hpp"
 
+#include <parser/Json.hpp>
 #include <threads/Group.hpp>
 #include <time/Meter.hpp>
 
@@ -89,3 +91,105 @@ BOOST_AUTO_TEST_CASE(simple)
     sGroup.wait();
 }
 BOOST_AUTO_TEST_SUITE_END() // catapult
+
+BOOST_AUTO_TEST_SUITE(trace)
+BOOST_AUTO_TEST_CASE(simple)
+{
+    Profile::Trace::Manager sManager(1024);
+    TRACE_THREAD("main");
+    {
+        TRACE_EVENT("step 1", "outer")
+        {
+            TRACE_EVENT("step 1", "inner")
+            TRACE_COUNTER("step 1", "value", 42);
+        }
+        std::thread([]() {
+            TRACE_THREAD("worker");
+            TRACE_MARK("step 2", "in thread");
+        }).join();
+    }
+
+    const auto sSnapshot = Profile::Trace::Snapshot::parse(sManager.snapshot().serialize());
+    BOOST_REQUIRE_EQUAL(sSnapshot.threads.size(), 2);
+    BOOST_CHECK_EQUAL(sSnapshot.threads[0].name, "main");
+    BOOST_CHECK_EQUAL(sSnapshot.threads[1].name, "worker");
+
+    const auto& sMain = sSnapshot.threads[0].events;
+    BOOST_REQUIRE_EQUAL(sMain.size(), 3);
+    BOOST_CHECK_EQUAL(sMain[0].kind, Profile::Trace::Event::COUNTER);
+    BOOST_CHECK_EQUAL(sMain[0].value, 42);
+    BOOST_CHECK_EQUAL(sSnapshot.names[sMain[1].id].second, "inner");
+    BOOST_CHECK_EQUAL(sSnapshot.names[sMain[2].id].second, "outer");
+    BOOST_CHECK(sMain[2].ticks <= sMain[1].ticks);
+    BOOST_CHECK(sMain[2].duration >= sMain[1].duration);
+
+    std::stringstream sJson;
+    Profile::Trace::to_chrome(sSnapshot, sJson);
+    BOOST_TEST_MESSAGE(sJson.str());
+    const auto sValue = Parser::Json::parse(sJson.str());
+    BOOST_CHECK_EQUAL(sValue["traceEvents"].size(), 6); // 4 events and 2 thread names
+}
+BOOST_AUTO_TEST_CASE(overwrite)
+{
+    Profile::Trace::Manager sManager(1024);
+    for (unsigned i = 0; i < 3000; i++)
+        TRACE_COUNTER("overwrite", "i", i);
+
+    auto sSnapshot = sManager.snapshot();
+    BOOST_REQUIRE_EQUAL(sSnapshot.threads.size(), 1);
+    const auto& sEvents = sSnapshot.threads[0].events;
+    BOOST_REQUIRE_EQUAL(sEvents.size(), 1024);
+    BOOST_CHECK_EQUAL(sEvents.front().value, 3000 - 1024);
+    BOOST_CHECK_EQUAL(sEvents.back().value, 2999);
+}
+BOOST_AUTO_TEST_CASE(concurrent)
+{
+    // snapshot while threads overwrite rings: every event must be complete
+    Profile::Trace::Manager sManager(256);
+    std::atomic_bool        sStop{false};
+    Threads::Group          sGroup;
+    sGroup.start(
+        [&]() {
+            for (uint64_t i = 0; !sStop; i++)
+                TRACE_COUNTER("concurrent", "i", i);
+        },
+        4);
+    size_t sChecked = 0;
+    for (unsigned i = 0; i < 100 or sChecked < 10000; i++) {
+        for (auto& x : sManager.snapshot().threads) {
+            for (size_t j = 1; j < x.events.size(); j++)
+                BOOST_REQUIRE_EQUAL(x.events[j].value, x.events[j - 1].value + 1);
+            sChecked += x.events.size();
+        }
+    }
+    sStop = true;
+    sGroup.wait();
+}
+BOOST_AUTO_TEST_CASE(overhead)
+{
+    constexpr unsigned N = 1000000;
+    auto sMeasure = [](auto&& aFunc) {
+        Time::Meter sMeter;
+        for (unsigned i = 0; i < N; i++)
+            aFunc();
+        return sMeter.get().to_double() * 1e9 / N;
+    };
+    const double sDisabled = sMeasure([]() { TRACE_EVENT("overhead", "event") });
+    double       sEnabled  = 0;
+    {
+        Profile::Trace::Manager sManager;
+        sEnabled = sMeasure([]() { TRACE_EVENT("overhead", "event") });
+    }
+    double sJson = 0;
+    {
+        Threads::Group sGroup;
+        CATAPULT_MANAGER("/tmp/__profile_overhead.json")
+        CATAPULT_START(sGroup);
+        CATAPULT_THREAD("main")
+        sJson = sMeasure([]() { CATAPULT_EVENT("overhead", "event") });
+        CATAPULT_DONE()
+        sGroup.wait();
+    }
+    BOOST_TEST_MESSAGE("ns per event: disabled " << sDisabled << ", binary " << sEnabled << ", json " << sJson);
+}
+BOOST_AUTO_TEST_SUITE_END() // trace
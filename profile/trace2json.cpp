@@ -0,0 +1,36 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "Trace.hpp"
+
+// convert binary trace (Trace::Snapshot) to chrome trace json
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <trace.bin> [trace.json]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream sInput(argv[1], std::ios::binary);
+    if (!sInput) {
+        std::cerr << "fail to open " << argv[1] << std::endl;
+        return 1;
+    }
+    std::stringstream sData;
+    sData << sInput.rdbuf();
+
+    try {
+        const auto sSnapshot = Profile::Trace::Snapshot::parse(sData.str());
+        if (argc > 2) {
+            std::ofstream sOutput(argv[2], std::ios::trunc);
+            Profile::Trace::to_chrome(sSnapshot, sOutput);
+        } else {
+            Profile::Trace::to_chrome(sSnapshot, std::cout);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -20,8 +20,7 @@ namespace Prometheus {
                 aResponse.result(http::status::method_not_allowed);
                 return;
             }
-            for (auto& x : Manager::instance().toPrometheus())
-                aResponse.body().append(x).append("\n");
+            Manager::instance().write(aResponse.body());
             aResponse.set(http::field::content_type, "text/plain");
             aResponse.result(http::status::ok);
         });
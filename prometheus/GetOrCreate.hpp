@@ -1,36 +1,91 @@
 #pragma once
 
+#include <array>
+#include <functional>
 #include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <typeindex>
 
-#include <boost/any.hpp>
 #include <boost/core/noncopyable.hpp>
 
 #include "Metrics.hpp"
 
 namespace Prometheus {
+
+    // label set (full metric name) with precomputed hash.
+    // build once and reuse to skip hashing on every lookup.
+    struct Key
+    {
+        std::string_view name;
+        size_t           hash;
+
+        Key(std::string_view aName)
+        : name(aName)
+        , hash(std::hash<std::string_view>{}(aName))
+        {}
+        Key(const std::string& aName)
+        : Key(std::string_view(aName))
+        {}
+        Key(const char* aName)
+        : Key(std::string_view(aName))
+        {}
+    };
+
+    // metrics interned by name in sharded maps.
+    // lookup of existing metric takes only shared lock on one shard.
     class GetOrCreate : public boost::noncopyable
     {
-        using Lock = std::unique_lock<std::mutex>;
-        std::mutex m_Mutex;
+        static constexpr unsigned SHARDS = 16;
+
+        struct Entry
+        {
+            std::shared_ptr<void> metric;
+            std::type_index       type;
+        };
+
+        struct Shard
+        {
+            mutable std::shared_mutex                 mutex;
+            std::map<std::string, Entry, std::less<>> map;
+        };
+        std::array<Shard, SHARDS> m_Shards;
 
-        std::map<std::string, boost::any> m_Map;
+        template <class T>
+        static T* cast(const Entry& aEntry)
+        {
+            if (aEntry.type != typeid(T))
+                throw std::invalid_argument("Prometheus: metric type mismatch");
+            return static_cast<T*>(aEntry.metric.get());
+        }
 
     public:
         template <class T>
-        T* get(const std::string& aName)
+        T* get(const Key& aKey)
         {
-            Lock sLock(m_Mutex);
-            using Ptr  = std::shared_ptr<T>;
-            auto& sVal = m_Map[aName];
-            if (sVal.empty())
-                sVal = std::make_shared<T>(aName);
-            return boost::any_cast<Ptr>(sVal).get();
+            auto& sShard = m_Shards[aKey.hash % SHARDS];
+            {
+                std::shared_lock sLock(sShard.mutex);
+                if (auto sIt = sShard.map.find(aKey.name); sIt != sShard.map.end())
+                    return cast<T>(sIt->second);
+            }
+            std::unique_lock sLock(sShard.mutex);
+            auto             sIt = sShard.map.find(aKey.name);
+            if (sIt == sShard.map.end()) {
+                std::string sName(aKey.name);
+                auto        sMetric = std::make_shared<T>(sName);
+                sIt                 = sShard.map.emplace(std::move(sName), Entry{std::move(sMetric), typeid(T)}).first;
+            }
+            return cast<T>(sIt->second);
         }
 
-        void erase(const std::string& aName)
+        void erase(const Key& aKey)
         {
-            Lock sLock(m_Mutex);
-            m_Map.erase(aName);
+            auto&            sShard = m_Shards[aKey.hash % SHARDS];
+            std::unique_lock sLock(sShard.mutex);
+            if (auto sIt = sShard.map.find(aKey.name); sIt != sShard.map.end())
+                sShard.map.erase(sIt);
         }
     };
-} // namespace Prometheus
\ No newline at end of file
+} // namespace Prometheus
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
+#include <cstring>
+#include <limits>
 
 #include <unsorted/Random.hpp>
 
@@ -78,4 +82,125 @@ namespace Prometheus {
             m_Max = 0;
         }
     };
+
+    // log-linear buckets (HDR style): 2^SUB_BITS linear buckets per power of 2,
+    // relative error about 2^-(SUB_BITS+1). lock-free tick, mergeable.
+    template <unsigned SUB_BITS = 5, int MIN_EXP = -24, int MAX_EXP = 40>
+    class LogHistogramm
+    {
+        static constexpr unsigned SUB     = 1u << SUB_BITS;
+        static constexpr unsigned BUCKETS = (MAX_EXP - MIN_EXP) * SUB + 1; // bucket 0 for zero and negative values
+
+        std::array<std::atomic<uint64_t>, BUCKETS> m_Count{};
+        std::atomic<double>                        m_Min{std::numeric_limits<double>::max()};
+        std::atomic<double>                        m_Max{std::numeric_limits<double>::lowest()};
+
+        // exponent and top mantissa bits taken from IEEE 754 representation
+        static unsigned index(double aValue)
+        {
+            if (!(aValue > 0))
+                return 0;
+            uint64_t sBits;
+            std::memcpy(&sBits, &aValue, sizeof(sBits));
+            const int sExp = int(sBits >> 52) - 1022; // as in frexp: mantissa in [0.5, 1)
+            if (sExp < MIN_EXP)
+                return 1;
+            if (sExp >= MAX_EXP)
+                return BUCKETS - 1;
+            const unsigned sSub = (sBits >> (52 - SUB_BITS)) & (SUB - 1);
+            return 1 + (sExp - MIN_EXP) * SUB + sSub;
+        }
+
+        // bucket middle
+        static double value(unsigned aIndex)
+        {
+            if (aIndex == 0)
+                return 0;
+            aIndex--;
+            const int    sExp  = MIN_EXP + int(aIndex / SUB);
+            const double sMant = 0.5 + (aIndex % SUB + 0.5) / (2 * SUB);
+            return std::ldexp(sMant, sExp);
+        }
+
+        static void update_min(std::atomic<double>& aMin, double aValue)
+        {
+            double sCurrent = aMin.load(std::memory_order_relaxed);
+            while (aValue < sCurrent and !aMin.compare_exchange_weak(sCurrent, aValue, std::memory_order_relaxed))
+                ;
+        }
+
+        static void update_max(std::atomic<double>& aMax, double aValue)
+        {
+            double sCurrent = aMax.load(std::memory_order_relaxed);
+            while (aValue > sCurrent and !aMax.compare_exchange_weak(sCurrent, aValue, std::memory_order_relaxed))
+                ;
+        }
+
+    public:
+        void tick(double aValue, uint64_t aCount = 1)
+        {
+            m_Count[index(aValue)].fetch_add(aCount, std::memory_order_relaxed);
+            update_min(m_Min, aValue);
+            update_max(m_Max, aValue);
+        }
+
+        uint64_t count() const
+        {
+            uint64_t sCount = 0;
+            for (auto& x : m_Count)
+                sCount += x.load(std::memory_order_relaxed);
+            return sCount;
+        }
+
+        void merge(const LogHistogramm& aOther)
+        {
+            for (unsigned i = 0; i < BUCKETS; i++)
+                if (auto sCount = aOther.m_Count[i].load(std::memory_order_relaxed); sCount > 0)
+                    m_Count[i].fetch_add(sCount, std::memory_order_relaxed);
+            update_min(m_Min, aOther.m_Min.load(std::memory_order_relaxed));
+            update_max(m_Max, aOther.m_Max.load(std::memory_order_relaxed));
+        }
+
+        template <class P>
+        auto quantile(const P& aParam) const -> P
+        {
+            P              sResult{};
+            const uint64_t sTotal = count();
+            if (sTotal == 0)
+                return sResult;
+            const double sMin = m_Min.load(std::memory_order_relaxed);
+            const double sMax = m_Max.load(std::memory_order_relaxed);
+
+            for (unsigned i = 0; i < aParam.size(); i++) {
+                const auto sPhi = aParam[i];
+                if (sPhi <= 0) {
+                    sResult[i] = sMin;
+                    continue;
+                }
+                if (sPhi >= 1) {
+                    sResult[i] = sMax;
+                    continue;
+                }
+                const uint64_t sRank = std::round(sPhi * (sTotal - 1));
+                uint64_t       sSeen = 0;
+                unsigned       j     = 0;
+                for (; j < BUCKETS; j++) {
+                    sSeen += m_Count[j].load(std::memory_order_relaxed);
+                    if (sSeen > sRank)
+                        break;
+                }
+                sResult[i] = std::clamp(value(std::min(j, BUCKETS - 1)), sMin, sMax);
+            }
+            return sResult;
+        }
+
+        // concurrent tick can be lost
+        void clear()
+        {
+            for (auto& x : m_Count)
+                x.store(0, std::memory_order_relaxed);
+            m_Min.store(std::numeric_limits<double>::max(), std::memory_order_relaxed);
+            m_Max.store(std::numeric_limits<double>::lowest(), std::memory_order_relaxed);
+        }
+    };
 } // namespace Prometheus
@@ -16,6 +16,7 @@ namespace Prometheus {
 
         MetricFace(std::string&& aName);
         virtual std::string format() const = 0;
+        virtual void        append(std::string& aOut) const { aOut.append(format()); }
         virtual ~MetricFace();
     };
 
@@ -87,6 +88,19 @@ namespace Prometheus {
             return format([](auto x) { return x->m_Name + ' ' + x->format(); });
         }
 
+        // exposition format written into one buffer, without temporary strings
+        void write(std::string& aOut) const
+        {
+            Lock lk(m_Mutex);
+            aOut.reserve(aOut.size() + m_Set.size() * 64);
+            for (auto x : m_Set) {
+                aOut.append(x->m_Name);
+                aOut.push_back(' ');
+                x->append(aOut);
+                aOut.push_back('\n');
+            }
+        }
+
         // refresh complex metrics (Time, Common)
         void onTimer()
         {
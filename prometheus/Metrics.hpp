@@ -2,7 +2,9 @@
 
 #include <time.h>
 
+#include <array>
 #include <atomic>
+#include <charconv>
 
 #include "Histogramm.hpp"
 #include "Manager.hpp"
@@ -48,10 +50,51 @@ namespace Prometheus {
         return aName;
     }
 
+    namespace Striped {
+        inline constexpr unsigned STRIPES = 16;
+
+        // stripe assigned to thread on first use, round robin
+        inline unsigned index()
+        {
+            static std::atomic<unsigned> sNext{0};
+            thread_local const unsigned  sIndex = sNext.fetch_add(1, std::memory_order_relaxed) % STRIPES;
+            return sIndex;
+        }
+
+        template <class T>
+        void add(std::atomic<T>& aValue, T aInc)
+        {
+            if constexpr (std::is_integral_v<T>) {
+                aValue.fetch_add(aInc, std::memory_order_relaxed);
+            } else {
+                T sCurrent = aValue.load(std::memory_order_relaxed);
+                while (!aValue.compare_exchange_weak(sCurrent, sCurrent + aInc, std::memory_order_relaxed))
+                    ;
+            }
+        }
+
+        template <class T>
+        void append(std::string& aOut, T aValue)
+        {
+            std::array<char, 64> sBuf;
+            std::to_chars_result sResult;
+            if constexpr (std::is_integral_v<T>)
+                sResult = std::to_chars(sBuf.data(), sBuf.data() + sBuf.size(), aValue);
+            else // same as std::to_string
+                sResult = std::to_chars(sBuf.data(), sBuf.data() + sBuf.size(), aValue, std::chars_format::fixed, 6);
+            aOut.append(sBuf.data(), sResult.ptr);
+        }
+    } // namespace Striped
+
+    // every thread updates own cache line, format() sums stripes
     template <class T = uint64_t>
     class Counter : public MetricFace
     {
-        std::atomic<T> m_Value{0};
+        struct alignas(64) Cell
+        {
+            std::atomic<T> value{0};
+        };
+        std::array<Cell, Striped::STRIPES> m_Value;
 
     public:
         template <class... G>
@@ -60,11 +103,27 @@ namespace Prometheus {
         {
         }
 
-        void tick() { m_Value++; }
-        void inc(T v) { m_Value += v; }
-        void set(T v) { m_Value = v; }
+        void tick() { Striped::add(m_Value[Striped::index()].value, T(1)); }
+        void inc(T v) { Striped::add(m_Value[Striped::index()].value, v); }
+
+        // gauge usage, not expected to run concurrently with inc()
+        void set(T v)
+        {
+            m_Value[0].value.store(v, std::memory_order_relaxed);
+            for (unsigned i = 1; i < Striped::STRIPES; i++)
+                m_Value[i].value.store(0, std::memory_order_relaxed);
+        }
+
+        T get() const
+        {
+            T sSum{0};
+            for (auto& x : m_Value)
+                sSum += x.value.load(std::memory_order_relaxed);
+            return sSum;
+        }
 
-        std::string format() const override { return std::to_string(m_Value); }
+        std::string format() const override { return std::to_string(get()); }
+        void        append(std::string& aOut) const override { Striped::append(aOut, get()); }
     };
 
     class Age : public MetricFace
@@ -89,12 +148,11 @@ namespace Prometheus {
 
     class Time : public ComplexFace
     {
-        using Lock = std::unique_lock<std::mutex>;
-        mutable std::mutex m_Mutex;
-
-        Histogramm m_Data1;
-        Histogramm m_Data2;
-        bool       m_Actual1 = true;
+        // account() ticks both histogramms, update() reads and clears the actual one.
+        // so quantiles cover data from 1 or 2 timer periods.
+        LogHistogramm<>   m_Data1;
+        LogHistogramm<>   m_Data2;
+        std::atomic<bool> m_Actual1{true};
 
         Counter<double> m_50;
         Counter<double> m_90;
@@ -113,7 +171,6 @@ namespace Prometheus {
 
         void account(double v)
         {
-            Lock lk(m_Mutex);
             m_Data1.tick(v);
             m_Data2.tick(v);
         }
@@ -122,16 +179,11 @@ namespace Prometheus {
         {
             constexpr std::array<double, 4> m_Prob{0.5, 0.9, 0.99, 1.0};
 
-            Histogramm sTmp;
-            {
-                Lock  lk(m_Mutex);
-                auto& sActual = m_Actual1 ? m_Data1 : m_Data2;
-                sTmp          = std::move(sActual);
-                sActual.clear();
-                m_Actual1 = !m_Actual1;
-            }
+            auto&      sActual = m_Actual1 ? m_Data1 : m_Data2;
+            const auto sResult = sActual.quantile(m_Prob);
+            sActual.clear();
+            m_Actual1 = !m_Actual1;
 
-            const auto sResult = sTmp.quantile(m_Prob);
             m_50.set(sResult[0]);
             m_90.set(sResult[1]);
             m_99.set(sResult[2]);
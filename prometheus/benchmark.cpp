@@ -1,21 +1,101 @@
 #include <benchmark/benchmark.h>
 
+#include <mutex>
+
+#include "GetOrCreate.hpp"
 #include "Metrics.hpp"
 
 static void BM_Tick(benchmark::State& state)
 {
-    Prometheus::Counter sCounter("not used");
+    static Prometheus::Counter sCounter("not used");
     for (auto _ : state)
         sCounter.tick();
 }
-BENCHMARK(BM_Tick)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK(BM_Tick)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime();
+
+// single shared atomic, as reference for striped counter
+static void BM_Atomic(benchmark::State& state)
+{
+    static std::atomic<uint64_t> sCounter{0};
+    for (auto _ : state)
+        sCounter.fetch_add(1, std::memory_order_relaxed);
+}
+BENCHMARK(BM_Atomic)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime();
 
 static void BM_Time(benchmark::State& state)
 {
-    Prometheus::Time sTime("not used");
+    static Prometheus::Time sTime("not used");
+    double                  sValue = 0.001;
+    for (auto _ : state) {
+        sTime.account(sValue);
+        sValue += 0.001;
+    }
+}
+BENCHMARK(BM_Time)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime();
+
+// reservoir histogramm behind mutex, as Time was implemented before
+static void BM_Reservoir(benchmark::State& state)
+{
+    static std::mutex             sMutex;
+    static Prometheus::Histogramm sHistogramm;
+    double                        sValue = 0.001;
+    for (auto _ : state) {
+        std::unique_lock sLock(sMutex);
+        sHistogramm.tick(sValue);
+        sValue += 0.001;
+    }
+}
+BENCHMARK(BM_Reservoir)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime();
+
+static void BM_Quantile(benchmark::State& state)
+{
+    constexpr std::array<double, 4> sProb{0.5, 0.9, 0.99, 1.0};
+    Prometheus::LogHistogramm<>     sHistogramm;
+    for (unsigned i = 1; i <= 100000; i++)
+        sHistogramm.tick(i * 0.001);
     for (auto _ : state)
-        sTime.account(1);
+        benchmark::DoNotOptimize(sHistogramm.quantile(sProb));
+}
+BENCHMARK(BM_Quantile);
+
+static void BM_GetOrCreate(benchmark::State& state)
+{
+    static Prometheus::GetOrCreate sStore;
+    const Prometheus::Key          sKey(R"(requests{handler="/api/v1/query",code="200"})");
+    for (auto _ : state)
+        sStore.get<Prometheus::Counter<>>(sKey)->tick();
+}
+BENCHMARK(BM_GetOrCreate)->Threads(1)->Threads(4)->Threads(16)->UseRealTime();
+
+static void BM_Write(benchmark::State& state)
+{
+    std::vector<std::unique_ptr<Prometheus::Counter<>>> sList;
+    for (unsigned i = 0; i < 1000; i++)
+        sList.push_back(std::make_unique<Prometheus::Counter<>>("metric", std::make_pair("id", std::to_string(i))));
+
+    std::string sBuffer;
+    for (auto _ : state) {
+        sBuffer.clear();
+        Prometheus::Manager::instance().write(sBuffer);
+        benchmark::DoNotOptimize(sBuffer.data());
+    }
+    state.SetBytesProcessed(state.iterations() * sBuffer.size());
+}
+BENCHMARK(BM_Write);
+
+static void BM_ToPrometheus(benchmark::State& state)
+{
+    std::vector<std::unique_ptr<Prometheus::Counter<>>> sList;
+    for (unsigned i = 0; i < 1000; i++)
+        sList.push_back(std::make_unique<Prometheus::Counter<>>("metric", std::make_pair("id", std::to_string(i))));
+
+    for (auto _ : state) {
+        std::string sBuffer;
+        for (auto& x : Prometheus::Manager::instance().toPrometheus())
+            sBuffer.append(x).append("\n");
+        benchmark::DoNotOptimize(sBuffer.data());
+    }
 }
-BENCHMARK(BM_Time)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK(BM_ToPrometheus);
 
-BENCHMARK_MAIN();
\ No newline at end of file
+BENCHMARK_MAIN();
@@ -1,6 +1,9 @@
 #define BOOST_TEST_MODULE Suites
 #include <boost/test/unit_test.hpp>
 
+#include <map>
+#include <thread>
+
 #include "API.hpp"
 #include "Common.hpp"
 #include "GetOrCreate.hpp"
@@ -58,6 +61,48 @@ BOOST_AUTO_TEST_CASE(histogramm)
         sH.clear();
     }
 }
+BOOST_AUTO_TEST_CASE(log_histogramm)
+{
+    constexpr std::array<double, 5> sProb{0, 0.5, 0.9, 0.99, 1.0};
+
+    Prometheus::LogHistogramm<> sH;
+    for (unsigned i = 1; i <= 1000; i++)
+        sH.tick(i);
+    const auto sResult = sH.quantile(sProb);
+    BOOST_CHECK_EQUAL(sResult[0], 1);
+    BOOST_CHECK_CLOSE(sResult[1], 500, 2);
+    BOOST_CHECK_CLOSE(sResult[2], 900, 2);
+    BOOST_CHECK_CLOSE(sResult[3], 990, 2);
+    BOOST_CHECK_EQUAL(sResult[4], 1000);
+
+    // merge with same data: quantiles unchanged, count doubled
+    Prometheus::LogHistogramm<> sOther;
+    sOther.merge(sH);
+    sOther.merge(sH);
+    BOOST_CHECK_EQUAL(sOther.count(), 2000);
+    BOOST_CHECK_CLOSE(sOther.quantile(sProb)[2], 900, 2);
+
+    sH.clear();
+    BOOST_CHECK_EQUAL(sH.count(), 0);
+    BOOST_CHECK_EQUAL(sH.quantile(sProb)[1], 0);
+}
+BOOST_AUTO_TEST_CASE(striped)
+{
+    Prometheus::Counter<> sCounter("striped");
+    std::vector<std::thread> sThreads;
+    for (unsigned i = 0; i < 8; i++)
+        sThreads.emplace_back([&sCounter]() {
+            for (unsigned j = 0; j < 10000; j++)
+                sCounter.tick();
+        });
+    for (auto& x : sThreads)
+        x.join();
+    BOOST_CHECK_EQUAL(sCounter.get(), 80000);
+
+    std::string sOut;
+    Prometheus::Manager::instance().write(sOut);
+    BOOST_CHECK_EQUAL(sOut, "striped 80000\n");
+}
 BOOST_AUTO_TEST_CASE(time)
 {
     Prometheus::Time sTime("time");
@@ -65,10 +110,16 @@ BOOST_AUTO_TEST_CASE(time)
         sTime.account(i * 0.1);
     sTime.update();
 
-    const auto                     sActual   = Prometheus::Manager::instance().toPrometheus();
-    const Prometheus::Manager::Set sExpected = {
-        {"time{quantile=\"0.5\"} 5.050000"}, {"time{quantile=\"0.9\"} 8.950000"}, {"time{quantile=\"0.99\"} 9.850000"}, {"time{quantile=\"1.0\"} 10.000000"}};
-    BOOST_CHECK_EQUAL_COLLECTIONS(sActual.begin(), sActual.end(), sExpected.begin(), sExpected.end());
+    std::map<std::string, double> sActual;
+    for (auto& x : Prometheus::Manager::instance().toPrometheus()) {
+        const auto sPos = x.find(' ');
+        sActual[x.substr(0, sPos)] = std::stod(x.substr(sPos + 1));
+    }
+    BOOST_CHECK_EQUAL(sActual.size(), 4);
+    BOOST_CHECK_CLOSE(sActual["time{quantile=\"0.5\"}"], 5.05, 2);
+    BOOST_CHECK_CLOSE(sActual["time{quantile=\"0.9\"}"], 8.95, 2);
+    BOOST_CHECK_CLOSE(sActual["time{quantile=\"0.99\"}"], 9.85, 2);
+    BOOST_CHECK_EQUAL(sActual["time{quantile=\"1.0\"}"], 10);
 }
 BOOST_AUTO_TEST_CASE(router)
 {
@@ -95,6 +146,12 @@ BOOST_AUTO_TEST_CASE(get_or_create)
     sStore.get<T>("rps")->set(10);
     sStore.get<T>("rps")->tick();
     BOOST_CHECK_EQUAL(sStore.get<T>("rps")->format(), "11");
+
+    const Prometheus::Key sKey("rps");
+    BOOST_CHECK_EQUAL(sStore.get<T>(sKey)->get(), 11);
+    BOOST_CHECK_THROW(sStore.get<Prometheus::Counter<double>>(sKey), std::invalid_argument);
+    sStore.erase(sKey);
+    BOOST_CHECK_EQUAL(sStore.get<T>(sKey)->get(), 0);
 }
 BOOST_AUTO_TEST_CASE(notice)
 {
@@ -0,0 +1,409 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Reflection.hpp"
+
+#include <unsorted/Tcc.hpp>
+
+namespace Protobuf {
+
+    namespace FilterDetail {
+
+        template <class X>
+        struct is_optional : std::false_type
+        {};
+        template <class V>
+        struct is_optional<std::optional<V>> : std::true_type
+        {};
+
+        template <class V>
+        const char* c_type()
+        {
+            using U = typename std::conditional_t<std::is_enum_v<V>, std::underlying_type<V>, std::type_identity<V>>::type;
+            if constexpr (std::is_same_v<U, bool>)
+                return "_Bool";
+            else if constexpr (std::is_floating_point_v<U>)
+                return sizeof(U) == sizeof(float) ? "float" : "double";
+            else if constexpr (std::is_signed_v<U>)
+                return sizeof(U) == 1 ? "signed char" : sizeof(U) == 2 ? "short" : sizeof(U) == 4 ? "int" : "long long";
+            else
+                return sizeof(U) == 1 ? "unsigned char" : sizeof(U) == 2 ? "unsigned short" : sizeof(U) == 4 ? "unsigned int" : "unsigned long long";
+        }
+
+        // accessor generated by protobuf.j2: address of field value or nullptr if not set
+        using Thunk = const void* (*)(const void*);
+
+        // how to read field from message: accessor per path element
+        struct Access
+        {
+            std::vector<Thunk> path;
+            const char*        type = nullptr; // nullptr for message
+        };
+
+        template <class M>
+        void resolve(std::string aName, bool aHas, Access& aAccess)
+        {
+            std::string sRest;
+            if (auto sPos = aName.find('.'); sPos != std::string::npos) {
+                sRest = aName.substr(sPos + 1);
+                aName.erase(sPos);
+            }
+            auto sKey = M::GetReflectionKey(aName);
+            if (sKey == nullptr)
+                throw std::invalid_argument("Protobuf::Filter: field " + aName + " not found");
+
+            // only optional fields have accessor
+            const bool sFound = M::GetAccessorByID(sKey->id, [&](Thunk aThunk, auto aType) {
+                using V = typename decltype(aType)::type::value_type;
+                aAccess.path.push_back(aThunk);
+                if constexpr (Reflection<M>::template can_walk<V>::value) {
+                    if (sRest.empty()) {
+                        if (!aHas)
+                            throw std::invalid_argument("Protobuf::Filter: field " + aName + " is a message");
+                        return;
+                    }
+                    resolve<V>(sRest, aHas, aAccess);
+                } else if constexpr (std::is_arithmetic_v<V> or std::is_enum_v<V>) {
+                    if (!sRest.empty())
+                        throw std::invalid_argument("Protobuf::Filter: field " + aName + " is not a message");
+                    aAccess.type = c_type<V>();
+                } else {
+                    throw std::invalid_argument("Protobuf::Filter: field " + aName + " has not supported type");
+                }
+            });
+            if (!sFound)
+                throw std::invalid_argument("Protobuf::Filter: repeated field " + aName + " not supported");
+        }
+
+        // expression to C translator
+        class Parser
+        {
+            using Resolve = std::function<size_t(const std::string&, bool)>; // index of accessor function
+
+            const std::string& m_Input;
+            size_t             m_Pos = 0;
+            std::string        m_Token;
+            Resolve            m_Resolve;
+
+            [[noreturn]] void error(const std::string& aMsg) const
+            {
+                throw std::invalid_argument("Protobuf::Filter: " + aMsg + " at position " + std::to_string(m_Pos) + " in `" + m_Input + "`");
+            }
+
+            void next()
+            {
+                while (m_Pos < m_Input.size() and std::isspace(m_Input[m_Pos]))
+                    m_Pos++;
+                m_Token.clear();
+                if (m_Pos == m_Input.size())
+                    return;
+
+                const size_t sStart = m_Pos;
+                const char   c      = m_Input[m_Pos];
+                if (std::isalpha(c) or c == '_') {
+                    while (m_Pos < m_Input.size() and (std::isalnum(m_Input[m_Pos]) or m_Input[m_Pos] == '_' or m_Input[m_Pos] == '.'))
+                        m_Pos++;
+                } else if (std::isdigit(c) or c == '.') {
+                    while (m_Pos < m_Input.size() and (std::isalnum(m_Input[m_Pos]) or m_Input[m_Pos] == '.' or ((m_Input[m_Pos] == '-' or m_Input[m_Pos] == '+') and std::tolower(m_Input[m_Pos - 1]) == 'e')))
+                        m_Pos++;
+                } else {
+                    static const char* sOps[] = {"==", "!=", "<=", ">=", "&&", "||"};
+                    m_Pos++;
+                    for (auto x : sOps)
+                        if (m_Input.compare(sStart, 2, x) == 0)
+                            m_Pos = sStart + 2;
+                }
+                m_Token = m_Input.substr(sStart, m_Pos - sStart);
+            }
+
+            bool accept(std::initializer_list<const char*> aList)
+            {
+                for (auto x : aList)
+                    if (m_Token == x)
+                        return true;
+                return false;
+            }
+
+            void expect(const char* aToken)
+            {
+                if (m_Token != aToken)
+                    error(std::string("expected `") + aToken + "`");
+                next();
+            }
+
+            std::string number()
+            {
+                std::string sToken = m_Token;
+                next();
+                if (sToken.find_first_not_of("0123456789") == std::string::npos)
+                    return sToken + "LL";
+                char* sEnd = nullptr;
+                std::strtod(sToken.c_str(), &sEnd);
+                if (*sEnd != 0)
+                    error("bad number " + sToken);
+                return sToken;
+            }
+
+            std::string primary()
+            {
+                if (m_Token.empty())
+                    error("unexpected end");
+                if (accept({"("})) {
+                    next();
+                    auto sResult = orExpr();
+                    expect(")");
+                    return "(" + sResult + ")";
+                }
+                if (std::isdigit(m_Token[0]) or m_Token[0] == '.')
+                    return number();
+                if (accept({"true"})) {
+                    next();
+                    return "1";
+                }
+                if (accept({"false"})) {
+                    next();
+                    return "0";
+                }
+                if (accept({"has"})) {
+                    next();
+                    expect("(");
+                    auto sIndex = m_Resolve(m_Token, true);
+                    next();
+                    expect(")");
+                    return "(has" + std::to_string(sIndex) + "(M) != 0)";
+                }
+                if (std::isalpha(m_Token[0]) or m_Token[0] == '_') {
+                    auto sIndex = m_Resolve(m_Token, false);
+                    next();
+                    return "get" + std::to_string(sIndex) + "(M)";
+                }
+                error("unexpected `" + m_Token + "`");
+            }
+
+            std::string unary()
+            {
+                if (accept({"-"})) {
+                    next();
+                    return "(-" + unary() + ")";
+                }
+                if (accept({"!", "not"})) {
+                    next();
+                    return "(!" + unary() + ")";
+                }
+                return primary();
+            }
+
+            std::string product()
+            {
+                auto sResult = unary();
+                while (accept({"*", "/"})) {
+                    const bool sDiv = m_Token == "/";
+                    next();
+                    auto sRight = unary();
+                    // division in double: no traps on zero
+                    sResult = sDiv ? "((double)" + sResult + " / " + sRight + ")" : "(" + sResult + " * " + sRight + ")";
+                }
+                return sResult;
+            }
+
+            std::string sum()
+            {
+                auto sResult = product();
+                while (accept({"+", "-"})) {
+                    auto sOp = m_Token;
+                    next();
+                    sResult = "(" + sResult + " " + sOp + " " + product() + ")";
+                }
+                return sResult;
+            }
+
+            std::string compare()
+            {
+                auto sResult = sum();
+                if (accept({"==", "!=", "<", "<=", ">", ">="})) {
+                    auto sOp = m_Token;
+                    next();
+                    sResult = "(" + sResult + " " + sOp + " " + sum() + ")";
+                }
+                return sResult;
+            }
+
+            std::string andExpr()
+            {
+                auto sResult = compare();
+                while (accept({"and", "&&"})) {
+                    next();
+                    sResult = "(" + sResult + " && " + compare() + ")";
+                }
+                return sResult;
+            }
+
+            std::string orExpr()
+            {
+                auto sResult = andExpr();
+                while (accept({"or", "||"})) {
+                    next();
+                    sResult = "(" + sResult + " || " + andExpr() + ")";
+                }
+                return sResult;
+            }
+
+        public:
+            Parser(const std::string& aInput, Resolve&& aResolve)
+            : m_Input(aInput)
+            , m_Resolve(std::move(aResolve))
+            {
+            }
+
+            std::string parse()
+            {
+                next();
+                auto sResult = orExpr();
+                if (!m_Token.empty())
+                    error("unexpected `" + m_Token + "`");
+                return sResult;
+            }
+        };
+
+        // C functions for field paths: has<i> returns value address or 0, get<i> value or 0.
+        // accessors called through `accessors` table, filled by caller after compilation
+        inline std::string declare(const std::vector<Access>& aList)
+        {
+            size_t sCount = 0;
+            for (auto& x : aList)
+                sCount += x.path.size();
+
+            std::string sResult = "typedef const void* (*thunk)(const void*);\n"
+                                  "thunk accessors[" + std::to_string(std::max(sCount, size_t(1))) + "];\n";
+            size_t sThunk = 0;
+            for (size_t i = 0; i < aList.size(); i++) {
+                const auto sIndex = std::to_string(i);
+                sResult += "static const void* has" + sIndex + "(const void* p)\n"
+                           "{\n";
+                for (size_t j = 0; j < aList[i].path.size(); j++)
+                    sResult += "    p = accessors[" + std::to_string(sThunk++) + "](p);\n"
+                               "    if (!p) return 0;\n";
+                sResult += "    return p;\n"
+                           "}\n";
+                if (aList[i].type == nullptr)
+                    continue;
+                const std::string sType = aList[i].type;
+                sResult += "static " + sType + " get" + sIndex + "(const void* p)\n"
+                           "{\n"
+                           "    p = has" + sIndex + "(p);\n"
+                           "    return p ? *(const " + sType + "*)p : 0;\n"
+                           "}\n";
+            }
+            return sResult;
+        }
+
+        // tcc state is not thread safe
+        inline std::mutex& compiler_mutex()
+        {
+            static std::mutex sMutex;
+            return sMutex;
+        }
+    } // namespace FilterDetail
+
+    // filter expression over message fields, translated to C and compiled in memory with tcc.
+    // compiled code read fields from message object with accessors generated by protobuf.j2, without copies.
+    //
+    // syntax: field paths (m1.m2.id), numbers, true/false, + - * /, comparisons,
+    // and/or/not (&& || !), parentheses, has(path). missing fields read as 0.
+    // only std::optional scalar fields supported (not repeated or lazy).
+    template <class T>
+    class Filter
+    {
+        Util::TinyCompiler m_Compiler;
+        std::string        m_Code;
+
+        using One   = int (*)(const void*);
+        using Batch = void (*)(const void*, unsigned long, unsigned long, unsigned long long*);
+
+        One   m_One   = nullptr;
+        Batch m_Batch = nullptr;
+
+    public:
+        using Bitmap = std::vector<uint64_t>;
+
+        explicit Filter(const std::string& aExpr)
+        {
+            std::vector<FilterDetail::Access> sAccess;
+            std::map<std::string, size_t>     sIndex;
+
+            FilterDetail::Parser sParser(aExpr, [&sAccess, &sIndex](const std::string& aPath, bool aHas) {
+                FilterDetail::Access sTmp;
+                FilterDetail::resolve<T>(aPath, aHas, sTmp);
+                auto [sIt, sNew] = sIndex.try_emplace(aPath, sAccess.size());
+                if (sNew)
+                    sAccess.push_back(std::move(sTmp));
+                return sIt->second;
+            });
+            const std::string sExpr = sParser.parse();
+
+            m_Code = FilterDetail::declare(sAccess) +
+                     "int filter_one(const void* M)\n"
+                     "{\n"
+                     "    return " + sExpr + " ? 1 : 0;\n"
+                     "}\n"
+                     "void filter_batch(const void* aPtr, unsigned long aSize, unsigned long aStride, unsigned long long* aResult)\n"
+                     "{\n"
+                     "    const char* M = (const char*)aPtr;\n"
+                     "    for (unsigned long i = 0; i < aSize; i++, M += aStride)\n"
+                     "        if (" + sExpr + ")\n"
+                     "            aResult[i >> 6] |= 1ULL << (i & 63);\n"
+                     "}\n";
+
+            std::unique_lock sLock(FilterDetail::compiler_mutex());
+            m_Compiler.Compile(m_Code);
+            auto* sTable = static_cast<FilterDetail::Thunk*>(m_Compiler.GetSymbol("accessors"));
+            if (!sTable)
+                throw std::runtime_error("Protobuf::Filter: fail to get symbol");
+            for (auto& x : sAccess)
+                for (auto y : x.path)
+                    *sTable++ = y;
+            m_One   = (One)m_Compiler.GetSymbol("filter_one");
+            m_Batch = (Batch)m_Compiler.GetSymbol("filter_batch");
+            if (!m_One or !m_Batch)
+                throw std::runtime_error("Protobuf::Filter: fail to get symbol");
+        }
+
+        bool operator()(const T& aMessage) const { return m_One(&aMessage); }
+
+        // bit i set if aList[i] matched
+        Bitmap filter(std::span<const T> aList) const
+        {
+            Bitmap sResult((aList.size() + 63) / 64, 0);
+            m_Batch(aList.data(), aList.size(), sizeof(T), reinterpret_cast<unsigned long long*>(sResult.data()));
+            return sResult;
+        }
+
+        const std::string& code() const { return m_Code; }
+
+        // compiled filters cached by expression text
+        static std::shared_ptr<const Filter> get(const std::string& aExpr)
+        {
+            static std::mutex                                                   sMutex;
+            static std::map<std::string, std::shared_ptr<const Filter>, std::less<>> sCache;
+            {
+                std::unique_lock sLock(sMutex);
+                if (auto sIt = sCache.find(aExpr); sIt != sCache.end())
+                    return sIt->second;
+            }
+            auto             sFilter = std::make_shared<const Filter>(aExpr);
+            std::unique_lock sLock(sMutex);
+            return sCache.emplace(aExpr, std::move(sFilter)).first->second;
+        }
+    };
+} // namespace Protobuf
@@ -1,11 +1,22 @@
 #pragma once
 
+#include <endian.h>
 #include <stdint.h>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstring>
+#include <memory_resource>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 /*
     dirty and incomplete parser for protobuf
@@ -22,6 +33,8 @@
     BM_GoogleSerialize         130 ns        130 ns    5400724
     BM_CustomSerialize          71 ns         71 ns    9866489
 
+    generated code (protobuf.j2) decode messages with per-message field table,
+    varints read with one 8 byte load (pext with BMI2) when enough memory available.
 */
 
 namespace Protobuf {
@@ -100,20 +113,203 @@ namespace Protobuf {
         ZIGZAG,      // sint
     };
 
+    class Reader;
+
+    // projection for partial decode: selected field ids, with own mask for partially selected submessages.
+    // fields not in mask skipped by length without decoding.
+    class Mask
+    {
+        bool                                   m_All = false;
+        std::vector<std::pair<uint32_t, Mask>> m_Fields;
+
+        void add(const uint32_t* aBegin, const uint32_t* aEnd)
+        {
+            auto sIt = std::find_if(m_Fields.begin(), m_Fields.end(), [aBegin](const auto& x) { return x.first == *aBegin; });
+            if (sIt == m_Fields.end())
+                sIt = m_Fields.insert(m_Fields.end(), {*aBegin, Mask()});
+            auto& sNested = sIt->second;
+            if (aBegin + 1 == aEnd) {
+                sNested.m_All = true;
+                sNested.m_Fields.clear();
+            } else if (!sNested.m_All) {
+                sNested.add(aBegin + 1, aEnd);
+            }
+        }
+
+    public:
+        Mask() = default;
+        Mask(std::initializer_list<std::vector<uint32_t>> aPaths)
+        {
+            for (auto& x : aPaths)
+                add(x);
+        }
+
+        // path of field ids, for example from Reflection::resolve("m1.m2.id")
+        Mask& add(const std::vector<uint32_t>& aPath)
+        {
+            if (aPath.empty())
+                throw std::invalid_argument("Protobuf::Mask: empty path");
+            add(aPath.data(), aPath.data() + aPath.size());
+            return *this;
+        }
+
+        bool all() const { return m_All; }
+
+        // mask for field value, nullptr if field not selected
+        const Mask* find(uint32_t aId) const
+        {
+            if (m_All)
+                return this;
+            for (auto& x : m_Fields)
+                if (x.first == aId)
+                    return &x.second;
+            return nullptr;
+        }
+    };
+
+    // generated message describe own fields with table: encoded tag and handler to parse value.
+    // handler used instead of member offset, since fields are std::optional/std::pmr::list
+    template <class M>
+    struct Field
+    {
+        uint32_t key = 0; // (id << 3) | wire type, as expected in message
+        void (*parse)(M&, Reader&, const Mask*) = nullptr;
+
+        constexpr uint32_t id() const { return key >> 3; }
+    };
+
+    // fields sorted by id. small ids resolved via dense index, large ones with binary search.
+    // fields usually come in declaration order, so next one checked first.
+    template <class M, size_t N>
+    class Table
+    {
+        static constexpr size_t DENSE = 32;
+        static_assert(N < 255, "too many fields for dense index");
+
+        std::array<Field<M>, N>    m_Fields;
+        std::array<uint8_t, DENSE> m_Dense{}; // id -> position + 1
+
+    public:
+        constexpr Table(const std::array<Field<M>, N>& aFields)
+        : m_Fields(aFields)
+        {
+            for (size_t i = 0; i < N; i++)
+                if (m_Fields[i].id() < DENSE)
+                    m_Dense[m_Fields[i].id()] = i + 1;
+        }
+
+        const Field<M>* find(uint64_t aTag, size_t& aHint) const
+        {
+            if (aHint < N and m_Fields[aHint].key == aTag) [[likely]]
+                return &m_Fields[aHint++];
+
+            const uint64_t sId  = aTag >> 3;
+            size_t         sPos = 0;
+            if (sId < DENSE) {
+                if (m_Dense[sId] == 0)
+                    return nullptr;
+                sPos = m_Dense[sId] - 1;
+            } else {
+                auto sIt = std::lower_bound(m_Fields.begin(), m_Fields.end(), sId, [](const Field<M>& a, uint64_t b) { return a.id() < b; });
+                if (sIt == m_Fields.end() or sIt->id() != sId)
+                    return nullptr;
+                sPos = sIt - m_Fields.begin();
+            }
+            aHint = sPos + 1;
+            return &m_Fields[sPos];
+        }
+    };
+
     // allow to decode some fields from protobuf
     // and skip others
     class Reader
     {
-        std::string_view m_Buffer;
+        const char* m_Ptr;
+        const char* m_End;
+        const char* m_Limit; // end of readable memory (>= m_End), 8 byte loads allowed before it
+
+        Reader(const char* aPtr, const char* aEnd, const char* aLimit)
+        : m_Ptr(aPtr)
+        , m_End(aEnd)
+        , m_Limit(aLimit)
+        {
+        }
 
         uint8_t readByte()
         {
-            if (m_Buffer.empty())
+            if (m_Ptr == m_End)
                 throw EndOfBuffer();
+            return *m_Ptr++;
+        }
+
+        // bounds checked once per field
+        const char* take(size_t aSize)
+        {
+            if (aSize > size_t(m_End - m_Ptr))
+                throw BadInput();
+            const char* sPtr = m_Ptr;
+            m_Ptr += aSize;
+            return sPtr;
+        }
+
+        // drop continuation bits from 8 bytes (up to 56 bits of value)
+        static uint64_t compact(uint64_t aWord, uint64_t aMask)
+        {
+#ifdef __BMI2__
+            return _pext_u64(aWord, aMask & 0x7F7F7F7F7F7F7F7FULL);
+#else
+            aWord &= aMask & 0x7F7F7F7F7F7F7F7FULL;
+            aWord = ((aWord & 0x7F007F007F007F00ULL) >> 1) | (aWord & 0x007F007F007F007FULL);
+            aWord = ((aWord & 0x3FFF00003FFF0000ULL) >> 2) | (aWord & 0x00003FFF00003FFFULL);
+            aWord = ((aWord & 0x0FFFFFFF00000000ULL) >> 4) | (aWord & 0x000000000FFFFFFFULL);
+            return aWord;
+#endif
+        }
+
+        uint64_t readVarIntSlow()
+        {
+            uint64_t sValue = 0;
+            for (int sShift = 0;; sShift += 7) {
+                if (sShift > 63)
+                    throw BadInput();
+                const uint8_t sByte = readByte();
+                sValue |= ((uint64_t)sByte & 0x7F) << sShift;
+                if (sByte < 0x80) // Each byte in a varint, except the last byte, has the most significant bit (msb) set
+                    return sValue;
+            }
+        }
 
-            uint8_t sByte = m_Buffer.front();
-            m_Buffer.remove_prefix(1);
-            return sByte;
+        // multi byte varint: load 8 bytes at once, find first byte without msb
+        [[gnu::always_inline]] uint64_t readVarIntWide()
+        {
+            if (m_Limit - m_Ptr >= 8) [[likely]] {
+                uint64_t sWord;
+                memcpy(&sWord, m_Ptr, sizeof(sWord));
+                sWord                = le64toh(sWord);
+                const uint64_t sStop = ~sWord & 0x8080808080808080ULL;
+                if (sStop != 0) [[likely]] {
+                    const char* sNext = m_Ptr + (std::countr_zero(sStop) + 1) / 8;
+                    if (sNext > m_End)
+                        throw EndOfBuffer();
+                    m_Ptr = sNext;
+                    return compact(sWord, sStop ^ (sStop - 1));
+                }
+            }
+            return readVarIntSlow();
+        }
+
+        // kept out of line, so every field handler inline only one byte case
+        [[gnu::noinline]] uint64_t readVarIntLong() { return readVarIntWide(); }
+
+        template <bool INLINE = false>
+        uint64_t readVarInt64()
+        {
+            if (m_Ptr != m_End and (int8_t)*m_Ptr >= 0) [[likely]]
+                return *m_Ptr++;
+            if constexpr (INLINE)
+                return readVarIntWide();
+            else
+                return readVarIntLong();
         }
 
 #ifdef BOOST_TEST_MODULE // open for tests only
@@ -121,50 +317,31 @@ namespace Protobuf {
 #endif
         FieldInfo readTag()
         {
-            return FieldInfo(readVarInt<uint64_t>());
+            return FieldInfo(readVarInt64());
         }
 
         template <class T>
         T readVarInt()
         {
-            T       sValue = 0;
-            int     sShift = 0;
-            uint8_t sByte  = 0;
-
-            do {
-                if (sShift > 63)
-                    throw BadInput();
-                sByte = readByte();
-                sValue |= (((T)sByte & 0x7F) << sShift);
-                sShift += 7;
-            } while (sByte >= 0x80); // Each byte in a varint, except the last byte, has the most significant bit (msb) set
-
-            return sValue;
+            return (T)readVarInt64();
         }
 
         void skip(const FieldInfo& aField)
         {
             size_t sSize = aField.decodeSize();
             if (sSize == 4 || sSize == 8) {
-                if (sSize > m_Buffer.size())
-                    throw BadInput();
-                else
-                    m_Buffer.remove_prefix(sSize);
+                take(sSize);
                 return;
             }
 
             // VarInt
             if (sSize == 1) {
-                readVarInt<size_t>();
+                readVarInt64();
                 return;
             }
 
             // Length-delimited
-            sSize = readVarInt<size_t>();
-            if (sSize > m_Buffer.size())
-                throw BadInput();
-
-            m_Buffer.remove_prefix(sSize);
+            take(readVarInt64());
         }
 
         // from wire_format_lite.h, unsigned to signed
@@ -174,15 +351,12 @@ namespace Protobuf {
         template <class T>
         void readFixed(T& aDest)
         {
-            if (sizeof(T) > m_Buffer.size())
-                throw BadInput();
-            memcpy(&aDest, m_Buffer.data(), sizeof(T));
-            m_Buffer.remove_prefix(sizeof(T));
+            memcpy(&aDest, take(sizeof(T)), sizeof(T));
         }
 
     public:
         Reader(std::string_view aBuffer)
-        : m_Buffer(aBuffer)
+        : Reader(aBuffer.data(), aBuffer.data() + aBuffer.size(), aBuffer.data() + aBuffer.size())
         {
         }
 
@@ -212,28 +386,60 @@ namespace Protobuf {
             std::is_class<T>::value, void>::type
         read(T& aDest)
         {
-            const auto sSize = readVarInt<size_t>();
-            if (sSize > m_Buffer.size())
-                throw BadInput();
-
-            aDest.assign(m_Buffer.data(), sSize);
-            m_Buffer.remove_prefix(sSize);
+            const size_t sSize = readVarInt64();
+            aDest.assign(take(sSize), sSize);
         }
 
         void read(std::string_view& aDest)
         {
-            const auto sSize = readVarInt<size_t>();
-            if (sSize > m_Buffer.size())
-                throw BadInput();
+            const size_t sSize = readVarInt64();
+            aDest              = std::string_view(take(sSize), sSize);
+        }
+
+        // reader for length-delimited field (submessage or packed list).
+        // shares memory limit with parent, so fast varint path works up to the end of outer buffer
+        Reader sub()
+        {
+            const size_t sSize = readVarInt64();
+            const char*  sPtr  = take(sSize);
+            return Reader(sPtr, sPtr + sSize, m_Limit);
+        }
 
-            aDest = std::string_view(m_Buffer.data(), sSize);
-            m_Buffer.remove_prefix(sSize);
+        template <class T, class F>
+        void readPacked(F&& aCallback, IntType mode = VARIANT)
+        {
+            Reader sReader = sub();
+            if constexpr (std::is_floating_point<T>::value) {
+                mode = FIXED;
+            }
+            if (mode == FIXED) {
+                if (sReader.m_Ptr == sReader.m_End)
+                    return;
+                if ((sReader.m_End - sReader.m_Ptr) % sizeof(T))
+                    throw BadInput();
+                for (; sReader.m_Ptr < sReader.m_End; sReader.m_Ptr += sizeof(T)) {
+                    T sTmp;
+                    memcpy(&sTmp, sReader.m_Ptr, sizeof(T));
+                    aCallback(sTmp);
+                }
+                return;
+            }
+            if constexpr (std::is_integral<T>::value) {
+                using U = typename std::make_unsigned<T>::type;
+                if (mode == ZIGZAG) {
+                    while (sReader.m_Ptr != sReader.m_End)
+                        aCallback(sReader.ZigZagDecode((U)sReader.readVarInt64<true>()));
+                } else {
+                    while (sReader.m_Ptr != sReader.m_End)
+                        aCallback((T)sReader.readVarInt64<true>());
+                }
+            }
         }
 
         template <class T>
         void parse(T aCallback)
         {
-            while (!m_Buffer.empty()) {
+            while (m_Ptr != m_End) {
                 const auto sField = readTag();
                 switch (aCallback(sField, this)) {
                 case ACT_USED: break;
@@ -243,9 +449,93 @@ namespace Protobuf {
             }
         }
 
+        // table driven decode for generated messages.
+        // unknown fields skipped, fields with unexpected wire type mark message as broken.
+        // with mask only selected fields decoded, mask passed down to submessages
+        template <class M, size_t N>
+        void decode(M& aMessage, const Table<M, N>& aTable, const Mask* aMask = nullptr)
+        {
+            if (aMask != nullptr and aMask->all())
+                aMask = nullptr;
+
+            size_t sHint = 0;
+            while (m_Ptr != m_End) {
+                const uint64_t sTag   = readVarInt64();
+                const auto*    sField = aTable.find(sTag, sHint);
+                if (sField == nullptr) [[unlikely]] {
+                    skip(FieldInfo(sTag));
+                } else if (sField->key != sTag) [[unlikely]] {
+                    aMessage.m_Error = true;
+                    skip(FieldInfo(sTag));
+                } else if (aMask == nullptr) [[likely]] {
+                    sField->parse(aMessage, *this, nullptr);
+                } else if (const Mask* sNested = aMask->find(sField->id()); sNested != nullptr) {
+                    sField->parse(aMessage, *this, sNested);
+                } else {
+                    skip(FieldInfo(sTag));
+                }
+            }
+        }
+
         bool empty() const
         {
-            return m_Buffer.empty();
+            return m_Ptr == m_End;
+        }
+    };
+
+    // submessage kept as raw slice of input and parsed on first access.
+    // input buffer (and mask, if any) must be alive until then.
+    // access caches parsed value, so it is not thread safe: use from one thread
+    template <class T>
+    class Lazy
+    {
+        std::pmr::memory_resource* m_Pool;
+        std::string_view           m_Data;
+        const Mask*                m_Mask = nullptr;
+        std::optional<T>           m_Value;
+
+    public:
+        Lazy(std::pmr::memory_resource* aPool)
+        : m_Pool(aPool)
+        {
+        }
+
+        void assign(std::string_view aData, const Mask* aMask = nullptr)
+        {
+            m_Data = aData;
+            m_Mask = aMask;
+            m_Value.reset();
+        }
+
+        std::string_view data() const { return m_Data; }
+        bool             parsed() const { return m_Value.has_value(); }
+
+        // parse errors thrown on every access, not cached
+        T& get()
+        {
+            if (!m_Value) {
+                try {
+                    m_Value.emplace(m_Pool);
+                    m_Value->ParseFromString(m_Data, m_Mask);
+                } catch (...) {
+                    m_Value.reset();
+                    throw;
+                }
+            }
+            return *m_Value;
+        }
+
+        T* operator->() { return &get(); }
+        T& operator*() { return get(); }
+
+        // not cached, if not parsed yet
+        auto to_json() const
+        {
+            if (m_Value)
+                return m_Value->to_json();
+            T sTmp(m_Pool);
+            sTmp.ParseFromString(m_Data, m_Mask);
+            return sTmp.to_json();
         }
     };
 
@@ -270,6 +560,15 @@ namespace Protobuf {
             writeVarInt(aInfo.tag | (aInfo.id << 3));
         }
 
+        template <class T>
+        void writeFixed(T aVal)
+        {
+            static_assert(std::endian::native == std::endian::little, "Protobuf::Writer: big endian not supported");
+            m_Buffer.append(reinterpret_cast<const char*>(&aVal), sizeof(aVal));
+        }
+
+        static constexpr uint8_t fixedTag(size_t aSize) { return aSize == 4 ? FieldInfo::TAG_FIXED32 : FieldInfo::TAG_FIXED64; }
+
     public:
         Writer(std::string& aStr)
         : m_Buffer(aStr)
@@ -281,21 +580,72 @@ namespace Protobuf {
             std::is_integral<T>::value, void>::type
         write(uint64_t aId, T aVal, IntType mode = VARIANT)
         {
+            using U = typename std::make_unsigned<T>::type;
             switch (mode) {
             case VARIANT:
                 writeTag({Protobuf::FieldInfo::TAG_VARIANT, aId});
-                writeVarInt(aVal);
+                if constexpr (std::is_signed<T>::value)
+                    writeVarInt(uint64_t(int64_t(aVal))); // negative always take 10 bytes
+                else
+                    writeVarInt(aVal);
+                break;
+            case FIXED:
+                if (sizeof(T) != 4 and sizeof(T) != 8)
+                    throw std::invalid_argument("fixed must be 32 or 64 bit");
+                writeTag({fixedTag(sizeof(T)), aId});
+                writeFixed(aVal);
+                break;
+            case ZIGZAG:
+                writeTag({Protobuf::FieldInfo::TAG_VARIANT, aId});
+                writeVarInt(U((U(aVal) << 1) ^ U(aVal >> (sizeof(T) * 8 - 1))));
                 break;
-            case FIXED: throw std::invalid_argument("fixed not implemented");
-            case ZIGZAG: throw std::invalid_argument("zigzag not implemented");
             }
         }
 
+        template <class T>
+        typename std::enable_if<
+            std::is_floating_point<T>::value, void>::type
+        write(uint64_t aId, T aVal)
+        {
+            writeTag({fixedTag(sizeof(T)), aId});
+            writeFixed(aVal);
+        }
+
         void write(uint64_t aId, std::string_view aStr)
         {
             writeTag({Protobuf::FieldInfo::TAG_LENGTH, aId});
             writeVarInt(aStr.size());
             m_Buffer.append(aStr);
         }
+
+        // submessage written in place by aBody.
+        // one byte reserved for length, moved if body is longer than 127 bytes
+        template <class F>
+        void message(uint64_t aId, F&& aBody)
+        {
+            writeTag({Protobuf::FieldInfo::TAG_LENGTH, aId});
+            const size_t sStart = m_Buffer.size();
+            m_Buffer.push_back(0);
+            aBody();
+
+            uint64_t sSize = m_Buffer.size() - sStart - 1;
+            if (sSize < 0x80) {
+                m_Buffer[sStart] = sSize;
+                return;
+            }
+            char   sLen[10];
+            size_t sLenSize = 0;
+            do {
+                uint8_t sByte = sSize & 0x7F;
+                sSize >>= 7;
+                if (sSize != 0)
+                    sByte |= 0x80;
+                sLen[sLenSize++] = sByte;
+            } while (sSize > 0);
+            m_Buffer.replace(sStart, 1, sLen, sLenSize);
+        }
+
+        // already encoded fields
+        void append(std::string_view aRaw) { m_Buffer.append(aRaw); }
     };
 } // namespace Protobuf
@@ -1,11 +1,16 @@
 #pragma once
 
+#include <memory_resource>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <vector>
 
 namespace Protobuf {
 
+    template <class T>
+    class Lazy;
+
     template <class T>
     struct Reflection
     {
@@ -16,6 +21,17 @@ namespace Protobuf {
         struct can_walk<U, std::void_t<decltype(&U::GetReflectionKey)>> : std::true_type
         {};
 
+        template <typename U>
+        struct unlazy
+        {
+            using type = U;
+        };
+        template <typename U>
+        struct unlazy<Lazy<U>>
+        {
+            using type = U;
+        };
+
         using Path = std::vector<uint32_t>;
 
         static void walk(T& aItem, std::string aName, Path& aPath)
@@ -39,6 +55,39 @@ namespace Protobuf {
             });
         }
 
+        // same as walk, but without message instance: nested types resolved with temporary objects.
+        // result can be used to build Protobuf::Mask for partial decode
+        static Path resolve(const std::string& aName)
+        {
+            Path sPath;
+            resolve(aName, sPath);
+            return sPath;
+        }
+
+        static void resolve(std::string aName, Path& aPath)
+        {
+            std::string sRest;
+            if (auto sPos = aName.find('.'); sPos != std::string::npos) {
+                sRest = aName.substr(sPos + 1);
+                aName.erase(sPos);
+            }
+            auto sKey = T::GetReflectionKey(aName);
+            if (sKey == nullptr)
+                throw std::invalid_argument("Protobuf::Reflection: field " + aName + " not found");
+            aPath.push_back(sKey->id);
+            if (sRest.empty())
+                return;
+
+            T sItem(std::pmr::null_memory_resource());
+            sItem.GetByID(sKey->id, [&sRest, &aPath](auto& x) mutable {
+                using V = typename unlazy<typename std::remove_reference_t<decltype(x)>::value_type>::type;
+                if constexpr (can_walk<V>::value)
+                    Reflection<V>::resolve(sRest, aPath);
+                else
+                    throw std::invalid_argument("Protobuf::Reflection: field " + sRest + " not found");
+            });
+        }
+
         template <class H>
         static void use(T& aItem, const Path& aPath, H&& aHandler, uint32_t aPos = 0)
         {
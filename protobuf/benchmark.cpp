@@ -1,5 +1,7 @@
 #include <benchmark/benchmark.h>
 
+#include <memory_resource>
+#include <random>
 #include <vector>
 
 #include "tutorial.pb.h"
@@ -8,6 +10,8 @@
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/util/json_util.h>
 
+#include "tutorial.hpp"
+
 const bool gProtobufCleanup = []() { std::atexit(google::protobuf::ShutdownProtobufLibrary); return true; }();
 
 struct PhoneNumber
@@ -141,6 +145,98 @@ static void BM_CustomParse(benchmark::State& state)
 }
 BENCHMARK(BM_CustomParse);
 
+template <class T>
+static void BM_GeneratedParse(benchmark::State& state)
+{
+    char                                sBuffer[1024];
+    std::pmr::monotonic_buffer_resource sPool{std::data(sBuffer), std::size(sBuffer)};
+    for (auto _ : state) {
+        T sPerson(&sPool);
+        sPerson.ParseFromString(gBuf);
+        benchmark::DoNotOptimize(sPerson);
+        sPool.release();
+    }
+}
+BENCHMARK_TEMPLATE(BM_GeneratedParse, pmr_tutorial::Person);
+BENCHMARK_TEMPLATE(BM_GeneratedParse, pmr_tutorial::PersonView);
+
+// packed list with varints of different length
+const std::string gPacked = []() {
+    tutorial::Xtest sMsg;
+    std::mt19937    sGen(42);
+    for (unsigned i = 0; i < 1024; i++)
+        sMsg.add_packed_list(sGen() >> (sGen() % 32));
+    return sMsg.SerializeAsString();
+}();
+
+static void BM_GooglePacked(benchmark::State& state)
+{
+    tutorial::Xtest sMsg;
+    for (auto _ : state)
+        sMsg.ParseFromString(gPacked);
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_GooglePacked);
+
+static void BM_CustomPacked(benchmark::State& state)
+{
+    std::pmr::monotonic_buffer_resource sPool(64 * 1024);
+    for (auto _ : state) {
+        pmr_tutorial::Xtest sMsg(&sPool);
+        sMsg.ParseFromString(gPacked);
+        benchmark::DoNotOptimize(sMsg);
+        sPool.release();
+    }
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_CustomPacked);
+
+// nested message with wide repeated fields, only few fields used
+const std::string gWide = []() {
+    tutorial::Wide sMsg;
+    sMsg.set_id(42);
+    sMsg.set_title("wide message");
+    for (unsigned i = 0; i < 64; i++) {
+        auto sItem = sMsg.add_items();
+        sItem->set_id(i);
+        sItem->set_name("item number " + std::to_string(i));
+        for (unsigned j = 0; j < 16; j++)
+            sItem->add_tags(i * j);
+        sItem->set_score(i / 2.0);
+    }
+    sMsg.mutable_head()->set_id(100);
+    return sMsg.SerializeAsString();
+}();
+
+static void BM_GoogleWide(benchmark::State& state)
+{
+    tutorial::Wide sMsg;
+    for (auto _ : state) {
+        sMsg.ParseFromString(gWide);
+        benchmark::DoNotOptimize(sMsg.head().id());
+    }
+}
+BENCHMARK(BM_GoogleWide);
+
+// arg: 0 - full parse, 1 - only id and head.id
+template <class T>
+static void BM_Wide(benchmark::State& state)
+{
+    const Protobuf::Mask                sMask{{1}, {4, 1}};
+    std::pmr::monotonic_buffer_resource sPool(64 * 1024);
+    for (auto _ : state) {
+        T sMsg(&sPool);
+        sMsg.ParseFromString(gWide, state.range(0) ? &sMask : nullptr);
+        if constexpr (std::is_same_v<T, pmr_tutorial::WideLazy>)
+            benchmark::DoNotOptimize((*sMsg.head)->id);
+        else
+            benchmark::DoNotOptimize(sMsg.head->id);
+        sPool.release();
+    }
+}
+BENCHMARK_TEMPLATE(BM_Wide, pmr_tutorial::Wide)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Wide, pmr_tutorial::WideLazy)->Arg(0)->Arg(1);
+
 //
 
 static void BM_GoogleSerialize(benchmark::State& state)
@@ -11,6 +11,9 @@
 #ifdef WITH_REFLECTION
 #include "ExprTK.hpp"
 #endif
+#ifdef WITH_TCC
+#include "Filter.hpp"
+#endif
 
 #include "tutorial.hpp"
 #include "tutorial.pb.h"
@@ -112,6 +115,50 @@ void BM_PMR_View(benchmark::State& state)
 }
 BENCHMARK(BM_PMR_View)->Arg(P_COUNT)->Threads(1)->Threads(4)->UseRealTime()->Unit(benchmark::kMillisecond);
 
+// numeric fields and packed list
+const std::string gXtest = []() {
+    tutorial::Xtest sMsg;
+    sMsg.set_i32(123);
+    sMsg.set_s32(-45);
+    sMsg.set_f32(-4.6);
+    sMsg.set_i64(1ULL << 40);
+    sMsg.set_s64(-1);
+    sMsg.set_f64(-6.2);
+    sMsg.set_binary("0123456789");
+    for (unsigned i = 0; i < 64; i++)
+        sMsg.add_packed_list(i << (i % 32));
+    return sMsg.SerializeAsString();
+}();
+
+void BM_GoogleXtest(benchmark::State& state)
+{
+    thread_local google::protobuf::Arena sArena;
+    for (auto _ : state) {
+        for (unsigned i = 0; i < state.range(0); i++) {
+            auto sMsg = google::protobuf::Arena::CreateMessage<tutorial::Xtest>(&sArena);
+            sMsg->ParseFromString(gXtest);
+        }
+        sArena.Reset();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.threads());
+}
+BENCHMARK(BM_GoogleXtest)->Arg(P_COUNT / 16)->Threads(1)->Threads(4)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+void BM_PMR_Xtest(benchmark::State& state)
+{
+    thread_local std::pmr::monotonic_buffer_resource sPool(1024 * 1024);
+    for (auto _ : state) {
+        for (unsigned i = 0; i < state.range(0); i++) {
+            pmr_tutorial::Xtest sMsg(&sPool);
+            sMsg.ParseFromString(gXtest);
+            benchmark::DoNotOptimize(sMsg);
+        }
+        sPool.release();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.threads());
+}
+BENCHMARK(BM_PMR_Xtest)->Arg(P_COUNT / 16)->Threads(1)->Threads(4)->UseRealTime()->Unit(benchmark::kMillisecond);
+
 // reflection
 
 #ifdef WITH_REFLECTION
@@ -153,7 +200,7 @@ static void BM_Expr(benchmark::State& state)
 {
     char                                sBuffer[1024] = {};
     std::pmr::monotonic_buffer_resource sPool{std::data(sBuffer), std::size(sBuffer)};
-    pmr_tutorial::xtest                 sVal(&sPool);
+    pmr_tutorial::Xtest                 sVal(&sPool);
     sVal.i32 = 123;
     Protobuf::ExprTK sExpr;
     sExpr.m_Table.create_variable("i32");
@@ -166,6 +213,35 @@ static void BM_Expr(benchmark::State& state)
     }
 }
 BENCHMARK(BM_Expr);
+
+#ifdef WITH_TCC
+static void BM_Filter(benchmark::State& state)
+{
+    char                                sBuffer[1024] = {};
+    std::pmr::monotonic_buffer_resource sPool{std::data(sBuffer), std::size(sBuffer)};
+    pmr_tutorial::Xtest                 sVal(&sPool);
+    sVal.i32 = 123;
+    auto sFilter = Protobuf::Filter<pmr_tutorial::Xtest>::get("i32 > 100 and i32 < 200");
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize((*sFilter)(sVal));
+}
+BENCHMARK(BM_Filter);
+
+static void BM_FilterBatch(benchmark::State& state)
+{
+    std::pmr::monotonic_buffer_resource sPool;
+    std::vector<pmr_tutorial::Xtest>    sList;
+    for (int i = 0; i < state.range(0); i++)
+        sList.emplace_back(&sPool).i32 = i;
+    auto sFilter = Protobuf::Filter<pmr_tutorial::Xtest>::get("i32 > 100 and i32 < 200");
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(sFilter->filter(sList));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FilterBatch)->Arg(1024);
+#endif // WITH_TCC
 #endif // WITH_REFLECTION
 
 BENCHMARK_MAIN();
@@ -85,6 +85,15 @@ def convert(x):
                 return ", " + xtype[name]
             return ""
 
+        def _wire(name, packed):
+            if packed or name in ("string", "bytes") or _customType(name):
+                return "Protobuf::FieldInfo::TAG_LENGTH"
+            if name in ("fixed32", "sfixed32", "float"):
+                return "Protobuf::FieldInfo::TAG_FIXED32"
+            if name in ("fixed64", "sfixed64", "double"):
+                return "Protobuf::FieldInfo::TAG_FIXED64"
+            return "Protobuf::FieldInfo::TAG_VARIANT"
+
         def _type(string_view, name):
             xtype = {
                 "string": "std::pmr::string",
@@ -106,6 +115,7 @@ def convert(x):
 
         x = AttrDict()
         x.id = get_by_name("id", i)
+        x.number = int(x.id) if x.id is not None else 0
         x.name = get_by_name("name", i)
         x.value = get_by_name("value", i)
         x.default = get_by_name("default", i)
@@ -115,13 +125,18 @@ def convert(x):
 
         string = x.proto_type == "string" or x.proto_type == "bytes"
         string_view = "use:string_view" in (get_by_name("comment", i) or "")
+        lazy = "use:lazy" in (get_by_name("comment", i) or "")
         x.pmr = (
             True if (string and not string_view) or _customType(x.proto_type) else False
         )
 
         x.cxx_type = _type(string_view, x.proto_type)
         x.custom_type = _customType(x.proto_type)
+        x.lazy = lazy and x.custom_type
+        if x.lazy:
+            x.cxx_type = "Protobuf::Lazy<" + x.cxx_type + ">"
         x.encoding = _encoding(x.proto_type)
+        x.wire = _wire(x.proto_type, x.packed)
 
         x.enum = x.proto_type in localEnums
         x.cast = "sTmp" if not x.enum else "static_cast<" + x.cxx_type + ">(sTmp)"
@@ -9,6 +9,9 @@
 #ifdef WITH_REFLECTION
 #include "ExprTK.hpp"
 #endif
+#ifdef WITH_TCC
+#include "Filter.hpp"
+#endif
 
 #include "tutorial.hpp"
 #include "tutorial.pb.h"
@@ -189,6 +192,205 @@ BOOST_AUTO_TEST_CASE(generated)
     }
     BOOST_CHECK_EQUAL(sMessage.binary(), sCustom.binary->c_str());
 }
+BOOST_AUTO_TEST_CASE(varint)
+{
+    // all varint sizes, with short buffer (byte by byte path) and with 8 byte loads
+    for (unsigned sLen = 1; sLen <= 10; sLen++) {
+        const uint64_t sValue = sLen == 10 ? UINT64_MAX : (1ULL << (7 * sLen)) - 1;
+        std::string    sBuf;
+        Protobuf::Writer sWriter(sBuf);
+        sWriter.write(1, sValue);
+        BOOST_CHECK_EQUAL(sBuf.size(), sLen + 1);
+        {
+            Protobuf::Reader sReader(sBuf);
+            BOOST_CHECK_EQUAL(1, sReader.readTag().id);
+            BOOST_CHECK_EQUAL(sValue, sReader.readVarInt<uint64_t>());
+            BOOST_CHECK(sReader.empty());
+        }
+        sWriter.write(2, "0123456789");
+        {
+            Protobuf::Reader sReader(sBuf);
+            BOOST_CHECK_EQUAL(1, sReader.readTag().id);
+            BOOST_CHECK_EQUAL(sValue, sReader.readVarInt<uint64_t>());
+            BOOST_CHECK_EQUAL(2, sReader.readTag().id);
+        }
+        {
+            Protobuf::Reader sReader(std::string_view(sBuf).substr(0, sLen));
+            BOOST_CHECK_EQUAL(1, sReader.readTag().id);
+            BOOST_CHECK_THROW(sReader.readVarInt<uint64_t>(), Protobuf::EndOfBuffer);
+        }
+    }
+
+    // packed list truncated in the middle of varint, but memory after it is readable
+    const std::string sBroken("\x22\x01\x80\x01\x92\x7f\x0a" "0123456789", 17);
+    char                                sBuffer[1024] = {};
+    std::pmr::monotonic_buffer_resource sPool{std::data(sBuffer), std::size(sBuffer)};
+    pmr_tutorial::Xtest                 sCustom(&sPool);
+    BOOST_CHECK_THROW(sCustom.ParseFromString(sBroken), Protobuf::EndOfBuffer);
+}
+BOOST_AUTO_TEST_CASE(packed)
+{
+    tutorial::Xtest sMessage;
+    for (unsigned i = 0; i < 1000; i++)
+        sMessage.add_packed_list(i % 2 ? i : UINT32_MAX / (i + 1));
+    sMessage.set_s64(-1);
+    sMessage.set_binary("123");
+
+    std::string sBuf;
+    sMessage.SerializeToString(&sBuf);
+
+    std::pmr::monotonic_buffer_resource sPool;
+    pmr_tutorial::Xtest                 sCustom(&sPool);
+    sCustom.ParseFromString(sBuf);
+    BOOST_CHECK(!sCustom.m_Error);
+    BOOST_CHECK_EQUAL(sMessage.s64(), *sCustom.s64);
+    BOOST_CHECK_EQUAL(sMessage.binary(), sCustom.binary->c_str());
+    BOOST_REQUIRE_EQUAL(sMessage.packed_list_size(), sCustom.packed_list.size());
+    unsigned i = 0;
+    for (auto& x : sCustom.packed_list)
+        BOOST_CHECK_EQUAL(sMessage.packed_list(i++), x);
+
+    // wrong wire type: fixed32 field sent as varint
+    std::string      sTmp;
+    Protobuf::Writer sWriter(sTmp);
+    sWriter.write(1, 5);
+    pmr_tutorial::Xtest sWrong(&sPool);
+    sWrong.ParseFromString(sTmp);
+    BOOST_CHECK(sWrong.m_Error);
+    BOOST_CHECK(!sWrong.i32);
+}
+BOOST_AUTO_TEST_CASE(writer)
+{
+    for (size_t sBody : {0, 127, 128, 20000}) {
+        std::string      sBuf;
+        Protobuf::Writer sWriter(sBuf);
+        sWriter.write(1, uint64_t(1234567890123), Protobuf::FIXED);
+        sWriter.write(2, -42);
+        sWriter.write(3, int64_t(-42), Protobuf::ZIGZAG);
+        sWriter.write(4, 0.5);
+        sWriter.message(5, [&]() {
+            sWriter.write(1, std::string(sBody, 'x'));
+            sWriter.message(2, [&]() { sWriter.write(1, 7u); });
+        });
+        sWriter.write(6, "tail");
+
+        Protobuf::Reader sReader(sBuf);
+        uint64_t         sFixed  = 0;
+        int64_t          sInt    = 0;
+        int64_t          sZigZag = 0;
+        double           sDouble = 0;
+        BOOST_CHECK_EQUAL(1, sReader.readTag().id);
+        sReader.read(sFixed, Protobuf::FIXED);
+        BOOST_CHECK_EQUAL(sFixed, 1234567890123);
+        BOOST_CHECK_EQUAL(2, sReader.readTag().id);
+        sReader.read(sInt);
+        BOOST_CHECK_EQUAL(sInt, -42);
+        BOOST_CHECK_EQUAL(3, sReader.readTag().id);
+        sReader.read(sZigZag, Protobuf::ZIGZAG);
+        BOOST_CHECK_EQUAL(sZigZag, -42);
+        BOOST_CHECK_EQUAL(4, sReader.readTag().id);
+        sReader.read(sDouble);
+        BOOST_CHECK_EQUAL(sDouble, 0.5);
+        BOOST_CHECK_EQUAL(5, sReader.readTag().id);
+        {
+            auto             sSub = sReader.sub();
+            std::string_view sStr;
+            BOOST_CHECK_EQUAL(1, sSub.readTag().id);
+            sSub.read(sStr);
+            BOOST_CHECK_EQUAL(sStr.size(), sBody);
+            BOOST_CHECK_EQUAL(2, sSub.readTag().id);
+            auto sNested = sSub.sub();
+            BOOST_CHECK_EQUAL(1, sNested.readTag().id);
+            BOOST_CHECK_EQUAL(7, sNested.readVarInt<uint32_t>());
+            BOOST_CHECK(sSub.empty());
+        }
+        std::string_view sTail;
+        BOOST_CHECK_EQUAL(6, sReader.readTag().id);
+        sReader.read(sTail);
+        BOOST_CHECK_EQUAL(sTail, "tail");
+        BOOST_CHECK(sReader.empty());
+    }
+}
+static std::string makeWide()
+{
+    tutorial::Wide sMsg;
+    sMsg.set_id(42);
+    sMsg.set_title("wide");
+    for (unsigned i = 0; i < 3; i++) {
+        auto sItem = sMsg.add_items();
+        sItem->set_id(i);
+        sItem->set_name("item " + std::to_string(i));
+        sItem->add_tags(i);
+        sItem->set_score(i / 2.0);
+    }
+    sMsg.mutable_head()->set_id(100);
+    return sMsg.SerializeAsString();
+}
+BOOST_AUTO_TEST_CASE(projection)
+{
+    const std::string sBuf = makeWide();
+
+    std::pmr::monotonic_buffer_resource sPool;
+    const Protobuf::Mask                sMask{{1}, {3, 1}, {3, 3}};
+    pmr_tutorial::Wide                  sWide(&sPool);
+    sWide.ParseFromString(sBuf, &sMask);
+    BOOST_CHECK(!sWide.m_Error);
+    BOOST_CHECK_EQUAL(*sWide.id, 42);
+    BOOST_CHECK(!sWide.title);
+    BOOST_CHECK(!sWide.head);
+    BOOST_REQUIRE_EQUAL(sWide.items.size(), 3);
+    int64_t i = 0;
+    for (auto& x : sWide.items) {
+        BOOST_CHECK_EQUAL(*x.id, i);
+        BOOST_CHECK(!x.name);
+        BOOST_CHECK(!x.score);
+        BOOST_CHECK_EQUAL(x.tags.size(), 1);
+        i++;
+    }
+
+    // shorter path select whole submessage
+    Protobuf::Mask sFull{{3, 1}};
+    sFull.add({3});
+    pmr_tutorial::Wide sWide2(&sPool);
+    sWide2.ParseFromString(sBuf, &sFull);
+    BOOST_CHECK(!sWide2.id);
+    BOOST_REQUIRE_EQUAL(sWide2.items.size(), 3);
+    BOOST_CHECK_EQUAL(*sWide2.items.back().name, "item 2");
+    BOOST_CHECK(sWide2.items.back().score);
+}
+BOOST_AUTO_TEST_CASE(lazy)
+{
+    const std::string sBuf = makeWide();
+
+    std::pmr::monotonic_buffer_resource sPool;
+    pmr_tutorial::WideLazy              sWide(&sPool);
+    sWide.ParseFromString(sBuf);
+    BOOST_CHECK_EQUAL(*sWide.id, 42);
+    BOOST_REQUIRE_EQUAL(sWide.items.size(), 3);
+    BOOST_CHECK(!sWide.items.front().parsed());
+    BOOST_CHECK_EQUAL(*sWide.items.front()->name, "item 0");
+    BOOST_CHECK(sWide.items.front().parsed());
+    BOOST_CHECK(!sWide.items.back().parsed());
+    BOOST_REQUIRE(sWide.head);
+    BOOST_CHECK_EQUAL(*(*sWide.head)->id, 100);
+
+    // mask applied when submessage parsed
+    const Protobuf::Mask     sMask{{3, 2}};
+    pmr_tutorial::WideLazy sWide2(&sPool);
+    sWide2.ParseFromString(sBuf, &sMask);
+    BOOST_CHECK(!sWide2.id);
+    BOOST_CHECK(!sWide2.head);
+    BOOST_REQUIRE_EQUAL(sWide2.items.size(), 3);
+    BOOST_CHECK_EQUAL(*sWide2.items.back()->name, "item 2");
+    BOOST_CHECK(!sWide2.items.back()->id);
+
+    // broken submessage: error on every access
+    auto& sBroken = sWide2.items.front();
+    sBroken.assign(std::string_view(sBuf).substr(0, 3));
+    BOOST_CHECK_THROW(sBroken.get(), std::exception);
+    BOOST_CHECK(!sBroken.parsed());
+    BOOST_CHECK_THROW(sBroken.get(), std::exception);
+}
 BOOST_AUTO_TEST_CASE(person)
 {
     GOOGLE_PROTOBUF_VERIFY_VERSION;
@@ -236,10 +438,10 @@ BOOST_AUTO_TEST_CASE(simple)
 {
     char                                sBuffer[1024] = {};
     std::pmr::monotonic_buffer_resource sPool{std::data(sBuffer), std::size(sBuffer)};
-    pmr_tutorial::xtest                 sCustom(&sPool);
+    pmr_tutorial::Xtest                 sCustom(&sPool);
     sCustom.i32 = 123;
 
-    auto sKey = pmr_tutorial::xtest::GetReflectionKey("i32");
+    auto sKey = pmr_tutorial::Xtest::GetReflectionKey("i32");
     BOOST_REQUIRE_NE(sKey, nullptr);
     BOOST_CHECK_EQUAL(sKey->id, 1);
     uint32_t sVal = 0;
@@ -255,24 +457,33 @@ BOOST_AUTO_TEST_CASE(walk)
 {
     char                                sBuffer[1024] = {};
     std::pmr::monotonic_buffer_resource sPool{std::data(sBuffer), std::size(sBuffer)};
-    pmr_tutorial::rwalk                 sCustom(&sPool);
+    pmr_tutorial::Rwalk                 sCustom(&sPool);
 
-    sCustom.m1         = pmr_tutorial::rwalk::xpart1(&sPool);
-    sCustom.m1->m2     = pmr_tutorial::rwalk::xpart2(&sPool);
+    sCustom.m1         = pmr_tutorial::Rwalk::Xpart1(&sPool);
+    sCustom.m1->m2     = pmr_tutorial::Rwalk::Xpart2(&sPool);
     sCustom.m1->m2->id = 10;
     int32_t sVal       = 0;
 
     std::vector<uint32_t> sPath;
-    Protobuf::Reflection<pmr_tutorial::rwalk>::walk(sCustom, "m1.m2.id", sPath);
+    Protobuf::Reflection<pmr_tutorial::Rwalk>::walk(sCustom, "m1.m2.id", sPath);
     assert(sPath.size() == 3);
 
-    Protobuf::Reflection<pmr_tutorial::rwalk>::use(sCustom, sPath, [&sVal](auto x) mutable {
+    Protobuf::Reflection<pmr_tutorial::Rwalk>::use(sCustom, sPath, [&sVal](auto x) mutable {
         if constexpr (std::is_same_v<decltype(x), std::optional<int32_t>>) {
             sVal = *x;
         }
     });
     BOOST_CHECK_EQUAL(sVal, 10);
 }
+BOOST_AUTO_TEST_CASE(resolve)
+{
+    using V = std::vector<uint32_t>;
+    BOOST_CHECK(V({1, 2, 10}) == Protobuf::Reflection<pmr_tutorial::Rwalk>::resolve("m1.m2.id"));
+    BOOST_CHECK(V({3, 2}) == Protobuf::Reflection<pmr_tutorial::Wide>::resolve("items.name"));
+    BOOST_CHECK(V({4, 1}) == Protobuf::Reflection<pmr_tutorial::WideLazy>::resolve("head.id"));
+    BOOST_CHECK_THROW(Protobuf::Reflection<pmr_tutorial::Wide>::resolve("items.none"), std::invalid_argument);
+    BOOST_CHECK_THROW(Protobuf::Reflection<pmr_tutorial::Wide>::resolve("id.none"), std::invalid_argument);
+}
 BOOST_AUTO_TEST_SUITE_END() // reflection
 
 BOOST_AUTO_TEST_CASE(exprtk)
@@ -284,9 +495,9 @@ BOOST_AUTO_TEST_CASE(exprtk)
     sExpr.m_Table.create_variable("m1.m2.id");
     sExpr.compile("m1.m2.id");
 
-    pmr_tutorial::rwalk sVal(&sPool);
-    sVal.m1         = pmr_tutorial::rwalk::xpart1(&sPool);
-    sVal.m1->m2     = pmr_tutorial::rwalk::xpart2(&sPool);
+    pmr_tutorial::Rwalk sVal(&sPool);
+    sVal.m1         = pmr_tutorial::Rwalk::Xpart1(&sPool);
+    sVal.m1->m2     = pmr_tutorial::Rwalk::Xpart2(&sPool);
     sVal.m1->m2->id = 10;
 
     sExpr.resolveFrom(sVal);
@@ -294,5 +505,70 @@ BOOST_AUTO_TEST_CASE(exprtk)
 
     BOOST_CHECK_EQUAL(sExpr.eval(), 10);
 }
+
+#ifdef WITH_TCC
+BOOST_AUTO_TEST_CASE(filter)
+{
+    std::pmr::monotonic_buffer_resource sPool;
+
+    Protobuf::Filter<pmr_tutorial::Rwalk> sFilter("(m1.m2.id > 5 and m1.m2.id < 20) or not has(m1.m2)");
+    BOOST_TEST_MESSAGE("code: " << sFilter.code());
+
+    pmr_tutorial::Rwalk sVal(&sPool);
+    BOOST_CHECK(sFilter(sVal));
+    sVal.m1.emplace(&sPool).m2.emplace(&sPool).id = 10;
+    BOOST_CHECK(sFilter(sVal));
+    sVal.m1->m2->id = 30;
+    BOOST_CHECK(!sFilter(sVal));
+    sVal.m1->m2.reset();
+    BOOST_CHECK(sFilter(sVal));
+
+    // batch
+    std::vector<pmr_tutorial::Xtest> sList;
+    for (int i = 0; i < 100; i++) {
+        auto& sItem = sList.emplace_back(&sPool);
+        if (i % 3)
+            sItem.i32 = i;
+        sItem.f64 = i / 2.0;
+    }
+    auto sBatch = Protobuf::Filter<pmr_tutorial::Xtest>::get("i32 > 10 && f64 / 2 < 20");
+    BOOST_CHECK_EQUAL(sBatch, Protobuf::Filter<pmr_tutorial::Xtest>::get("i32 > 10 && f64 / 2 < 20"));
+    auto sBitmap = sBatch->filter(sList);
+    BOOST_REQUIRE_EQUAL(sBitmap.size(), 2);
+    for (int i = 0; i < 100; i++) {
+        const bool sExpected = (i % 3) and i > 10 and i / 4.0 < 20;
+        BOOST_CHECK_EQUAL(sExpected, bool((sBitmap[i / 64] >> (i % 64)) & 1));
+        BOOST_CHECK_EQUAL(sExpected, (*sBatch)(sList[i]));
+    }
+
+    BOOST_CHECK_THROW(Protobuf::Filter<pmr_tutorial::Xtest>("i32 >"), std::invalid_argument);
+    BOOST_CHECK_THROW(Protobuf::Filter<pmr_tutorial::Xtest>("none > 1"), std::invalid_argument);
+    BOOST_CHECK_THROW(Protobuf::Filter<pmr_tutorial::Xtest>("packed_list > 1"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(filter_types)
+{
+    std::pmr::monotonic_buffer_resource sPool;
+
+    pmr_tutorial::Xtest sVal(&sPool);
+    Protobuf::Filter<pmr_tutorial::Xtest> sFilter("i32 == 1 and s32 == -2 and f32 == 0.5 and i64 == 4 and s64 == -5 and f64 == 6.5");
+    Protobuf::Filter<pmr_tutorial::Xtest> sHas("has(f32) or has(s64) or i32 + s32 + f32 + i64 + s64 + f64 != 0");
+    BOOST_CHECK(!sFilter(sVal));
+    BOOST_CHECK(!sHas(sVal));
+
+    sVal.i32 = 1;
+    sVal.s32 = -2;
+    sVal.f32 = 0.5;
+    sVal.i64 = 4;
+    sVal.s64 = -5;
+    sVal.f64 = 6.5;
+    BOOST_CHECK(sFilter(sVal));
+    BOOST_CHECK(sHas(sVal));
+
+    sVal.s64.reset();
+    BOOST_CHECK(!sFilter(sVal));
+    BOOST_CHECK(sHas(sVal));
+}
+#endif                      // WITH_TCC
 #endif                      // WITH_REFLECTION
 BOOST_AUTO_TEST_SUITE_END() // Protobuf
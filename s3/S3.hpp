@@ -3,6 +3,7 @@
 #include <fmt/core.h>
 #include <fmt/format.h>
 
+#include <mutex>
 #include <string>
 
 #include <curl/Curl.hpp>
@@ -31,17 +32,44 @@ namespace S3 {
         std::string secret_key = Util::getEnv("S3_SECRET_KEY");
         std::string region     = Util::getEnv("S3_REGION");
 
+        bool unsigned_payload = false; // do not hash content if sha256 not passed, sign with UNSIGNED-PAYLOAD
+
         Curl::Client::Default curl;
     };
 
+    constexpr std::string_view UNSIGNED_PAYLOAD = "UNSIGNED-PAYLOAD";
+
     class MultipartUpload;
+    class Transfer;
     class API
     {
         friend class MultipartUpload;
+        friend class Transfer;
         const Params m_Params;
         Time::Zone   m_Zone;
         Curl::Client m_Client;
 
+        // signing key depends on date and region (fixed for API), so derived once a day
+        mutable std::mutex  m_KeyMutex;
+        mutable std::string m_KeyDate;
+        mutable std::string m_SigningKey;
+
+        std::string signingKey(std::string_view aDate) const
+        {
+            using namespace SSLxx;
+            using namespace SSLxx::HMAC;
+
+            std::unique_lock sLock(m_KeyMutex);
+            if (m_KeyDate != aDate) {
+                const std::string sDateKey    = Sign(EVP_sha256(), hmacKey("AWS4" + m_Params.secret_key), aDate);
+                const std::string sRegionKey  = Sign(EVP_sha256(), hmacKey(sDateKey), m_Params.region);
+                const std::string sServiceKey = Sign(EVP_sha256(), hmacKey(sRegionKey), std::string_view("s3"));
+                m_SigningKey                  = Sign(EVP_sha256(), hmacKey(sServiceKey), std::string_view("aws4_request"));
+                m_KeyDate                     = aDate;
+            }
+            return m_SigningKey;
+        }
+
         std::string authorization(
             Curl::Client::Method         aMethod,
             const Curl::Client::Headers& aHeaders,
@@ -92,11 +120,7 @@ namespace S3 {
                 "{}",
                 aDateTime, sDate, m_Params.region, DigestStr(EVP_sha256(), sCR));
 
-            const std::string sDateKey    = Sign(EVP_sha256(), hmacKey("AWS4" + m_Params.secret_key), sDate);
-            const std::string sRegionKey  = Sign(EVP_sha256(), hmacKey(sDateKey), m_Params.region);
-            const std::string sServiceKey = Sign(EVP_sha256(), hmacKey(sRegionKey), std::string_view("s3"));
-            const std::string sSigningKey = Sign(EVP_sha256(), hmacKey(sServiceKey), std::string_view("aws4_request"));
-            const std::string sSignature  = Format::to_hex(Sign(EVP_sha256(), hmacKey(sSigningKey), sSTS));
+            const std::string sSignature = Format::to_hex(Sign(EVP_sha256(), hmacKey(signingKey(sDate)), sSTS));
 
             std::string sHeader = fmt::format(
                 "AWS4-HMAC-SHA256 "
@@ -118,7 +142,10 @@ namespace S3 {
             const auto [aContent, aContentHash] = aContentWithHash;
             const time_t      sNow              = ::time(nullptr);
             const std::string sDateTime         = m_Zone.format(sNow, Time::ISO8601_TZ);
-            const std::string sContentHash(aContentHash.empty() ? SSLxx::DigestStr(EVP_sha256(), aContent) : aContentHash);
+            const std::string sContentHash(!aContentHash.empty()      ? aContentHash
+                                           : m_Params.unsigned_payload ? UNSIGNED_PAYLOAD
+                                                                       : SSLxx::DigestStr(EVP_sha256(), aContent));
+            const bool        sSigned = sContentHash != UNSIGNED_PAYLOAD;
 
             Curl::Client::Request sRequest;
 
@@ -130,13 +157,13 @@ namespace S3 {
             sRequest.headers["x-amz-content-sha256"] = sContentHash;
             sRequest.headers["x-amz-date"]           = sDateTime;
             // no x-amz-meta-sha256 for multipart uploads
-            if ((aMethod == Curl::Client::Method::PUT or aMethod == Curl::Client::Method::POST) and
+            if (sSigned and (aMethod == Curl::Client::Method::PUT or aMethod == Curl::Client::Method::POST) and
                 !(aQuery.starts_with("partNumber=") or aQuery == "uploads=")) {
                 sRequest.headers["x-amz-meta-sha256"] = sContentHash;
             }
             if (aMethod == Curl::Client::Method::POST and aQuery == "uploads=") // create multipart upload
                 sRequest.headers["x-amz-checksum-algorithm"] = "SHA256";
-            if (aMethod == Curl::Client::Method::PUT and aQuery.starts_with("partNumber=")) // upload part
+            if (sSigned and aMethod == Curl::Client::Method::PUT and aQuery.starts_with("partNumber=")) // upload part
                 sRequest.headers["x-amz-checksum-sha256"] = Format::Base64(Parser::from_hex(sContentHash));
             sRequest.headers["Authorization"] = authorization(aMethod, sRequest.headers, aName, aQuery, sContentHash, sDateTime);
 
@@ -207,6 +234,13 @@ namespace S3 {
             return {sResult.headers["ETag"], sHash};
         }
 
+        void abortMultipartUpload(std::string_view aName, const std::string& aUploadId)
+        {
+            auto sResult = m_Client(make(Curl::Client::Method::DELETE, aName, {}, "uploadId=" + aUploadId));
+            if (sResult.status != 204)
+                reportError(sResult);
+        }
+
         void completeMultipartUpload(std::string_view aName, const std::string& aUploadId,
                                      const std::vector<UploadTag>& aETags)
         {
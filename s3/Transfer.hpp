@@ -0,0 +1,215 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <curl/Multi.hpp>
+#include <file/Interface.hpp>
+#include <file/Reader.hpp>
+#include <file/Writer.hpp>
+#include <threads/Group.hpp>
+
+#include "S3.hpp"
+
+namespace S3 {
+
+    // large objects: download split to range GETs, upload split to multipart parts.
+    // requests of one transfer run concurrently on Curl::Multi, not more than concurrency parts in memory.
+    class Transfer
+    {
+    public:
+        struct Params
+        {
+            size_t   part_size   = 8 * 1024 * 1024; // multipart upload requires 5MB at least
+            unsigned concurrency = 8;               // requests in flight
+            time_t   timeout_ms  = 60000;           // per request
+        };
+
+        // data passed in order
+        using Handler = std::function<void(std::string_view)>;
+
+    private:
+        API&           m_API;
+        const Params   m_Params;
+        Curl::Multi    m_Multi;
+        Threads::Group m_Group; // stopped first
+
+        // results of requests in flight by part number.
+        // destructor waits for all requests, so buffers and callbacks stay valid on error
+        class Pending
+        {
+            std::mutex                            m_Mutex;
+            std::condition_variable               m_Cond;
+            std::map<size_t, Curl::Multi::Result> m_Done;
+            size_t                                m_Started  = 0;
+            size_t                                m_Finished = 0;
+
+        public:
+            void start(Curl::Multi& aMulti, size_t aPart, const Curl::Client::Request& aRequest)
+            {
+                {
+                    std::unique_lock sLock(m_Mutex);
+                    m_Started++;
+                }
+                aMulti(aRequest, [this, aPart](Curl::Multi::Result&& aResult) {
+                    std::unique_lock sLock(m_Mutex);
+                    m_Done.emplace(aPart, std::move(aResult));
+                    m_Finished++;
+                    m_Cond.notify_all(); // under mutex: Pending can be destroyed right after unlock
+                });
+            }
+
+            Curl::Client::Result wait(size_t aPart)
+            {
+                std::unique_lock sLock(m_Mutex);
+                m_Cond.wait(sLock, [&]() { return m_Done.contains(aPart); });
+                auto sResult = std::move(m_Done.extract(aPart).mapped());
+                sLock.unlock();
+                return sResult.get();
+            }
+
+            ~Pending()
+            {
+                std::unique_lock sLock(m_Mutex);
+                m_Cond.wait(sLock, [this]() { return m_Finished == m_Started; });
+            }
+        };
+
+        Curl::Client::Request make(Curl::Client::Method aMethod, std::string_view aName, API::ContentWithHash aContent, std::string_view aQuery) const
+        {
+            auto sRequest       = m_API.make(aMethod, aName, aContent, aQuery);
+            sRequest.timeout_ms = m_Params.timeout_ms;
+            return sRequest;
+        }
+
+        // read part, short only at end of data
+        void fill(File::IReader& aReader, std::string& aBuffer) const
+        {
+            aBuffer.resize(m_Params.part_size);
+            size_t sSize = 0;
+            while (sSize < aBuffer.size() and !aReader.eof())
+                sSize += aReader.read(aBuffer.data() + sSize, aBuffer.size() - sSize);
+            aBuffer.resize(sSize);
+        }
+
+    public:
+        Transfer(API& aAPI, const Params& aParams)
+        : m_API(aAPI)
+        , m_Params(aParams)
+        , m_Multi({.max_connections = aParams.concurrency, .queue_timeout_ms = unsigned(aParams.timeout_ms)})
+        {
+            if (m_Params.concurrency == 0)
+                throw std::invalid_argument("S3::Transfer: zero concurrency");
+            m_Multi.start(m_Group);
+        }
+
+        void GET(std::string_view aName, const Handler& aHandler)
+        {
+            const auto sHead = m_API.HEAD(aName);
+            if (sHead.status != 200)
+                throw API::Error("HEAD " + std::string(aName), sHead.status);
+
+            const size_t sSize  = sHead.size;
+            const size_t sCount = (sSize + m_Params.part_size - 1) / m_Params.part_size;
+
+            // sha256 known only for objects uploaded by single PUT
+            std::optional<SSLxx::DigestStream> sHash;
+            if (!sHead.sha256.empty())
+                sHash.emplace(EVP_sha256());
+
+            Pending sPending;
+            size_t  sNext = 0;
+            for (size_t i = 0; i < sCount; i++) {
+                for (; sNext < sCount and sNext < i + m_Params.concurrency; sNext++) {
+                    const size_t sBegin   = sNext * m_Params.part_size;
+                    const size_t sEnd     = std::min(sBegin + m_Params.part_size, sSize);
+                    auto         sRequest = make(Curl::Client::Method::GET, aName, {}, {});
+                    sRequest.headers["Range"] = fmt::format("bytes={}-{}", sBegin, sEnd - 1);
+                    sPending.start(m_Multi, sNext, sRequest);
+                }
+
+                auto sResult = sPending.wait(i);
+                if (sResult.status != 206 and sResult.status != 200)
+                    m_API.reportError(sResult);
+                const size_t sExpected = std::min(m_Params.part_size, sSize - i * m_Params.part_size);
+                if (sResult.body.size() != sExpected)
+                    throw std::runtime_error(fmt::format("S3::Transfer: got {} bytes of part {}, expected {}", sResult.body.size(), i, sExpected));
+                if (sHash)
+                    sHash->update(sResult.body);
+                aHandler(sResult.body);
+            }
+            if (sHash and Format::to_hex(sHash->final()) != sHead.sha256)
+                throw std::runtime_error("Checksum mismatch");
+        }
+
+        void GET(std::string_view aName, const std::string& aFileName)
+        {
+            File::FileWriter sWriter(aFileName, O_TRUNC);
+            GET(aName, [&sWriter](std::string_view aData) { sWriter.write(aData.data(), aData.size()); });
+            sWriter.close();
+        }
+
+        // data shorter than part uploaded with single PUT
+        void PUT(std::string_view aName, File::IReader& aReader)
+        {
+            std::vector<std::string> sBuffers(m_Params.concurrency);
+            fill(aReader, sBuffers[0]);
+            if (sBuffers[0].size() < m_Params.part_size) {
+                m_API.PUT(aName, sBuffers[0]);
+                return;
+            }
+
+            const std::string           sUploadId = m_API.startMultipartUpload(aName, {});
+            std::vector<API::UploadTag> sTags;
+            try {
+                Pending sPending;
+                size_t  sStarted  = 0;
+                size_t  sFinished = 0;
+                auto    sComplete = [&]() {
+                    auto sResult = sPending.wait(sFinished);
+                    if (sResult.status != 200)
+                        m_API.reportError(sResult);
+                    sTags[sFinished++].etag = sResult.headers["ETag"];
+                };
+
+                while (true) {
+                    if (sStarted - sFinished == sBuffers.size())
+                        sComplete(); // buffer of oldest part can be reused
+                    auto& sBuffer = sBuffers[sStarted % sBuffers.size()];
+                    if (sStarted > 0)
+                        fill(aReader, sBuffer);
+                    if (sBuffer.empty())
+                        break;
+
+                    // hashed here, while previous parts are on the wire
+                    sTags.push_back({{}, SSLxx::DigestStr(EVP_sha256(), sBuffer)});
+                    sPending.start(m_Multi, sStarted, make(Curl::Client::Method::PUT, aName, {sBuffer, sTags.back().hash}, fmt::format("partNumber={}&uploadId={}", sStarted + 1, sUploadId)));
+                    sStarted++;
+                    if (sBuffer.size() < m_Params.part_size)
+                        break;
+                }
+                while (sFinished < sStarted)
+                    sComplete();
+            } catch (...) {
+                try {
+                    m_API.abortMultipartUpload(aName, sUploadId);
+                } catch (const std::exception& e) {
+                    WARN("fail to abort multipart upload " << sUploadId << ": " << e.what());
+                }
+                throw;
+            }
+            m_API.completeMultipartUpload(aName, sUploadId, sTags);
+        }
+
+        void PUT(std::string_view aName, const std::string& aFileName)
+        {
+            File::FileReader sReader(aFileName);
+            PUT(aName, sReader);
+        }
+    };
+
+} // namespace S3
@@ -2,6 +2,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include "S3.hpp"
+#include "Transfer.hpp"
 
 // minioc mb s3/test
 
@@ -77,6 +78,74 @@ BOOST_AUTO_TEST_CASE(multipart)
     sAPI.DELETE("some_multipart");
 }
 
+// parts of data from memory, as if from file
+struct StringReader : File::IReader
+{
+    std::string_view data;
+    size_t           chunk;
+
+    StringReader(std::string_view aData, size_t aChunk)
+    : data(aData)
+    , chunk(aChunk)
+    {}
+    size_t read(void* aPtr, size_t aSize) override
+    {
+        const size_t sSize = std::min({aSize, chunk, data.size()});
+        memcpy(aPtr, data.data(), sSize);
+        data.remove_prefix(sSize);
+        return sSize;
+    }
+    bool eof() override { return data.empty(); }
+    void close() override {}
+};
+
+BOOST_AUTO_TEST_CASE(transfer)
+{
+    S3::Params   sParams;
+    S3::API      sAPI(sParams);
+    S3::Transfer sTransfer(sAPI, {.part_size = 5 * 1024 * 1024, .concurrency = 3});
+
+    std::string sContent;
+    for (int i = 0; i < 16 * 1024 * 1024 + 12345; i++)
+        sContent.push_back('a' + i % 23);
+
+    auto sGet = [&](std::string_view aName) {
+        std::string sResult;
+        sTransfer.GET(aName, [&sResult](std::string_view aData) { sResult.append(aData); });
+        return sResult;
+    };
+
+    // 3 full parts and tail, more parts than concurrency
+    StringReader sReader(sContent, 1024 * 1024);
+    sTransfer.PUT("some_transfer", sReader);
+    BOOST_CHECK_EQUAL(sAPI.HEAD("some_transfer").parts, 4);
+    BOOST_CHECK(sGet("some_transfer") == sContent);
+
+    // short data with single PUT, checksum validated on GET
+    StringReader sSmall(std::string_view(sContent).substr(0, 12345), 1000);
+    sTransfer.PUT("some_transfer_small", sSmall);
+    BOOST_CHECK_EQUAL(sAPI.HEAD("some_transfer_small").sha256, SSLxx::DigestStr(EVP_sha256(), sContent.substr(0, 12345)));
+    BOOST_CHECK_EQUAL(sGet("some_transfer_small"), sContent.substr(0, 12345));
+
+    BOOST_CHECK_THROW(sGet("some_nx_file"), S3::API::Error);
+
+    // cleanup
+    sAPI.DELETE("some_transfer");
+    sAPI.DELETE("some_transfer_small");
+}
+
+BOOST_AUTO_TEST_CASE(unsigned_payload)
+{
+    S3::Params sParams;
+    sParams.unsigned_payload = true;
+    S3::API sAPI(sParams);
+
+    sAPI.PUT("some_unsigned", "test data");
+    BOOST_CHECK_EQUAL(sAPI.GET("some_unsigned"), "test data");
+    BOOST_CHECK_EQUAL(sAPI.HEAD("some_unsigned").sha256, "");
+    sAPI.DELETE("some_unsigned");
+}
+
 BOOST_AUTO_TEST_CASE(csv)
 {
     S3::Params sParams;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <mutex>
 #include <numeric>
@@ -11,6 +12,7 @@
 #include <etcd/Etcd.hpp>
 #include <hash/Ring.hpp>
 #include <prometheus/Metrics.hpp>
+#include <threads/Rcu.hpp>
 #include <time/Meter.hpp>
 #include <unsorted/Ewma.hpp>
 #include <unsorted/Random.hpp>
@@ -88,18 +90,33 @@ namespace SD::Balancer {
         }
     };
 
+    // call path (test, add) is lock free, except once a second in prepare().
+    // calls of current second accumulated in atomics and passed to m_Ewma on next second
     class PeerInfo
     {
         using Lock = std::unique_lock<std::mutex>;
         mutable std::mutex m_Mutex;
 
         friend class ByWeight;
+        friend class Table;
         const Params      m_Params;
         const std::string m_Key;
 
-        double m_Budget      = 0; // used in ByWeight
-        double m_LastWeight  = 0;
-        time_t m_CurrentTime = 0;
+        double              m_Budget     = 0; // used in ByWeight
+        double              m_LastWeight = 0;
+        std::atomic<time_t> m_CurrentTime{0};
+        std::atomic<bool>   m_Close{false}; // copy of m_Breaker state
+
+        std::atomic<double>   m_Elapsed{0};
+        std::atomic<uint32_t> m_Count{0};
+        std::atomic<uint32_t> m_Success{0};
+
+        // used by Table to choose between two peers
+        static constexpr double LATENCY_FACTOR  = 0.8;
+        static constexpr double FAILURE_PENALTY = 4;   // failed call counted as slow one
+        static constexpr double FAILURE_LATENCY = 1.0; // at least, so failing peer without samples loses
+        std::atomic<int64_t>    m_Inflight{0};
+        std::atomic<double>     m_Latency{0}; // per call ewma, 0 if unknown
 
         Util::EwmaRps m_Ewma;
         Breaker       m_Breaker;
@@ -107,16 +124,41 @@ namespace SD::Balancer {
 
         void prepare(time_t aNow)
         {
-            if (aNow <= m_CurrentTime)
+            if (aNow <= m_CurrentTime.load(std::memory_order_relaxed))
                 return;
-            m_CurrentTime = aNow;
+            Lock         sLock(m_Mutex);
+            const time_t sLast = m_CurrentTime;
+            if (aNow <= sLast)
+                return;
+            const uint32_t sCount = m_Count.exchange(0);
+            if (sCount > 0)
+                m_Ewma.add(sLast, m_Elapsed.exchange(0), sCount, m_Success.exchange(0));
 
             if (m_Params.use_circuit_breaker) {
                 const bool sOldClose = m_Breaker.is_close();
                 m_Breaker.update(m_Ewma.estimate().success_rate);
                 if (!sOldClose and m_Breaker.is_close())
                     m_Metrics.closed.tick();
+                m_Close = m_Breaker.is_close();
             }
+            m_Ewma.add(aNow, 0, 0, 0); // fold previous second
+            m_CurrentTime = aNow;
+        }
+
+        void update_latency(double aLatency)
+        {
+            double sOld = m_Latency.load(std::memory_order_relaxed);
+            while (!m_Latency.compare_exchange_weak(sOld, sOld > 0 ? sOld * LATENCY_FACTOR + aLatency * (1 - LATENCY_FACTOR) : aLatency, std::memory_order_relaxed))
+                ;
+        }
+
+        bool has_latency() const { return m_Latency.load(std::memory_order_relaxed) > 0; }
+
+        // lower is better
+        double cost(double aWeight) const
+        {
+            const int64_t sInflight = std::max<int64_t>(m_Inflight.load(std::memory_order_relaxed), 0);
+            return (sInflight + 1) * m_Latency.load(std::memory_order_relaxed) / aWeight;
         }
 
         void adjust_weight(Entry& aEntry)
@@ -176,21 +218,27 @@ namespace SD::Balancer {
 
         bool test(time_t aNow, bool aKeepAlive = false)
         {
-            Lock sLock(m_Mutex);
             prepare(aNow);
-            if (m_Breaker.is_close() and !aKeepAlive)
+            const bool sClose = m_Close.load(std::memory_order_relaxed);
+            if (sClose and !aKeepAlive)
                 m_Metrics.blocked.tick();
-            return !m_Breaker.is_close();
+            return !sClose;
         }
 
+        // complete call to peer returned by Engine::random()
         void add(time_t aNow, double aLatency, bool aSuccess, bool aBySession = false)
         {
-            Lock sLock(m_Mutex);
             prepare(aNow);
             m_Metrics.allowed.tick();
-            m_Ewma.add(aNow, aLatency, aSuccess);
-            if (!aSuccess)
+            m_Elapsed.fetch_add(aLatency, std::memory_order_relaxed);
+            m_Count.fetch_add(1, std::memory_order_relaxed);
+            if (aSuccess) {
+                m_Success.fetch_add(1, std::memory_order_relaxed);
+                update_latency(aLatency);
+            } else {
                 m_Metrics.failed.tick();
+                update_latency(std::max(aLatency * FAILURE_PENALTY, FAILURE_LATENCY));
+            }
             if (aBySession)
                 m_Metrics.session.tick();
         }
@@ -214,18 +262,198 @@ namespace SD::Balancer {
         };
 
         const std::string& key() const { return m_Key; }
+        int64_t            inflight() const { return m_Inflight.load(std::memory_order_relaxed); }
 
         void reset(double aLatency, double aSuccessRate)
         {
             Lock sLock(m_Mutex);
             m_CurrentTime = 0;
+            m_Count       = 0;
+            m_Elapsed     = 0;
+            m_Success     = 0;
+            m_Latency     = aLatency;
             m_Ewma.reset({aLatency, 0, aSuccessRate});
             m_Breaker.reset();
+            m_Close = false;
         }
     };
     using PeerInfoPtr = std::shared_ptr<PeerInfo>;
     using Pair        = std::pair<PeerInfoPtr, bool /* sticky session */>;
 
+    // immutable peer table, Engine publish new one after every update.
+    // pick is power of two choices: first peer from precomputed weighted round robin schedule,
+    // second is random one. less loaded (in-flight calls * latency / weight) wins.
+    // without latency data for any of them first one used, so calls distributed by weight.
+    // session calls spend per peer budgets, like ByWeight::try_session.
+    class Table : public boost::noncopyable
+    {
+        static constexpr uint32_t SCHEDULE   = 4096;
+        static constexpr uint32_t NONE       = -1;
+        static constexpr double   MIN_WEIGHT = 0.0000001;
+        static constexpr double   MAX_UTIL   = 0.9;
+
+        std::vector<PeerInfoPtr> m_Info;
+        std::vector<Entry>       m_Peers;
+        std::vector<uint32_t>    m_Schedule;
+        Hash::Ring               m_Ring; // same as in ByWeight, so session goes to the same peer
+        double                   m_TotalWeight  = 0;
+        double                   m_Step         = 0;
+        bool                     m_SecondChance = false;
+
+        mutable std::vector<std::atomic<double>> m_Budget; // spent by calls with session only
+
+        // smooth weighted round robin, like in nginx
+        void build_schedule()
+        {
+            std::vector<double> sCurrent(m_Peers.size(), 0);
+            m_Schedule.resize(SCHEDULE);
+            for (auto& x : m_Schedule) {
+                uint32_t sBest = 0;
+                for (uint32_t i = 0; i < m_Peers.size(); i++) {
+                    sCurrent[i] += m_Peers[i].weight;
+                    if (sCurrent[i] > sCurrent[sBest])
+                        sBest = i;
+                }
+                sCurrent[sBest] -= m_TotalWeight;
+                x = sBest;
+            }
+        }
+
+        // thread own position in schedule, so threads do not share counter
+        uint32_t next() const
+        {
+            thread_local uint32_t sPos = Util::randomInt(SCHEDULE);
+            return m_Schedule[sPos++ % SCHEDULE];
+        }
+
+        // random peer, other than aExclude if possible
+        uint32_t other(uint32_t aExclude) const
+        {
+            const uint32_t sStart = Util::randomInt(SCHEDULE);
+            for (uint32_t i = 0; i < SCHEDULE; i++) {
+                const uint32_t sPos = m_Schedule[(sStart + i) % SCHEDULE];
+                if (sPos != aExclude)
+                    return sPos;
+            }
+            return aExclude;
+        }
+
+        bool spend(uint32_t aPos) const
+        {
+            double sOld = m_Budget[aPos].load(std::memory_order_relaxed);
+            while (sOld >= m_Step) {
+                if (m_Budget[aPos].compare_exchange_weak(sOld, sOld - m_Step, std::memory_order_relaxed))
+                    return true;
+            }
+            return false;
+        }
+
+        // refill when all budgets spent. capped by weight, so concurrent rewinds are harmless
+        void rewind() const
+        {
+            for (auto& x : m_Budget)
+                if (x.load(std::memory_order_relaxed) >= m_Step)
+                    return;
+            for (uint32_t i = 0; i < m_Peers.size(); i++) {
+                double sOld = m_Budget[i].load(std::memory_order_relaxed);
+                while (!m_Budget[i].compare_exchange_weak(sOld, std::min(sOld + m_Peers[i].weight, m_Peers[i].weight), std::memory_order_relaxed))
+                    ;
+            }
+        }
+
+        uint32_t session(uint64_t aSession) const
+        {
+            rewind();
+            for (auto sPos : m_Ring(aSession)) {
+                if (m_Peers[sPos].weight > 0 and !m_Info[sPos]->m_Close.load(std::memory_order_relaxed) and spend(sPos)) {
+                    assert(m_Info[sPos]->m_Key == m_Peers[sPos].key);
+                    return sPos;
+                }
+            }
+            return NONE;
+        }
+
+        // in-flight call lasts while returned pointer alive, even if PeerInfo::add() not called
+        Pair acquire(uint32_t aPos, bool aBySession) const
+        {
+            const auto& sInfo = m_Info[aPos];
+            sInfo->m_Inflight.fetch_add(1, std::memory_order_relaxed);
+            return {PeerInfoPtr(sInfo.get(), [sInfo](PeerInfo* aInfo) { aInfo->m_Inflight.fetch_sub(1, std::memory_order_relaxed); }), aBySession};
+        }
+
+    public:
+        Table() = default;
+
+        Table(const Params& aParams, const std::vector<PeerInfoPtr>& aInfo, const std::vector<Entry>& aPeers, const Hash::Ring& aRing, double aStep)
+        : m_Info(aInfo.begin(), aInfo.begin() + aPeers.size())
+        , m_Peers(aPeers)
+        , m_Ring(aRing)
+        , m_Step(aStep)
+        , m_Budget(aPeers.size())
+        {
+            double sRPS = 0;
+            for (uint32_t i = 0; i < m_Peers.size(); i++) {
+                sRPS += m_Peers[i].rps;
+                m_TotalWeight += m_Peers[i].weight;
+                m_Budget[i] = m_Peers[i].weight;
+            }
+            m_SecondChance = aParams.second_chance and m_Peers.size() > 1 and sRPS / m_TotalWeight < MAX_UTIL;
+            if (m_TotalWeight < MIN_WEIGHT)
+                return;
+            build_schedule();
+        }
+
+        // allow peers to recover from `CB closed` state
+        void keep_alive(time_t aNow) const
+        {
+            for (auto& x : m_Info)
+                x->test(aNow, true /* keep alive */);
+        }
+
+        // complete call with PeerInfo::add()
+        Pair random(time_t aNow, const std::optional<uint64_t>& aSession) const
+        {
+            if (empty() or m_TotalWeight < MIN_WEIGHT)
+                throw Error("SD: no peers available");
+
+            const bool sSession   = aSession.has_value() and m_Peers.size() > 1;
+            bool       sBySession = false;
+            uint32_t   sEntry     = NONE;
+            uint32_t   sOther     = NONE;
+            if (sSession) {
+                sEntry = session(aSession.value());
+                if (sEntry != NONE)
+                    sBySession = true;
+            }
+            if (sEntry == NONE) {
+                sEntry = next();
+                sOther = other(sEntry);
+                if (m_Info[sEntry]->has_latency() and m_Info[sOther]->has_latency() and
+                    m_Info[sOther]->cost(m_Peers[sOther].weight) < m_Info[sEntry]->cost(m_Peers[sEntry].weight))
+                    std::swap(sEntry, sOther);
+                if (sSession) // as ByWeight::random_i spends budget
+                    m_Budget[sEntry].fetch_sub(m_Step, std::memory_order_relaxed);
+            }
+            if (m_SecondChance) {
+                if (m_Info[sEntry]->test(aNow))
+                    return acquire(sEntry, sBySession);
+                sBySession = false;
+                sEntry     = sOther != NONE ? sOther : other(sEntry);
+            }
+            if (!m_Info[sEntry]->test(aNow))
+                throw Error("SD: request to " + m_Peers[sEntry].key + " blocked by circuit breaker");
+
+            return acquire(sEntry, sBySession);
+        }
+
+        const std::vector<Entry>& state() const { return m_Peers; }
+
+        bool   empty() const { return m_Peers.empty(); }
+        size_t size() const { return m_Peers.size(); }
+    };
+
+    // keeps peer weights. random() is budget based and not thread safe,
+    // Engine picks via Table built by table()
     class ByWeight
     {
 #ifdef BOOST_TEST_MODULE
@@ -413,6 +641,8 @@ namespace SD::Balancer {
 
         std::vector<Entry> state() const { return m_Peers; }
 
+        std::unique_ptr<Table> table() const { return std::make_unique<Table>(m_Params, m_Info, m_Peers, m_Ring, m_Step); }
+
         void   clear() { m_Peers.clear(); }
         bool   empty() const { return m_Peers.empty(); }
         size_t size() const { return m_Peers.size(); }
@@ -429,11 +659,20 @@ namespace SD::Balancer {
     public:
 #endif
         using Lock = std::unique_lock<std::mutex>;
-        mutable std::mutex m_Mutex;
+        mutable std::mutex m_Mutex; // serialize updates
         ByWeight           m_State;
 
+        Threads::Rcu<Table> m_Table{std::make_unique<Table>()};
+        std::atomic<time_t> m_LastTime{0};
+
         std::string m_LastError;
 
+        // lock must be held
+        void publish()
+        {
+            m_Table.update(m_State.table());
+        }
+
         void read_i(boost::asio::yield_context yield)
         {
             Etcd::Client       sClient(m_Service, m_Params.addr, yield);
@@ -463,6 +702,7 @@ namespace SD::Balancer {
         {
             Lock lk(m_Mutex);
             m_State.update(std::move(aState));
+            publish();
             m_LastError.clear();
         }
 
@@ -492,10 +732,14 @@ namespace SD::Balancer {
             return m_State.state();
         }
 
+        // lock free. call PeerInfo::add() or wrap() when call completed
         Pair random(time_t aNow = time(nullptr), std::optional<uint64_t> aSession = {})
         {
-            Lock lk(m_Mutex);
-            return m_State.random(aNow, aSession);
+            auto   sTable = m_Table.read();
+            time_t sLast  = m_LastTime.load(std::memory_order_relaxed);
+            if (aNow > sLast and m_LastTime.compare_exchange_strong(sLast, aNow))
+                sTable->keep_alive(aNow);
+            return sTable->random(aNow, aSession);
         }
 
         std::string lastError() const
@@ -528,6 +772,7 @@ namespace SD::Balancer {
                     }
                     Lock lk(m_Mutex);
                     m_State.clear();
+                    publish();
                     m_LastError = "stopped";
                 });
             return sPromise->get_future();
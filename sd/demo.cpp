@@ -70,13 +70,39 @@ struct Server
     }
 };
 
+// picks per second from aThreads threads. every pick completed with add(), like real call
+template <class P>
+double contention(unsigned aThreads, double aTime, P&& aPick)
+{
+    std::atomic<bool>     sStop{false};
+    std::atomic<uint64_t> sCount{0};
+    Threads::Group        sGroup;
+    sGroup.start(
+        [&]() {
+            uint64_t sLocal = 0;
+            while (!sStop) {
+                const time_t sNow  = time(nullptr);
+                auto         sPeer = aPick(sNow);
+                sPeer->add(sNow, 0.001, true);
+                sLocal++;
+            }
+            sCount += sLocal;
+        },
+        aThreads);
+    Threads::sleep(aTime);
+    sStop = true;
+    sGroup.wait();
+    return sCount / aTime;
+}
+
 int main(int argc, char** argv)
 {
     // clang-format off
     po::options_description desc("Program options");
     desc.add_options()("help,h", "show usage information")
     ("load", po::value<float>()->default_value(0.5), "load level (1 = 100% of cluster capacity)")
-    ("time", po::value<time_t>()->default_value(60), "time to run in seconds");
+    ("time", po::value<time_t>()->default_value(60), "time to run in seconds")
+    ("contention", po::value<unsigned>()->default_value(0), "compare pick rate with global mutex and lock free, up to given number of threads");
     // clang-format on
 
     po::variables_map vm;
@@ -132,6 +158,22 @@ int main(int argc, char** argv)
     };
     sRefresh();
 
+    if (const unsigned sMaxThreads = vm["contention"].as<unsigned>(); sMaxThreads > 0) {
+        std::mutex sMutex; // how Engine::random worked before lock free table
+        std::cout << "threads,mutex,lock_free" << std::endl;
+        for (unsigned sThreads = 1; sThreads <= sMaxThreads; sThreads *= 2) {
+            const double sMutexRate = contention(sThreads, 2, [&](time_t aNow) {
+                std::unique_lock sLock(sMutex);
+                return sBalancer->m_State.random(aNow, {}).first;
+            });
+            const double sFreeRate = contention(sThreads, 2, [&](time_t aNow) {
+                return sBalancer->random(aNow).first;
+            });
+            std::cout << sThreads << ',' << sMutexRate << ',' << sFreeRate << std::endl;
+        }
+        return 0;
+    }
+
     const uint32_t TOTAL_WEIGHT  = sBalancer->m_State.m_TotalWeight;
     const int      REQUEST_COUNT = TOTAL_WEIGHT * vm["load"].as<float>();
 
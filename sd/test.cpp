@@ -285,6 +285,7 @@ BOOST_AUTO_TEST_CASE(with_session)
 
     // to place 10 calls to single peer, set minimal step to 1
     sFixture.m_Balancer->m_State.m_Step = 1;
+    sFixture.m_Balancer->publish();
     for (size_t i = 0; i < 10; i++) {
         auto sPair = sFixture.m_Balancer->random(1 /* timestamp */, 5 /* single session */);
         sPair.first->add(1 /* timestamp */, 0, true, sPair.second);
@@ -305,4 +306,78 @@ BOOST_AUTO_TEST_CASE(with_session)
     }
     BOOST_CHECK_EQUAL(10, sCalls);
 }
+BOOST_AUTO_TEST_CASE(power_of_two)
+{
+    WithBreaker            sFixture;
+    std::vector<SD::Entry> sData{{.key = "a", .weight = 10}, {.key = "b", .weight = 10}, {.key = "c", .weight = 10}};
+    sFixture.m_Balancer->update(std::move(sData));
+
+    // slow peer loses when compared with fast one
+    const std::map<std::string, double> sLatency{{"a", 0.01}, {"b", 0.01}, {"c", 0.1}};
+    std::map<std::string, size_t>       sStat;
+    const size_t                        COUNT = 20000;
+    for (size_t i = 0; i < COUNT; i++) {
+        auto sPeer = sFixture.m_Balancer->random(1).first;
+        sPeer->add(1, sLatency.at(sPeer->key()), true);
+        sStat[sPeer->key()]++;
+    }
+    for (auto& x : sStat)
+        BOOST_TEST_MESSAGE(x.first << ": " << x.second);
+    BOOST_CHECK_LT(sStat["c"], COUNT / 6);
+    BOOST_CHECK_GT(sStat["a"], COUNT / 3);
+}
+BOOST_AUTO_TEST_CASE(power_of_two_failure)
+{
+    WithBreaker            sFixture;
+    std::vector<SD::Entry> sData{{.key = "a", .weight = 10}, {.key = "b", .weight = 10}, {.key = "c", .weight = 10}};
+    sFixture.m_Balancer->update(std::move(sData));
+
+    // failing peer has no latency samples from success, but must not attract calls
+    std::map<std::string, size_t> sStat;
+    const size_t                  COUNT = 20000;
+    for (size_t i = 0; i < COUNT; i++) {
+        auto sPeer = sFixture.m_Balancer->random(1).first;
+        if (sPeer->key() == "c")
+            sPeer->add(1, 0, false);
+        else
+            sPeer->add(1, 0.01, true);
+        sStat[sPeer->key()]++;
+    }
+    for (auto& x : sStat)
+        BOOST_TEST_MESSAGE(x.first << ": " << x.second);
+    BOOST_CHECK_LT(sStat["c"], COUNT / 6);
+
+    // in-flight released without add()
+    for (size_t i = 0; i < 10; i++)
+        sFixture.m_Balancer->random(1);
+    for (auto& x : sFixture.m_Balancer->m_State.m_Info)
+        BOOST_CHECK_EQUAL(x->inflight(), 0);
+}
+BOOST_AUTO_TEST_CASE(concurrent)
+{
+    WithBreaker sFixture;
+    auto        sState = [](double aWeight) {
+        return std::vector<SD::Entry>{{.key = "a", .weight = aWeight}, {.key = "b", .weight = 10}};
+    };
+    sFixture.m_Balancer->update(sState(10));
+
+    std::atomic<bool>   sStop{false};
+    std::atomic<size_t> sCount{0};
+    Threads::Group      sGroup;
+    sGroup.start(
+        [&]() {
+            while (!sStop) {
+                auto sPeer = sFixture.m_Balancer->random(1).first;
+                sPeer->add(1, 0.001, true);
+                sCount++;
+            }
+        },
+        4);
+    for (int i = 0; i < 100; i++)
+        sFixture.m_Balancer->update(sState(1 + i % 10)); // table replaced under readers
+    sStop = true;
+    sGroup.wait();
+    BOOST_TEST_MESSAGE("picks: " << sCount);
+    BOOST_CHECK_GT(sCount, 0);
+}
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -3,8 +3,11 @@
 #include <sqlite3.h>
 
 #include <functional>
+#include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include <boost/core/noncopyable.hpp>
 
@@ -50,27 +53,81 @@ namespace Lite {
         }
 
     public:
+        template <class X>
+        void Bind(unsigned aIndex, const X& aValue)
+        {
+            if constexpr (std::is_same_v<X, std::nullptr_t>) {
+                Check(sqlite3_bind_null(m_Statement, aIndex));
+            } else if constexpr (std::is_same_v<X, bool> or std::numeric_limits<X>::is_integer) {
+                Check(sqlite3_bind_int64(m_Statement, aIndex, aValue));
+            } else if constexpr (std::is_floating_point_v<X>) {
+                Check(sqlite3_bind_double(m_Statement, aIndex, aValue));
+            } else if constexpr (std::is_same_v<X, std::string_view>) {
+                Check(sqlite3_bind_text(m_Statement, aIndex, aValue.data(), aValue.size(), SQLITE_STATIC));
+            } else if constexpr (std::is_same_v<X, std::string>) {
+                Check(sqlite3_bind_text(m_Statement, aIndex, aValue.data(), aValue.size(), SQLITE_STATIC));
+            } else {
+                throw std::invalid_argument("assign: not supported type");
+            }
+        }
+
         template <class... T>
         void Assign(T&&... a)
         {
             unsigned sIndex = 1;
             Mpl::for_each_argument(
                 [this, &sIndex](auto&& aValue) {
-                    using X = std::decay_t<decltype(aValue)>;
-                    if constexpr (std::numeric_limits<X>::is_integer) {
-                        Check(sqlite3_bind_int64(m_Statement, sIndex, aValue));
-                    } else if constexpr (std::is_same_v<X, std::string_view>) {
-                        Check(sqlite3_bind_text(m_Statement, sIndex, aValue.data(), aValue.size(), SQLITE_STATIC));
-                    } else if constexpr (std::is_same_v<X, std::string>) {
-                        Check(sqlite3_bind_text(m_Statement, sIndex, aValue.data(), aValue.size(), SQLITE_STATIC));
-                    } else {
-                        throw std::invalid_argument("assign: not supported type");
-                    }
+                    Bind(sIndex, aValue);
                     sIndex++;
                 },
                 a...);
         }
 
+        // true if row available
+        bool Step()
+        {
+            const int sCode = sqlite3_step(m_Statement);
+            if (sCode == SQLITE_ROW)
+                return true;
+            if (sCode != SQLITE_DONE)
+                Check(sCode);
+            return false;
+        }
+
+        // run statement without result rows, returns number of changed rows
+        int Execute()
+        {
+            Util::Raii sCleanup([this]() { Reset(); });
+            while (Step())
+                ;
+            return sqlite3_changes(m_Handle);
+        }
+
+        // typed row access: aHandler(const Statement&) called for every row
+        template <class T>
+        void Fetch(T&& aHandler)
+        {
+            Util::Raii sCleanup([this]() { Reset(); });
+            while (Step())
+                aHandler(std::as_const(*this));
+        }
+
+        unsigned         Columns() const { return m_Columns; }
+        const char*      Name(unsigned i) const { return m_Names[i]; }
+        bool             IsNull(unsigned i) const { return sqlite3_column_type(m_Statement, i) == SQLITE_NULL; }
+        int64_t          Int(unsigned i) const { return sqlite3_column_int64(m_Statement, i); }
+        double           Double(unsigned i) const { return sqlite3_column_double(m_Statement, i); }
+        std::string_view Text(unsigned i) const
+        {
+            auto sPtr = (const char*)sqlite3_column_text(m_Statement, i);
+            return std::string_view(sPtr, sPtr ? sqlite3_column_bytes(m_Statement, i) : 0);
+        }
+        std::string_view Blob(unsigned i) const
+        {
+            auto sPtr = (const char*)sqlite3_column_blob(m_Statement, i);
+            return std::string_view(sPtr, sPtr ? sqlite3_column_bytes(m_Statement, i) : 0);
+        }
+
         template <class T>
         void Use(T&& aHandler)
         {
@@ -112,6 +169,8 @@ namespace Lite {
     {
         sqlite3* m_Handle = nullptr;
 
+        std::map<std::string, std::unique_ptr<Statement>, std::less<>> m_Cache;
+
         static int Callback(void* aCB, int aColumns, char** aValues, char** aNames)
         {
             if (aCB == nullptr)
@@ -148,6 +207,7 @@ namespace Lite {
 
         void close()
         {
+            m_Cache.clear();
             Check(sqlite3_close(m_Handle));
             m_Handle = nullptr;
         }
@@ -175,6 +235,32 @@ namespace Lite {
             return Statement(m_Handle, sData);
         }
 
+        // prepared once and kept until close.
+        // reset on every call: previous user may not run it, and stale bindings must not leak
+        Statement& Cached(std::string_view aQuery)
+        {
+            auto sIt = m_Cache.find(aQuery);
+            if (sIt == m_Cache.end()) {
+                sqlite3_stmt* sData = nullptr;
+                Check(sqlite3_prepare_v3(m_Handle, aQuery.data(), aQuery.size(), SQLITE_PREPARE_PERSISTENT, &sData, nullptr));
+                sIt = m_Cache.emplace(aQuery, std::unique_ptr<Statement>(new Statement(m_Handle, sData))).first;
+            } else {
+                sIt->second->Reset();
+            }
+            return *sIt->second;
+        }
+
+        void BusyTimeout(int aMs)
+        {
+            Check(sqlite3_busy_timeout(m_Handle, aMs));
+        }
+
+        // false if statement error rolled back current transaction
+        bool InTransaction() const
+        {
+            return sqlite3_get_autocommit(m_Handle) == 0;
+        }
+
         ~DB()
         {
             try {
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "Lite.hpp"
+
+namespace Lite {
+
+    struct StoreParams
+    {
+        std::string path;                 // database file, WAL needs real file
+        std::string schema;               // executed once by writer on start
+        size_t      batch        = 1000;  // max writes in one transaction
+        int         busy_timeout = 5000;  // ms
+        bool        sync         = false; // synchronous=FULL, NORMAL otherwise: WAL survives process crash, not power loss
+    };
+
+    // storage engine mode:
+    // single writer thread takes all queued writes and commits them in one transaction,
+    // so concurrent writers share one WAL sync.
+    // every reader thread gets own read-only connection with cached prepared statements.
+    // connections live until Store destroyed.
+    class Store : public boost::noncopyable
+    {
+    public:
+        using Value = std::variant<std::nullptr_t, int64_t, double, std::string>;
+
+    private:
+        struct Item
+        {
+            std::string        query;
+            std::vector<Value> args;
+            std::promise<int>  promise;
+        };
+
+        const StoreParams m_Params;
+        const uint64_t    m_Serial;
+        DB                m_Writer;
+
+        std::mutex              m_Mutex;
+        std::condition_variable m_Cond;
+        std::deque<Item>        m_Queue;
+        bool                    m_Stop = false;
+        std::atomic<uint64_t>   m_Batches{0};
+        std::atomic<uint64_t>   m_Writes{0};
+
+        std::mutex                       m_ReadersMutex;
+        std::vector<std::unique_ptr<DB>> m_Readers;
+
+        std::thread m_Thread;
+
+        static uint64_t NextSerial()
+        {
+            static std::atomic<uint64_t> sSerial{0};
+            return ++sSerial;
+        }
+
+        template <class X>
+        static Value Convert(X&& aValue)
+        {
+            using T = std::decay_t<X>;
+            if constexpr (std::is_same_v<T, std::nullptr_t>)
+                return nullptr;
+            else if constexpr (std::is_same_v<T, bool> or std::numeric_limits<T>::is_integer)
+                return int64_t(aValue);
+            else if constexpr (std::is_floating_point_v<T>)
+                return double(aValue);
+            else
+                return std::string(std::forward<X>(aValue));
+        }
+
+        void Commit(std::deque<Item>& aBatch)
+        {
+            std::vector<std::exception_ptr> sErrors(aBatch.size());
+            std::vector<int>                sChanges(aBatch.size());
+            try {
+                m_Writer.Cached("BEGIN IMMEDIATE").Execute();
+                for (size_t i = 0; i < aBatch.size(); i++) {
+                    try {
+                        auto& sStmt = m_Writer.Cached(aBatch[i].query);
+                        for (unsigned j = 0; j < aBatch[i].args.size(); j++)
+                            std::visit([&sStmt, j](auto& x) { sStmt.Bind(j + 1, x); }, aBatch[i].args[j]);
+                        sChanges[i] = sStmt.Execute();
+                    } catch (...) {
+                        // constraint errors fail only own statement,
+                        // but IO/OOM errors roll back whole transaction
+                        if (!m_Writer.InTransaction())
+                            throw;
+                        sErrors[i] = std::current_exception();
+                    }
+                }
+                m_Writer.Cached("COMMIT").Execute();
+            } catch (...) {
+                if (m_Writer.InTransaction()) {
+                    try {
+                        m_Writer.Cached("ROLLBACK").Execute();
+                    } catch (...) {
+                    }
+                }
+                std::fill(sErrors.begin(), sErrors.end(), std::current_exception());
+            }
+
+            m_Batches++;
+            m_Writes += aBatch.size();
+            for (size_t i = 0; i < aBatch.size(); i++) {
+                if (sErrors[i])
+                    aBatch[i].promise.set_exception(sErrors[i]);
+                else
+                    aBatch[i].promise.set_value(sChanges[i]);
+            }
+        }
+
+        void Run()
+        {
+            std::deque<Item> sBatch;
+            while (true) {
+                {
+                    std::unique_lock sLock(m_Mutex);
+                    m_Cond.wait(sLock, [this]() { return m_Stop or !m_Queue.empty(); });
+                    if (m_Queue.empty())
+                        return;
+                    if (m_Queue.size() <= m_Params.batch) {
+                        sBatch.swap(m_Queue);
+                    } else {
+                        for (size_t i = 0; i < m_Params.batch; i++) {
+                            sBatch.push_back(std::move(m_Queue.front()));
+                            m_Queue.pop_front();
+                        }
+                    }
+                }
+                Commit(sBatch);
+                sBatch.clear();
+            }
+        }
+
+        DB& Reader()
+        {
+            // keyed by serial: entries of destroyed stores never looked up again
+            thread_local std::unordered_map<uint64_t, DB*> sReaders;
+
+            auto& sReader = sReaders[m_Serial];
+            if (sReader == nullptr) {
+                auto sDB = std::make_unique<DB>(m_Params.path, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX);
+                sDB->BusyTimeout(m_Params.busy_timeout);
+                sReader = sDB.get();
+                std::unique_lock sLock(m_ReadersMutex);
+                m_Readers.push_back(std::move(sDB));
+            }
+            return *sReader;
+        }
+
+    public:
+        Store(const StoreParams& aParams)
+        : m_Params(aParams)
+        , m_Serial(NextSerial())
+        , m_Writer(aParams.path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX)
+        {
+            m_Writer.BusyTimeout(m_Params.busy_timeout);
+            m_Writer.Query("PRAGMA journal_mode=WAL", [](int, char const* const*, char const* const*) {});
+            m_Writer.Query(m_Params.sync ? "PRAGMA synchronous=FULL" : "PRAGMA synchronous=NORMAL");
+            if (!m_Params.schema.empty())
+                m_Writer.Query(m_Params.schema);
+            m_Thread = std::thread([this]() { Run(); });
+        }
+
+        // queue write, future gets number of changed rows or error
+        template <class... A>
+        std::future<int> Write(std::string aQuery, A&&... aArgs)
+        {
+            Item sItem{std::move(aQuery), {Convert(std::forward<A>(aArgs))...}, {}};
+            auto sFuture = sItem.promise.get_future();
+            {
+                std::unique_lock sLock(m_Mutex);
+                if (m_Stop)
+                    throw Error("store stopped");
+                m_Queue.push_back(std::move(sItem));
+            }
+            m_Cond.notify_one();
+            return sFuture;
+        }
+
+        // aHandler(const Statement&) called for every row, arguments bound without copy
+        template <class H, class... A>
+        void Read(std::string_view aQuery, H&& aHandler, const A&... aArgs)
+        {
+            auto& sStmt = Reader().Cached(aQuery);
+            sStmt.Assign(aArgs...);
+            sStmt.Fetch(std::forward<H>(aHandler));
+        }
+
+        uint64_t Batches() const { return m_Batches; }
+        uint64_t Writes() const { return m_Writes; }
+
+        // queued writes committed before exit
+        ~Store()
+        {
+            {
+                std::unique_lock sLock(m_Mutex);
+                m_Stop = true;
+            }
+            m_Cond.notify_one();
+            m_Thread.join();
+            std::unique_lock sLock(m_ReadersMutex);
+            m_Readers.clear();
+        }
+    };
+} // namespace Lite
@@ -2,8 +2,11 @@
 #include <xxhash.h>
 
 #include <filesystem>
+#include <optional>
+#include <random>
 
 #include "Lite.hpp"
+#include "Store.hpp"
 
 #include <parser/Atoi.hpp>
 #include <prometheus/Histogramm.hpp>
@@ -98,4 +101,67 @@ static void BM_GetSet(benchmark::State& state)
 }
 BENCHMARK(BM_GetSet)->UseRealTime()->Unit(benchmark::kMillisecond);
 
+// Lite::Store shared by benchmark threads, created by first thread before loop
+static std::unique_ptr<Lite::Store> sStore;
+constexpr int                       STORE_KEYS = 100000;
+
+static void StoreSetup(benchmark::State& state, size_t aBatch)
+{
+    if (state.thread_index() != 0)
+        return;
+    for (auto x : {"__store.db", "__store.db-wal", "__store.db-shm"})
+        std::filesystem::remove(x);
+    sStore = std::make_unique<Lite::Store>(Lite::StoreParams{
+        .path   = "__store.db",
+        .schema = "CREATE TABLE kv(Key INTEGER PRIMARY KEY, Value TEXT NOT NULL)",
+        .batch  = aBatch});
+}
+
+static void StoreTeardown(benchmark::State& state, uint64_t aOps)
+{
+    state.counters["rps"] = benchmark::Counter(aOps, benchmark::Counter::kIsRate);
+    if (state.thread_index() != 0)
+        return;
+    state.counters["writes/batch"] = sStore->Writes() / std::max<double>(1, sStore->Batches());
+    sStore.reset();
+}
+
+// every thread waits own write. batch=1 is transaction per write, as with plain prepared statement
+static void BM_StoreWrite(benchmark::State& state)
+{
+    StoreSetup(state, state.range(0));
+    const std::string sValue(100, 'x');
+    std::minstd_rand  sRandom(state.thread_index() + 1);
+    uint64_t          sOps = 0;
+
+    for (auto _ : state) {
+        sStore->Write("REPLACE INTO kv(Key, Value) VALUES (?, ?)", sRandom() % STORE_KEYS, sValue).get();
+        sOps++;
+    }
+    StoreTeardown(state, sOps);
+}
+BENCHMARK(BM_StoreWrite)->ArgName("batch")->Arg(1)->Arg(1000)->Threads(1)->Threads(8)->UseRealTime();
+
+// 9 reads per write, readers use own WAL connections in parallel with writer
+static void BM_StoreMixed(benchmark::State& state)
+{
+    StoreSetup(state, 1000);
+    const std::string sValue(100, 'x');
+    std::minstd_rand  sRandom(state.thread_index() + 1);
+    uint64_t          sOps   = 0;
+    uint64_t          sFound = 0;
+
+    for (auto _ : state) {
+        const int64_t sKey = sRandom() % STORE_KEYS;
+        if (sOps % 10 == 0)
+            sStore->Write("REPLACE INTO kv(Key, Value) VALUES (?, ?)", sKey, sValue).get();
+        else
+            sStore->Read("SELECT Value FROM kv WHERE Key = ?", [&sFound](const Lite::Statement& aRow) { sFound += aRow.Text(0).size(); }, sKey);
+        sOps++;
+    }
+    benchmark::DoNotOptimize(sFound);
+    StoreTeardown(state, sOps);
+}
+BENCHMARK(BM_StoreMixed)->Threads(1)->Threads(8)->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -1,7 +1,11 @@
 #define BOOST_TEST_MODULE Suites
 #include <boost/test/unit_test.hpp>
 
+#include <filesystem>
+#include <thread>
+
 #include "Lite.hpp"
+#include "Store.hpp"
 
 BOOST_AUTO_TEST_SUITE(SqlLite)
 BOOST_AUTO_TEST_CASE(simple)
@@ -87,4 +91,101 @@ BOOST_AUTO_TEST_CASE(attach)
         BOOST_TEST_MESSAGE(aValues[0] << '\t' << aValues[1] << '\t' << aValues[2]);
     });
 }
+BOOST_AUTO_TEST_CASE(typed)
+{
+    Lite::DB sDB;
+    sDB.Query("CREATE TABLE items(Id INTEGER PRIMARY KEY, Name TEXT, Price REAL, Data BLOB)");
+    auto& sInsert = sDB.Cached("INSERT INTO items(Name, Price, Data) VALUES (?, ?, ?)");
+    BOOST_CHECK_EQUAL(&sInsert, &sDB.Cached("INSERT INTO items(Name, Price, Data) VALUES (?, ?, ?)"));
+    sInsert.Assign(std::string_view("apple"), 1.5, nullptr);
+    BOOST_CHECK_EQUAL(sInsert.Execute(), 1);
+    sInsert.Assign(std::string_view("pear"), 2, std::string_view("raw"));
+    BOOST_CHECK_EQUAL(sInsert.Execute(), 1);
+
+    unsigned sRows = 0;
+    sDB.Cached("SELECT Id, Name, Price, Data FROM items ORDER BY Id").Fetch([&sRows](const Lite::Statement& aRow) {
+        BOOST_REQUIRE_EQUAL(aRow.Columns(), 4);
+        BOOST_CHECK_EQUAL(aRow.Name(1), "Name");
+        BOOST_CHECK_EQUAL(aRow.Int(0), sRows + 1);
+        if (sRows == 0) {
+            BOOST_CHECK_EQUAL(aRow.Text(1), "apple");
+            BOOST_CHECK_EQUAL(aRow.Double(2), 1.5);
+            BOOST_CHECK(aRow.IsNull(3));
+            BOOST_CHECK(aRow.Blob(3).empty());
+        } else {
+            BOOST_CHECK_EQUAL(aRow.Text(1), "pear");
+            BOOST_CHECK_EQUAL(aRow.Double(2), 2);
+            BOOST_CHECK_EQUAL(aRow.Blob(3), "raw");
+        }
+        sRows++;
+    });
+    BOOST_CHECK_EQUAL(sRows, 2);
+    BOOST_CHECK_THROW(sDB.Cached("SELECT * FROM none"), Lite::Error);
+
+    // abandoned bindings not passed to next user
+    sDB.Cached("SELECT ?, ?").Assign(1, 2);
+    auto& sSelect = sDB.Cached("SELECT ?, ?");
+    sSelect.Assign(3);
+    sSelect.Fetch([](const Lite::Statement& aRow) {
+        BOOST_CHECK_EQUAL(aRow.Int(0), 3);
+        BOOST_CHECK(aRow.IsNull(1));
+    });
+}
+BOOST_AUTO_TEST_CASE(store)
+{
+    std::filesystem::remove("__test.store.db");
+    std::filesystem::remove("__test.store.db-wal");
+    std::filesystem::remove("__test.store.db-shm");
+
+    const unsigned THREADS = 4;
+    const unsigned WRITES  = 500;
+    {
+        Lite::Store sStore({.path = "__test.store.db", .schema = "CREATE TABLE kv(Key INTEGER PRIMARY KEY, Value TEXT NOT NULL)"});
+
+        // boost test is not thread safe: check results after join
+        std::vector<std::thread> sThreads;
+        std::atomic<unsigned>    sChanged{0};
+        for (unsigned t = 0; t < THREADS; t++)
+            sThreads.emplace_back([&sStore, &sChanged, t]() {
+                std::vector<std::future<int>> sResult;
+                for (unsigned i = 0; i < WRITES; i++)
+                    sResult.push_back(sStore.Write("REPLACE INTO kv(Key, Value) VALUES (?, ?)", t * WRITES + i, "value-" + std::to_string(i)));
+                for (auto& x : sResult)
+                    sChanged += x.get();
+            });
+        for (auto& x : sThreads)
+            x.join();
+        BOOST_CHECK_EQUAL(sChanged, THREADS * WRITES);
+        BOOST_TEST_MESSAGE("writes: " << sStore.Writes() << ", batches: " << sStore.Batches());
+        BOOST_CHECK_EQUAL(sStore.Writes(), THREADS * WRITES);
+        BOOST_CHECK_LT(sStore.Batches(), THREADS * WRITES);
+
+        // failed statement does not break batch
+        auto sBad  = sStore.Write("INSERT INTO kv(Key, Value) VALUES (?, ?)", 1, nullptr);
+        auto sGood = sStore.Write("UPDATE kv SET Value = ? WHERE Key = ?", "updated", 1);
+        BOOST_CHECK_THROW(sBad.get(), Lite::Error);
+        BOOST_CHECK_EQUAL(sGood.get(), 1);
+
+        // readers in parallel threads
+        sThreads.clear();
+        std::atomic<unsigned> sFound{0};
+        for (unsigned t = 0; t < THREADS; t++)
+            sThreads.emplace_back([&sStore, &sFound]() {
+                for (int64_t i = 0; i < THREADS * WRITES; i++)
+                    sStore.Read("SELECT Value FROM kv WHERE Key = ?", [&sFound](const Lite::Statement& aRow) { sFound += !aRow.Text(0).empty(); }, i);
+            });
+        for (auto& x : sThreads)
+            x.join();
+        BOOST_CHECK_EQUAL(sFound, THREADS * THREADS * WRITES);
+
+        std::string sValue;
+        sStore.Read("SELECT Value FROM kv WHERE Key = ?", [&sValue](const Lite::Statement& aRow) { sValue = aRow.Text(0); }, 1);
+        BOOST_CHECK_EQUAL(sValue, "updated");
+
+        // writes queued before destruction are committed
+        sStore.Write("DELETE FROM kv WHERE Key = ?", 2);
+    }
+    Lite::DB sDB("__test.store.db");
+    sDB.Cached("SELECT COUNT(*) FROM kv").Fetch([](const Lite::Statement& aRow) { BOOST_CHECK_EQUAL(aRow.Int(0), THREADS * WRITES - 1); });
+}
 BOOST_AUTO_TEST_SUITE_END()
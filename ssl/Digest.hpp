@@ -69,6 +69,31 @@ namespace SSLxx {
         return DigestHash(aKind, std::forward<T&&>(aInput)...) % aPart == 0;
     }
 
+    // digest of data coming by parts
+    class DigestStream
+    {
+        DigestCtx m_Ctx;
+
+    public:
+        DigestStream(const EVP_MD* aKind)
+        : m_Ctx(makeDigestCtx())
+        {
+            if (1 != EVP_DigestInit_ex(m_Ctx.get(), aKind, NULL))
+                throw Error("EVP_DigestInit_ex");
+        }
+
+        void update(std::string_view aInput) { updateDigest(m_Ctx.get(), aInput); }
+
+        std::string final()
+        {
+            unsigned int sLen = EVP_MD_CTX_size(m_Ctx.get());
+            std::string  sResult(sLen, '\0');
+            if (1 != EVP_DigestFinal_ex(m_Ctx.get(), (uint8_t*)sResult.data(), &sLen))
+                throw Error("EVP_DigestFinal_ex");
+            return sResult;
+        }
+    };
+
     inline std::string Scrypt(const std::string_view aPass, const std::string& aSalt, size_t aSize)
     {
         std::string sResult(aSize, ' ');
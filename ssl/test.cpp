@@ -18,6 +18,11 @@ BOOST_AUTO_TEST_CASE(hash)
     BOOST_CHECK_EQUAL(SSLxx::DigestNth(EVP_md5(), 10, std::string_view("qwerty10")), false);
     BOOST_CHECK_EQUAL(SSLxx::DigestNth(EVP_md5(), 10, std::string_view("qwerty99")), true);
     BOOST_CHECK_EQUAL(SSLxx::DigestStr(EVP_md5(), 42), "9824a7030ce67cf3f0efe7529f0c6ecc");
+
+    SSLxx::DigestStream sStream(EVP_sha256());
+    sStream.update("qwe");
+    sStream.update("rty");
+    BOOST_CHECK_EQUAL(Format::to_hex(sStream.final()), "65e84be33532fb784c48129675f9eff3a682b27168c0ea744b2cf58ee02337c5");
 }
 BOOST_AUTO_TEST_CASE(encrypt_aes_ctr)
 {
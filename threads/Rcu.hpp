@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <boost/noncopyable.hpp>
+
+namespace Threads {
+
+    // read-copy-update pointer.
+    // readers never block: one atomic increment on per-thread slot, no shared counter like in shared_ptr.
+    // writer publishes new object and deletes old one after grace period (all readers who can see it are gone).
+    // grace period detection is two-phase, like in userspace RCU:
+    // readers count themselves in counter of current phase, writer flips phase twice and waits
+    // for counters of previous phase to drain. so writer can't be starved by new readers.
+    template <class T>
+    class Rcu : public boost::noncopyable
+    {
+        static constexpr unsigned SLOTS = 64;
+
+        struct alignas(64) Slot
+        {
+            std::atomic<int64_t> count[2] = {0, 0};
+        };
+
+        mutable std::array<Slot, SLOTS> m_Slots;
+        std::atomic<unsigned>           m_Phase{0};
+        std::atomic<T*>                 m_Ptr{nullptr};
+        std::mutex                      m_Mutex; // serialize writers
+
+        // threads share slot if there are more than SLOTS of them: only contention, counters are atomic
+        static unsigned index()
+        {
+            static std::atomic<unsigned> sNext{0};
+            thread_local const unsigned  sIndex = sNext++ % SLOTS;
+            return sIndex;
+        }
+
+        void drain(unsigned aPhase)
+        {
+            for (auto& x : m_Slots)
+                while (x.count[aPhase].load() != 0)
+                    std::this_thread::yield();
+        }
+
+        // caller holds m_Mutex
+        void synchronize()
+        {
+            for (int i = 0; i < 2; i++)
+                drain(m_Phase.fetch_xor(1));
+        }
+
+    public:
+        class Guard : public boost::noncopyable
+        {
+            std::atomic<int64_t>* m_Counter = nullptr;
+            const T*              m_Ptr     = nullptr;
+
+        public:
+            Guard(std::atomic<int64_t>* aCounter, const T* aPtr)
+            : m_Counter(aCounter)
+            , m_Ptr(aPtr)
+            {
+            }
+            Guard(Guard&& aOther)
+            : m_Counter(aOther.m_Counter)
+            , m_Ptr(aOther.m_Ptr)
+            {
+                aOther.m_Counter = nullptr;
+            }
+            ~Guard()
+            {
+                if (m_Counter)
+                    m_Counter->fetch_sub(1, std::memory_order_release);
+            }
+
+            const T* get() const { return m_Ptr; }
+            const T* operator->() const { return m_Ptr; }
+            const T& operator*() const { return *m_Ptr; }
+            explicit operator bool() const { return m_Ptr != nullptr; }
+        };
+
+        Rcu(std::unique_ptr<T> aPtr = {})
+        : m_Ptr(aPtr.release())
+        {
+        }
+
+        ~Rcu()
+        {
+            delete m_Ptr.load();
+        }
+
+        // object stays alive until guard destroyed. do not hold guard for long: it delays writers
+        Guard read() const
+        {
+            // counter incremented before pointer loaded (both seq_cst),
+            // so writer either waits for us or we see new pointer
+            auto& sCounter = m_Slots[index()].count[m_Phase.load() & 1];
+            sCounter.fetch_add(1);
+            return Guard(&sCounter, m_Ptr.load());
+        }
+
+        // publish new object, blocks until old one can be deleted
+        void update(std::unique_ptr<T> aPtr)
+        {
+            std::unique_lock sLock(m_Mutex);
+            std::unique_ptr<T> sOld(m_Ptr.exchange(aPtr.release()));
+            if (sOld)
+                synchronize();
+        }
+    };
+} // namespace Threads
@@ -4,6 +4,7 @@
 #include <mutex>
 #include <shared_mutex>
 
+#include "Rcu.hpp"
 #include "Spinlock.hpp"
 
 using namespace std::chrono_literals;
@@ -122,4 +123,63 @@ BM_UpdateSMutexMap/real_time/threads:4        32.0 us         2.34 us        218
 BM_UpdateSMutexMap/real_time/threads:12       31.5 us         2.35 us        22716
 */
 
+static void BM_UpdateRcuMap(benchmark::State& state)
+{
+    using T = std::map<std::string, int>;
+    static Threads::Rcu<T> sPtr;
+    static std::mutex      sMutex; // writers
+    uint64_t               sCounter = 0;
+    uint64_t               sTmp     = 0;
+
+    if (state.thread_index() == 0) {
+        sPtr.update(std::make_unique<T>(T{{"foo", 1}, {"bar", 2}, {"no one", 3}}));
+    }
+
+    for (auto _ : state) {
+        if (sCounter % 100) {
+            benchmark::DoNotOptimize(sTmp += sPtr.read()->at("foo"));
+            std::this_thread::sleep_for(10us);
+        } else {
+            std::unique_lock sLock(sMutex);
+            auto             sNew = std::make_unique<T>(*sPtr.read());
+            sNew->operator[]("foo")++;
+            std::this_thread::sleep_for(100us);
+            sPtr.update(std::move(sNew));
+        }
+        sCounter++;
+    }
+}
+BENCHMARK(BM_UpdateRcuMap)->Threads(1)->Threads(4)->Threads(12)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// read only: cost of access itself
+static void BM_ReadAtomicMap(benchmark::State& state)
+{
+    using T = std::map<std::string, int>;
+    static Threads::AtomicSharedPtr<T> sPtr(std::make_shared<T>(T{{"foo", 1}, {"bar", 2}, {"no one", 3}}));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(sPtr.Read()->find("foo"));
+}
+BENCHMARK(BM_ReadAtomicMap)->Threads(1)->Threads(4)->Threads(12);
+
+static void BM_ReadSMutexMap(benchmark::State& state)
+{
+    using T = std::map<std::string, int>;
+    static std::shared_mutex sMutex;
+    static T                 sMap{{"foo", 1}, {"bar", 2}, {"no one", 3}};
+    for (auto _ : state) {
+        std::shared_lock sLock(sMutex);
+        benchmark::DoNotOptimize(sMap.find("foo"));
+    }
+}
+BENCHMARK(BM_ReadSMutexMap)->Threads(1)->Threads(4)->Threads(12);
+
+static void BM_ReadRcuMap(benchmark::State& state)
+{
+    using T = std::map<std::string, int>;
+    static Threads::Rcu<T> sPtr(std::make_unique<T>(T{{"foo", 1}, {"bar", 2}, {"no one", 3}}));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(sPtr.read()->find("foo"));
+}
+BENCHMARK(BM_ReadRcuMap)->Threads(1)->Threads(4)->Threads(12);
+
 BENCHMARK_MAIN();
\ No newline at end of file
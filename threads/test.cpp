@@ -36,6 +36,7 @@
 #include "OrderedWorker.hpp"
 #include "Periodic.hpp" // for sleep
 #include "Pipeline.hpp"
+#include "Rcu.hpp"
 #include "Spinlock.hpp"
 #include "WaitGroup.hpp"
 
@@ -737,3 +738,53 @@ BOOST_AUTO_TEST_CASE(Atomic)
     sPtr.Update([](auto x) { x->operator[]("foo") = "bar"; });
     BOOST_CHECK_EQUAL(sPtr.Read()->operator[]("foo"), "bar");
 }
+BOOST_AUTO_TEST_CASE(Rcu)
+{
+    struct Data
+    {
+        std::atomic<int>& alive;
+        const int         value;
+        Data(std::atomic<int>& aAlive, int aValue)
+        : alive(aAlive)
+        , value(aValue)
+        {
+            alive++;
+        }
+        ~Data() { alive--; }
+    };
+    std::atomic<int> sAlive{0};
+    {
+        Threads::Rcu<Data> sPtr(std::make_unique<Data>(sAlive, 0));
+        std::atomic<bool>  sStop{false};
+        std::atomic<int>   sErrors{0};
+        std::atomic<int>   sReads{0};
+
+        std::vector<std::thread> sReaders;
+        for (int i = 0; i < 4; i++)
+            sReaders.emplace_back([&]() {
+                int sLast = 0;
+                while (!sStop) {
+                    auto sGuard = sPtr.read();
+                    // never see older object. use-after-free caught by sanitizers
+                    if (sGuard->value < sLast)
+                        sErrors++;
+                    sLast = sGuard->value;
+                    sReads++;
+                }
+            });
+        for (int i = 1; i <= 1000; i++) {
+            sPtr.update(std::make_unique<Data>(sAlive, i));
+            if (i % 100 == 0)
+                std::this_thread::yield();
+        }
+        sStop = true;
+        for (auto& x : sReaders)
+            x.join();
+
+        BOOST_CHECK_EQUAL(sErrors, 0);
+        BOOST_CHECK_EQUAL(sAlive, 1); // old versions deleted
+        BOOST_CHECK_EQUAL(sPtr.read()->value, 1000);
+        BOOST_TEST_MESSAGE("reads: " << sReads);
+    }
+    BOOST_CHECK_EQUAL(sAlive, 0);
+}
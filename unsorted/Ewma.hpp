@@ -52,6 +52,11 @@ namespace Util {
         }
 
         bool add(time_t aNow, double aElapsed, bool aSuccess)
+        {
+            return add(aNow, aElapsed, 1, aSuccess ? 1 : 0);
+        }
+        // aCount calls with total time aElapsed, aSuccess of them successful
+        bool add(time_t aNow, double aElapsed, uint32_t aCount, uint32_t aSuccess)
         {
             Lock lk(m_Mutex);
             bool sNewSecond = false;
@@ -70,9 +75,8 @@ namespace Util {
                 sNewSecond     = true;
             };
             m_Elapsed += aElapsed;
-            m_Count++;
-            if (aSuccess)
-                m_Success++;
+            m_Count += aCount;
+            m_Success += aSuccess;
             return sNewSecond;
         }
         Info estimate() const
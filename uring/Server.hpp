@@ -27,7 +27,7 @@ namespace URing::http {
         Server(Util::URing& aRing, int aFD)
         : m_Ring(aRing)
         , m_Parser([this](httpd::Request& aRequest) {
-            m_Request     = std::move(aRequest);
+            m_Request     = aRequest; // copy to keep parser arena
             m_HaveRequest = true;
         })
         , m_FD(aFD)
@@ -0,0 +1,439 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <array>
+#include <cstring>
+#include <string_view>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace UTF8::Simd {
+
+    // result of one pass over string
+    struct Info
+    {
+        bool   valid        = true;
+        bool   bmp          = true; // no 4 byte sequences
+        size_t continuation = 0;    // number of continuation bytes
+    };
+
+    // lead byte to sequence size, 0 for continuation and bytes never used in utf-8
+    inline constexpr std::array<uint8_t, 256> SIZE = [] {
+        std::array<uint8_t, 256> sSize{};
+        for (unsigned i = 0; i < 256; i++) {
+            if (i < 0x80)
+                sSize[i] = 1;
+            else if (i >= 0xC2 and i <= 0xDF)
+                sSize[i] = 2;
+            else if (i >= 0xE0 and i <= 0xEF)
+                sSize[i] = 3;
+            else if (i >= 0xF0 and i <= 0xF4)
+                sSize[i] = 4;
+        }
+        return sSize;
+    }();
+
+    // validate one sequence at aPtr, return its size or 0 if invalid. Unicode 3-7
+    inline size_t sequence(const uint8_t* aPtr, size_t aSize)
+    {
+        const uint8_t sLead = aPtr[0];
+        const size_t  sLen  = SIZE[sLead];
+        if (sLen <= 1 or sLen > aSize)
+            return sLen;
+        // allowed range of second byte
+        uint8_t sMin = 0x80, sMax = 0xBF;
+        switch (sLead) {
+        case 0xE0: sMin = 0xA0; break; // overlong
+        case 0xED: sMax = 0x9F; break; // surrogates
+        case 0xF0: sMin = 0x90; break; // overlong
+        case 0xF4: sMax = 0x8F; break; // above U+10FFFF
+        }
+        if (aPtr[1] < sMin or aPtr[1] > sMax)
+            return 0;
+        for (size_t i = 2; i < sLen; i++)
+            if ((aPtr[i] & 0xC0) != 0x80)
+                return 0;
+        return sLen;
+    }
+
+    // scalar version, 8 bytes of ascii at once
+    inline Info inspect_scalar(const uint8_t* aPtr, size_t aSize)
+    {
+        Info   sInfo;
+        size_t i = 0;
+        while (i < aSize) {
+            if (i + 8 <= aSize) {
+                uint64_t sWord;
+                memcpy(&sWord, aPtr + i, 8);
+                if ((sWord & 0x8080808080808080ull) == 0) {
+                    i += 8;
+                    continue;
+                }
+            }
+            const size_t sLen = sequence(aPtr + i, aSize - i);
+            if (sLen == 0 or i + sLen > aSize) {
+                sInfo.valid = false;
+                return sInfo;
+            }
+            sInfo.continuation += sLen - 1;
+            sInfo.bmp &= sLen < 4;
+            i += sLen;
+        }
+        return sInfo;
+    }
+
+#ifdef __AVX2__
+    // Keiser, Lemire. Validating UTF-8 In Less Than One Instruction Per Byte.
+    // https://arxiv.org/abs/2010.03090
+    class Validator
+    {
+        // error classes for pair of bytes
+        static constexpr uint8_t TOO_SHORT      = 1 << 0; // 11______ 0_______ or 11______ 11______
+        static constexpr uint8_t TOO_LONG       = 1 << 1; // 0_______ 10______
+        static constexpr uint8_t OVERLONG_3     = 1 << 2; // 11100000 100_____
+        static constexpr uint8_t TOO_LARGE      = 1 << 3; // 11110100 1001____ and above
+        static constexpr uint8_t SURROGATE      = 1 << 4; // 11101101 101_____
+        static constexpr uint8_t OVERLONG_2     = 1 << 5; // 1100000_ 10______
+        static constexpr uint8_t TOO_LARGE_1000 = 1 << 6; // 11110101 1000____ and above
+        static constexpr uint8_t OVERLONG_4     = 1 << 6; // 11110000 1000____
+        static constexpr uint8_t TWO_CONTS      = 1 << 7; // 10______ 10______
+        static constexpr uint8_t CARRY          = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+        __m256i m_Error      = _mm256_setzero_si256();
+        __m256i m_Prev       = _mm256_setzero_si256();
+        __m256i m_Incomplete = _mm256_setzero_si256(); // last block ends inside sequence
+        __m256i m_Max        = _mm256_setzero_si256();
+        size_t  m_Continuation = 0;
+
+        static __m256i table(const std::array<uint8_t, 16>& aTable)
+        {
+            return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(aTable.data())));
+        }
+
+        static __m256i high(__m256i aInput)
+        {
+            return _mm256_and_si256(_mm256_srli_epi16(aInput, 4), _mm256_set1_epi8(0x0F));
+        }
+
+        // input shifted by N bytes, with tail of previous block
+        template <int N>
+        static __m256i prev(__m256i aInput, __m256i aPrev)
+        {
+            return _mm256_alignr_epi8(aInput, _mm256_permute2x128_si256(aPrev, aInput, 0x21), 16 - N);
+        }
+
+        static __m256i special_cases(__m256i aInput, __m256i aPrev1)
+        {
+            static const std::array<uint8_t, 16> BYTE_1_HIGH{
+                // 0_______ ________ <ascii in byte 1>
+                TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                // 10______ ________ <continuation in byte 1>
+                TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                // 1100____ ________ <two byte lead in byte 1>
+                TOO_SHORT | OVERLONG_2,
+                // 1101____ ________ <two byte lead in byte 1>
+                TOO_SHORT,
+                // 1110____ ________ <three byte lead in byte 1>
+                TOO_SHORT | OVERLONG_3 | SURROGATE,
+                // 1111____ ________ <four+ byte lead in byte 1>
+                TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4};
+            static const std::array<uint8_t, 16> BYTE_1_LOW{
+                CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, // ____0000 ________
+                CARRY | OVERLONG_2,                           // ____0001 ________
+                CARRY,                                        // ____001_ ________
+                CARRY,
+                CARRY | TOO_LARGE,                            // ____0100 ________
+                CARRY | TOO_LARGE | TOO_LARGE_1000,           // ____0101 ________
+                CARRY | TOO_LARGE | TOO_LARGE_1000,           // ____011_ ________
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000, // ____1___ ________
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, // ____1101 ________
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000};
+            static const std::array<uint8_t, 16> BYTE_2_HIGH{
+                // ________ 0_______ <ascii in byte 2>
+                TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                // ________ 1000____
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+                // ________ 1001____
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                // ________ 101_____
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                // ________ 11______
+                TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT};
+
+            const __m256i sByte1High = _mm256_shuffle_epi8(table(BYTE_1_HIGH), high(aPrev1));
+            const __m256i sByte1Low  = _mm256_shuffle_epi8(table(BYTE_1_LOW), _mm256_and_si256(aPrev1, _mm256_set1_epi8(0x0F)));
+            const __m256i sByte2High = _mm256_shuffle_epi8(table(BYTE_2_HIGH), high(aInput));
+            return _mm256_and_si256(_mm256_and_si256(sByte1High, sByte1Low), sByte2High);
+        }
+
+        // 3rd and 4th bytes of sequences must be continuation
+        static __m256i multibyte_lengths(__m256i aInput, __m256i aPrev, __m256i aSpecial)
+        {
+            const __m256i sPrev2  = prev<2>(aInput, aPrev);
+            const __m256i sPrev3  = prev<3>(aInput, aPrev);
+            const __m256i sThird  = _mm256_subs_epu8(sPrev2, _mm256_set1_epi8(0xE0 - 0x80));
+            const __m256i sFourth = _mm256_subs_epu8(sPrev3, _mm256_set1_epi8(0xF0 - 0x80));
+            const __m256i sMust23 = _mm256_and_si256(_mm256_or_si256(sThird, sFourth), _mm256_set1_epi8(0x80));
+            return _mm256_xor_si256(sMust23, aSpecial);
+        }
+
+        // non zero if block ends inside sequence
+        static __m256i incomplete(__m256i aInput)
+        {
+            const __m256i sMax = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                  0xF0 - 1, 0xE0 - 1, 0xC0 - 1);
+            return _mm256_subs_epu8(aInput, sMax);
+        }
+
+    public:
+        void add(__m256i aInput)
+        {
+            m_Max = _mm256_max_epu8(m_Max, aInput);
+            if (_mm256_movemask_epi8(aInput) == 0) {
+                // ascii: only check nothing left incomplete before
+                m_Error = _mm256_or_si256(m_Error, m_Incomplete);
+                m_Incomplete = _mm256_setzero_si256();
+            } else {
+                const __m256i sPrev1   = prev<1>(aInput, m_Prev);
+                const __m256i sSpecial = special_cases(aInput, sPrev1);
+                m_Error = _mm256_or_si256(m_Error, multibyte_lengths(aInput, m_Prev, sSpecial));
+                m_Incomplete = incomplete(aInput);
+                // continuation bytes are 0x80..0xBF, below -64 as signed
+                m_Continuation += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-64), aInput)));
+            }
+            m_Prev = aInput;
+        }
+
+        Info finish() const
+        {
+            const __m256i sError = _mm256_or_si256(m_Error, m_Incomplete);
+            const __m256i sFour  = _mm256_cmpeq_epi8(_mm256_max_epu8(m_Max, _mm256_set1_epi8(0xF0)), m_Max);
+            Info sInfo;
+            sInfo.valid        = _mm256_testz_si256(sError, sError);
+            sInfo.bmp          = _mm256_movemask_epi8(sFour) == 0;
+            sInfo.continuation = m_Continuation;
+            return sInfo;
+        }
+    };
+
+    inline Info inspect(const uint8_t* aPtr, size_t aSize)
+    {
+        Validator sValidator;
+        size_t    i = 0;
+        for (; i + 32 <= aSize; i += 32)
+            sValidator.add(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPtr + i)));
+        if (i < aSize) {
+            // zero padding is ascii
+            alignas(32) uint8_t sTail[32] = {};
+            memcpy(sTail, aPtr + i, aSize - i);
+            sValidator.add(_mm256_load_si256(reinterpret_cast<const __m256i*>(sTail)));
+        }
+        return sValidator.finish();
+    }
+
+    // length of ascii prefix, 32 bytes at once
+    inline size_t ascii(const uint8_t* aPtr, size_t aSize)
+    {
+        size_t i = 0;
+        for (; i + 32 <= aSize; i += 32) {
+            const int sMask = _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPtr + i)));
+            if (sMask != 0)
+                return i + __builtin_ctz(sMask);
+        }
+        while (i < aSize and aPtr[i] < 0x80)
+            i++;
+        return i;
+    }
+#else
+    inline Info inspect(const uint8_t* aPtr, size_t aSize) { return inspect_scalar(aPtr, aSize); }
+
+    inline size_t ascii(const uint8_t* aPtr, size_t aSize)
+    {
+        size_t i = 0;
+        for (; i + 8 <= aSize; i += 8) {
+            uint64_t sWord;
+            memcpy(&sWord, aPtr + i, 8);
+            if (sWord & 0x8080808080808080ull)
+                break;
+        }
+        while (i < aSize and aPtr[i] < 0x80)
+            i++;
+        return i;
+    }
+#endif
+
+    // widen ascii prefix of aSize bytes
+    template <class C>
+    inline void widen(const uint8_t* aPtr, size_t aSize, C* aOut)
+    {
+        size_t i = 0;
+#ifdef __AVX2__
+        if constexpr (sizeof(C) == 2) {
+            for (; i + 16 <= aSize; i += 16)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(aOut + i), _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(aPtr + i))));
+        } else {
+            for (; i + 8 <= aSize; i += 8)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(aOut + i), _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(aPtr + i))));
+        }
+#endif
+        for (; i < aSize; i++)
+            aOut[i] = aPtr[i];
+    }
+
+#ifdef __AVX2__
+    // shuffle to move kept 16 bit lanes (bits of mask) to begin
+    inline constexpr auto COMPACT = [] {
+        std::array<std::array<int8_t, 16>, 256> sTable{};
+        for (unsigned sMask = 0; sMask < 256; sMask++) {
+            unsigned k = 0;
+            for (unsigned j = 0; j < 8; j++)
+                if (sMask & (1 << j)) {
+                    sTable[sMask][2 * k]     = 2 * j;
+                    sTable[sMask][2 * k + 1] = 2 * j + 1;
+                    k++;
+                }
+            for (; k < 8; k++)
+                sTable[sMask][2 * k] = sTable[sMask][2 * k + 1] = -1;
+        }
+        return sTable;
+    }();
+
+    // 16 bytes of valid one and two byte sequences, starting from lead byte. aPtr[16] must be readable,
+    // aOut must have space for 16 code units. return number of bytes consumed, 0 if block has longer sequences
+    template <class C>
+    inline size_t two_byte(const uint8_t* aPtr, C*& aOut)
+    {
+        const __m128i sInput = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aPtr));
+        const __m128i sLimit = _mm_set1_epi8(0xDF);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(sInput, sLimit), sLimit)) != 0xFFFF)
+            return 0;
+
+        // every lane decoded as if it is lead byte, with next byte as continuation
+        const __m256i sByte  = _mm256_cvtepu8_epi16(sInput);
+        const __m256i sNext  = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(aPtr + 1)));
+        const __m256i sTwo   = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(sByte, _mm256_set1_epi16(0x1F)), 6), _mm256_and_si256(sNext, _mm256_set1_epi16(0x3F)));
+        const __m256i sValue = _mm256_blendv_epi8(sByte, sTwo, _mm256_cmpgt_epi16(sByte, _mm256_set1_epi16(0xBF)));
+
+        // drop continuation lanes
+        const unsigned sKeep = _mm_movemask_epi8(_mm_cmpgt_epi8(sInput, _mm_set1_epi8(-65)));
+        auto           sPut  = [&aOut](__m128i aHalf, unsigned aMask) {
+            const __m128i sPacked = _mm_shuffle_epi8(aHalf, _mm_loadu_si128(reinterpret_cast<const __m128i*>(COMPACT[aMask].data())));
+            if constexpr (sizeof(C) == 2)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(aOut), sPacked);
+            else
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(aOut), _mm256_cvtepu16_epi32(sPacked));
+            aOut += __builtin_popcount(aMask);
+        };
+        sPut(_mm256_castsi256_si128(sValue), sKeep & 0xFF);
+        sPut(_mm256_extracti128_si256(sValue, 1), sKeep >> 8);
+        return 16 + (aPtr[15] >= 0xC0);
+    }
+#endif
+
+    // decode valid sequence of aLen bytes
+    inline uint32_t decode(const uint8_t* aPtr, size_t aLen)
+    {
+        switch (aLen) {
+        case 1: return aPtr[0];
+        case 2: return (aPtr[0] & 0x1F) << 6 | (aPtr[1] & 0x3F);
+        case 3: return (aPtr[0] & 0x0F) << 12 | (aPtr[1] & 0x3F) << 6 | (aPtr[2] & 0x3F);
+        default: return (aPtr[0] & 0x07) << 18 | (aPtr[1] & 0x3F) << 12 | (aPtr[2] & 0x3F) << 6 | (aPtr[3] & 0x3F);
+        }
+    }
+
+    // encode code point, return number of bytes
+    inline size_t encode(uint32_t aChar, char* aOut)
+    {
+        if (aChar < 0x80) {
+            aOut[0] = aChar;
+            return 1;
+        }
+        if (aChar < 0x800) {
+            aOut[0] = 0xC0 | (aChar >> 6);
+            aOut[1] = 0x80 | (aChar & 0x3F);
+            return 2;
+        }
+        if (aChar < 0x10000) {
+            aOut[0] = 0xE0 | (aChar >> 12);
+            aOut[1] = 0x80 | ((aChar >> 6) & 0x3F);
+            aOut[2] = 0x80 | (aChar & 0x3F);
+            return 3;
+        }
+        aOut[0] = 0xF0 | (aChar >> 18);
+        aOut[1] = 0x80 | ((aChar >> 12) & 0x3F);
+        aOut[2] = 0x80 | ((aChar >> 6) & 0x3F);
+        aOut[3] = 0x80 | (aChar & 0x3F);
+        return 4;
+    }
+
+    // ascii prefix of utf-16 or utf-32 string, narrowed to aOut
+    template <class C>
+    inline size_t narrow(const C* aPtr, size_t aSize, char* aOut)
+    {
+        size_t i = 0;
+#ifdef __AVX2__
+        if constexpr (sizeof(C) == 2) {
+            for (; i + 16 <= aSize; i += 16) {
+                const __m256i sInput = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPtr + i));
+                if (!_mm256_testz_si256(sInput, _mm256_set1_epi16(int16_t(0xFF80))))
+                    break;
+                const __m256i sPacked = _mm256_permute4x64_epi64(_mm256_packus_epi16(sInput, sInput), 0b1000);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(aOut + i), _mm256_castsi256_si128(sPacked));
+            }
+        } else {
+            for (; i + 8 <= aSize; i += 8) {
+                const __m256i sInput = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPtr + i));
+                if (!_mm256_testz_si256(sInput, _mm256_set1_epi32(int32_t(0xFFFFFF80))))
+                    break;
+                const __m256i sBytes = _mm256_shuffle_epi8(sInput, _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                                                     0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+                const __m256i sPacked = _mm256_permutevar8x32_epi32(sBytes, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(aOut + i), _mm256_castsi256_si128(sPacked));
+            }
+        }
+#endif
+        for (; i < aSize and uint32_t(aPtr[i]) < 0x80; i++)
+            aOut[i] = aPtr[i];
+        return i;
+    }
+
+    // all code points in one of ranges (pairs of begin and size - 1)
+    template <size_t N>
+    inline bool in_range(const char32_t* aPtr, size_t aSize, const std::array<std::pair<uint32_t, uint32_t>, N>& aRanges)
+    {
+        size_t i = 0;
+#ifdef __AVX2__
+        for (; i + 8 <= aSize; i += 8) {
+            const __m256i sInput = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPtr + i));
+            __m256i       sHit   = _mm256_setzero_si256();
+            for (auto& [sBegin, sLast] : aRanges) {
+                // x - begin <= last, unsigned
+                const __m256i sOffset = _mm256_sub_epi32(sInput, _mm256_set1_epi32(sBegin));
+                sHit = _mm256_or_si256(sHit, _mm256_cmpeq_epi32(_mm256_min_epu32(sOffset, _mm256_set1_epi32(sLast)), sOffset));
+            }
+            if (_mm256_movemask_epi8(sHit) != -1)
+                return false;
+        }
+#endif
+        for (; i < aSize; i++) {
+            bool sHit = false;
+            for (auto& [sBegin, sLast] : aRanges)
+                sHit |= uint32_t(aPtr[i]) - sBegin <= sLast;
+            if (!sHit)
+                return false;
+        }
+        return true;
+    }
+
+} // namespace UTF8::Simd
@@ -1,12 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <iterator>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 
-#include <mpl/Mpl.hpp>
+#include "Simd.hpp"
 
 namespace UTF8 {
     struct BadCharacter : std::invalid_argument
@@ -87,7 +88,7 @@ namespace UTF8 {
                     throw BadCharacter();
                 if (m_TrailSize > 2 and m_Char <= 0xFFFF)
                     throw BadCharacter();
-                if (m_Char > 0x1FFFFF)
+                if (m_Char > 0x10FFFF)
                     throw BadCharacter();
                 // detect UTF-16 surrogates
                 if (m_Char >= 0xD800 and m_Char <= 0xDFFF)
@@ -176,24 +177,117 @@ namespace UTF8 {
     // validate string
     inline void Validate(std::string_view aStr)
     {
-        for (auto x : CharDecoder(aStr))
-            (void)x;
+        if (!Simd::inspect(reinterpret_cast<const uint8_t*>(aStr.data()), aStr.size()).valid)
+            throw BadCharacter();
     }
 
     // string length in code points
     inline uint32_t Length(std::string_view aStr)
     {
-        CharDecoder sDecoder(aStr);
-        return std::distance(sDecoder.begin(), sDecoder.end());
+        const auto sInfo = Simd::inspect(reinterpret_cast<const uint8_t*>(aStr.data()), aStr.size());
+        if (!sInfo.valid)
+            throw BadCharacter();
+        return aStr.size() - sInfo.continuation;
     }
 
     // ensure characters from Basic Multilingual Plane
     inline bool IsBMP(std::string_view aStr)
     {
-        for (auto x : CharDecoder(aStr))
-            if (x > 0xFFFF)
-                return false;
-        return true;
+        const auto sInfo = Simd::inspect(reinterpret_cast<const uint8_t*>(aStr.data()), aStr.size());
+        if (!sInfo.valid)
+            throw BadCharacter();
+        return sInfo.bmp;
+    }
+
+    namespace aux {
+        template <class C>
+        inline size_t decode(std::string_view aStr, C* aOut)
+        {
+            const uint8_t* sPtr  = reinterpret_cast<const uint8_t*>(aStr.data());
+            const size_t   sSize = aStr.size();
+            if (!Simd::inspect(sPtr, sSize).valid)
+                throw BadCharacter();
+
+            C*     sOut = aOut;
+            size_t i    = 0;
+            while (i < sSize) {
+                const size_t sAscii = Simd::ascii(sPtr + i, sSize - i);
+                Simd::widen(sPtr + i, sAscii, sOut);
+                i += sAscii;
+                sOut += sAscii;
+                while (i < sSize and sPtr[i] >= 0x80) {
+#ifdef __AVX2__
+                    if (i + 17 <= sSize) {
+                        if (const size_t sUsed = Simd::two_byte(sPtr + i, sOut)) {
+                            i += sUsed;
+                            continue;
+                        }
+                    }
+#endif
+                    const size_t   sLen  = Simd::SIZE[sPtr[i]];
+                    const uint32_t sChar = Simd::decode(sPtr + i, sLen);
+                    if (sizeof(C) == 2 and sChar > 0xFFFF) {
+                        *sOut++ = 0xD800 + ((sChar - 0x10000) >> 10);
+                        *sOut++ = 0xDC00 + (sChar & 0x3FF);
+                    } else {
+                        *sOut++ = sChar;
+                    }
+                    i += sLen;
+                }
+            }
+            return sOut - aOut;
+        }
+    } // namespace aux
+
+    // transcode to caller buffer, return number of code units written.
+    // buffer must have space for aStr.size() code units
+    inline size_t ToUTF16(std::string_view aStr, char16_t* aOut) { return aux::decode(aStr, aOut); }
+    inline size_t ToUTF32(std::string_view aStr, char32_t* aOut) { return aux::decode(aStr, aOut); }
+
+    // encode to utf-8, return number of bytes written.
+    // buffer must have space for 3 * aStr.size() bytes
+    inline size_t FromUTF16(std::u16string_view aStr, char* aOut)
+    {
+        const char16_t* sPtr  = aStr.data();
+        const size_t    sSize = aStr.size();
+        char*           sOut  = aOut;
+        size_t          i     = 0;
+        while (i < sSize) {
+            const size_t sAscii = Simd::narrow(sPtr + i, sSize - i, sOut);
+            i += sAscii;
+            sOut += sAscii;
+            while (i < sSize and sPtr[i] >= 0x80) {
+                uint32_t sChar = sPtr[i++];
+                if (sChar >= 0xD800 and sChar <= 0xDFFF) {
+                    if (sChar > 0xDBFF or i == sSize or sPtr[i] < 0xDC00 or sPtr[i] > 0xDFFF)
+                        throw std::invalid_argument("utf8 encode: unpaired surrogate");
+                    sChar = 0x10000 + ((sChar - 0xD800) << 10) + (sPtr[i++] - 0xDC00);
+                }
+                sOut += Simd::encode(sChar, sOut);
+            }
+        }
+        return sOut - aOut;
+    }
+
+    // buffer must have space for 4 * aStr.size() bytes
+    inline size_t FromUTF32(std::u32string_view aStr, char* aOut)
+    {
+        const char32_t* sPtr  = aStr.data();
+        const size_t    sSize = aStr.size();
+        char*           sOut  = aOut;
+        size_t          i     = 0;
+        while (i < sSize) {
+            const size_t sAscii = Simd::narrow(sPtr + i, sSize - i, sOut);
+            i += sAscii;
+            sOut += sAscii;
+            while (i < sSize and sPtr[i] >= 0x80) {
+                const uint32_t sChar = sPtr[i++];
+                if (sChar > 0x10FFFF or (sChar >= 0xD800 and sChar <= 0xDFFF))
+                    throw std::invalid_argument("utf8 encode: invalid code point");
+                sOut += Simd::encode(sChar, sOut);
+            }
+        }
+        return sOut - aOut;
     }
 
     // https://en.wikipedia.org/wiki/Plane_(Unicode)
@@ -207,19 +301,21 @@ namespace UTF8 {
     inline constexpr Range BasicLatin{0x0000, 0x007F};
     inline constexpr Range BasicCyr{0x0400, 0x04FF};
 
+    // decoded by blocks, 8 code points checked at once
     template <class... T>
     inline bool InRange(std::string_view aStr, T&&... aSet)
     {
-        for (auto x : CharDecoder(aStr)) {
-            bool sHit = false;
-            Mpl::for_each_argument(
-                [x, &sHit](auto range) {
-                    if (!sHit)
-                        sHit |= range.test(x);
-                },
-                aSet...);
-            if (!sHit)
+        const std::array<std::pair<uint32_t, uint32_t>, sizeof...(T)> sRanges{std::pair<uint32_t, uint32_t>(aSet.begin, aSet.end - aSet.begin)...};
+
+        char32_t sBuffer[256];
+        while (!aStr.empty()) {
+            size_t sSize = std::min(aStr.size(), std::size(sBuffer));
+            // do not split sequence
+            for (int i = 0; i < 3 and sSize < aStr.size() and (uint8_t(aStr[sSize]) & 0xC0) == 0x80; i++)
+                sSize--;
+            if (!Simd::in_range(sBuffer, ToUTF32(aStr.substr(0, sSize), sBuffer), sRanges))
                 return false;
+            aStr.remove_prefix(sSize);
         }
         return true;
     }
@@ -1,7 +1,9 @@
 #define BOOST_TEST_MODULE Suites
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
 #include <iostream>
+#include <random>
 
 #include <UTF8.hpp>
 
@@ -60,4 +62,130 @@ BOOST_AUTO_TEST_CASE(iterate)
         sResult.push_back(x);
     BOOST_CHECK_EQUAL_COLLECTIONS(sResult.begin(), sResult.end(), sExpected.begin(), sExpected.end());
 }
+BOOST_AUTO_TEST_CASE(large)
+{
+    // above U+10FFFF
+    BOOST_CHECK_THROW(UTF8::Validate("\xF4\x90\x80\x80"), UTF8::BadCharacter);
+    BOOST_CHECK_THROW(UTF8::Validate("\xF5\x80\x80\x80"), UTF8::BadCharacter);
+    BOOST_CHECK_THROW(UTF8::Decode("\xF7\xBF\xBF\xBF"), UTF8::BadCharacter);
+    BOOST_CHECK_EQUAL(0x10FFFF, UTF8::Decode("\xF4\x8F\xBF\xBF"));
+
+    // errors in long string, at block boundaries and in tail
+    const std::string sGood(100, 'x');
+    for (size_t i = 0; i < sGood.size(); i++) {
+        std::string sTmp = sGood;
+        sTmp[i]          = '\x80';
+        BOOST_CHECK_THROW(UTF8::Validate(sTmp), UTF8::BadCharacter);
+        sTmp[i] = '\xD0'; // sequence not complete
+        BOOST_CHECK_THROW(UTF8::Validate(sTmp), UTF8::BadCharacter);
+    }
+    std::string sCyr;
+    for (int i = 0; i < 50; i++)
+        sCyr += "ж";
+    BOOST_CHECK_EQUAL(UTF8::Length(sCyr), 50);
+    BOOST_CHECK_EQUAL(UTF8::InRange(sCyr, UTF8::BasicCyr), true);
+    BOOST_CHECK_EQUAL(UTF8::InRange(sCyr + "x", UTF8::BasicCyr), false);
+    BOOST_CHECK_EQUAL(UTF8::IsBMP(sCyr + "\xf0\x90\x85\x83"), false);
+    BOOST_CHECK_THROW(UTF8::Length(sCyr.substr(0, 99)), UTF8::BadCharacter);
+}
+BOOST_AUTO_TEST_CASE(transcode)
+{
+    const std::string sStr = "test строка € \xf0\x90\x85\x83 and some long ascii tail to use wide path";
+    std::u16string    sUTF16(sStr.size(), 0);
+    std::u32string    sUTF32(sStr.size(), 0);
+    sUTF16.resize(UTF8::ToUTF16(sStr, sUTF16.data()));
+    sUTF32.resize(UTF8::ToUTF32(sStr, sUTF32.data()));
+    BOOST_CHECK(sUTF16 == u"test строка € \U00010143 and some long ascii tail to use wide path");
+    BOOST_CHECK(sUTF32 == U"test строка € \U00010143 and some long ascii tail to use wide path");
+
+    std::string sBack(sUTF32.size() * 4, 0);
+    sBack.resize(UTF8::FromUTF16(sUTF16, sBack.data()));
+    BOOST_CHECK_EQUAL(sBack, sStr);
+    sBack.resize(sUTF32.size() * 4);
+    sBack.resize(UTF8::FromUTF32(sUTF32, sBack.data()));
+    BOOST_CHECK_EQUAL(sBack, sStr);
+
+    char sTmp[16];
+    BOOST_CHECK_THROW(UTF8::ToUTF32("\xC0\x80", reinterpret_cast<char32_t*>(sTmp)), UTF8::BadCharacter);
+    BOOST_CHECK_THROW(UTF8::FromUTF16(u"\xD800x", sTmp), std::invalid_argument);
+    BOOST_CHECK_THROW(UTF8::FromUTF16(u"\xDC00", sTmp), std::invalid_argument);
+    BOOST_CHECK_THROW(UTF8::FromUTF32(U"\x110000", sTmp), std::invalid_argument);
+}
+BOOST_AUTO_TEST_CASE(random)
+{
+    // compare with CharDecoder on random mix of valid and broken sequences
+    const std::vector<std::string> sParts{"a", "z0", "\x00", "ж", "€", "\xf0\x90\x85\x83", "\xF4\x8F\xBF\xBF", "\x80", "\xC0\x80", "\xC3", "\xE2\x82", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xFF", std::string(40, 'q')};
+    std::mt19937 sGen(1);
+    for (int i = 0; i < 20000; i++) {
+        std::string sStr;
+        const int   sCount = sGen() % 40;
+        for (int j = 0; j < sCount; j++) {
+            const size_t sIndex = sGen() % sParts.size();
+            // mostly valid parts
+            sStr += sParts[sIndex < 7 or sGen() % 16 == 0 ? sIndex : sIndex % 7];
+        }
+        std::vector<uint32_t> sExpected;
+        bool                  sValid = true;
+        try {
+            for (auto x : UTF8::CharDecoder(sStr))
+                sExpected.push_back(x);
+        } catch (const UTF8::BadCharacter&) {
+            sValid = false;
+        }
+        if (!sValid) {
+            BOOST_CHECK_THROW(UTF8::Validate(sStr), UTF8::BadCharacter);
+            continue;
+        }
+        BOOST_CHECK_EQUAL(UTF8::Length(sStr), sExpected.size());
+        std::u32string sUTF32(sStr.size(), 0);
+        sUTF32.resize(UTF8::ToUTF32(sStr, sUTF32.data()));
+        const std::vector<uint32_t> sResult(sUTF32.begin(), sUTF32.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(sResult.begin(), sResult.end(), sExpected.begin(), sExpected.end());
+
+        // round trip
+        std::u16string sUTF16(sStr.size(), 0);
+        sUTF16.resize(UTF8::ToUTF16(sStr, sUTF16.data()));
+        std::string sBack(sUTF16.size() * 3, 0);
+        sBack.resize(UTF8::FromUTF16(sUTF16, sBack.data()));
+        BOOST_CHECK_EQUAL(sBack, sStr);
+        sBack.resize(sUTF32.size() * 4);
+        sBack.resize(UTF8::FromUTF32(sUTF32, sBack.data()));
+        BOOST_CHECK_EQUAL(sBack, sStr);
+    }
+}
+BOOST_AUTO_TEST_CASE(speed)
+{
+    auto sRepeat = [](std::string_view aStr) {
+        std::string sResult;
+        while (sResult.size() < 1024 * 1024)
+            sResult += aStr;
+        return sResult;
+    };
+    const std::vector<std::pair<std::string, std::string>> sInputs{
+        {"ascii", sRepeat("The quick brown fox jumps over the lazy dog. ")},
+        {"cyrillic", sRepeat("Съешь же ещё этих мягких французских булок, да выпей чаю. ")},
+        {"mixed", sRepeat("price: 100€, имя: Вася, emoji: \xf0\x9f\x98\x80; ")}};
+
+    auto sMeasure = [](const std::string& aStr, auto&& aFunc) {
+        const auto sStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < 20; i++)
+            aFunc();
+        const std::chrono::duration<double> sElapsed = std::chrono::steady_clock::now() - sStart;
+        return aStr.size() * 20 / sElapsed.count() / 1e9;
+    };
+
+    std::u16string sUTF16(1024 * 1024 * 2, 0);
+    for (auto& [sName, sStr] : sInputs) {
+        const double sDecoder  = sMeasure(sStr, [&]() {
+            uint32_t sCount = 0;
+            for (auto x : UTF8::CharDecoder(sStr))
+                sCount += x != 0;
+            BOOST_CHECK(sCount > 0);
+        });
+        const double sValidate = sMeasure(sStr, [&]() { UTF8::Validate(sStr); });
+        const double sLength   = sMeasure(sStr, [&]() { BOOST_CHECK(UTF8::Length(sStr) > 0); });
+        const double sTo16     = sMeasure(sStr, [&]() { BOOST_CHECK(UTF8::ToUTF16(sStr, sUTF16.data()) > 0); });
+        BOOST_TEST_MESSAGE(sName << " GB/s: decoder " << sDecoder << ", validate " << sValidate << ", length " << sLength << ", to utf16 " << sTo16);
+    }
+}
 BOOST_AUTO_TEST_SUITE_END()